@@ -53,42 +53,57 @@ namespace {
      }
    */
 
-json::MapPtr to_properties(uint64_t id, const std::string& color) {
-  return json::map({
-      {"fill", color},
-      {"stroke", std::string("white")},
-      {"stroke-width", static_cast<uint64_t>(1)},
-      {"fill-opacity", json::fp_t{0.8, 1}},
-      {"id", id},
-  });
+void to_properties(json::Jwriter& writer, uint64_t id, const std::string& color) {
+  writer.start_object("properties");
+  writer("fill", color);
+  writer("stroke", "white");
+  writer("stroke-width", static_cast<uint64_t>(1));
+  writer("fill-opacity", json::fp_t{0.8, 1});
+  writer("id", id);
+  writer.end_object();
 }
 
 using ring_t = std::list<PointLL>;
 using polygon_t = std::list<ring_t>;
-json::MapPtr to_geometry(const polygon_t& polygon) {
-  auto coords = json::array({});
+void to_coord(json::Jwriter& writer, const PointLL& coord) {
+  writer.start_array();
+  writer(json::fp_t{coord.first, 6});
+  writer(json::fp_t{coord.second, 6});
+  writer.end_array();
+}
+
+void to_geometry(json::Jwriter& writer, const polygon_t& polygon) {
+  writer.start_object("geometry");
+  writer("type", "Polygon");
+  writer.start_array("coordinates");
   bool outer = true;
   for (const auto& ring : polygon) {
-    auto ring_coords = json::array({});
-    for (const auto& coord : ring) {
-      if (outer) {
-        ring_coords->emplace_back(
-            json::array({json::fp_t{coord.first, 6}, json::fp_t{coord.second, 6}}));
-      } else {
-        ring_coords->emplace_front(
-            json::array({json::fp_t{coord.first, 6}, json::fp_t{coord.second, 6}}));
+    // the inner rings wind the other way
+    writer.start_array();
+    if (outer) {
+      for (auto coord = ring.cbegin(); coord != ring.cend(); ++coord) {
+        to_coord(writer, *coord);
+      }
+    } else {
+      for (auto coord = ring.crbegin(); coord != ring.crend(); ++coord) {
+        to_coord(writer, *coord);
       }
     }
-    coords->emplace_back(ring_coords);
+    writer.end_array();
     outer = false;
   }
-  return json::map({{"type", std::string("Polygon")}, {"coordinates", coords}});
+  writer.end_array();
+  writer.end_object();
 }
 
-json::MapPtr to_feature(const std::pair<size_t, polygon_t>& boundary, const std::string& color) {
-  return json::map({{"type", std::string("Feature")},
-                    {"geometry", to_geometry(boundary.second)},
-                    {"properties", to_properties(boundary.first, color)}});
+void to_feature(json::Jwriter& writer,
+                const std::pair<size_t, polygon_t>& boundary,
+                const std::string& color) {
+  writer.start_object();
+  writer("type", "Feature");
+  to_geometry(writer, boundary.second);
+  to_properties(writer, static_cast<uint64_t>(boundary.first), color);
+  writer.end_object();
 }
 
 template <class T>
@@ -96,17 +111,20 @@ std::string to_feature_collection(const std::unordered_map<size_t, polygon_t>& b
                                   const std::multimap<size_t, size_t, T>& arities) {
   std::default_random_engine generator;
   std::uniform_int_distribution<int> distribution(64, 192);
-  auto features = json::array({});
+  json::Jwriter writer;
+  writer.start_object();
+  writer("type", "FeatureCollection");
+  writer.start_array("features");
   for (const auto& arity : arities) {
     std::stringstream hex;
     hex << "#" << std::hex << distribution(generator);
     hex << std::hex << distribution(generator);
     hex << std::hex << distribution(generator);
-    features->emplace_back(to_feature(*boundaries.find(arity.second), hex.str()));
+    to_feature(writer, *boundaries.find(arity.second), hex.str());
   }
-  std::stringstream ss;
-  ss << *json::map({{"type", std::string("FeatureCollection")}, {"features", features}});
-  return ss.str();
+  writer.end_array();
+  writer.end_object();
+  return writer.release();
 }
 
 polygon_t to_boundary(const std::pair<size_t, std::unordered_set<uint32_t>>& region,
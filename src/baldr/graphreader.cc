@@ -1,8 +1,13 @@
 #include "baldr/graphreader.h"
 
+#include <algorithm>
+#include <atomic>
 #include <boost/filesystem.hpp>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <sys/stat.h>
 
@@ -18,6 +23,15 @@ namespace {
 constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1073741824; // 1 gig
 constexpr size_t AVERAGE_TILE_SIZE = 2097152;         // 2 megs
 constexpr size_t AVERAGE_MM_TILE_SIZE = 1024;         // 1k
+constexpr size_t CONCURRENT_CACHE_SHARDS = 64;        // write locks in the concurrent cache
+constexpr size_t DEFAULT_PREFETCH_MAX_TILES = 64;     // tiles held by the prefetcher
+constexpr float DEFAULT_PRELOAD_CACHE_FRACTION = 0.75f; // of the cache to fill when preloading
+const std::string kTileLoadPrefix = "tile_load::";    // logged for every tile loaded
+
+// How a tile is written in a tile list and in the log when it is loaded
+std::string TileListEntry(const valhalla::baldr::GraphId& id) {
+  return std::to_string(id.level()) + "/" + std::to_string(id.tileid());
+}
 } // namespace
 
 namespace valhalla {
@@ -98,6 +112,96 @@ const GraphTile* SimpleTileCache::Put(const GraphId& graphid, const GraphTile& t
   return &cache_.emplace(graphid, tile).first->second;
 }
 
+// Clears the cache if it is over committed.
+void SimpleTileCache::Trim() {
+  if (OverCommitted()) {
+    Clear();
+  }
+}
+
+// Constructor.
+TileCacheLRU::TileCacheLRU(size_t max_size, MemoryLimitControl mem_control)
+    : cache_size_(0), max_cache_size_(max_size), mem_control_(mem_control) {
+}
+
+// Gets the number of bytes an entry takes up in the cache.
+size_t TileCacheLRU::EntrySize(size_t size) {
+  // The list node has two links and the map node has a link and the hash
+  return size + sizeof(KeyValue) + sizeof(std::pair<const GraphId, KeyValueIter>) +
+         4 * sizeof(void*);
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void TileCacheLRU::Reserve(size_t tile_size) {
+  cache_.reserve(max_cache_size_ / EntrySize(tile_size));
+}
+
+// Checks if tile exists in the cache.
+bool TileCacheLRU::Contains(const GraphId& graphid) const {
+  return cache_.find(graphid) != cache_.end();
+}
+
+// Lets you know if the cache is too large.
+bool TileCacheLRU::OverCommitted() const {
+  return max_cache_size_ < cache_size_;
+}
+
+// Clears the cache.
+void TileCacheLRU::Clear() {
+  cache_size_ = 0;
+  cache_.clear();
+  key_val_lru_list_.clear();
+}
+
+// Evicts the least recently used tiles until the cache fits its limit.
+void TileCacheLRU::Trim() {
+  TrimToFit(max_cache_size_);
+}
+
+// Evicts the least recently used tiles until the cache fits the given size.
+size_t TileCacheLRU::TrimToFit(size_t max_size) {
+  size_t freed = 0;
+  while (cache_size_ > max_size && key_val_lru_list_.size() > 1) {
+    const auto& entry = key_val_lru_list_.back();
+    cache_size_ -= entry.size;
+    freed += entry.size;
+    cache_.erase(entry.id);
+    key_val_lru_list_.pop_back();
+  }
+  return freed;
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+const GraphTile* TileCacheLRU::Get(const GraphId& graphid) const {
+  auto cached = cache_.find(graphid);
+  if (cached == cache_.end()) {
+    return nullptr;
+  }
+  // Mark it as the most recently used
+  key_val_lru_list_.splice(key_val_lru_list_.begin(), key_val_lru_list_, cached->second);
+  return &cached->second->tile;
+}
+
+// Puts a copy of a tile of into the cache.
+const GraphTile* TileCacheLRU::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  // Already have it so just mark it as the most recently used
+  if (const auto* cached = Get(graphid)) {
+    return cached;
+  }
+
+  // Add it as the most recently used
+  size_t entry_size = EntrySize(size);
+  key_val_lru_list_.emplace_front(KeyValue{graphid, tile, entry_size});
+  cache_.emplace(graphid, key_val_lru_list_.begin());
+  cache_size_ += entry_size;
+
+  // Make room for it if we must
+  if (mem_control_ == MemoryLimitControl::HARD) {
+    TrimToFit(max_cache_size_);
+  }
+  return &key_val_lru_list_.front().tile;
+}
+
 // Constructor.
 SynchronizedTileCache::SynchronizedTileCache(TileCache& cache, std::mutex& mutex)
     : cache_(cache), mutex_ref_(mutex) {
@@ -127,6 +231,12 @@ void SynchronizedTileCache::Clear() {
   cache_.Clear();
 }
 
+// Brings the cache back within its limit if it is over committed.
+void SynchronizedTileCache::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_ref_);
+  cache_.Trim();
+}
+
 // Get a pointer to a graph tile object given a GraphId.
 const GraphTile* SynchronizedTileCache::Get(const GraphId& graphid) const {
   std::lock_guard<std::mutex> lock(mutex_ref_);
@@ -140,21 +250,193 @@ SynchronizedTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t
   return cache_.Put(graphid, tile, size);
 }
 
+// The table of published tiles along with the per shard write state
+struct ConcurrentTileCache::shared_state_t {
+  using slot_t = std::atomic<const GraphTile*>;
+
+  // One lazily allocated table of slots per hierarchy level
+  struct level_t {
+    std::atomic<slot_t*> slots;
+    uint32_t tile_count;
+  };
+
+  // Writers to slots hashing to the same shard are serialized
+  struct shard_t {
+    std::mutex mutex;
+    std::vector<slot_t*> filled;
+    size_t size;
+  };
+
+  shared_state_t(size_t max_size)
+      : cache_size(0), max_cache_size(max_size), max_level(TileHierarchy::get_max_level()),
+        levels(new level_t[max_level + 1]) {
+    for (uint32_t i = 0; i <= max_level; ++i) {
+      levels[i].slots.store(nullptr);
+      levels[i].tile_count = 0;
+    }
+    for (const auto& level : TileHierarchy::levels()) {
+      levels[level.first].tile_count = level.second.tiles.TileCount();
+    }
+    const auto& transit_level = TileHierarchy::GetTransitLevel();
+    levels[transit_level.level].tile_count = transit_level.tiles.TileCount();
+    for (auto& shard : shards) {
+      shard.size = 0;
+    }
+  }
+
+  ~shared_state_t() {
+    clear();
+    for (uint32_t i = 0; i <= max_level; ++i) {
+      delete[] levels[i].slots.load();
+    }
+  }
+
+  // Get the slot for this tile, allocating the level's table if asked to
+  slot_t* slot(const GraphId& graphid, bool create) const {
+    if (graphid.level() > max_level) {
+      return nullptr;
+    }
+    auto& level = levels[graphid.level()];
+    if (graphid.tileid() >= level.tile_count) {
+      return nullptr;
+    }
+    auto* slots = level.slots.load(std::memory_order_acquire);
+    if (!slots && create) {
+      // Several writers may race to allocate the table, only one wins
+      auto* allocated = new slot_t[level.tile_count];
+      for (uint32_t i = 0; i < level.tile_count; ++i) {
+        allocated[i].store(nullptr, std::memory_order_relaxed);
+      }
+      if (level.slots.compare_exchange_strong(slots, allocated, std::memory_order_acq_rel)) {
+        slots = allocated;
+      } else {
+        delete[] allocated;
+      }
+    }
+    return slots ? slots + graphid.tileid() : nullptr;
+  }
+
+  shard_t& shard(const GraphId& graphid) {
+    return shards[(graphid.tileid() + graphid.level()) % CONCURRENT_CACHE_SHARDS];
+  }
+
+  // Unpublish and free all the tiles
+  void clear() {
+    for (auto& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (auto* s : shard.filled) {
+        delete s->exchange(nullptr, std::memory_order_acq_rel);
+      }
+      shard.filled.clear();
+      cache_size.fetch_sub(shard.size);
+      shard.size = 0;
+    }
+  }
+
+  std::atomic<size_t> cache_size;
+  size_t max_cache_size;
+  uint32_t max_level;
+  std::unique_ptr<level_t[]> levels;
+  shard_t shards[CONCURRENT_CACHE_SHARDS];
+};
+
+// Constructor.
+ConcurrentTileCache::ConcurrentTileCache(size_t max_size)
+    : state_(std::make_shared<shared_state_t>(max_size)) {
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void ConcurrentTileCache::Reserve(size_t tile_size) {
+  // The tables are sized according to the tile hierarchy instead
+}
+
+// Checks if tile exists in the cache.
+bool ConcurrentTileCache::Contains(const GraphId& graphid) const {
+  return Get(graphid) != nullptr;
+}
+
+// Lets you know if the cache is too large.
+bool ConcurrentTileCache::OverCommitted() const {
+  return state_->max_cache_size < state_->cache_size.load(std::memory_order_relaxed);
+}
+
+// Clears the cache.
+void ConcurrentTileCache::Clear() {
+  state_->clear();
+}
+
+// Clears the cache if it is over committed.
+void ConcurrentTileCache::Trim() {
+  if (OverCommitted()) {
+    Clear();
+  }
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+const GraphTile* ConcurrentTileCache::Get(const GraphId& graphid) const {
+  auto* slot = state_->slot(graphid, false);
+  return slot ? slot->load(std::memory_order_acquire) : nullptr;
+}
+
+// Puts a copy of a tile of into the cache.
+const GraphTile*
+ConcurrentTileCache::Put(const GraphId& graphid, const GraphTile& tile, size_t size) {
+  auto* slot = state_->slot(graphid, true);
+  if (!slot) {
+    return nullptr;
+  }
+
+  // Someone else may have beaten us to it
+  auto& shard = state_->shard(graphid);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (const auto* cached = slot->load(std::memory_order_acquire)) {
+    return cached;
+  }
+
+  // Publish a copy for the readers
+  const auto* cached = new GraphTile(tile);
+  slot->store(cached, std::memory_order_release);
+  shard.filled.push_back(slot);
+  shard.size += size;
+  state_->cache_size.fetch_add(size);
+  return cached;
+}
+
 // Constructs tile cache.
 TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree& pt) {
   static std::mutex globalCacheMutex_;
   static std::shared_ptr<TileCache> globalTileCache_;
+  static std::shared_ptr<ConcurrentTileCache> globalConcurrentTileCache_;
 
   size_t max_cache_size = pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE);
+  bool use_lru = pt.get<bool>("use_lru_mem_cache", false);
+  auto mem_control = pt.get<bool>("lru_mem_cache_hard_control", false)
+                         ? TileCacheLRU::MemoryLimitControl::HARD
+                         : TileCacheLRU::MemoryLimitControl::SOFT;
 
   // wrap tile cache with thread-safe version
   if (pt.get<bool>("global_synchronized_cache", false)) {
+    std::lock_guard<std::mutex> lock(globalCacheMutex_);
+    // or share one that doesnt need locking to read from
+    if (pt.get<bool>("lock_free_cache", false)) {
+      if (!globalConcurrentTileCache_) {
+        globalConcurrentTileCache_.reset(new ConcurrentTileCache(max_cache_size));
+      }
+      return new ConcurrentTileCache(*globalConcurrentTileCache_);
+    }
     if (!globalTileCache_) {
-      globalTileCache_.reset(new SimpleTileCache(max_cache_size));
+      globalTileCache_.reset(use_lru ? static_cast<TileCache*>(new TileCacheLRU(max_cache_size,
+                                                                                mem_control))
+                                     : new SimpleTileCache(max_cache_size));
     }
     return new SynchronizedTileCache(*globalTileCache_, globalCacheMutex_);
   }
 
+  // evict least recently used tiles instead of clearing everything
+  if (use_lru) {
+    return new TileCacheLRU(max_cache_size, mem_control);
+  }
+
   // default
   return new SimpleTileCache(max_cache_size);
 }
@@ -162,10 +444,21 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 // Constructor using separate tile files
 GraphReader::GraphReader(const boost::property_tree::ptree& pt)
     : tile_url_(pt.get<std::string>("tile_url", "")), tile_dir_(pt.get<std::string>("tile_dir")),
-      tile_extract_(get_extract_instance(pt)), cache_(TileCacheFactory::createTileCache(pt)) {
+      mmap_tiles_(pt.get<bool>("mmap_tiles", false)),
+      log_tile_loads_(pt.get<bool>("log_tile_loads", false)),
+      tile_extract_(get_extract_instance(pt)),
+      cache_(TileCacheFactory::createTileCache(pt)) {
   // Reserve cache (based on whether using individual tile files or shared,
   // mmap'd file
   cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+
+  // Load tiles from the tile_dir in the background, the extract is already in memory
+  size_t prefetch_threads = pt.get<size_t>("prefetch_threads", 0);
+  if (prefetch_threads > 0 && tile_extract_->tiles.empty()) {
+    prefetcher_.reset(new TilePrefetcher(tile_dir_, mmap_tiles_, prefetch_threads,
+                                         pt.get<size_t>("prefetch_max_tiles",
+                                                        DEFAULT_PREFETCH_MAX_TILES)));
+  }
 }
 
 // Method to test if tile exists
@@ -208,7 +501,8 @@ bool GraphReader::DoesTileExist(const boost::property_tree::ptree& pt, const Gra
 // Get a pointer to a graph tile object given a GraphId. Return nullptr
 // if the tile is not found/empty
 const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
-  // TODO: clear the cache automatically once we become overcommitted by a certain amount
+  // NOTE: keeping the cache within its limits is left to the cache. The LRU cache with hard
+  // memory control evicts during Put, otherwise callers should Trim in between requests
 
   // Return nullptr if not a valid tile
   if (!graphid.Is_Valid()) {
@@ -221,43 +515,236 @@ const GraphTile* GraphReader::GetGraphTile(const GraphId& graphid) {
     return cached;
   }
 
+  // Keep a copy in the cache and return it
+  GraphTile tile;
+  size_t size = 0;
+  if (!LoadGraphTile(base, tile, size)) {
+    return nullptr;
+  }
+  auto inserted = cache_->Put(base, tile, size);
+  if (log_tile_loads_) {
+    midgard::logging::Log(kTileLoadPrefix + TileListEntry(base), " [ANALYTICS] ");
+  }
+  if (prefetcher_) {
+    PrefetchNeighbors(base);
+  }
+  return inserted;
+}
+
+// Loads a tile which is not in the cache, without adding it to the cache
+bool GraphReader::LoadGraphTile(const GraphId& base, GraphTile& tile, size_t& size) {
   // Try getting it from the memmapped tar extract
   if (!tile_extract_->tiles.empty()) {
     // Do we have this tile
     auto t = tile_extract_->tiles.find(base);
     if (t == tile_extract_->tiles.cend()) {
-      return nullptr;
-    }
-
-    // This initializes the tile from mmap
-    GraphTile tile(base, t->second.first, t->second.second);
-    if (!tile.header()) {
-      return nullptr;
+      return false;
     }
 
-    // Keep a copy in the cache and return it
-    size_t size = AVERAGE_MM_TILE_SIZE; // tile.end_offset();  // TODO what size??
-    auto inserted = cache_->Put(base, tile, size);
-    return inserted;
+    // This initializes the tile from mmap. The tile data lives in the extract which is
+    // mapped once for everyone so the cache only pays for the tile object itself
+    tile = GraphTile(base, t->second.first, t->second.second);
+    size = sizeof(GraphTile);
+    return tile.header() != nullptr;
   } // Try getting it from flat file
   else {
-    // This reads the tile from disk
-    GraphTile tile(tile_dir_, base);
+    // This reads the tile from disk or maps it, unless it was loaded in the background
+    if (!prefetcher_ || !prefetcher_->Take(base, tile)) {
+      tile = GraphTile(tile_dir_, base, mmap_tiles_);
+    }
     if (!tile.header()) {
       if (tile_url_.empty() || _404s.find(base) != _404s.end()) {
-        return nullptr;
+        return false;
       }
       tile = GraphTile(tile_url_, base, curler);
       if (!tile.header()) {
         _404s.insert(base);
-        return nullptr;
+        return false;
+      }
+    }
+
+    // Mapped tiles are unmapped when evicted so their size still counts towards the limit,
+    // this also bounds the number of mappings we keep
+    size = tile.header()->end_offset();
+    return true;
+  }
+}
+
+// Gets the tiles to load before taking requests
+std::vector<GraphId> GraphReader::GetPreloadTiles(const boost::property_tree::ptree& pt) const {
+  std::vector<GraphId> tiles;
+  auto preload = pt.get_child_optional("preload");
+  if (!preload) {
+    return tiles;
+  }
+  std::unordered_set<GraphId> seen;
+  auto add = [&tiles, &seen](const GraphId& id) {
+    if (id.Is_Valid() && seen.insert(id).second) {
+      tiles.push_back(id);
+    }
+  };
+
+  // The recorded hot tiles first, they are listed the most used first
+  auto tile_list = preload->get<std::string>("tile_list", "");
+  if (!tile_list.empty()) {
+    std::ifstream file(tile_list);
+    if (!file.is_open()) {
+      throw std::runtime_error("Could not open preload tile list " + tile_list);
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+      auto slash = line.find('/');
+      if (line.empty() || line.front() == '#' || slash == std::string::npos) {
+        continue;
+      }
+      try {
+        auto level = std::stoul(line.substr(0, slash));
+        auto tileid = std::stoul(line.substr(slash + 1));
+        if (level <= TileHierarchy::get_max_level()) {
+          add({static_cast<uint32_t>(tileid), static_cast<uint32_t>(level), 0});
+        }
+      } catch (...) { LOG_WARN("Skipping invalid preload tile " + line); }
+    }
+  }
+
+  // Then whole levels, sorted so the tiles are read in directory order
+  if (auto levels = preload->get_child_optional("levels")) {
+    for (const auto& level : *levels) {
+      auto tile_set = GetTileSet(static_cast<uint8_t>(level.second.get_value<uint32_t>()));
+      std::vector<GraphId> level_tiles(tile_set.begin(), tile_set.end());
+      std::sort(level_tiles.begin(), level_tiles.end());
+      for (const auto& id : level_tiles) {
+        add(id);
+      }
+    }
+  }
+
+  // Then the area on every level
+  auto bbox = preload->get<std::string>("bbox", "");
+  if (!bbox.empty()) {
+    float minx, miny, maxx, maxy;
+    char c1, c2, c3;
+    std::istringstream ss(bbox);
+    if (!(ss >> minx >> c1 >> miny >> c2 >> maxx >> c3 >> maxy) || c1 != ',' || c2 != ',' ||
+        c3 != ',') {
+      throw std::runtime_error("Preload bbox should be minx,miny,maxx,maxy not " + bbox);
+    }
+    AABB2<PointLL> box(minx, miny, maxx, maxy);
+    for (const auto& level : TileHierarchy::levels()) {
+      for (auto id : level.second.tiles.TileList(box)) {
+        GraphId tile(static_cast<uint32_t>(id), level.first, 0);
+        if (DoesTileExist(tile)) {
+          add(tile);
+        }
+      }
+    }
+  }
+  return tiles;
+}
+
+// Loads tiles into the cache, stopping before they take up more than the given size
+size_t GraphReader::Preload(const std::vector<GraphId>& tiles, size_t max_size, size_t& size) {
+  // Tiles are only put in the cache once they are known to fit, they aren't loaded by
+  // requests so they don't belong in the recorded hot tile set either
+  size = 0;
+  size_t count = 0;
+  for (const auto& id : tiles) {
+    auto base = id.Tile_Base();
+    GraphTile tile;
+    size_t tile_size = 0;
+    const GraphTile* cached = cache_->Get(base);
+    if (cached) {
+      tile_size =
+          tile_extract_->tiles.empty() ? cached->header()->end_offset() : sizeof(GraphTile);
+    } else if (!LoadGraphTile(base, tile, tile_size)) {
+      continue;
+    }
+    if (size + tile_size > max_size) {
+      break;
+    }
+    if (!cached) {
+      cache_->Put(base, tile, tile_size);
+    }
+    size += tile_size;
+    ++count;
+  }
+  return count;
+}
+
+// Warms the cache with the tiles configured in the preload section
+void GraphReader::Preload(const boost::property_tree::ptree& pt) {
+  auto start = std::chrono::steady_clock::now();
+  auto tiles = GetPreloadTiles(pt);
+  if (tiles.empty()) {
+    return;
+  }
+  size_t max_size = pt.get<size_t>("preload.max_size",
+                                   pt.get<size_t>("max_cache_size", DEFAULT_MAX_CACHE_SIZE) *
+                                       DEFAULT_PRELOAD_CACHE_FRACTION);
+  size_t size = 0;
+  auto count = Preload(tiles, max_size, size);
+  std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+  LOG_INFO("Preloaded " + std::to_string(count) + " of " + std::to_string(tiles.size()) +
+           " tiles taking up " + std::to_string(size / 1048576) + " MB in " +
+           std::to_string(elapsed.count()) + " seconds");
+}
+
+// Requests the tiles a route between two areas is likely to expand into
+void GraphReader::PrefetchCorridor(const AABB2<PointLL>& origin,
+                                   const AABB2<PointLL>& destination) {
+  if (!prefetcher_) {
+    return;
+  }
+
+  // Expansions start on the local level so request those tiles first
+  const auto& levels = TileHierarchy::levels();
+  for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+    const auto& tiles = level->second.tiles;
+    const float half = tiles.TileSize() / 2.0f;
+
+    // Below the highway level expansions stay around the ends of the route
+    std::vector<AABB2<PointLL>> boxes;
+    if (level->first != levels.begin()->first) {
+      boxes = {origin, destination};
+    } // On the highway level they go along the whole route, so take the tiles along the line
+    else {
+      // between the areas and a tile to either side. Alternate between both ends like a
+      // bidirectional expansion would
+      const auto a = origin.Center();
+      const auto b = destination.Center();
+      const float length = std::hypot(b.lng() - a.lng(), b.lat() - a.lat());
+      const int32_t steps = static_cast<int32_t>(std::ceil(length / half));
+      for (int32_t i = 0, j = steps; i <= j; ++i, --j) {
+        for (auto k : {i, j}) {
+          const float t = steps > 0 ? static_cast<float>(k) / steps : 0.0f;
+          const PointLL p(a.lng() + (b.lng() - a.lng()) * t, a.lat() + (b.lat() - a.lat()) * t);
+          boxes.emplace_back(p.lng() - half, p.lat() - half, p.lng() + half, p.lat() + half);
+        }
       }
     }
 
-    // Keep a copy in the cache and return it
-    size_t size = tile.header()->end_offset();
-    auto inserted = cache_->Put(base, tile, size);
-    return inserted;
+    for (const auto& box : boxes) {
+      for (auto id : tiles.TileList(box)) {
+        Prefetch({static_cast<uint32_t>(id), level->first, 0});
+      }
+    }
+  }
+}
+
+// Requests the tiles around a tile on the same level
+void GraphReader::PrefetchNeighbors(const GraphId& graphid) {
+  const auto level = TileHierarchy::levels().find(graphid.level());
+  if (level == TileHierarchy::levels().end()) {
+    return;
+  }
+  const auto& tiles = level->second.tiles;
+  const float half = tiles.TileSize() / 2.0f;
+  auto box = tiles.TileBounds(graphid.tileid());
+  box = {box.minx() - half, box.miny() - half, box.maxx() + half, box.maxy() + half};
+  for (auto id : tiles.TileList(box)) {
+    if (static_cast<uint32_t>(id) != graphid.tileid()) {
+      Prefetch({static_cast<uint32_t>(id), graphid.level(), 0});
+    }
   }
 }
 
@@ -5,6 +5,7 @@
 #include "midgard/aabb2.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
+#include "midgard/sequence.h"
 #include "midgard/tiles.h"
 
 #include <boost/algorithm/string.hpp>
@@ -51,16 +52,33 @@ GraphTile::GraphTile()
       lane_connectivity_(nullptr), lane_connectivity_size_(0), edge_elevation_(nullptr) {
 }
 
-// Constructor given a filename. Reads the graph data into memory.
-GraphTile::GraphTile(const std::string& tile_dir, const GraphId& graphid) : header_(nullptr) {
+// Constructor given a filename. Reads the graph data into memory or maps it.
+GraphTile::GraphTile(const std::string& tile_dir, const GraphId& graphid, bool memory_map)
+    : header_(nullptr) {
 
   // Don't bother with invalid ids
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
     return;
   }
 
-  // Open to the end of the file so we can immediately get size;
+  // Try to map the uncompressed file, any failure falls back to reading it
   std::string file_location = tile_dir + filesystem::path_separator + FileSuffix(graphid.Tile_Base());
+  if (memory_map) {
+    struct stat s;
+    if (stat(file_location.c_str(), &s) == 0 && s.st_size > 0) {
+      try {
+        memory_map_ = std::make_shared<midgard::mem_map<char>>(file_location, s.st_size,
+                                                              POSIX_MADV_NORMAL, true);
+        Initialize(graphid, memory_map_->get(), memory_map_->size());
+        return;
+      } catch (const std::exception& e) {
+        memory_map_.reset();
+        LOG_WARN("Tile " + file_location + " could not be memory mapped: " + e.what());
+      }
+    }
+  }
+
+  // Open to the end of the file so we can immediately get size;
   std::ifstream file(file_location, std::ios::in | std::ios::binary | std::ios::ate);
   if (file.is_open()) {
     // Read binary file into memory. TODO - protect against failure to
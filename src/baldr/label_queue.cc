@@ -0,0 +1,34 @@
+#include "baldr/label_queue.h"
+#include "baldr/double_bucket_queue.h"
+#include "baldr/radix_queue.h"
+
+#include <stdexcept>
+
+namespace valhalla {
+namespace baldr {
+
+// Get the type of label queue given its name in the configuration.
+LabelQueueType LabelQueueFactory::type(const std::string& name) {
+  if (name == "double_bucket") {
+    return LabelQueueType::kDoubleBucket;
+  }
+  if (name == "radix") {
+    return LabelQueueType::kRadix;
+  }
+  throw std::runtime_error("Unknown label queue type: " + name);
+}
+
+// Constructs a label queue.
+LabelQueue* LabelQueueFactory::createLabelQueue(const LabelQueueType type,
+                                                const float mincost,
+                                                const float range,
+                                                const uint32_t bucketsize,
+                                                const LabelCost& labelcost) {
+  if (type == LabelQueueType::kRadix) {
+    return new RadixQueue(mincost, range, bucketsize, labelcost);
+  }
+  return new DoubleBucketQueue(mincost, range, bucketsize, labelcost);
+}
+
+} // namespace baldr
+} // namespace valhalla
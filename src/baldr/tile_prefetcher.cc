@@ -0,0 +1,151 @@
+#include "baldr/tile_prefetcher.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace valhalla {
+namespace baldr {
+
+// Constructor. Starts the threads.
+TilePrefetcher::TilePrefetcher(const std::string& tile_dir,
+                               bool memory_map,
+                               size_t thread_count,
+                               size_t max_tiles)
+    : tile_dir_(tile_dir), memory_map_(memory_map), max_tiles_(std::max(max_tiles, size_t(1))),
+      sequence_(0), stop_(false) {
+  tiles_.reserve(max_tiles_);
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back(&TilePrefetcher::Load, this);
+  }
+}
+
+// Destructor. Stops the threads.
+TilePrefetcher::~TilePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  requested_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+// Requests a tile to be loaded in the background.
+void TilePrefetcher::Prefetch(const GraphId& graphid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tiles_.find(graphid) != tiles_.end()) {
+      return;
+    }
+    if (tiles_.size() >= max_tiles_ && !Evict()) {
+      return;
+    }
+    tiles_.emplace(graphid, entry_t{State::kQueued, ++sequence_, {}});
+    queue_.push_back(graphid);
+  }
+  requested_.notify_one();
+}
+
+// Takes a tile which was requested, waiting for it if it is being loaded.
+bool TilePrefetcher::Take(const GraphId& graphid, GraphTile& tile) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto entry = tiles_.find(graphid);
+  if (entry == tiles_.end()) {
+    return false;
+  }
+
+  // Nobody started on it so its quicker to load it ourselves than to wait
+  if (entry->second.state == State::kQueued) {
+    tiles_.erase(entry);
+    return false;
+  }
+
+  // If it fails to load the entry is dropped and we have to load it ourselves
+  loaded_.wait(lock, [this, &graphid, &entry]() {
+    entry = tiles_.find(graphid);
+    return entry == tiles_.end() || entry->second.state == State::kLoaded;
+  });
+  if (entry == tiles_.end()) {
+    return false;
+  }
+  tile = entry->second.tile;
+  tiles_.erase(entry);
+  return true;
+}
+
+// Drops all the requested and loaded tiles.
+void TilePrefetcher::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tiles_.clear();
+  queue_.clear();
+}
+
+// Gets the number of tiles requested and not yet taken.
+size_t TilePrefetcher::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tiles_.size();
+}
+
+// Loads the requested tiles until the prefetcher is destroyed.
+void TilePrefetcher::Load() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    requested_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+
+    // Skip ids that were taken or dropped since they were requested
+    const GraphId graphid = queue_.front();
+    queue_.pop_front();
+    auto entry = tiles_.find(graphid);
+    if (entry == tiles_.end() || entry->second.state != State::kQueued) {
+      continue;
+    }
+    entry->second.state = State::kLoading;
+    const auto sequence = entry->second.sequence;
+    lock.unlock();
+
+    // This reads the tile from disk or maps it, without the lock
+    GraphTile tile;
+    bool loaded = true;
+    try {
+      tile = GraphTile(tile_dir_, graphid, memory_map_);
+    } catch (...) { loaded = false; }
+
+    // Unless the tile was dropped in the mean time, hand it over. If loading
+    // it failed the owner loads it again itself so it sees the same error
+    lock.lock();
+    entry = tiles_.find(graphid);
+    if (entry != tiles_.end() && entry->second.sequence == sequence) {
+      if (loaded) {
+        entry->second.tile = tile;
+        entry->second.state = State::kLoaded;
+      } else {
+        tiles_.erase(entry);
+      }
+      loaded_.notify_all();
+    }
+  }
+}
+
+// Drops the tile requested the longest time ago which is not being loaded.
+bool TilePrefetcher::Evict() {
+  auto oldest = tiles_.end();
+  uint64_t sequence = std::numeric_limits<uint64_t>::max();
+  for (auto entry = tiles_.begin(); entry != tiles_.end(); ++entry) {
+    if (entry->second.state != State::kLoading && entry->second.sequence < sequence) {
+      oldest = entry;
+      sequence = entry->second.sequence;
+    }
+  }
+  if (oldest == tiles_.end()) {
+    return false;
+  }
+  tiles_.erase(oldest);
+  return true;
+}
+
+} // namespace baldr
+} // namespace valhalla
@@ -5,6 +5,7 @@
 #include <boost/make_shared.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
+#include <boost/python/stl_iterator.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/shared_ptr.hpp>
@@ -53,6 +54,34 @@ void py_configure(const std::string& config_file) {
   configure(config_file);
 }
 
+// matches the traces of any python iterable, only pulling the next trace when a thread is free.
+// results are passed to the callback in the order of the traces or, without one, returned as a list
+boost::python::object match_batch(valhalla::meili::TrafficSegmentMatcher& matcher,
+                                  const boost::python::object& traces,
+                                  const uint32_t concurrency,
+                                  const boost::python::object& callback) {
+  boost::python::stl_input_iterator<std::string> trace(traces), end;
+  boost::python::list results;
+  matcher.match_batch(
+      [&](std::string& json) {
+        if (trace == end) {
+          return false;
+        }
+        json = *trace;
+        ++trace;
+        return true;
+      },
+      [&](const std::string& result) {
+        if (callback.is_none()) {
+          results.append(result);
+        } else {
+          callback(result);
+        }
+      },
+      concurrency);
+  return callback.is_none() ? boost::python::object(results) : boost::python::object();
+}
+
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(route_overloads, route, 1, 1);
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(locate_overloads, locate, 1, 1);
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(optimized_route_overloads, optimized_route, 1, 1);
@@ -77,7 +106,10 @@ BOOST_PYTHON_MODULE(valhalla) {
       .def("__init__", boost::python::make_constructor(+[]() {
              return boost::make_shared<valhalla::meili::TrafficSegmentMatcher>(configure());
            }))
-      .def("Match", &valhalla::meili::TrafficSegmentMatcher::match);
+      .def("Match", &valhalla::meili::TrafficSegmentMatcher::match)
+      .def("MatchBatch", &match_batch,
+           (boost::python::arg("traces"), boost::python::arg("concurrency") = 1,
+            boost::python::arg("callback") = boost::python::object()));
 
   boost::python::class_<valhalla::tyr::actor_t, boost::noncopyable,
                         boost::shared_ptr<valhalla::tyr::actor_t>>("Actor", boost::python::no_init)
@@ -201,12 +201,13 @@ loki_worker_t::loki_worker_t(const boost::property_tree::ptree& config)
 
   // Register standard edge/node costing methods
   factory.RegisterStandardCostingModels();
+
+  // Warm the tile cache before taking any requests
+  reader.Preload(config.get_child("mjolnir"));
 }
 
 void loki_worker_t::cleanup() {
-  if (reader.OverCommitted()) {
-    reader.Clear();
-  }
+  reader.Trim();
 }
 
 #ifdef HAVE_HTTP
@@ -251,7 +252,7 @@ worker_t::result_t loki_worker_t::work(const std::list<zmq::message_t>& job,
     switch (request.options.action()) {
       case odin::DirectionsOptions::route:
         route(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
+        result.messages.emplace_back(request.downstream_document());
         result.messages.emplace_back(request.options.SerializeAsString());
         break;
       case odin::DirectionsOptions::locate:
@@ -260,18 +261,18 @@ worker_t::result_t loki_worker_t::work(const std::list<zmq::message_t>& job,
       case odin::DirectionsOptions::sources_to_targets:
       case odin::DirectionsOptions::optimized_route:
         matrix(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
+        result.messages.emplace_back(request.downstream_document());
         result.messages.emplace_back(request.options.SerializeAsString());
         break;
       case odin::DirectionsOptions::isochrone:
         isochrones(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
+        result.messages.emplace_back(request.downstream_document());
         result.messages.emplace_back(request.options.SerializeAsString());
         break;
       case odin::DirectionsOptions::trace_attributes:
       case odin::DirectionsOptions::trace_route:
         trace(request);
-        result.messages.emplace_back(rapidjson::to_string(request.document));
+        result.messages.emplace_back(request.downstream_document());
         result.messages.emplace_back(request.options.SerializeAsString());
         break;
       case odin::DirectionsOptions::height:
@@ -290,7 +290,9 @@ MapMatcher::MapMatcher(const boost::property_tree::ptree& config,
                        baldr::GraphReader& graphreader,
                        CandidateQuery& candidatequery,
                        const sif::cost_ptr_t* mode_costing,
-                       sif::TravelMode travelmode)
+                       sif::TravelMode travelmode,
+                       TransitionCache* transition_cache,
+                       uint64_t costing_hash)
     : config_(config), graphreader_(graphreader), candidatequery_(candidatequery),
       mode_costing_(mode_costing), travelmode_(travelmode), interrupt_(nullptr), vs_(), ts_(vs_),
       container_(), emission_cost_model_(graphreader_, container_, config_),
@@ -301,6 +303,7 @@ MapMatcher::MapMatcher(const boost::property_tree::ptree& config,
                              mode_costing_,
                              travelmode_,
                              config_) {
+  transition_cost_model_.set_cache(transition_cache, costing_hash);
   vs_.set_emission_cost_model(emission_cost_model_);
   vs_.set_transition_cost_model(transition_cost_model_);
 }
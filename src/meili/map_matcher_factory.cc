@@ -1,5 +1,8 @@
+#include <sstream>
 #include <string>
 
+#include <boost/property_tree/json_parser.hpp>
+
 #include "baldr/graphreader.h"
 #include "baldr/tilehierarchy.h"
 #include "sif/autocost.h"
@@ -31,7 +34,8 @@ MapMatcherFactory::MapMatcherFactory(const boost::property_tree::ptree& root)
       candidatequery_(graphreader_,
                       local_tile_size() / root.get<size_t>("meili.grid.size"),
                       local_tile_size() / root.get<size_t>("meili.grid.size")),
-      max_grid_cache_size_(root.get<float>("meili.grid.cache_size")) {
+      max_grid_cache_size_(root.get<float>("meili.grid.cache_size")),
+      transition_cache_(root.get<size_t>("meili.transition_cache_size", 0)) {
   cost_factory_.RegisterStandardCostingModels();
   cost_factory_.Register("multimodal", CreateUniversalCost);
 }
@@ -66,8 +70,22 @@ MapMatcher* MapMatcherFactory::Create(const std::string& costing,
 
   mode_costing_[static_cast<uint32_t>(mode)] = cost;
 
+  // Matchers share the cached paths of the same costing, costing options and
+  // turn penalty factor, which adds to the cost of the turns along them
+  TransitionCache* transition_cache = nullptr;
+  uint64_t costing_hash = 0;
+  if (transition_cache_.max_size() > 0) {
+    std::stringstream options;
+    const auto costing_options = preferences.get_child("costing_options." + costing, {});
+    boost::property_tree::write_json(options, costing_options, false);
+    options << config.get<float>("turn_penalty_factor");
+    transition_cache = &transition_cache_;
+    costing_hash = std::hash<std::string>()(costing + options.str());
+  }
+
   // TODO investigate exception safety
-  return new MapMatcher(config, graphreader_, candidatequery_, mode_costing_, mode);
+  return new MapMatcher(config, graphreader_, candidatequery_, mode_costing_, mode,
+                        transition_cache, costing_hash);
 }
 
 boost::property_tree::ptree
@@ -120,9 +138,7 @@ sif::cost_ptr_t MapMatcherFactory::get_costing(const boost::property_tree::ptree
 }
 
 void MapMatcherFactory::ClearFullCache() {
-  if (graphreader_.OverCommitted()) {
-    graphreader_.Clear();
-  }
+  graphreader_.Trim();
 
   if (candidatequery_.size() > max_grid_cache_size_) {
     candidatequery_.Clear();
@@ -132,6 +148,7 @@ void MapMatcherFactory::ClearFullCache() {
 void MapMatcherFactory::ClearCache() {
   graphreader_.Clear();
   candidatequery_.Clear();
+  transition_cache_.Clear();
 }
 
 } // namespace meili
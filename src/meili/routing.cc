@@ -36,17 +36,16 @@ void LabelSet::put(const baldr::GraphId& nodeid,
 
   // Find the node Id. If not found, create a new label and push
   // it to the queue
-  const auto it = node_status_.find(nodeid);
-  if (it == node_status_.end()) {
-    const uint32_t idx = labels_.size();
+  const uint32_t idx = labels_.size();
+  const auto added = node_status_.emplace(nodeid.value, idx);
+  if (added.second) {
     labels_.emplace_back(nodeid, kInvalidDestination, edgeid, source, target, cost, turn_cost,
                          sortcost, predecessor, edge, mode);
     queue_->add(idx);
-    node_status_.emplace(nodeid, idx);
   } else {
     // Node has been found. Check if there is a lower sortcost than the
     // existing label - if so update priority queue and Label
-    const auto& status = it->second;
+    const auto& status = *added.first;
     if (!status.permanent && sortcost < labels_[status.label_idx].sortcost()) {
       // Update queue first since it uses the label cost within the decrease
       // method to determine the current bucket.
@@ -104,15 +103,15 @@ uint32_t LabelSet::pop() {
   if (idx != baldr::kInvalidLabel) {
     const auto& label = labels_[idx];
     if (label.nodeid().Is_Valid()) {
-      const auto it = node_status_.find(label.nodeid());
+      auto* it = node_status_.find(label.nodeid().value);
 
       // When these logic errors happen, go check LabelSet::put
-      if (it == node_status_.end()) {
+      if (it == nullptr) {
         // No exception, unless BucketQueue::put was wrong: it said it
         // added but actually failed
         throw std::logic_error("all nodes in the queue should have its status");
       }
-      auto& status = it->second;
+      auto& status = *it;
       if (status.label_idx != idx) {
         throw std::logic_error(
             "the index stored in the node status " + std::to_string(status.label_idx) +
@@ -590,6 +589,178 @@ find_shortest_path(baldr::GraphReader& reader,
   return results;
 }
 
+/**
+ * Get the cost of leaving the origin along one of its edges.
+ */
+bool leave_origin(baldr::GraphReader& reader,
+                  const baldr::PathLocation::PathEdge& origin,
+                  const Label& origin_label,
+                  sif::cost_ptr_t costing,
+                  const float turn_cost_table[181],
+                  const float max_dist,
+                  const float max_time,
+                  sif::Cost& cost,
+                  float& turn_cost) {
+  // Skip if edge is not allowed
+  const baldr::GraphTile* tile = nullptr;
+  const auto directededge = reader.directededge(origin.id, tile);
+  if (!directededge || !IsEdgeAllowed(directededge, origin.id, costing, origin_label, tile)) {
+    return false;
+  }
+
+  // U-turn cost
+  turn_cost = origin_label.turn_cost();
+  if (origin_label.edgeid().Is_Valid() && origin_label.edgeid() != origin.id &&
+      origin_label.opp_local_idx() == directededge->localedgeidx()) {
+    turn_cost += turn_cost_table[0];
+  }
+
+  // Get cost to the end node and check that it is within the limits
+  float f = (1.0f - origin.percent_along);
+  cost = {origin_label.cost().cost + directededge->length() * f,
+          origin_label.cost().secs + costing->EdgeCost(directededge).secs * f};
+  return cost.cost < max_dist && (max_time < 0 || cost.secs < max_time) &&
+         reader.GetEndNode(directededge, tile) != nullptr;
+}
+
+/**
+ * Follow a path found by an earlier search from an origin edge to a
+ * destination edge. Costs are added up in the same order as in
+ * find_shortest_path so they come out the same. The path was the shortest
+ * one, so going over the distance limit anywhere along it means no path is
+ * within the limit. It need not be the only path within the time limit though.
+ */
+PathStatus follow_path(baldr::GraphReader& reader,
+                       const baldr::PathLocation::PathEdge& origin,
+                       const baldr::PathLocation::PathEdge& destination,
+                       const uint16_t dest,
+                       const TransitionCache::path_t* path,
+                       labelset_ptr_t labelset,
+                       const uint32_t origin_label_idx,
+                       sif::cost_ptr_t costing,
+                       const float turn_cost_table[181],
+                       const float max_dist,
+                       const float max_time,
+                       uint32_t& label_idx) {
+  const sif::TravelMode travelmode = costing->travel_mode();
+  const auto over_time = [max_time](const sif::Cost& cost) {
+    return 0 <= max_time && max_time <= cost.secs;
+  };
+  const Label origin_label = labelset->label(origin_label_idx);
+  const baldr::GraphTile* tile = nullptr;
+  const auto* directededge = reader.directededge(origin.id, tile);
+
+  // The destination is ahead on the origin edge
+  if (origin.id == destination.id && origin.percent_along <= destination.percent_along) {
+    if (!directededge || !IsEdgeAllowed(directededge, origin.id, costing, origin_label, tile)) {
+      return PathStatus::kUnreachable;
+    }
+    float turn_cost = origin_label.turn_cost();
+    if (origin_label.edgeid().Is_Valid() && origin_label.edgeid() != origin.id &&
+        origin_label.opp_local_idx() == directededge->localedgeidx()) {
+      turn_cost += turn_cost_table[0];
+    }
+    float f = (destination.percent_along - origin.percent_along);
+    sif::Cost cost(origin_label.cost().cost + directededge->length() * f,
+                   origin_label.cost().secs + costing->EdgeCost(directededge).secs * f);
+    if (max_dist <= cost.cost) {
+      return PathStatus::kUnreachable;
+    }
+    if (over_time(cost)) {
+      return PathStatus::kUnknown;
+    }
+    label_idx = labelset->append({baldr::GraphId{}, dest, origin.id, origin.percent_along,
+                                  destination.percent_along, cost, turn_cost, cost.cost,
+                                  origin_label_idx, directededge, travelmode});
+    return PathStatus::kReached;
+  }
+
+  // Every other destination is reached through the end node of the origin edge
+  sif::Cost cost;
+  float turn_cost;
+  if (!leave_origin(reader, origin, origin_label, costing, turn_cost_table, max_dist, max_time,
+                    cost, turn_cost)) {
+    return PathStatus::kUnreachable;
+  }
+  if (path == nullptr) {
+    return PathStatus::kUnknown;
+  }
+
+  // No path was within the limits of the earlier search. The destination is
+  // no closer now if there is no more room left to go from the end node.
+  if (!path->found) {
+    const auto* dest_edge = reader.directededge(destination.id, tile);
+    if (dest_edge &&
+        max_dist - cost.cost <= path->min_cost + dest_edge->length() * destination.percent_along) {
+      return PathStatus::kUnreachable;
+    }
+    return PathStatus::kUnknown;
+  }
+
+  uint32_t pred_idx =
+      labelset->append({directededge->endnode(), kInvalidDestination, origin.id,
+                        origin.percent_along, 1.f, cost, turn_cost, cost.cost, origin_label_idx,
+                        directededge, travelmode});
+  Label label = labelset->label(pred_idx);
+  for (size_t i = 0; i <= path->edges.size(); ++i) {
+    const bool last = i == path->edges.size();
+    const baldr::GraphId& edgeid = last ? destination.id : path->edges[i];
+
+    // The edge leaves from the node of the label unless the path took a
+    // transition edge to another level
+    baldr::GraphId node = label.nodeid();
+    if (node.Tile_Base() != edgeid.Tile_Base()) {
+      directededge = reader.directededge(edgeid, tile);
+      if (!directededge) {
+        return PathStatus::kUnknown;
+      }
+      node = reader.GetDirectedEdgeNodes(tile, directededge).first;
+    }
+    tile = node.Is_Valid() ? reader.GetGraphTile(node) : nullptr;
+    if (tile == nullptr) {
+      return PathStatus::kUnknown;
+    }
+    const baldr::NodeInfo* nodeinfo = tile->node(node);
+    directededge = tile->directededge(edgeid);
+
+    // Add the turn cost based on turn degree
+    const auto inbound_hdg = get_inbound_edgelabel_heading(reader, label, nodeinfo);
+    const auto outbound_hdg = get_outbound_edge_heading(tile, directededge, nodeinfo);
+    turn_cost =
+        label.turn_cost() + turn_cost_table[midgard::get_turn_degree180(inbound_hdg, outbound_hdg)];
+
+    // End along the destination edge
+    if (last) {
+      cost = {label.cost().cost + directededge->length() * destination.percent_along,
+              label.cost().secs + costing->EdgeCost(directededge).secs * destination.percent_along};
+      if (max_dist <= cost.cost) {
+        return PathStatus::kUnreachable;
+      }
+      if (over_time(cost)) {
+        return PathStatus::kUnknown;
+      }
+      label_idx = labelset->append({baldr::GraphId{}, dest, edgeid, 0.f,
+                                    destination.percent_along, cost, turn_cost, cost.cost, pred_idx,
+                                    directededge, travelmode});
+      return PathStatus::kReached;
+    }
+
+    cost = {label.cost().cost + directededge->length(),
+            label.cost().secs + costing->EdgeCost(directededge).secs};
+    if (max_dist <= cost.cost) {
+      return PathStatus::kUnreachable;
+    }
+    if (over_time(cost) ||
+        (directededge->leaves_tile() && !reader.GetGraphTile(directededge->endnode()))) {
+      return PathStatus::kUnknown;
+    }
+    pred_idx = labelset->append({directededge->endnode(), kInvalidDestination, edgeid, 0.f, 1.f,
+                                 cost, turn_cost, cost.cost, pred_idx, directededge, travelmode});
+    label = labelset->label(pred_idx);
+  }
+  return PathStatus::kUnknown;
+}
+
 } // namespace meili
 
 } // namespace valhalla
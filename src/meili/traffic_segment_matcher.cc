@@ -1,5 +1,10 @@
 #include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #include "meili/traffic_segment_matcher.h"
 #include "midgard/logging.h"
@@ -130,10 +135,150 @@ constexpr float kQueueSpeedThreshold = 2.0f; // approx 4.3 MPH
 TrafficSegmentMatcher::TrafficSegmentMatcher(const boost::property_tree::ptree& config)
     : matcher_factory(config),
       customizable(midgard::ToSet<boost::property_tree::ptree, std::unordered_set<std::string>>(
-          config.get_child("meili.customizable"))) {
+          config.get_child("meili.customizable"))),
+      batch_config(config) {
+  batch_config.put("mjolnir.global_synchronized_cache", true);
 }
 
 std::string TrafficSegmentMatcher::match(const std::string& json) {
+  auto result = match_trace(json, matcher_factory);
+
+  // Check if we are overcommitted on either cache and and clear if needed
+  matcher_factory.ClearFullCache();
+
+  // give back json
+  return result;
+}
+
+void TrafficSegmentMatcher::match_batch(const std::function<bool(std::string&)>& next,
+                                        const std::function<void(const std::string&)>& emit,
+                                        const uint32_t concurrency) {
+  // Each thread needs its own matchers
+  const size_t thread_count = std::max(concurrency, 1u);
+  while (batch_factories.size() < thread_count) {
+    batch_factories.emplace_back(new MapMatcherFactory(batch_config));
+  }
+
+  // Traces which are read but not yet handed back, in input order. The first
+  // claimed ones have been taken by a thread. Elements of a deque stay put
+  // when others are added at the back or removed from the front.
+  struct trace_t {
+    std::string json;
+    std::string result;
+    bool done;
+  };
+  std::deque<trace_t> traces;
+  size_t claimed = 0;
+  size_t busy = 0;
+  bool finished = false;
+  std::mutex mutex;
+  std::condition_variable work, ready;
+
+  // Match traces until told there are no more
+  const auto match_traces = [&](MapMatcherFactory& factory) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      work.wait(lock, [&]() { return finished || claimed < traces.size(); });
+      if (claimed == traces.size()) {
+        return;
+      }
+      auto& trace = traces[claimed++];
+      ++busy;
+      lock.unlock();
+
+      std::string result;
+      try {
+        result = match_trace(trace.json, factory);
+      } catch (const std::exception& e) {
+        std::stringstream ss;
+        ss << *baldr::json::map({{"error", std::string(e.what())}});
+        result = ss.str();
+      } catch (...) { result = R"({"error":"Unknown error"})"; }
+
+      lock.lock();
+      trace.result = std::move(result);
+      trace.done = true;
+      --busy;
+      ready.notify_one();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back(match_traces, std::ref(*batch_factories[i]));
+  }
+
+  // Keep the threads busy with a few traces each and hand back the oldest one
+  // once it is matched. The callbacks are called without holding the lock.
+  std::exception_ptr error;
+  try {
+    const size_t window = thread_count * 4;
+    bool more = true;
+    std::string json;
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (more && traces.size() < window) {
+        lock.unlock();
+        more = next(json);
+        lock.lock();
+        if (more) {
+          traces.push_back({std::move(json), {}, false});
+          work.notify_one();
+        }
+      }
+      if (traces.empty()) {
+        break;
+      }
+
+      // Tiles may only be dropped from the shared cache while no thread uses them
+      if (batch_factories.front()->graphreader().OverCommitted()) {
+        ready.wait(lock, [&]() { return claimed == traces.size() && busy == 0; });
+        for (auto& factory : batch_factories) {
+          factory->ClearFullCache();
+        }
+      }
+
+      ready.wait(lock, [&]() { return traces.front().done; });
+      auto result = std::move(traces.front().result);
+      traces.pop_front();
+      --claimed;
+      lock.unlock();
+      emit(result);
+    }
+  } catch (...) { error = std::current_exception(); }
+
+  // Let the threads go and pass on any error of the callbacks
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  work.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+std::vector<std::string> TrafficSegmentMatcher::match_batch(const std::vector<std::string>& jsons,
+                                                            const uint32_t concurrency) {
+  std::vector<std::string> results;
+  results.reserve(jsons.size());
+  auto json = jsons.cbegin();
+  match_batch(
+      [&](std::string& trace) {
+        if (json == jsons.cend()) {
+          return false;
+        }
+        trace = *json++;
+        return true;
+      },
+      [&](const std::string& result) { results.push_back(result); }, concurrency);
+  return results;
+}
+
+std::string TrafficSegmentMatcher::match_trace(const std::string& json,
+                                               MapMatcherFactory& factory) const {
   // Try to parse json
   boost::property_tree::ptree match_config;
   auto request = parse_json(json);
@@ -142,7 +287,7 @@ std::string TrafficSegmentMatcher::match(const std::string& json) {
   std::shared_ptr<MapMatcher> matcher;
   float default_accuracy, default_search_radius;
   try {
-    matcher.reset(matcher_factory.Create(request));
+    matcher.reset(factory.Create(request));
     default_accuracy = matcher->config().get<float>("gps_accuracy");
     default_search_radius = matcher->config().get<float>("search_radius");
   } catch (...) { throw std::runtime_error("Couldn't create traffic matcher using configuration."); }
@@ -167,9 +312,6 @@ std::string TrafficSegmentMatcher::match(const std::string& json) {
   // Get the segments along the measurements
   auto traffic_segments = form_segments(interpolations, matcher->graphreader());
 
-  // Check if we are overcommitted on either cache and and clear if needed
-  matcher_factory.ClearFullCache();
-
   // give back json
   return serialize(traffic_segments);
 }
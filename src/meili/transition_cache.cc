@@ -0,0 +1,76 @@
+#include "meili/transition_cache.h"
+
+namespace valhalla {
+namespace meili {
+
+TransitionCache::TransitionCache(const size_t max_size)
+    : max_size_(max_size), hits_(0), misses_(0) {
+  index_.reserve(max_size_);
+}
+
+bool TransitionCache::Get(const key_t& key, path_t& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++misses_;
+    return false;
+  }
+
+  // Mark it as the most recently used
+  entries_.splice(entries_.begin(), entries_, it->second);
+  path = it->second->second;
+  ++hits_;
+  return true;
+}
+
+void TransitionCache::Put(const key_t& key, const path_t& path) {
+  if (max_size_ == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = index_.find(key);
+  if (it != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, it->second);
+    it->second->second = path;
+    return;
+  }
+
+  // Make room for it by dropping the least recently used path
+  if (entries_.size() >= max_size_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(key, path);
+  index_.emplace(key, entries_.begin());
+}
+
+void TransitionCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  index_.clear();
+  entries_.clear();
+}
+
+size_t TransitionCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+uint64_t TransitionCache::hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+uint64_t TransitionCache::misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+float TransitionCache::hit_rate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto lookups = hits_ + misses_;
+  return lookups ? static_cast<float>(hits_) / lookups : 0.f;
+}
+
+} // namespace meili
+} // namespace valhalla
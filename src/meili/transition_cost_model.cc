@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "meili/transition_cost_model.h"
 #include "meili/routing.h"
 
@@ -6,6 +8,40 @@ inline float GreatCircleDistance(const valhalla::meili::Measurement& left,
                                  const valhalla::meili::Measurement& right) {
   return left.lnglat().Distance(right.lnglat());
 }
+
+// Whether the candidate is along its edges rather than at a node
+inline bool AlongEdges(const valhalla::baldr::PathLocation& candidate) {
+  return !candidate.edges.empty() &&
+         std::none_of(candidate.edges.begin(), candidate.edges.end(),
+                      [](const valhalla::baldr::PathLocation::PathEdge& edge) {
+                        return edge.begin_node() || edge.end_node();
+                      });
+}
+
+// Get the edges of a path between the origin edge and the destination edge
+bool TraceEdges(const valhalla::meili::LabelSet& labelset,
+                uint32_t label_idx,
+                const valhalla::baldr::GraphId& origin_edge,
+                std::vector<valhalla::baldr::GraphId>& edges) {
+  using valhalla::baldr::kInvalidLabel;
+  edges.clear();
+  label_idx = labelset.label(label_idx).predecessor();
+  while (label_idx != kInvalidLabel) {
+    const auto& label = labelset.label(label_idx);
+    const auto predecessor = label.predecessor();
+
+    // Stop at the label which left the origin along the origin edge
+    if (predecessor != kInvalidLabel &&
+        labelset.label(predecessor).predecessor() == kInvalidLabel) {
+      std::reverse(edges.begin(), edges.end());
+      return label.edgeid() == origin_edge && label.nodeid().Is_Valid();
+    }
+    edges.push_back(label.edgeid());
+    label_idx = predecessor;
+  }
+  // The destination is ahead on the origin edge
+  return false;
+}
 } // namespace
 
 namespace valhalla {
@@ -26,7 +62,8 @@ TransitionCostModel::TransitionCostModel(baldr::GraphReader& graphreader,
       travelmode_(travelmode), beta_(beta), inv_beta_(1.f / beta_),
       breakage_distance_(breakage_distance), max_route_distance_factor_(max_route_distance_factor),
       max_route_time_factor_(max_route_time_factor),
-      turn_penalty_factor_(turn_penalty_factor), turn_cost_table_{0.f} {
+      turn_penalty_factor_(turn_penalty_factor), turn_cost_table_{0.f}, cache_(nullptr),
+      costing_hash_(0) {
   if (beta_ <= 0.f) {
     throw std::invalid_argument("Expect beta to be positive");
   }
@@ -142,13 +179,166 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
   }
 
   labelset_ptr_t labelset = std::make_shared<LabelSet>(max_route_distance);
-  const auto& results = find_shortest_path(graphreader_, locations, 0, labelset, approximator,
-                                           right_measurement.search_radius(),
-                                           mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
-                                           turn_cost_table_, max_route_distance, max_route_time);
+  const auto& results =
+      cache_ && AlongEdges(left.candidate())
+          ? UpdateRouteFromCache(locations, labelset, approximator,
+                                 right_measurement.search_radius(), edgelabel, max_route_distance,
+                                 max_route_time)
+          : find_shortest_path(graphreader_, locations, 0, labelset, approximator,
+                               right_measurement.search_radius(),
+                               mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
+                               turn_cost_table_, max_route_distance, max_route_time);
 
   left.SetRoute(unreached_stateids, results, labelset);
 }
 
+std::unordered_map<uint16_t, uint32_t>
+TransitionCostModel::UpdateRouteFromCache(const std::vector<baldr::PathLocation>& locations,
+                                          const labelset_ptr_t& labelset,
+                                          const midgard::DistanceApproximator& approximator,
+                                          const float search_radius,
+                                          const Label* edgelabel,
+                                          const float max_route_distance,
+                                          const float max_route_time) const {
+  const auto& costing = mode_costing_[static_cast<size_t>(travelmode_)];
+  const auto& origin = locations.front();
+
+  // The paths start from the origin label find_shortest_path would put
+  Label origin_label = edgelabel ? *edgelabel : Label();
+  origin_label.InitAsOrigin(costing->travel_mode(), 0, {});
+  const uint32_t origin_label_idx = labelset->append(origin_label);
+
+  // Edges of the destinations along edges. Destinations at nodes are left to
+  // the search.
+  struct target_t {
+    uint16_t dest;
+    const baldr::PathLocation::PathEdge* edge;
+  };
+  std::vector<target_t> targets;
+  for (uint16_t dest = 1; dest < locations.size(); ++dest) {
+    if (AlongEdges(locations[dest])) {
+      for (const auto& edge : locations[dest].edges) {
+        targets.push_back({dest, &edge});
+      }
+    }
+  }
+
+  // Get the paths from each origin edge to each destination edge
+  std::vector<TransitionCache::path_t> paths(origin.edges.size() * targets.size());
+  std::vector<bool> cached(paths.size(), false);
+  for (size_t i = 0; i < origin.edges.size(); ++i) {
+    const auto& origin_edge = origin.edges[i];
+    sif::Cost cost;
+    float turn_cost;
+    if (!leave_origin(graphreader_, origin_edge, origin_label, costing, turn_cost_table_,
+                      max_route_distance, max_route_time, cost, turn_cost)) {
+      continue;
+    }
+
+    // Destinations ahead on the origin edge need no path
+    std::vector<size_t> missing;
+    for (size_t t = 0; t < targets.size(); ++t) {
+      const auto& edge = *targets[t].edge;
+      const auto p = i * targets.size() + t;
+      cached[p] = (origin_edge.id == edge.id && origin_edge.percent_along <= edge.percent_along) ||
+                  cache_->Get({origin_edge.id, edge.id, costing_hash_}, paths[p]);
+      if (!cached[p]) {
+        missing.push_back(t);
+      }
+    }
+    if (missing.empty()) {
+      continue;
+    }
+
+    // Route from this origin edge to each missing destination edge on its own
+    // and without a time limit, so the paths are the shortest between the edges
+    std::vector<baldr::PathLocation> route_locations{origin};
+    route_locations.front().edges = {origin_edge};
+    for (const auto t : missing) {
+      route_locations.push_back(locations[targets[t].dest]);
+      route_locations.back().edges = {*targets[t].edge};
+    }
+    labelset_ptr_t route_labelset = std::make_shared<LabelSet>(max_route_distance);
+    const auto& results =
+        find_shortest_path(graphreader_, route_locations, 0, route_labelset, approximator,
+                           search_radius, costing, edgelabel, turn_cost_table_, max_route_distance,
+                           -1.f);
+
+    for (uint16_t dest = 1; dest < route_locations.size(); ++dest) {
+      const auto& edge = route_locations[dest].edges.front();
+      const auto p = i * targets.size() + missing[dest - 1];
+      auto& path = paths[p];
+      const auto it = results.find(dest);
+      if (it != results.end()) {
+        path.found = true;
+        path.min_cost = 0.f;
+        if (!TraceEdges(*route_labelset, it->second, origin_edge.id, path.edges)) {
+          continue;
+        }
+      } else {
+        // The search ran out of room, which bounds the cost from the end node
+        // of the origin edge to the destination edge
+        const auto* directededge = graphreader_.directededge(edge.id);
+        if (!directededge) {
+          continue;
+        }
+        path.found = false;
+        path.min_cost =
+            max_route_distance - cost.cost - directededge->length() * edge.percent_along;
+        path.edges.clear();
+      }
+      cache_->Put({origin_edge.id, edge.id, costing_hash_}, path);
+      cached[p] = true;
+    }
+  }
+
+  // Follow the paths to each destination and keep the cheapest. Destinations
+  // which only a search can tell about are routed as usual.
+  std::unordered_map<uint16_t, uint32_t> results;
+  std::vector<baldr::PathLocation> route_locations{origin};
+  std::vector<uint16_t> route_dests;
+  auto target = targets.cbegin();
+  for (uint16_t dest = 1; dest < locations.size(); ++dest) {
+    bool known = target != targets.cend() && target->dest == dest;
+    uint32_t best = baldr::kInvalidLabel;
+    for (; target != targets.cend() && target->dest == dest; ++target) {
+      for (size_t i = 0; i < origin.edges.size() && known; ++i) {
+        const auto p = i * targets.size() + (target - targets.cbegin());
+        uint32_t label_idx;
+        const auto status = follow_path(graphreader_, origin.edges[i], *target->edge, dest,
+                                        cached[p] ? &paths[p] : nullptr, labelset,
+                                        origin_label_idx, costing, turn_cost_table_,
+                                        max_route_distance, max_route_time, label_idx);
+        if (status == PathStatus::kUnknown) {
+          known = false;
+        } else if (status == PathStatus::kReached &&
+                   (best == baldr::kInvalidLabel ||
+                    labelset->label(label_idx).cost().cost < labelset->label(best).cost().cost)) {
+          best = label_idx;
+        }
+      }
+    }
+
+    if (!known) {
+      route_locations.push_back(locations[dest]);
+      route_dests.push_back(dest);
+    } else if (best != baldr::kInvalidLabel) {
+      results[dest] = best;
+    }
+  }
+
+  if (!route_dests.empty()) {
+    const auto& routed =
+        find_shortest_path(graphreader_, route_locations, 0, labelset, approximator, search_radius,
+                           costing, edgelabel, turn_cost_table_, max_route_distance, max_route_time);
+    for (const auto& result : routed) {
+      if (result.first > 0) {
+        results[route_dests[result.first - 1]] = result.second;
+      }
+    }
+  }
+  return results;
+}
+
 } // namespace meili
 } // namespace valhalla
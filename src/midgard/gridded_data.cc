@@ -9,6 +9,238 @@
 #include <algorithm>
 #include <cmath>
 #include <sstream>
+#include <unordered_map>
+
+namespace {
+
+// Stitches the segments of a contour together into lines. The points of all
+// the lines are kept in one vector, linked to the points before and after them
+// in their line, so that lines can be extended, joined and reversed in place.
+// The open ends of the lines are found through a table of their coordinates.
+template <class coord_t> class contour_lines_t {
+public:
+  contour_lines_t() : slots_(kInitialSlots, slot_t{coord_t(), kEmpty}), used_(0) {
+  }
+
+  // Connects the segment to the lines whose ends it touches
+  void add(coord_t pt1, coord_t pt2) {
+    // see if we have anything to connect this segment to
+    size_t rec_a = find(pt1);
+    size_t rec_b = find(pt2);
+    if (rec_b != kNone) {
+      std::swap(pt1, pt2);
+      std::swap(rec_a, rec_b);
+    }
+
+    // we want to merge two lines
+    if (rec_b != kNone) {
+      // get the lines in question and remove their lookup info
+      uint32_t line_a = slots_[rec_a].line;
+      bool head_a = slots_[rec_a].pt == front(line_a);
+      uint32_t line_b = slots_[rec_b].line;
+      bool head_b = slots_[rec_b].pt == front(line_b);
+      erase(rec_a);
+      erase(rec_b);
+
+      // this line is now a ring
+      if (line_a == line_b) {
+        push_back(line_a, front(line_a));
+        return;
+      }
+
+      // erase the other lookups
+      erase(find(pt1 == front(line_a) ? back(line_a) : front(line_a)));
+      erase(find(pt2 == front(line_b) ? back(line_b) : front(line_b)));
+
+      // add b to a
+      if (!head_a && head_b) {
+        append(line_a, line_b);
+      } // add a to b
+      else if (!head_b && head_a) {
+        append(line_b, line_a);
+        line_a = line_b;
+      } // flip a and add b
+      else if (head_a && head_b) {
+        reverse(line_a);
+        append(line_a, line_b);
+      } // flip b and add to a
+      else {
+        reverse(line_b);
+        append(line_a, line_b);
+      }
+
+      // update the look up
+      insert(front(line_a), line_a);
+      insert(back(line_a), line_a);
+    } // ap/prepend to an existing one
+    else if (rec_a != kNone) {
+      uint32_t line = slots_[rec_a].line;
+      erase(rec_a);
+      // it goes on the front
+      if (front(line) == pt1) {
+        push_front(line, pt2);
+        // it goes on the back
+      } else {
+        push_back(line, pt2);
+      }
+      insert(pt2, line);
+    } // this is an orphan segment for now
+    else {
+      uint32_t line = lines_.size();
+      lines_.push_back({kEmpty, kEmpty, true});
+      push_back(line, pt1);
+      push_back(line, pt2);
+      insert(pt1, line);
+      insert(pt2, line);
+    }
+  }
+
+  // Moves the lines into the list, the most recently started line first
+  template <class feature_t> void extract(feature_t& lines) {
+    for (auto line = lines_.crbegin(); line != lines_.crend(); ++line) {
+      if (!line->alive) {
+        continue;
+      }
+      lines.emplace_back();
+      for (uint32_t p = line->front; p != kEmpty; p = points_[p].next) {
+        lines.back().push_back(points_[p].pt);
+      }
+    }
+  }
+
+private:
+  static constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t kErased = kEmpty - 1;
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+  static constexpr size_t kInitialSlots = 1024;
+
+  struct point_t {
+    coord_t pt;
+    uint32_t prev;
+    uint32_t next;
+  };
+  struct line_t {
+    uint32_t front;
+    uint32_t back;
+    bool alive;
+  };
+  struct slot_t {
+    coord_t pt;
+    uint32_t line;
+  };
+
+  std::vector<point_t> points_;
+  std::vector<line_t> lines_;
+  std::vector<slot_t> slots_; // open addressed, the size is a power of 2
+  size_t used_;               // slots which are not empty, including erased ones
+
+  const coord_t& front(const uint32_t line) const {
+    return points_[lines_[line].front].pt;
+  }
+
+  const coord_t& back(const uint32_t line) const {
+    return points_[lines_[line].back].pt;
+  }
+
+  void push_front(const uint32_t line, const coord_t& pt) {
+    const uint32_t p = points_.size();
+    points_.push_back({pt, kEmpty, lines_[line].front});
+    points_[lines_[line].front].prev = p;
+    lines_[line].front = p;
+  }
+
+  void push_back(const uint32_t line, const coord_t pt) {
+    const uint32_t p = points_.size();
+    points_.push_back({pt, lines_[line].back, kEmpty});
+    if (lines_[line].back == kEmpty) {
+      lines_[line].front = p;
+    } else {
+      points_[lines_[line].back].next = p;
+    }
+    lines_[line].back = p;
+  }
+
+  // moves the points of line b onto the end of line a
+  void append(const uint32_t a, const uint32_t b) {
+    points_[lines_[a].back].next = lines_[b].front;
+    points_[lines_[b].front].prev = lines_[a].back;
+    lines_[a].back = lines_[b].back;
+    lines_[b].alive = false;
+  }
+
+  void reverse(const uint32_t line) {
+    for (uint32_t p = lines_[line].front; p != kEmpty; p = points_[p].prev) {
+      std::swap(points_[p].prev, points_[p].next);
+    }
+    std::swap(lines_[line].front, lines_[line].back);
+  }
+
+  size_t find(const coord_t& pt) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = std::hash<coord_t>()(pt) & mask;; i = (i + 1) & mask) {
+      if (slots_[i].line == kEmpty) {
+        return kNone;
+      }
+      if (slots_[i].line != kErased && slots_[i].pt == pt) {
+        return i;
+      }
+    }
+  }
+
+  void erase(const size_t slot) {
+    if (slot != kNone) {
+      slots_[slot].line = kErased;
+    }
+  }
+
+  // adds the end of a line unless the coordinate is already there
+  void insert(const coord_t& pt, const uint32_t line) {
+    const size_t mask = slots_.size() - 1;
+    size_t slot = kNone;
+    size_t i = std::hash<coord_t>()(pt) & mask;
+    for (; slots_[i].line != kEmpty; i = (i + 1) & mask) {
+      if (slots_[i].line == kErased) {
+        slot = slot == kNone ? i : slot;
+      } else if (slots_[i].pt == pt) {
+        return;
+      }
+    }
+    if (slot == kNone) {
+      slot = i;
+      ++used_;
+    }
+    slots_[slot] = {pt, line};
+
+    // keep at least half of the slots empty so probing stays short
+    if (used_ * 2 > slots_.size()) {
+      rehash();
+    }
+  }
+
+  void rehash() {
+    std::vector<slot_t> slots;
+    slots.swap(slots_);
+    size_t live = std::count_if(slots.cbegin(), slots.cend(), [](const slot_t& s) {
+      return s.line != kEmpty && s.line != kErased;
+    });
+    slots_.assign(live * 4 > slots.size() ? slots.size() * 2 : slots.size(),
+                  slot_t{coord_t(), kEmpty});
+    used_ = 0;
+    const size_t mask = slots_.size() - 1;
+    for (const auto& s : slots) {
+      if (s.line != kEmpty && s.line != kErased) {
+        size_t i = std::hash<coord_t>()(s.pt) & mask;
+        while (slots_[i].line != kEmpty) {
+          i = (i + 1) & mask;
+        }
+        slots_[i] = s;
+        ++used_;
+      }
+    }
+  }
+};
+
+} // namespace
 
 namespace valhalla {
 namespace midgard {
@@ -55,6 +287,31 @@ bool GriddedData<coord_t>::SetIfLessThan(const int tile_id, const float value) {
   return false;
 }
 
+// Set the value along a segment if less than the current value
+template <class coord_t>
+void GriddedData<coord_t>::SetIfLessThan(const coord_t& u, const coord_t& v, const float value) {
+  this->Rasterize(u, v, [this, &value](int32_t x, int32_t y) {
+    // cant mark ones that are outside the valid range of tiles
+    if (x < 0 || y < 0 || x >= this->ncolumns_ || y >= this->nrows_) {
+      return true;
+    }
+    float& current = data_[y * this->ncolumns_ + x];
+    if (value < current) {
+      current = value;
+    }
+    return false;
+  });
+}
+
+// Set the values of another gridded data with the same tiles if less than the current values
+template <class coord_t>
+void GriddedData<coord_t>::SetIfLessThan(const GriddedData<coord_t>& other) {
+  auto value = other.data_.cbegin();
+  for (auto& current : data_) {
+    current = std::min(current, *value++);
+  }
+}
+
 // Get the array of times
 template <class coord_t> const std::vector<float>& GriddedData<coord_t>::data() const {
   return data_;
@@ -69,9 +326,53 @@ typename GriddedData<coord_t>::contours_t
 GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_intervals,
                                        const bool rings_only,
                                        const float denoise,
-                                       const float generalize) const {
+                                       const float generalize,
+                                       const uint32_t concurrency) const {
   // TODO: sort and validate contour range
 
+  // we need something to hold each iso-line, bigger ones first
+  contours_t contours([](float a, float b) { return a > b; });
+  for (auto v : contour_intervals) {
+    contours[v].emplace_back();
+  }
+
+  // The range of values of the cells in each row and the row above it, so
+  // rows without any part of a contour are skipped quickly
+  std::vector<std::pair<float, float>> row_ranges(this->nrows_);
+  for (int row = 0; row < this->nrows_ - 1; ++row) {
+    auto first = data_.cbegin() + row * this->ncolumns_;
+    auto range = std::minmax_element(first, first + 2 * this->ncolumns_);
+    row_ranges[row] = std::make_pair(*range.first, *range.second);
+  }
+
+  // If the generalization value equals kOptimalGeneralization then set
+  // the generalization factor to 1/4 of the grid size
+  float gen_factor = generalize;
+  if (generalize == kOptimalGeneralization) {
+    gen_factor = this->tilesize_ * 0.125f * kMetersPerDegreeLat;
+  }
+
+  // The contours do not depend on each other so additional threads trace
+  // some of them
+  std::vector<typename contours_t::iterator> work;
+  for (auto collection = contours.begin(); collection != contours.end(); ++collection) {
+    work.push_back(collection);
+  }
+  parallel_for(work.size(), concurrency, [&](size_t i, size_t) {
+    GenerateContour(work[i]->first, row_ranges, rings_only, denoise, gen_factor, work[i]->second);
+  });
+
+  return contours;
+}
+
+// Generate the contour lines of a single contour value
+template <class coord_t>
+void GriddedData<coord_t>::GenerateContour(const float contour,
+                                           const std::vector<std::pair<float, float>>& row_ranges,
+                                           const bool rings_only,
+                                           const float denoise,
+                                           const float gen_factor,
+                                           std::list<feature_t>& features) const {
   // Values at tile corners and center (0 element is center)
   int sh[5];
   typename coord_t::first_type s[5]; // Values at the tile corners and center
@@ -84,15 +385,8 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
                    (s[p2] * tile_corners[p1].y() - s[p1] * tile_corners[p2].y()) / ds);
   };
 
-  // we need something to hold each iso-line, bigger ones first
-  contours_t contours([](float a, float b) { return a > b; });
-  for (auto v : contour_intervals) {
-    contours[v].emplace_back();
-  }
-  // and something to find them quickly
-  using contour_lookup_t = std::unordered_map<coord_t, typename feature_t::iterator>;
-  std::unordered_map<float, contour_lookup_t> lookup(contour_intervals.size());
-  // TODO: preallocate the lookups for each interval
+  // something to stitch the segments together into lines
+  contour_lines_t<coord_t> lines;
 
   int tile_inc[4] = {0, 1, this->ncolumns_ + 1, this->ncolumns_};
   int case_value;
@@ -102,6 +396,9 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
 
   // For each cell, skipping the outer rim since its out of bounds
   for (int row = 1; row < this->nrows_ - 1; ++row) {
+    if (contour < row_ranges[row].first || contour > row_ranges[row].second) {
+      continue;
+    }
     for (int col = 1; col < this->ncolumns_ - 1; ++col) {
       int tileid = this->TileId(col, row);
       auto cell1 = data_[tileid];
@@ -112,250 +409,164 @@ GriddedData<coord_t>::GenerateContours(const std::vector<float>& contour_interva
       auto dmax = std::max(std::max(cell1, cell2), std::max(cell3, cell4));
 
       // Continue if outside the range of contour values
-      if (dmax < contour_intervals.front() || dmin > contour_intervals.back()) {
+      if (contour < dmin || contour > dmax) {
         continue;
       }
 
-      for (auto contour : contour_intervals) {
-        if (contour < dmin || contour > dmax) {
+      for (int m = 4; m >= 0; m--) {
+        if (m > 0) {
+          int newtileid = tileid + tile_inc[m - 1];
+          // Make sure the tile corner value is not set to the max_value
+          // (messes up the intersect method). Set a value slightly above
+          // the contour (e.g. 1 minute higher).
+          // TODO - the value 1 is a bit of a hack.
+          s[m] = (data_[newtileid] < max_value_) ? data_[newtileid] - contour : 1.0f;
+          tile_corners[m] = this->Base(newtileid);
+        } else {
+          s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
+          tile_corners[0] = this->Center(tileid);
+        }
+        if (s[m] > 0.0f) {
+          sh[m] = 1;
+        } else if (s[m] < 0.0f) {
+          sh[m] = -1;
+        } else {
+          sh[m] = 0;
+        }
+      }
+
+      /*
+       Note: at this stage the relative heights of the corners and the
+       centre are in the h array, and the corresponding coordinates are
+       in the xh and yh arrays. The centre of the box is indexed by 0
+       and the 4 corners by 1 to 4 as shown below.
+       Each triangle is then indexed by the parameter m, and the 3
+       vertices of each triangle are indexed by parameters m1,m2,and m3.
+       It is assumed that the centre of the box is always vertex 2
+       though this is important only when all 3 vertices lie exactly on
+       the same contour level, in which case only the side of the box
+       is drawn.
+          vertex 4 +-------------------+ vertex 3
+                   | \               / |
+                   |   \    m-3    /   |
+                   |     \       /     |
+                   |       \   /       |
+                   |  m=2    X   m=2   |       the centre is vertex 0
+                   |       /   \       |
+                   |     /       \     |
+                   |   /    m=1    \   |
+                   | /               \ |
+          vertex 1 +-------------------+ vertex 2
+      */
+
+      // Scan each triangle in the box
+      coord_t pt1, pt2;
+      for (int m = 1; m <= 4; m++) {
+        int m1 = m;
+        int m2 = 0;
+        int m3 = (m != 4) ? m + 1 : 1;
+        if ((case_value = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1]) == 0) {
           continue;
         }
-        for (int m = 4; m >= 0; m--) {
-          if (m > 0) {
-            int newtileid = tileid + tile_inc[m - 1];
-            // Make sure the tile corner value is not set to the max_value
-            // (messes up the intersect method). Set a value slightly above
-            // the contour (e.g. 1 minute higher).
-            // TODO - the value 1 is a bit of a hack.
-            s[m] = (data_[newtileid] < max_value_) ? data_[newtileid] - contour : 1.0f;
-            tile_corners[m] = this->Base(newtileid);
-          } else {
-            s[0] = 0.25 * (s[1] + s[2] + s[3] + s[4]);
-            tile_corners[0] = this->Center(tileid);
-          }
-          if (s[m] > 0.0f) {
-            sh[m] = 1;
-          } else if (s[m] < 0.0f) {
-            sh[m] = -1;
-          } else {
-            sh[m] = 0;
-          }
+
+        switch (case_value) {
+          case 1: // Line between vertices 1 and 2
+            pt1 = tile_corners[m1];
+            pt2 = tile_corners[m2];
+            break;
+          case 2: // Line between vertices 2 and 3
+            pt1 = tile_corners[m2];
+            pt2 = tile_corners[m3];
+            break;
+          case 3: // Line between vertices 3 and 1
+            pt1 = tile_corners[m3];
+            pt2 = tile_corners[m1];
+            break;
+          case 4: // Line between vertex 1 and side 2-3
+            pt1 = tile_corners[m1];
+            pt2 = intersect(m2, m3);
+            break;
+          case 5: // Line between vertex 2 and side 3-1
+            pt1 = tile_corners[m2];
+            pt2 = intersect(m3, m1);
+            break;
+          case 6: // Line between vertex 3 and side 1-2
+            pt1 = tile_corners[m3];
+            pt2 = intersect(m1, m2);
+            break;
+          case 7: // Line between sides 1-2 and 2-3
+            pt1 = intersect(m1, m2);
+            pt2 = intersect(m2, m3);
+            break;
+          case 8: // Line between sides 2-3 and 3-1
+            pt1 = intersect(m2, m3);
+            pt2 = intersect(m3, m1);
+            break;
+          case 9: // Line between sides 3-1 and 1-2
+            pt1 = intersect(m3, m1);
+            pt2 = intersect(m1, m2);
+            break;
+          default:
+            break;
         }
 
-        /*
-         Note: at this stage the relative heights of the corners and the
-         centre are in the h array, and the corresponding coordinates are
-         in the xh and yh arrays. The centre of the box is indexed by 0
-         and the 4 corners by 1 to 4 as shown below.
-         Each triangle is then indexed by the parameter m, and the 3
-         vertices of each triangle are indexed by parameters m1,m2,and m3.
-         It is assumed that the centre of the box is always vertex 2
-         though this is important only when all 3 vertices lie exactly on
-         the same contour level, in which case only the side of the box
-         is drawn.
-            vertex 4 +-------------------+ vertex 3
-                     | \               / |
-                     |   \    m-3    /   |
-                     |     \       /     |
-                     |       \   /       |
-                     |  m=2    X   m=2   |       the centre is vertex 0
-                     |       /   \       |
-                     |     /       \     |
-                     |   /    m=1    \   |
-                     | /               \ |
-            vertex 1 +-------------------+ vertex 2
-        */
-
-        // Scan each triangle in the box
-        coord_t pt1, pt2;
-        for (int m = 1; m <= 4; m++) {
-          int m1 = m;
-          int m2 = 0;
-          int m3 = (m != 4) ? m + 1 : 1;
-          if ((case_value = case_table[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1]) == 0) {
-            continue;
-          }
-
-          switch (case_value) {
-            case 1: // Line between vertices 1 and 2
-              pt1 = tile_corners[m1];
-              pt2 = tile_corners[m2];
-              break;
-            case 2: // Line between vertices 2 and 3
-              pt1 = tile_corners[m2];
-              pt2 = tile_corners[m3];
-              break;
-            case 3: // Line between vertices 3 and 1
-              pt1 = tile_corners[m3];
-              pt2 = tile_corners[m1];
-              break;
-            case 4: // Line between vertex 1 and side 2-3
-              pt1 = tile_corners[m1];
-              pt2 = intersect(m2, m3);
-              break;
-            case 5: // Line between vertex 2 and side 3-1
-              pt1 = tile_corners[m2];
-              pt2 = intersect(m3, m1);
-              break;
-            case 6: // Line between vertex 3 and side 1-2
-              pt1 = tile_corners[m3];
-              pt2 = intersect(m1, m2);
-              break;
-            case 7: // Line between sides 1-2 and 2-3
-              pt1 = intersect(m1, m2);
-              pt2 = intersect(m2, m3);
-              break;
-            case 8: // Line between sides 2-3 and 3-1
-              pt1 = intersect(m2, m3);
-              pt2 = intersect(m3, m1);
-              break;
-            case 9: // Line between sides 3-1 and 1-2
-              pt1 = intersect(m3, m1);
-              pt2 = intersect(m1, m2);
-              break;
-            default:
-              break;
-          }
-
-          // this isnt a segment..
-          if (pt1 == pt2) {
-            continue;
-          }
-
-          // see if we have anything to connect this segment to
-          typename contour_lookup_t::iterator rec_a = lookup[contour].find(pt1);
-          typename contour_lookup_t::iterator rec_b = lookup[contour].find(pt2);
-          if (rec_b != lookup[contour].end()) {
-            std::swap(pt1, pt2);
-            std::swap(rec_a, rec_b);
-          }
-
-          // we want to merge two records
-          if (rec_b != lookup[contour].end()) {
-            // get the segments in question and remove their lookup info
-            auto segment_a = rec_a->second;
-            bool head_a = rec_a->first == segment_a->front();
-            auto segment_b = rec_b->second;
-            bool head_b = rec_b->first == segment_b->front();
-            lookup[contour].erase(rec_a);
-            lookup[contour].erase(rec_b);
-
-            // this segment is now a ring
-            if (segment_a == segment_b) {
-              segment_a->push_back(segment_a->front());
-              continue;
-            }
-
-            // erase the other lookups
-            lookup[contour].erase(lookup[contour].find(
-                pt1 == segment_a->front() ? segment_a->back() : segment_a->front()));
-            lookup[contour].erase(lookup[contour].find(
-                pt2 == segment_b->front() ? segment_b->back() : segment_b->front()));
-
-            // add b to a
-            if (!head_a && head_b) {
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            } // add a to b
-            else if (!head_b && head_a) {
-              segment_b->splice(segment_b->end(), *segment_a);
-              contours[contour].front().erase(segment_a);
-              segment_a = segment_b;
-            } // flip a and add b
-            else if (head_a && head_b) {
-              segment_a->reverse();
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            } // flip b and add to a
-            else if (!head_a && !head_b) {
-              segment_b->reverse();
-              segment_a->splice(segment_a->end(), *segment_b);
-              contours[contour].front().erase(segment_b);
-            }
-
-            // update the look up
-            lookup[contour].emplace(segment_a->front(), segment_a);
-            lookup[contour].emplace(segment_a->back(), segment_a);
-          } // ap/prepend to an existing one
-          else if (rec_a != lookup[contour].end()) {
-            // it goes on the front
-            if (rec_a->second->front() == pt1) {
-              rec_a->second->push_front(pt2);
-              // it goes on the back
-            } else {
-              rec_a->second->push_back(pt2);
-            }
-
-            // update the lookup table
-            lookup[contour].emplace(pt2, rec_a->second);
-            lookup[contour].erase(rec_a);
-          } // this is an orphan segment for now
-          else {
-            contours[contour].front().push_front(contour_t{pt1, pt2});
-            lookup[contour].emplace(pt1, contours[contour].front().begin());
-            lookup[contour].emplace(pt2, contours[contour].front().begin());
-          }
+        // this isnt a segment..
+        if (pt1 == pt2) {
+          continue;
         }
-      } // Each contour
-    }   // Each tile col
-  }     // Each tile row
 
-  // If the generalization value equals kOptimalGeneralization then set
-  // the generalization factor to 1/4 of the grid size
-  float gen_factor = generalize;
-  if (generalize == kOptimalGeneralization) {
-    gen_factor = this->tilesize_ * 0.125f * kMetersPerDegreeLat;
-  }
+        // connect it to whatever it touches
+        lines.add(pt1, pt2);
+      }
+    } // Each tile col
+  }   // Each tile row
+
+  // the lines as they would be in a list where each new line was put on the front
+  auto& contour_lines = features.front();
+  lines.extract(contour_lines);
 
   // some info about the area the image covers
-  auto c = this->TileBounds().Center();
   auto h = this->tilesize_ / 2;
-  // for each contour
-  for (auto& collection : contours) {
-    auto& contour = collection.second.front();
-    // they only wanted rings
-    if (rings_only) {
-      contour.remove_if([](const contour_t& line) { return line.front() != line.back(); });
-    }
-    // sort them by area (maybe length would be sufficient?) biggest first
-    std::unordered_map<const contour_t*, typename coord_t::first_type> cache(contour.size());
-    std::for_each(contour.cbegin(), contour.cend(),
-                  [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
-    contour.sort([&cache](const contour_t& a, const contour_t& b) {
-      return std::abs(cache[&a]) > std::abs(cache[&b]);
+  // they only wanted rings
+  if (rings_only) {
+    contour_lines.remove_if([](const contour_t& line) { return line.front() != line.back(); });
+  }
+  // sort them by area (maybe length would be sufficient?) biggest first
+  std::unordered_map<const contour_t*, typename coord_t::first_type> cache(contour_lines.size());
+  std::for_each(contour_lines.cbegin(), contour_lines.cend(),
+                [&cache](const contour_t& c) { cache[&c] = polygon_area(c); });
+  contour_lines.sort([&cache](const contour_t& a, const contour_t& b) {
+    return std::abs(cache[&a]) > std::abs(cache[&b]);
+  });
+  // they only want the most significant ones!
+  if (denoise > 0.f) {
+    contour_lines.remove_if([&cache, &contour_lines, denoise](const contour_t& c) {
+      return std::abs(cache[&c] / cache[&contour_lines.front()]) < denoise;
     });
-    // they only want the most significant ones!
-    if (denoise > 0.f) {
-      contour.remove_if([&cache, &contour, denoise](const contour_t& c) {
-        return std::abs(cache[&c] / cache[&contour.front()]) < denoise;
-      });
+  }
+  // clean up the lines
+  for (auto& line : contour_lines) {
+    // TODO: generalizing makes self intersections which makes other libraries unhappy
+    if (gen_factor > 0.f) {
+      Polyline2<coord_t>::Generalize(line, gen_factor);
     }
-    // clean up the lines
-    for (auto& line : contour) {
-      // TODO: generalizing makes self intersections which makes other libraries unhappy
-      if (gen_factor > 0.f) {
-        Polyline2<coord_t>::Generalize(line, gen_factor);
-      }
-      // if this ends up as an inner we'll undo this later
-      if (cache[&line] > 0) {
-        line.reverse();
-      }
-      // sampling the bottom left corner means everything is skewed, so unskew it
-      for (auto& coord : line) {
-        coord.first += h;
-        coord.second += h;
-      }
+    // if this ends up as an inner we'll undo this later
+    if (cache[&line] > 0) {
+      line.reverse();
     }
-    // if they just wanted linestrings we need only one per feature
-    if (!rings_only) {
-      for (auto& linestring : contour) {
-        collection.second.push_back({std::move(linestring)});
-      }
-      collection.second.pop_front();
+    // sampling the bottom left corner means everything is skewed, so unskew it
+    for (auto& coord : line) {
+      coord.first += h;
+      coord.second += h;
     }
   }
-
-  return contours;
+  // if they just wanted linestrings we need only one per feature
+  if (!rings_only) {
+    for (auto& linestring : contour_lines) {
+      features.push_back({std::move(linestring)});
+    }
+    features.pop_front();
+  }
 }
 
 // Explicit instantiation
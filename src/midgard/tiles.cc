@@ -388,6 +388,53 @@ void Tiles<coord_t>::ColorMap(std::unordered_map<uint32_t, size_t>& connectivity
   }
 }
 
+template <class coord_t>
+void Tiles<coord_t>::RasterizeSegment(const coord_t& u,
+                                      const coord_t& v,
+                                      const std::function<bool(int32_t, int32_t)>& set_pixel)
+    const {
+  // figure out global subdivision start and end points
+  auto x0 = (u.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
+  auto y0 = (u.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
+  auto x1 = (v.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
+  auto y1 = (v.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
+
+  int ix0 = std::floor(x0), ix1 = std::floor(x1);
+  int iy0 = std::floor(y0), iy1 = std::floor(y1);
+  int dx = ix0 - ix1, dy = iy0 - iy1;
+  int ds = dx * dx + dy * dy;
+  // its likely for our use case that its all in one cell
+  if (ds == 0) {
+    set_pixel(ix0, iy0);
+  }
+  // if not the next most likley thing is adjacent cells
+  else if (ds == 1) {
+    set_pixel(ix0, iy0);
+    set_pixel(ix1, iy1);
+  }
+  // pretend the subdivisions are pixels and we are doing line rasterization
+  else {
+    bresenham_line(x0, y0, x1, y1, set_pixel);
+  }
+}
+
+template <class coord_t>
+void Tiles<coord_t>::Rasterize(const coord_t& u,
+                               const coord_t& v,
+                               const std::function<bool(int32_t, int32_t)>& set_pixel) const {
+  // resample long spherical segments the same way Intersect does, see below
+  auto max_meters = std::max(1.f, subdivision_size_ * .25f *
+                                      DistanceApproximator::MetersPerLngDegree(u.second));
+  if (coord_t::IsSpherical() && u.Distance(v) > max_meters) {
+    auto resampled = resample_spherical_polyline(std::vector<coord_t>{u, v}, max_meters, true);
+    for (auto p = std::next(resampled.cbegin()); p != resampled.cend(); ++p) {
+      RasterizeSegment(*std::prev(p), *p, set_pixel);
+    }
+    return;
+  }
+  RasterizeSegment(u, v, set_pixel);
+}
+
 template <class coord_t>
 template <class container_t>
 std::unordered_map<int32_t, std::unordered_set<unsigned short>>
@@ -395,7 +442,8 @@ Tiles<coord_t>::Intersect(const container_t& linestring) const {
   std::unordered_map<int32_t, std::unordered_set<unsigned short>> intersection;
 
   // what to do when we want to mark a subdivision as containing a segment of this linestring
-  const auto set_pixel = [this, &intersection](int32_t x, int32_t y) {
+  const std::function<bool(int32_t, int32_t)> set_pixel = [this, &intersection](int32_t x,
+                                                                                int32_t y) {
     // cant mark ones that are outside the valid range of tiles
     // TODO: wrap coordinates around x and y?
     if (x < 0 || y < 0 || x >= nsubdivisions_ * ncolumns_ || y >= nsubdivisions_ * nrows_) {
@@ -436,30 +484,7 @@ Tiles<coord_t>::Intersect(const container_t& linestring) const {
       return intersection;
     }
     ui = vi;
-
-    // figure out global subdivision start and end points
-    auto x0 = (u.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
-    auto y0 = (u.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
-    auto x1 = (v.first - tilebounds_.minx()) / tilebounds_.Width() * ncolumns_ * nsubdivisions_;
-    auto y1 = (v.second - tilebounds_.miny()) / tilebounds_.Height() * nrows_ * nsubdivisions_;
-
-    int ix0 = std::floor(x0), ix1 = std::floor(x1);
-    int iy0 = std::floor(y0), iy1 = std::floor(y1);
-    int dx = ix0 - ix1, dy = iy0 - iy1;
-    int ds = dx * dx + dy * dy;
-    // its likely for our use case that its all in one cell
-    if (ds == 0) {
-      set_pixel(ix0, iy0);
-    }
-    // if not the next most likley thing is adjacent cells
-    else if (ds == 1) {
-      set_pixel(ix0, iy0);
-      set_pixel(ix1, iy1);
-    }
-    // pretend the subdivisions are pixels and we are doing line rasterization
-    else {
-      bresenham_line(x0, y0, x1, y1, set_pixel);
-    }
+    RasterizeSegment(u, v, set_pixel);
   }
 
   // give them back
@@ -58,12 +58,50 @@ uint32_t GetMultiPolyId(const std::unordered_map<uint32_t, multi_polygon_type>&
   return index;
 }
 
+// Constructor. Indexes the multipolygons in the order of the map.
+MultiPolygonIndex::MultiPolygonIndex(std::unordered_map<uint32_t, multi_polygon_type>&& polys) {
+  polys_.reserve(polys.size());
+  std::vector<value_type> boxes;
+  for (auto& poly : polys) {
+    const uint32_t position = polys_.size();
+    polys_.emplace_back(poly.first, std::move(poly.second));
+    const auto& multi_poly = polys_.back().second;
+    for (uint32_t i = 0; i < multi_poly.size(); ++i) {
+      boxes.emplace_back(boost::geometry::return_envelope<box_type>(multi_poly[i].outer()),
+                         std::make_pair(position, i));
+    }
+  }
+
+  // Pack the tree in one go, its much quicker to query than one filled by inserting
+  rtree_ = decltype(rtree_)(boxes.begin(), boxes.end());
+}
+
+// Get the index of the first multipolygon which covers a point.
+uint32_t MultiPolygonIndex::Find(const PointLL& ll) const {
+  // Polygons come out of the tree in any order so keep the one added first
+  point_type p(ll.lng(), ll.lat());
+  uint32_t first = polys_.size();
+  for (auto box = rtree_.qbegin(boost::geometry::index::intersects(p)); box != rtree_.qend();
+       ++box) {
+    const auto& position = box->second;
+    if (position.first < first &&
+        boost::geometry::covered_by(p, polys_[position.first].second[position.second])) {
+      first = position.first;
+    }
+  }
+  return first < polys_.size() ? polys_[first].first : 0;
+}
+
+// Get the polygon index using the spatial index of the polys.
+uint32_t GetMultiPolyId(const MultiPolygonIndex& polys, const PointLL& ll) {
+  return polys.Find(ll);
+}
+
 // Get the timezone polys from the db
-std::unordered_map<uint32_t, multi_polygon_type> GetTimeZones(sqlite3* db_handle,
-                                                              const AABB2<PointLL>& aabb) {
+MultiPolygonIndex GetTimeZones(sqlite3* db_handle, const AABB2<PointLL>& aabb) {
   std::unordered_map<uint32_t, multi_polygon_type> polys;
   if (!db_handle) {
-    return polys;
+    return MultiPolygonIndex();
   }
 
   sqlite3_stmt* stmt = 0;
@@ -113,18 +151,17 @@ std::unordered_map<uint32_t, multi_polygon_type> GetTimeZones(sqlite3* db_handle
     sqlite3_finalize(stmt);
     stmt = 0;
   }
-  return polys;
+  return MultiPolygonIndex(std::move(polys));
 }
 
 // Get the admin polys that intersect with the tile bounding box.
-std::unordered_map<uint32_t, multi_polygon_type>
-GetAdminInfo(sqlite3* db_handle,
-             std::unordered_map<uint32_t, bool>& drive_on_right,
-             const AABB2<PointLL>& aabb,
-             GraphTileBuilder& tilebuilder) {
+MultiPolygonIndex GetAdminInfo(sqlite3* db_handle,
+                               std::unordered_map<uint32_t, bool>& drive_on_right,
+                               const AABB2<PointLL>& aabb,
+                               GraphTileBuilder& tilebuilder) {
   std::unordered_map<uint32_t, multi_polygon_type> polys;
   if (!db_handle) {
-    return polys;
+    return MultiPolygonIndex();
   }
 
   std::unordered_map<uint32_t, uint32_t> indexes;
@@ -219,7 +256,7 @@ GetAdminInfo(sqlite3* db_handle,
     stmt = 0;
   }
 
-  return polys;
+  return MultiPolygonIndex(std::move(polys));
 }
 
 // Get all the country access records from the db and save them to a map.
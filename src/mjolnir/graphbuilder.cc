@@ -48,18 +48,22 @@ constexpr double kMinimumInterval = 10.0f;
  * we also need to then update the edges that pointed to them
  *
  */
-std::map<GraphId, size_t>
-SortGraph(const std::string& nodes_file, const std::string& edges_file, const uint8_t level) {
+std::map<GraphId, size_t> SortGraph(const std::string& nodes_file,
+                                    const std::string& edges_file,
+                                    const uint8_t level,
+                                    const unsigned int threads) {
   LOG_INFO("Sorting graph...");
 
   // Sort nodes by graphid then by osmid, so its basically a set of tiles
   sequence<Node> nodes(nodes_file, false);
-  nodes.sort([](const Node& a, const Node& b) {
-    if (a.graph_id == b.graph_id) {
-      return a.node.osmid < b.node.osmid;
-    }
-    return a.graph_id < b.graph_id;
-  });
+  nodes.sort(
+      [](const Node& a, const Node& b) {
+        if (a.graph_id == b.graph_id) {
+          return a.node.osmid < b.node.osmid;
+        }
+        return a.graph_id < b.graph_id;
+      },
+      threads);
   // run through the sorted nodes, going back to the edges they reference and updating each edge
   // to point to the first (out of the duplicates) nodes index. at the end of this there will be
   // tons of nodes that no edges reference, but we need them because they are the means by which
@@ -442,7 +446,7 @@ void BuildTileSet(const std::string& ways_file,
       // tile is entirely inside the polygon
       bool tile_within_one_admin = false;
       uint32_t id = tile_id.tileid();
-      std::unordered_map<uint32_t, multi_polygon_type> admin_polys;
+      MultiPolygonIndex admin_polys;
       std::unordered_map<uint32_t, bool> drive_on_right;
       if (admin_db_handle) {
         admin_polys = GetAdminInfo(admin_db_handle, drive_on_right, tiling.TileBounds(id), graphtile);
@@ -453,7 +457,7 @@ void BuildTileSet(const std::string& ways_file,
       }
 
       bool tile_within_one_tz = false;
-      std::unordered_map<uint32_t, multi_polygon_type> tz_polys;
+      MultiPolygonIndex tz_polys;
       if (tz_db_handle) {
         tz_polys = GetTimeZones(tz_db_handle, tiling.TileBounds(id));
         if (tz_polys.size() == 1) {
@@ -1088,7 +1092,7 @@ void GraphBuilder::Build(const boost::property_tree::ptree& pt,
                  });
 
   // Line up the nodes and then re-map the edges that the edges to them
-  auto tiles = SortGraph(nodes_file, edges_file, level);
+  auto tiles = SortGraph(nodes_file, edges_file, level, threads);
 
   // Reclassify links (ramps). Cannot do this when building tiles since the
   // edge list needs to be modified
@@ -3,7 +3,9 @@
 #include "mjolnir/countryaccess.h"
 #include "mjolnir/graphtilebuilder.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <cmath>
 #include <future>
 #include <limits>
 #include <list>
@@ -44,6 +46,12 @@
 #include "midgard/util.h"
 #include "mjolnir/osmaccess.h"
 
+#ifdef INLINE_TEST
+#include "test/test.h"
+#include <boost/property_tree/ptree.hpp>
+#include <random>
+#endif
+
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
 using namespace valhalla::mjolnir;
@@ -188,11 +196,10 @@ void UpdateSpeed(DirectedEdge& directededge, const uint32_t density, const uint3
  * edge cannot reach higher class roads and a search cannot expand after
  * a set number of iterations the edge is considered unreachable.
  * @param  reader        Graph reader
- * @param  lock          Mutex for locking while tiles are retrieved
  * @param  directededge  Directed edge to test.
  * @return  Returns true if the edge is found to be unreachable.
  */
-bool IsUnreachable(GraphReader& reader, std::mutex& lock, DirectedEdge& directededge) {
+bool IsUnreachable(GraphReader& reader, DirectedEdge& directededge) {
   // Only check driveable edges. If already on a higher class road consider
   // the edge reachable
   if (!(directededge.forwardaccess() & kAutoAccess) ||
@@ -207,8 +214,8 @@ bool IsUnreachable(GraphReader& reader, std::mutex& lock, DirectedEdge& directed
 
   // Expand until we either find a tertiary or higher classification,
   // expand more than kUnreachableIterations nodes, or cannot expand
-  // any further. To reduce calls to lock and unlock keep a record of
-  // current tile and only read a new tile when needed.
+  // any further. To reduce tile lookups keep a record of current tile
+  // and only get a new tile when needed.
   uint32_t n = 0;
   GraphId prior_tile;
   const GraphTile* tile;
@@ -224,9 +231,7 @@ bool IsUnreachable(GraphReader& reader, std::mutex& lock, DirectedEdge& directed
     expandset.erase(expandset.begin());
     visitedset.insert(expandnode);
     if (expandnode.Tile_Base() != prior_tile) {
-      lock.lock();
       tile = reader.GetGraphTile(expandnode);
-      lock.unlock();
       prior_tile = expandnode.Tile_Base();
     }
     const NodeInfo* nodeinfo = tile->node(expandnode);
@@ -250,10 +255,7 @@ bool IsUnreachable(GraphReader& reader, std::mutex& lock, DirectedEdge& directed
 
 // Test if this is a "not thru" edge. These are edges that enter a region that
 // has no exit other than the edge entering the region
-bool IsNotThruEdge(GraphReader& reader,
-                   std::mutex& lock,
-                   const GraphId& startnode,
-                   DirectedEdge& directededge) {
+bool IsNotThruEdge(GraphReader& reader, const GraphId& startnode, DirectedEdge& directededge) {
   // Add the end node to the expand list
   std::unordered_set<GraphId> visitedset; // Set of visited nodes
   std::unordered_set<GraphId> expandset;  // Set of nodes to expand
@@ -261,8 +263,8 @@ bool IsNotThruEdge(GraphReader& reader,
 
   // Expand edges until exhausted, the maximum number of expansions occur,
   // or end up back at the starting node. No node can be visited twice.
-  // To reduce calls to lock and unlock keep a record of current tile and
-  // only read a new tile when needed.
+  // To reduce tile lookups keep a record of current tile and only get a
+  // new tile when needed.
   GraphId prior_tile;
   const GraphTile* tile;
   for (uint32_t n = 0; n < kMaxNoThruTries; n++) {
@@ -277,9 +279,7 @@ bool IsNotThruEdge(GraphReader& reader,
     expandset.erase(expandset.begin());
     visitedset.insert(expandnode);
     if (expandnode.Tile_Base() != prior_tile) {
-      lock.lock();
       tile = reader.GetGraphTile(expandnode);
-      lock.unlock();
       prior_tile = expandnode.Tile_Base();
     }
     const NodeInfo* nodeinfo = tile->node(expandnode);
@@ -316,7 +316,6 @@ bool IsNotThruEdge(GraphReader& reader,
 // Test if the edge is internal to an intersection.
 bool IsIntersectionInternal(const GraphTile* start_tile,
                             GraphReader& reader,
-                            std::mutex& lock,
                             const GraphId& startnode,
                             NodeInfo& startnodeinfo,
                             DirectedEdge& directededge,
@@ -399,9 +398,7 @@ bool IsIntersectionInternal(const GraphTile* start_tile,
   // Get the tile at the end node. and find inbound heading of the candidate
   // edge to the end node.
   if (tile->id() != directededge.endnode().Tile_Base()) {
-    lock.lock();
     tile = reader.GetGraphTile(directededge.endnode());
-    lock.unlock();
   }
   const NodeInfo* node = tile->node(directededge.endnode());
   diredge = tile->directededge(node->edge_index());
@@ -485,68 +482,186 @@ bool IsIntersectionInternal(const GraphTile* start_tile,
 }
 
 /**
- * Get the road density around the specified lat,lng position. This is a
- * value from 0-15 indicating a relative road density. This can be used
- * in costing methods to help avoid dense, urban areas.
- * @param  reader        Graph reader
- * @param  lock          Mutex for locking while tiles are retrieved
- * @param  ll            Lat,lng position
- * @param  maxdensity    (OUT) max density found
- * @param  tiles         Tiling (for getting list of required tiles)
- * @param  local_level   Level of the local tiles.
- * @return  Returns the relative road density (0-15) - higher values are
- *          more dense.
+ * Road lengths of the nodes in and around a tile, binned into a grid of cells
+ * a quarter of the density radius across. Cells which lie entirely within the
+ * radius of a position add their total length, only the nodes of the cells on
+ * the edge of the radius are checked one by one. This replaces checking every
+ * node of every tile within the radius for each node in the tile.
  */
-uint32_t GetDensity(GraphReader& reader,
-                    std::mutex& lock,
-                    const PointLL& ll,
-                    enhancer_stats& stats,
-                    const Tiles<PointLL>& tiles,
-                    uint8_t local_level) {
-  // Radius is in km - turn into meters
-  float rm = kDensityRadius * kMetersPerKm;
-  float mr2 = rm * rm;
-
-  // Use distance approximator for all distance checks
-  DistanceApproximator approximator(ll);
-
-  // Get a list of tiles required for a node search within this radius
-  float lngdeg = (rm / DistanceApproximator::MetersPerLngDegree(ll.lat()));
-  AABB2<PointLL> bbox(Point2(ll.lng() - lngdeg, ll.lat() - kDensityLatDeg),
-                      Point2(ll.lng() + lngdeg, ll.lat() + kDensityLatDeg));
-  std::vector<int32_t> tilelist = tiles.TileList(bbox);
-
-  // For all tiles needed to find nodes within the radius...find nodes within
-  // the radius (squared) and add lengths of directed edges
-  float roadlengths = 0.0f;
-  for (auto t : tilelist) {
-    // Check all the nodes within the tile. Skip if tile has no nodes (can be
-    // an empty tile added for connectivity map logic).
-    lock.lock();
-    const GraphTile* newtile = reader.GetGraphTile(GraphId(t, local_level, 0));
-    lock.unlock();
-    if (!newtile || newtile->header()->nodecount() == 0) {
-      continue;
-    }
-    const auto start_node = newtile->node(0);
-    const auto end_node = start_node + newtile->header()->nodecount();
-    for (auto node = start_node; node < end_node; ++node) {
-      // Check if within radius
-      if (approximator.DistanceSquared(node->latlng()) < mr2) {
-        // Get all directed edges and add length
+class DensityGrid {
+public:
+  /**
+   * Constructor. Bins the road length at every node within the density
+   * radius of the tile.
+   * @param  reader        Graph reader
+   * @param  tile_bounds   Bounds of the tile the density is needed for
+   * @param  tiles         Tiling (for getting list of required tiles)
+   * @param  local_level   Level of the local tiles.
+   */
+  DensityGrid(GraphReader& reader,
+              const AABB2<PointLL>& tile_bounds,
+              const Tiles<PointLL>& tiles,
+              uint8_t local_level) {
+    // The grid reaches the density radius past the tile at the latitude where
+    // a degree of longitude is shortest, plus a cell for rounding
+    float rm = kDensityRadius * kMetersPerKm;
+    float maxlat = std::max(std::abs(tile_bounds.miny()), std::abs(tile_bounds.maxy()));
+    float lngdeg = std::min(rm / DistanceApproximator::MetersPerLngDegree(maxlat), 180.0f);
+    cell_width_ = lngdeg * 0.25f;
+    cell_height_ = kDensityLatDeg * 0.25f;
+    bounds_ = AABB2<PointLL>(tile_bounds.minx() - lngdeg - cell_width_,
+                             tile_bounds.miny() - kDensityLatDeg - cell_height_,
+                             tile_bounds.maxx() + lngdeg + cell_width_,
+                             tile_bounds.maxy() + kDensityLatDeg + cell_height_);
+    columns_ = std::max(static_cast<int32_t>(std::ceil(bounds_.Width() / cell_width_)), 1);
+    rows_ = std::max(static_cast<int32_t>(std::ceil(bounds_.Height() / cell_height_)), 1);
+
+    // Get the road length at each node within the grid. Nodes without roads
+    // never add to the density so they are left out
+    std::vector<std::pair<uint32_t, node_t>> binned;
+    for (auto t : tiles.TileList(bounds_)) {
+      // Skip if tile has no nodes (can be an empty tile added for
+      // connectivity map logic).
+      const GraphTile* newtile = reader.GetGraphTile(GraphId(t, local_level, 0));
+      if (!newtile || newtile->header()->nodecount() == 0) {
+        continue;
+      }
+      const auto start_node = newtile->node(0);
+      const auto end_node = start_node + newtile->header()->nodecount();
+      for (auto node = start_node; node < end_node; ++node) {
+        if (!bounds_.Contains(node->latlng())) {
+          continue;
+        }
+        uint32_t length = 0;
         const DirectedEdge* directededge = newtile->directededge(node->edge_index());
         for (uint32_t i = 0; i < node->edge_count(); i++, directededge++) {
           // Exclude non-roads (parking, walkways, ferries, etc.)
           if (directededge->use() == Use::kRoad || directededge->use() == Use::kRamp ||
               directededge->use() == Use::kTurnChannel || directededge->use() == Use::kAlley ||
               directededge->use() == Use::kEmergencyAccess) {
-            roadlengths += directededge->length();
+            length += directededge->length();
+          }
+        }
+        if (length > 0) {
+          uint32_t cell = Row(node->latlng().lat()) * columns_ + Column(node->latlng().lng());
+          binned.emplace_back(cell, node_t{node->latlng(), length});
+        }
+      }
+    }
+
+    // Sort the nodes by cell, offsets_ has the index of the first node of
+    // each cell and one past the last node of the last cell
+    lengths_.assign(columns_ * rows_, 0);
+    offsets_.assign(columns_ * rows_ + 1, 0);
+    for (const auto& node : binned) {
+      lengths_[node.first] += node.second.length;
+      offsets_[node.first + 1]++;
+    }
+    for (size_t cell = 1; cell < offsets_.size(); ++cell) {
+      offsets_[cell] += offsets_[cell - 1];
+    }
+    nodes_.resize(binned.size());
+    std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+    for (const auto& node : binned) {
+      nodes_[next[node.first]++] = node.second;
+    }
+  }
+
+  /**
+   * Get the road length of the nodes within the density radius of a position
+   * in the tile. Adds up the same nodes as checking each node's distance.
+   * @param  ll  Lat,lng position
+   * @return  Returns the total length of the road edges (meters).
+   */
+  uint64_t RoadLength(const PointLL& ll) const {
+    float rm = kDensityRadius * kMetersPerKm;
+    float mr2 = rm * rm;
+
+    // Cells are only taken whole or skipped when they are clearly within or
+    // outside the radius, so rounding never decides which nodes are counted
+    float inner = mr2 * 0.999f;
+    float outer = mr2 * 1.001f;
+
+    // Use distance approximator for all distance checks
+    DistanceApproximator approximator(ll);
+    float lngdeg = (rm / DistanceApproximator::MetersPerLngDegree(ll.lat()));
+    int32_t minrow = std::max(Row(ll.lat() - kDensityLatDeg), 0);
+    int32_t maxrow = std::min(Row(ll.lat() + kDensityLatDeg), rows_ - 1);
+    int32_t mincol = std::max(Column(ll.lng() - lngdeg), 0);
+    int32_t maxcol = std::min(Column(ll.lng() + lngdeg), columns_ - 1);
+
+    uint64_t roadlengths = 0;
+    for (int32_t row = minrow; row <= maxrow; ++row) {
+      float miny = bounds_.miny() + row * cell_height_;
+      float maxy = miny + cell_height_;
+      for (int32_t col = mincol; col <= maxcol; ++col) {
+        uint32_t cell = row * columns_ + col;
+        if (lengths_[cell] == 0) {
+          continue;
+        }
+
+        // The corner of the cell farthest from the position and the point of
+        // the cell nearest to it
+        float minx = bounds_.minx() + col * cell_width_;
+        float maxx = minx + cell_width_;
+        PointLL farthest(ll.lng() - minx > maxx - ll.lng() ? minx : maxx,
+                         ll.lat() - miny > maxy - ll.lat() ? miny : maxy);
+        PointLL nearest(std::min(std::max(ll.lng(), minx), maxx),
+                        std::min(std::max(ll.lat(), miny), maxy));
+        if (approximator.DistanceSquared(farthest) < inner) {
+          roadlengths += lengths_[cell];
+        } else if (approximator.DistanceSquared(nearest) < outer) {
+          for (uint32_t n = offsets_[cell]; n < offsets_[cell + 1]; ++n) {
+            if (approximator.DistanceSquared(nodes_[n].ll) < mr2) {
+              roadlengths += nodes_[n].length;
+            }
           }
         }
       }
     }
+    return roadlengths;
   }
 
+protected:
+  struct node_t {
+    PointLL ll;
+    uint32_t length;
+  };
+
+  int32_t Column(float lng) const {
+    return std::min(static_cast<int32_t>(std::floor((lng - bounds_.minx()) / cell_width_)),
+                    columns_ - 1);
+  }
+
+  int32_t Row(float lat) const {
+    return std::min(static_cast<int32_t>(std::floor((lat - bounds_.miny()) / cell_height_)),
+                    rows_ - 1);
+  }
+
+  AABB2<PointLL> bounds_;
+  float cell_width_;
+  float cell_height_;
+  int32_t columns_;
+  int32_t rows_;
+  std::vector<uint64_t> lengths_; // total road length per cell, row by row
+  std::vector<uint32_t> offsets_; // first node of each cell
+  std::vector<node_t> nodes_;     // nodes with road length, cell by cell
+};
+
+/**
+ * Get the road density around the specified lat,lng position. This is a
+ * value from 0-15 indicating a relative road density. This can be used
+ * in costing methods to help avoid dense, urban areas.
+ * @param  grid          Road lengths around the tile of the position
+ * @param  ll            Lat,lng position
+ * @param  maxdensity    (OUT) max density found
+ * @return  Returns the relative road density (0-15) - higher values are
+ *          more dense.
+ */
+uint32_t GetDensity(const DensityGrid& grid, const PointLL& ll, enhancer_stats& stats) {
+  // Edge lengths are whole meters so the sum is exact
+  float roadlengths = grid.RoadLength(ll);
+
   // Form density measure as km/km^2. Convert roadlengths to km and divide by 2
   // (since 2 directed edges per edge)
   float density = (roadlengths * 0.0005f) / (kPi * kDensityRadius2);
@@ -947,8 +1062,9 @@ bool ConsistentNames(const std::string& country_code,
   return (!(street_names1->FindCommonBaseNames(*street_names2)->empty()));
 }
 
-// We make sure to lock on reading and writing because we dont want to race
-// since difference threads, use for the tilequeue as well
+// Tiles are written whole to a temporary file which then replaces the tile,
+// so each thread reads tiles with its own reader without locking. The lock
+// is only for the tilequeue
 void enhance(const boost::property_tree::ptree& pt,
              const std::string& access_file,
              const boost::property_tree::ptree& hierarchy_properties,
@@ -992,8 +1108,7 @@ void enhance(const boost::property_tree::ptree& pt,
 
   // Iterate through the tiles in the queue and perform enhancements
   while (true) {
-    // Get the next tile Id from the queue and get writeable and readable
-    // tile. Lock while we access the tile queue and get the tile.
+    // Get the next tile Id from the queue. Lock while we access the tile queue
     lock.lock();
     if (tilequeue.empty()) {
       lock.unlock();
@@ -1001,19 +1116,18 @@ void enhance(const boost::property_tree::ptree& pt,
     }
     GraphId tile_id = tilequeue.front();
     tilequeue.pop();
+    lock.unlock();
 
     // Get a readable tile.If the tile is empty, skip it. Empty tiles are
     // added where ways go through a tile but no end not is within the tile.
     // This allows creation of connectivity maps using the tile set,
     const GraphTile* tile = reader.GetGraphTile(tile_id);
     if (tile->header()->nodecount() == 0) {
-      lock.unlock();
       continue;
     }
 
     // Tile builder - serialize in existing tile so we can add admin names
     GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, true);
-    lock.unlock();
 
     // this will be our updated list of restrictions.
     // need to do some conversions on weights; therefore, we must update
@@ -1037,9 +1151,7 @@ void enhance(const boost::property_tree::ptree& pt,
         if (tile->id() == directededge.endnode().Tile_Base()) {
           endnodetile = tile;
         } else {
-          lock.lock();
           endnodetile = reader.GetGraphTile(directededge.endnode());
-          lock.unlock();
         }
 
         // If this edge is a link, update its use (potentially change short
@@ -1055,13 +1167,16 @@ void enhance(const boost::property_tree::ptree& pt,
       }
     }
 
+    // Road lengths around the tile for the density at its nodes
+    DensityGrid density_grid(reader, tiles.TileBounds(id), tiles, local_level);
+
     // Second pass - add admin information and edge transition information.
     for (uint32_t i = 0; i < tilebuilder.header()->nodecount(); i++) {
       GraphId startnode(id, local_level, i);
       NodeInfo& nodeinfo = tilebuilder.node_builder(i);
 
       // Get relative road density and local density
-      uint32_t density = GetDensity(reader, lock, nodeinfo.latlng(), stats, tiles, local_level);
+      uint32_t density = GetDensity(density_grid, nodeinfo.latlng(), stats);
       nodeinfo.set_density(density);
 
       uint32_t admin_index = nodeinfo.admin_index();
@@ -1127,9 +1242,7 @@ void enhance(const boost::property_tree::ptree& pt,
           end_admin_index = tile->node(directededge.endnode().id())->admin_index();
           end_node_code = tile->admin(end_admin_index)->country_iso();
         } else {
-          lock.lock();
           endnodetile = reader.GetGraphTile(directededge.endnode());
-          lock.unlock();
           end_admin_index = endnodetile->node(directededge.endnode().id())->admin_index();
           end_node_code = endnodetile->admin(end_admin_index)->country_iso();
         }
@@ -1257,7 +1370,7 @@ void enhance(const boost::property_tree::ptree& pt,
         }
 
         // Set unreachable (driving) flag
-        if (IsUnreachable(reader, lock, directededge)) {
+        if (IsUnreachable(reader, directededge)) {
           directededge.set_unreachable(true);
           stats.unreachable++;
         }
@@ -1265,7 +1378,7 @@ void enhance(const boost::property_tree::ptree& pt,
         // Check for not_thru edge (only on low importance edges). Exclude
         // transit edges
         if (directededge.classification() > RoadClass::kTertiary) {
-          if (IsNotThruEdge(reader, lock, startnode, directededge)) {
+          if (IsNotThruEdge(reader, startnode, directededge)) {
             directededge.set_not_thru(true);
             stats.not_thru++;
           }
@@ -1273,7 +1386,7 @@ void enhance(const boost::property_tree::ptree& pt,
 
         // Test if an internal intersection edge. Must do this after setting
         // opposing edge index
-        if (IsIntersectionInternal(&tilebuilder, reader, lock, startnode, nodeinfo, directededge,
+        if (IsIntersectionInternal(&tilebuilder, reader, startnode, nodeinfo, directededge,
                                    j)) {
           directededge.set_internal(true);
           stats.internalcount++;
@@ -1321,7 +1434,6 @@ void enhance(const boost::property_tree::ptree& pt,
     tilebuilder.AddAccessRestrictions(access_restrictions);
 
     // Write the new file
-    lock.lock();
     tilebuilder.StoreTileData();
     LOG_TRACE((boost::format("GraphEnhancer completed tile %1%") % tile_id).str());
 
@@ -1329,7 +1441,6 @@ void enhance(const boost::property_tree::ptree& pt,
     if (reader.OverCommitted()) {
       reader.Clear();
     }
-    lock.unlock();
   }
 
   if (admin_db_handle) {
@@ -1411,3 +1522,137 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt, const std::st
 
 } // namespace mjolnir
 } // namespace valhalla
+
+/**********************************************************************************************/
+
+#ifdef INLINE_TEST
+
+namespace {
+
+const std::string density_tile_dir = "test/data/density_tiles";
+
+// Road length of the edges of a node the way the density counts it
+uint32_t road_length(const GraphTile* tile, const NodeInfo* node) {
+  uint32_t length = 0;
+  const DirectedEdge* directededge = tile->directededge(node->edge_index());
+  for (uint32_t i = 0; i < node->edge_count(); i++, directededge++) {
+    if (directededge->use() == Use::kRoad || directededge->use() == Use::kRamp ||
+        directededge->use() == Use::kTurnChannel || directededge->use() == Use::kAlley ||
+        directededge->use() == Use::kEmergencyAccess) {
+      length += directededge->length();
+    }
+  }
+  return length;
+}
+
+// Fill the local tiles within a tile of the position with random nodes and
+// edges, some of which are not roads
+std::vector<int32_t> make_tiles(const PointLL& ll, std::mt19937& gen) {
+  const auto& local = TileHierarchy::levels().rbegin()->second;
+  auto bounds = local.tiles.TileBounds(local.tiles.TileId(ll));
+  auto size = local.tiles.TileSize();
+  auto tile_ids = local.tiles.TileList(AABB2<PointLL>(bounds.minx() - size, bounds.miny() - size,
+                                                      bounds.maxx() + size, bounds.maxy() + size));
+  const Use uses[] = {Use::kRoad, Use::kRamp, Use::kFootway, Use::kParkingAisle, Use::kAlley};
+  std::uniform_int_distribution<uint32_t> edge_count(1, 4), use(0, 4), length(1, 2000);
+  for (auto tile_id : tile_ids) {
+    auto tile_bounds = local.tiles.TileBounds(tile_id);
+    std::uniform_real_distribution<float> lng(tile_bounds.minx(), tile_bounds.maxx());
+    std::uniform_real_distribution<float> lat(tile_bounds.miny(), tile_bounds.maxy());
+    GraphTileBuilder tile(density_tile_dir, GraphId(tile_id, local.level, 0), false);
+    for (uint32_t n = 0; n < 2000; ++n) {
+      NodeInfo node;
+      node.set_latlng({lng(gen), lat(gen)});
+      node.set_edge_index(tile.directededges().size());
+      node.set_edge_count(edge_count(gen));
+      for (uint32_t i = 0; i < node.edge_count(); ++i) {
+        DirectedEdge edge;
+        edge.set_use(uses[use(gen)]);
+        edge.set_length(length(gen));
+        tile.directededges().emplace_back(std::move(edge));
+      }
+      tile.nodes().emplace_back(std::move(node));
+    }
+    tile.StoreTileData();
+  }
+  return tile_ids;
+}
+
+// Check the road length the grid finds around positions in the tile of the
+// position against adding up every node within the radius
+void check_road_length(const PointLL& ll) {
+  std::mt19937 gen(static_cast<uint32_t>(ll.lng() * 1000 + ll.lat()));
+  boost::filesystem::remove_all(density_tile_dir);
+  auto tile_ids = make_tiles(ll, gen);
+
+  boost::property_tree::ptree conf;
+  conf.put("tile_dir", density_tile_dir);
+  GraphReader reader(conf);
+  const auto& local = TileHierarchy::levels().rbegin()->second;
+  auto bounds = local.tiles.TileBounds(local.tiles.TileId(ll));
+  DensityGrid grid(reader, bounds, local.tiles, local.level);
+
+  // The nodes of the tile, its corners and random positions in it
+  std::vector<PointLL> positions{bounds.minpt(), bounds.maxpt(), {bounds.minx(), bounds.maxy()},
+                                 {bounds.maxx(), bounds.miny()}};
+  const GraphTile* tile = reader.GetGraphTile(GraphId(local.tiles.TileId(ll), local.level, 0));
+  for (uint32_t n = 0; n < tile->header()->nodecount(); ++n) {
+    positions.push_back(tile->node(n)->latlng());
+  }
+  std::uniform_real_distribution<float> lng(bounds.minx(), bounds.maxx());
+  std::uniform_real_distribution<float> lat(bounds.miny(), bounds.maxy());
+  for (uint32_t i = 0; i < 1000; ++i) {
+    positions.emplace_back(lng(gen), lat(gen));
+  }
+
+  float rm = kDensityRadius * kMetersPerKm;
+  float mr2 = rm * rm;
+  for (const auto& position : positions) {
+    DistanceApproximator approximator(position);
+    uint64_t expected = 0;
+    for (auto tile_id : tile_ids) {
+      const GraphTile* other = reader.GetGraphTile(GraphId(tile_id, local.level, 0));
+      for (uint32_t n = 0; n < other->header()->nodecount(); ++n) {
+        const NodeInfo* node = other->node(n);
+        if (approximator.DistanceSquared(node->latlng()) < mr2) {
+          expected += road_length(other, node);
+        }
+      }
+    }
+    auto length = grid.RoadLength(position);
+    if (length != expected) {
+      throw std::logic_error("Road length at " + std::to_string(position.lat()) + "," +
+                             std::to_string(position.lng()) + " should be " +
+                             std::to_string(expected) + " but was " + std::to_string(length));
+    }
+  }
+  boost::filesystem::remove_all(density_tile_dir);
+}
+
+void TestRoadLength() {
+  check_road_length({5.1f, 52.1f});
+}
+
+void TestRoadLengthHighLatitude() {
+  check_road_length({15.6f, 78.2f});
+  check_road_length({-40.1f, -84.9f});
+}
+
+void TestRoadLengthAntimeridian() {
+  check_road_length({179.9f, -17.8f});
+  check_road_length({-179.9f, 65.6f});
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("graphenhancer");
+
+  suite.test(TEST_CASE(TestRoadLength));
+  suite.test(TEST_CASE(TestRoadLengthHighLatitude));
+  suite.test(TEST_CASE(TestRoadLengthAntimeridian));
+
+  return suite.tear_down();
+}
+
+#endif
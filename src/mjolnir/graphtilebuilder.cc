@@ -14,6 +14,21 @@
 
 using namespace valhalla::baldr;
 
+namespace {
+
+// Tiles are written to a temporary file next to the tile which then replaces
+// it in one go. Threads reading tiles while others are being written never
+// see part of a tile, readers which opened the old file keep reading it.
+std::string TempTilePath(const boost::filesystem::path& filename) {
+  return filename.string() + ".tmp";
+}
+
+void ReplaceTile(const boost::filesystem::path& filename) {
+  boost::filesystem::rename(TempTilePath(filename), filename);
+}
+
+} // namespace
+
 namespace valhalla {
 namespace mjolnir {
 
@@ -181,7 +196,7 @@ void GraphTileBuilder::StoreTileData() {
 
   // Open file and truncate
   std::stringstream in_mem;
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  std::ofstream file(TempTilePath(filename), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
     // Write the nodes
     header_builder_.set_nodecount(nodes_builder_.size());
@@ -336,6 +351,7 @@ void GraphTileBuilder::StoreTileData() {
     file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
     file << in_mem.rdbuf();
     file.close();
+    ReplaceTile(filename);
   } else {
     throw std::runtime_error("Failed to open file " + filename.string());
   }
@@ -356,7 +372,7 @@ void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
   }
 
   // Open file. Truncate so we replace the contents.
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  std::ofstream file(TempTilePath(filename), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
     // Write the header
     file.write(reinterpret_cast<const char*>(header_), sizeof(GraphTileHeader));
@@ -379,6 +395,7 @@ void GraphTileBuilder::Update(const std::vector<NodeInfo>& nodes,
     auto end = reinterpret_cast<const char*>(header()) + header()->end_offset();
     file.write(begin, end - begin);
     file.close();
+    ReplaceTile(filename);
   } else {
     throw std::runtime_error("GraphTileBuilder::Update - Failed to open file " + filename.string());
   }
@@ -859,7 +876,7 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
   if (!boost::filesystem::exists(filename.parent_path())) {
     boost::filesystem::create_directories(filename.parent_path());
   }
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  std::ofstream file(TempTilePath(filename), std::ios::out | std::ios::binary | std::ios::trunc);
   // open it
   if (file.is_open()) {
     // new header
@@ -876,6 +893,8 @@ void GraphTileBuilder::AddBins(const std::string& tile_dir,
     begin = reinterpret_cast<const char*>(tile->GetBin(kBinsDim - 1, kBinsDim - 1).end());
     end = reinterpret_cast<const char*>(tile->header()) + tile->header()->end_offset();
     file.write(begin, end - begin);
+    file.close();
+    ReplaceTile(filename);
   } // failed
   else {
     throw std::runtime_error("Failed to open file " + filename.string());
@@ -992,7 +1011,7 @@ void GraphTileBuilder::UpdateTrafficSegments(const bool update_dir_edges) {
 
   // Open file and truncate
   std::stringstream in_mem;
-  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  std::ofstream file(TempTilePath(filename), std::ios::out | std::ios::binary | std::ios::trunc);
   if (file.is_open()) {
     // Write a new header
     file.write(reinterpret_cast<const char*>(&header_builder_), sizeof(GraphTileHeader));
@@ -1040,6 +1059,7 @@ void GraphTileBuilder::UpdateTrafficSegments(const bool update_dir_edges) {
 
     // Close the file
     file.close();
+    ReplaceTile(filename);
   }
 }
 
@@ -349,9 +349,7 @@ void validate(
     std::vector<DirectedEdge> directededges;
 
     // Get this tile
-    lock.lock();
     const GraphTile* tile = graph_reader.GetGraphTile(tile_id);
-    lock.unlock();
 
     // Iterate through the nodes and the directed edges
     uint32_t dupcount = 0;
@@ -422,9 +420,7 @@ void validate(
           directededge.set_leaves_tile(true);
 
           // Get the end node tile
-          lock.lock();
           endnode_tile = graph_reader.GetGraphTile(directededge.endnode());
-          lock.unlock();
           // make sure this is set to false as access tag logic could of set this to true.
         } else {
           directededge.set_leaves_tile(false);
@@ -505,8 +501,8 @@ void validate(
     // Bin the edges
     auto bins = GraphTileBuilder::BinEdges(tile, tweeners);
 
-    // Write the new tile
-    lock.lock();
+    // Write the new tile. Tiles are written whole to a temporary file which
+    // then replaces the tile, so the other threads read tiles without locking
     tilebuilder.Update(nodes, directededges);
 
     // Write the bins to it
@@ -519,7 +515,6 @@ void validate(
     if (graph_reader.OverCommitted()) {
       graph_reader.Clear();
     }
-    lock.unlock();
 
     // Add possible duplicates to return class
     duplicates[level] += dupcount;
@@ -3,10 +3,17 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <atomic>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -93,23 +100,25 @@ bool AddUpwardTransition(const GraphId& node,
   }
 }
 
-void SortSequences() {
+void SortSequences(unsigned int threads) {
   // Sort the new nodes. Sort so highway level is first
   sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-  new_to_old.sort([](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
-    if (a.first.level() == b.first.level()) {
-      if (a.first.tileid() == b.first.tileid()) {
-        return a.first.id() < b.first.id();
-      }
-      return a.first.tileid() < b.first.tileid();
-    }
-    return a.first.level() < b.first.level();
-  });
+  new_to_old.sort(
+      [](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
+        if (a.first.level() == b.first.level()) {
+          if (a.first.tileid() == b.first.tileid()) {
+            return a.first.id() < b.first.id();
+          }
+          return a.first.tileid() < b.first.tileid();
+        }
+        return a.first.level() < b.first.level();
+      },
+      threads);
 
   // Sort old to new by node Id
   sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
   old_to_new.sort(
-      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; });
+      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; }, threads);
 }
 
 // Convencience method to find the node association.
@@ -126,14 +135,19 @@ OldToNewNodes find_nodes(sequence<OldToNewNodes>& old_to_new, const GraphId& nod
   }
 }
 
-// Form tiles in the new level.
-void FormTilesInNewLevel(GraphReader& reader, bool has_elevation) {
-  // Use the sequence that associate new nodes to old nodes
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-
-  // Use the sorted sequence that associates old nodes to new nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+// A range of the sorted new to old node associations which are all in the same new tile
+struct NewTile {
+  GraphId tile_id;
+  size_t begin;
+  size_t end;
+};
 
+// Form a tile in the new level from its range of new nodes.
+void FormTileInNewLevel(GraphReader& reader,
+                        sequence<std::pair<GraphId, GraphId>>& new_to_old,
+                        sequence<OldToNewNodes>& old_to_new,
+                        const NewTile& new_tile,
+                        bool has_elevation) {
   // lambda to indicate whether a directed edge should be included
   auto include_edge = [&old_to_new](const DirectedEdge* directededge, const GraphId& base_node,
                                     const uint8_t current_level) {
@@ -157,37 +171,20 @@ void FormTilesInNewLevel(GraphReader& reader, bool has_elevation) {
     }
   };
 
-  // Iterate through the new nodes. They have been sorted by level so that
-  // highway level is done first.
-  reader.Clear();
+  // New tilebuilder for the tile
   bool added = false;
-  uint8_t current_level;
-  GraphId tile_id;
+  uint8_t current_level = new_tile.tile_id.level();
   std::hash<std::string> hasher;
-  GraphTileBuilder* tilebuilder = nullptr;
-  for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++) {
-    // Get the node - check if a new tile
-    GraphId nodea = (*new_node).first;
-    if (nodea.Tile_Base() != tile_id) {
-      // Store the prior tile
-      if (tilebuilder != nullptr) {
-        tilebuilder->StoreTileData();
-        delete tilebuilder;
-      }
+  std::unique_ptr<GraphTileBuilder> tilebuilder(
+      new GraphTileBuilder(reader.tile_dir(), new_tile.tile_id, false));
 
-      // New tilebuilder for the next tile. Update current level.
-      tile_id = nodea.Tile_Base();
-      tilebuilder = new GraphTileBuilder(reader.tile_dir(), tile_id, false);
-      current_level = nodea.level();
-
-      // Check if we need to clear the base/local tile cache
-      if (reader.OverCommitted()) {
-        reader.Clear();
-      }
-    }
+  // Iterate through the new nodes in the tile
+  for (size_t n = new_tile.begin; n < new_tile.end; ++n) {
+    std::pair<GraphId, GraphId> new_node = *new_to_old[n];
+    GraphId nodea = new_node.first;
 
     // Get the node in the base level
-    GraphId base_node = (*new_node).second;
+    GraphId base_node = new_node.second;
     const GraphTile* tile = reader.GetGraphTile(base_node);
     if (tile == nullptr) {
       LOG_ERROR("Base tile is null? ");
@@ -321,37 +318,182 @@ void FormTilesInNewLevel(GraphReader& reader, bool has_elevation) {
     // Add transition edges
     auto new_nodes = find_nodes(old_to_new, base_node);
     if (current_level == 0) {
-      AddDownwardTransition(new_nodes.arterial_node, tilebuilder, has_elevation);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder, has_elevation);
+      AddDownwardTransition(new_nodes.arterial_node, tilebuilder.get(), has_elevation);
+      AddDownwardTransition(new_nodes.local_node, tilebuilder.get(), has_elevation);
     } else if (current_level == 1) {
-      AddDownwardTransition(new_nodes.local_node, tilebuilder, has_elevation);
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder, has_elevation);
+      AddDownwardTransition(new_nodes.local_node, tilebuilder.get(), has_elevation);
+      AddUpwardTransition(new_nodes.highway_node, tilebuilder.get(), has_elevation);
     }
     if (current_level == 2) {
-      AddUpwardTransition(new_nodes.arterial_node, tilebuilder, has_elevation);
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder, has_elevation);
+      AddUpwardTransition(new_nodes.arterial_node, tilebuilder.get(), has_elevation);
+      AddUpwardTransition(new_nodes.highway_node, tilebuilder.get(), has_elevation);
     }
 
     // Set the edge count for the new node
     node.set_edge_count(tilebuilder->directededges().size() - edge_count);
   }
 
-  // Delete the tile builder
-  if (tilebuilder != nullptr) {
-    tilebuilder->StoreTileData();
-    delete tilebuilder;
+  // Store the tile
+  tilebuilder->StoreTileData();
+}
+
+// Form tiles in the new level from the queue until there are none left. Each thread has its own
+// reader and handles to the sequences
+void FormTilesInNewLevel(const boost::property_tree::ptree& pt,
+                         std::deque<NewTile>& tilequeue,
+                         std::mutex& lock,
+                         bool has_elevation,
+                         std::promise<void>& result) {
+  try {
+    GraphReader reader(pt);
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+    while (true) {
+      lock.lock();
+      if (tilequeue.empty()) {
+        lock.unlock();
+        break;
+      }
+      NewTile new_tile = tilequeue.front();
+      tilequeue.pop_front();
+      lock.unlock();
+
+      FormTileInNewLevel(reader, new_to_old, old_to_new, new_tile, has_elevation);
+
+      // Check if we need to clear the base/local tile cache
+      if (reader.OverCommitted()) {
+        reader.Clear();
+      }
+    }
+  } // Send the failure back to the main thread
+  catch (std::exception& e) {
+    result.set_exception(std::current_exception());
+    LOG_ERROR(std::string("Failed to form tiles in new level: ") + e.what());
+    return;
+  }
+  result.set_value();
+}
+
+// Form tiles in the new levels. The new nodes have been sorted by level so that highway level is
+// done first. Each level is done separately, in parallel over its tiles, because the new local
+// tiles replace the base tiles which all the levels are formed from
+void FormTilesInNewLevels(const boost::property_tree::ptree& pt,
+                          bool has_elevation,
+                          unsigned int threads) {
+  // Find the range of new nodes in each new tile
+  std::map<uint8_t, std::deque<NewTile>> levels;
+  {
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    for (size_t n = 0; n < new_to_old.size(); ++n) {
+      GraphId tile_id = (*new_to_old[n]).first.Tile_Base();
+      auto& tiles = levels[tile_id.level()];
+      if (tiles.empty() || tiles.back().tile_id != tile_id) {
+        tiles.push_back({tile_id, n, n});
+      }
+      ++tiles.back().end;
+    }
+  }
+
+  // Form the tiles of each level
+  for (auto& level : levels) {
+    std::mutex lock;
+    std::vector<std::shared_ptr<std::thread>> workers(threads);
+    std::list<std::promise<void>> results;
+    for (auto& worker : workers) {
+      results.emplace_back();
+      worker.reset(new std::thread(FormTilesInNewLevel, std::cref(pt), std::ref(level.second),
+                                   std::ref(lock), has_elevation, std::ref(results.back())));
+    }
+
+    // Wait for the threads to finish, a failure in any of them is rethrown here
+    for (auto& worker : workers) {
+      worker->join();
+    }
+    for (auto& result : results) {
+      result.get_future().get();
+    }
   }
 }
 
+// The levels a base node exists on and which tiles it falls in on those levels
+struct NodeLevels {
+  bool levels[3];
+  uint32_t highway_tile;
+  uint32_t arterial_tile;
+  uint32_t density;
+};
+
+// The levels of all the nodes in a base tile
+struct TileNodeLevels {
+  bool has_elevation;
+  std::vector<NodeLevels> nodes;
+};
+
+/**
+ * Find which hierarchy levels each node in a base tile exists on.
+ * @param  reader        Graph reader.
+ * @param  base_tile_id  Tile on the base/local level.
+ * @return Returns the levels of the nodes in the tile and whether the tile has edge elevation.
+ */
+TileNodeLevels GetNodeLevels(GraphReader& reader, const GraphId& base_tile_id) {
+  // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
+  TileNodeLevels result{false};
+  const GraphTile* tile = reader.GetGraphTile(base_tile_id);
+  if (tile == nullptr || tile->header()->nodecount() == 0) {
+    return result;
+  }
+
+  // Update the has_elevation flag
+  result.has_elevation = tile->header()->has_edge_elevation();
+
+  // Hierarchy level information
+  auto tile_level = TileHierarchy::levels().rbegin();
+  tile_level++;
+  auto& arterial_level = tile_level->second;
+  tile_level++;
+  auto& highway_level = tile_level->second;
+
+  // Iterate through the nodes. Nodes exist on the new level when best
+  // road class <= the new level classification cutoff
+  uint32_t nodecount = tile->header()->nodecount();
+  result.nodes.resize(nodecount);
+  GraphId edgeid = base_tile_id;
+  const NodeInfo* nodeinfo = tile->node(base_tile_id);
+  for (uint32_t i = 0; i < nodecount; i++, nodeinfo++) {
+    // Iterate through the edges to see which levels this node exists.
+    auto& node = result.nodes[i];
+    bool* levels = node.levels;
+    levels[0] = levels[1] = levels[2] = false;
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
+      // Update the flag for the level of this edge (skip transit
+      // connection edges)
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      if (directededge->use() != Use::kTransitConnection &&
+          directededge->use() != Use::kEgressConnection &&
+          directededge->use() != Use::kPlatformConnection) {
+        levels[TileHierarchy::get_level(directededge->classification())] = true;
+      }
+    }
+    node.highway_tile = levels[0] ? highway_level.tiles.TileId(nodeinfo->latlng()) : 0;
+    node.arterial_tile = levels[1] ? arterial_level.tiles.TileId(nodeinfo->latlng()) : 0;
+    node.density = nodeinfo->density();
+  }
+  return result;
+}
+
 /**
  * Create node associations between "new" nodes placed into respective
  * hierarchy levels and the existing nodes on the base/local level. The
  * associations go both ways: from the "old" nodes on the base/local level
  * to new nodes (using a mapping in memory) and from new nodes to old nodes
- * using a sequence (file).
+ * using a sequence (file). The levels of the nodes in each tile are found
+ * in parallel but the new node Ids are assigned in tile order so they are
+ * the same no matter how many threads are used.
  * @return  Returns true if any base tiles have edge elevation data.
  */
-bool CreateNodeAssociations(GraphReader& reader) {
+bool CreateNodeAssociations(const boost::property_tree::ptree& pt,
+                            GraphReader& reader,
+                            unsigned int threads) {
   // Map of tiles vs. count of nodes. Used to construct new node Ids.
   std::unordered_map<GraphId, uint32_t> new_nodes;
 
@@ -385,79 +527,99 @@ bool CreateNodeAssociations(GraphReader& reader) {
 
   // Get the set of tiles on the local level
   auto local_tiles = reader.GetTileSet(base_level.level);
+  std::vector<GraphId> base_tiles(local_tiles.begin(), local_tiles.end());
+
+  // Each thread gets its own reader
+  std::vector<std::unique_ptr<GraphReader>> readers;
+  for (unsigned int i = 0; i < threads; ++i) {
+    readers.emplace_back(new GraphReader(pt));
+  }
 
-  // Iterate through all tiles in the local level
+  // Iterate through all tiles in the local level, a batch at a time
   bool has_elevation = false;
-  uint32_t ntiles = base_level.tiles.TileCount();
-  uint32_t bl = static_cast<uint32_t>(base_level.level);
   uint32_t al = static_cast<uint32_t>(arterial_level.level);
   uint32_t hl = static_cast<uint32_t>(highway_level.level);
-  for (const auto& base_tile_id : local_tiles) {
-    // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
-    const GraphTile* tile = reader.GetGraphTile(base_tile_id);
-    if (tile == nullptr || tile->header()->nodecount() == 0) {
-      continue;
+  std::vector<TileNodeLevels> batch;
+  for (size_t batch_start = 0; batch_start < base_tiles.size(); batch_start += batch.size()) {
+    // Find the levels of the nodes in each tile of this batch in parallel
+    batch.clear();
+    batch.resize(std::min(static_cast<size_t>(threads) * 64, base_tiles.size() - batch_start));
+    std::atomic<size_t> next(0);
+    std::vector<std::shared_ptr<std::thread>> workers;
+    std::list<std::promise<void>> results;
+    for (auto& tile_reader : readers) {
+      results.emplace_back();
+      auto& result = results.back();
+      workers.emplace_back(
+          new std::thread([&tile_reader, &batch, &base_tiles, &next, &result, batch_start]() {
+            try {
+              for (size_t i = next++; i < batch.size(); i = next++) {
+                batch[i] = GetNodeLevels(*tile_reader, base_tiles[batch_start + i]);
+
+                // Check if we need to clear the tile cache
+                if (tile_reader->OverCommitted()) {
+                  tile_reader->Clear();
+                }
+              }
+            } // Send the failure back to the main thread
+            catch (std::exception& e) {
+              result.set_exception(std::current_exception());
+              LOG_ERROR(std::string("Failed to get node levels: ") + e.what());
+              return;
+            }
+            result.set_value();
+          }));
     }
 
-    // Update the has_elevation flag
-    if (tile->header()->has_edge_elevation()) {
-      has_elevation = true;
+    // Wait for the threads to finish, a failure in any of them is rethrown here
+    for (auto& worker : workers) {
+      worker->join();
+    }
+    for (auto& result : results) {
+      result.get_future().get();
     }
 
-    // Iterate through the nodes. Add nodes to the new level when
-    // best road class <= the new level classification cutoff
-    bool levels[3];
-    uint32_t nodecount = tile->header()->nodecount();
-    GraphId basenode = base_tile_id;
-    GraphId edgeid = base_tile_id;
-    const NodeInfo* nodeinfo = tile->node(basenode);
-    for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
-      // Iterate through the edges to see which levels this node exists.
-      levels[0] = levels[1] = levels[2] = false;
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
-        // Update the flag for the level of this edge (skip transit
-        // connection edges)
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        if (directededge->use() != Use::kTransitConnection &&
-            directededge->use() != Use::kEgressConnection &&
-            directededge->use() != Use::kPlatformConnection) {
-          levels[TileHierarchy::get_level(directededge->classification())] = true;
-        }
-      }
-
-      // Associate new nodes to base nodes and base node to new nodes
-      GraphId highway_node, arterial_node, local_node;
-      if (levels[0]) {
-        // New node is on the highway level. Associate back to base/local node
-        GraphId new_tile(highway_level.tiles.TileId(nodeinfo->latlng()), hl, 0);
-        highway_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(highway_node, basenode));
-      }
-      if (levels[1]) {
-        // New node is on the arterial level. Associate back to base/local node
-        GraphId new_tile(arterial_level.tiles.TileId(nodeinfo->latlng()), al, 0);
-        arterial_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(arterial_node, basenode));
-      }
-      if (levels[2]) {
-        // New node is on the local level. Associate back to base/local node
-        local_node = get_new_node(base_tile_id);
-        new_to_old.push_back(std::make_pair(local_node, basenode));
+    // Associate the nodes in tile order
+    for (size_t t = 0; t < batch.size(); ++t) {
+      // Update the has_elevation flag
+      if (batch[t].has_elevation) {
+        has_elevation = true;
       }
 
-      if (!levels[0] && !levels[1] && !levels[2]) {
-        LOG_ERROR("No valid level for this node!");
-      }
+      const GraphId& base_tile_id = base_tiles[batch_start + t];
+      GraphId basenode = base_tile_id;
+      for (const auto& node : batch[t].nodes) {
+        // Associate new nodes to base nodes and base node to new nodes
+        const bool* levels = node.levels;
+        GraphId highway_node, arterial_node, local_node;
+        if (levels[0]) {
+          // New node is on the highway level. Associate back to base/local node
+          GraphId new_tile(node.highway_tile, hl, 0);
+          highway_node = get_new_node(new_tile);
+          new_to_old.push_back(std::make_pair(highway_node, basenode));
+        }
+        if (levels[1]) {
+          // New node is on the arterial level. Associate back to base/local node
+          GraphId new_tile(node.arterial_tile, al, 0);
+          arterial_node = get_new_node(new_tile);
+          new_to_old.push_back(std::make_pair(arterial_node, basenode));
+        }
+        if (levels[2]) {
+          // New node is on the local level. Associate back to base/local node
+          local_node = get_new_node(base_tile_id);
+          new_to_old.push_back(std::make_pair(local_node, basenode));
+        }
 
-      // Associate the old node to the new node(s). Entries in the tuple
-      // that are invalid nodes indicate no node exists in the new level.
-      OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, nodeinfo->density());
-      old_to_new.push_back(assoc);
-    }
+        if (!levels[0] && !levels[1] && !levels[2]) {
+          LOG_ERROR("No valid level for this node!");
+        }
 
-    // Check if we need to clear the tile cache
-    if (reader.OverCommitted()) {
-      reader.Clear();
+        // Associate the old node to the new node(s). Entries in the tuple
+        // that are invalid nodes indicate no node exists in the new level.
+        OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, node.density);
+        old_to_new.push_back(assoc);
+        ++basenode;
+      }
     }
   }
   return has_elevation;
@@ -557,26 +719,27 @@ namespace mjolnir {
 // base level. Each successive level of the hierarchy is based on
 // and connected to the next.
 void HierarchyBuilder::Build(const boost::property_tree::ptree& pt) {
-
-  // TODO: thread this. Might be more possible now that we don't create
-  // shortcuts in the HierarchyBuilder
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
 
   // Construct GraphReader
   LOG_INFO("HierarchyBuilder");
   GraphReader reader(pt.get_child("mjolnir"));
 
   // Association of old nodes to new nodes
-  bool has_elevation = CreateNodeAssociations(reader);
+  bool has_elevation = CreateNodeAssociations(pt.get_child("mjolnir"), reader, threads);
   if (has_elevation) {
     LOG_INFO("Base tiles have edge elevation information");
   }
 
   // Sort the sequences
-  SortSequences();
+  SortSequences(threads);
 
   // Iterate through the hierarchy (from highway down to local) and build
   // new tiles
-  FormTilesInNewLevel(reader, has_elevation);
+  reader.Clear();
+  FormTilesInNewLevels(pt.get_child("mjolnir"), has_elevation, threads);
 
   // Remove any base tiles that no longer have any data (nodes and edges
   // only exist on arterial and highway levels)
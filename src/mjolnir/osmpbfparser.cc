@@ -33,6 +33,13 @@
 #else
 #include <netinet/in.h>
 #endif
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <zlib.h>
@@ -81,9 +88,7 @@ BlobHeader read_header(char* buffer, std::ifstream& file, bool& finished) {
   return result;
 }
 
-int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const BlobHeader& header) {
-  Blob blob;
-
+void read_blob(std::string& blob, std::ifstream& file, const BlobHeader& header) {
   // is the size of the following blob sane
   int32_t sz = header.datasize();
   if (sz > MAX_UNCOMPRESSED_BLOB_SIZE) {
@@ -91,23 +96,29 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   }
 
   // pull out the bytes
-  if (!file.read(buffer, sz)) {
+  blob.resize(sz);
+  if (!file.read(&blob[0], sz)) {
     throw std::runtime_error("unable to read blob from file");
   }
+}
+
+int32_t unpack_blob(const std::string& bytes, char* unpack_buffer) {
+  Blob blob;
 
   // turn it into a protobuf object
-  if (!blob.ParseFromArray(buffer, sz)) {
+  if (!blob.ParseFromArray(bytes.data(), bytes.size())) {
     throw std::runtime_error("unable to parse blob");
   }
 
   // if the blob was uncompressed
+  int32_t sz;
   if (blob.has_raw()) {
     // check that raw_size is set correctly and move it to the final buffer
     sz = blob.raw().size();
     if (sz != blob.raw_size()) {
       LOG_WARN("blob reports wrong raw_size: " + std::to_string(blob.raw_size()) + " bytes");
     }
-    memcpy(unpack_buffer, buffer, sz);
+    memcpy(unpack_buffer, bytes.data(), sz);
     return sz;
   } // if the blob was zlib compressed
   else if (blob.has_zlib_data()) {
@@ -139,6 +150,18 @@ int32_t read_blob(char* buffer, char* unpack_buffer, std::ifstream& file, const
   throw std::runtime_error("Unsupported blob data format");
 }
 
+// an osm object (or changeset) decoded from a primitive block waiting to be handed to the callback
+struct element_t {
+  Interest type;
+  uint64_t osmid;
+  double lng;
+  double lat;
+  Tags tags;
+  std::vector<uint64_t> nodes;
+  std::vector<Member> members;
+};
+using elements_t = std::vector<element_t>;
+
 template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::PrimitiveBlock& primblock) {
   OSMPBF::Tags result(object.keys_size());
   for (int i = 0; i < object.keys_size(); ++i) {
@@ -154,7 +177,9 @@ template <class T> OSMPBF::Tags get_tags(const T& object, const OSMPBF::Primitiv
 void parse_primitive_block(char* unpack_buffer,
                            int32_t sz,
                            const Interest interest,
-                           Callback& callback) {
+                           Callback& callback,
+                           const size_t thread,
+                           elements_t& elements) {
   // turn the blob bytes into a protobuf object
   PrimitiveBlock primblock;
   if (!primblock.ParseFromArray(unpack_buffer, sz)) {
@@ -170,9 +195,13 @@ void parse_primitive_block(char* unpack_buffer,
       for (const auto& node : primitive_group.nodes()) {
         double lon = 0.000000001 * (primblock.lon_offset() + (primblock.granularity() * node.lon()));
         double lat = 0.000000001 * (primblock.lat_offset() + (primblock.granularity() * node.lat()));
-        callback.node_callback(node.id(), lon, lat, get_tags<Node>(node, primblock));
+        auto tags = get_tags<Node>(node, primblock);
+        if (callback.transform_callback(thread, NODES, node.id(), tags)) {
+          elements.push_back(element_t{NODES, static_cast<uint64_t>(node.id()), lon, lat,
+                                       std::move(tags)});
+        }
         if (node.has_info() && node.info().has_changeset() && (interest & CHANGESETS) == CHANGESETS) {
-          callback.changeset_callback(node.info().changeset());
+          elements.push_back(element_t{CHANGESETS, static_cast<uint64_t>(node.info().changeset())});
         }
       }
 
@@ -203,12 +232,14 @@ void parse_primitive_block(char* unpack_buffer,
             tags[key_string] = val_string;
           }
           ++current_kv;
-          callback.node_callback(id, lon, lat, tags);
+          if (callback.transform_callback(thread, NODES, id, tags)) {
+            elements.push_back(element_t{NODES, id, lon, lat, std::move(tags)});
+          }
         }
         if (dense_nodes.has_denseinfo() && (interest & CHANGESETS) == CHANGESETS) {
           uint64_t changeset = 0;
           for (auto changeset_id_offset : dense_nodes.denseinfo().changeset()) {
-            callback.changeset_callback(changeset += changeset_id_offset);
+            elements.push_back(element_t{CHANGESETS, changeset += changeset_id_offset});
           }
         }
       }
@@ -217,19 +248,23 @@ void parse_primitive_block(char* unpack_buffer,
     // do the ways
     if ((interest & WAYS) == WAYS) {
       for (const auto& way : primitive_group.ways()) {
-        uint64_t node = 0;
-        std::vector<uint64_t> nodes;
-        nodes.reserve(way.refs_size());
-        for (auto node_id_offset : way.refs()) {
-          node += node_id_offset;
-          // TODO: skip consecutive duplicates, make this configurable
-          if (nodes.size() == 0 || node != nodes.back()) {
-            nodes.push_back(node);
+        auto tags = get_tags<Way>(way, primblock);
+        if (callback.transform_callback(thread, WAYS, way.id(), tags)) {
+          uint64_t node = 0;
+          std::vector<uint64_t> nodes;
+          nodes.reserve(way.refs_size());
+          for (auto node_id_offset : way.refs()) {
+            node += node_id_offset;
+            // TODO: skip consecutive duplicates, make this configurable
+            if (nodes.size() == 0 || node != nodes.back()) {
+              nodes.push_back(node);
+            }
           }
+          elements.push_back(element_t{WAYS, static_cast<uint64_t>(way.id()), 0, 0, std::move(tags),
+                                       std::move(nodes)});
         }
-        callback.way_callback(way.id(), get_tags<Way>(way, primblock), nodes);
         if (way.has_info() && way.info().has_changeset() && (interest & CHANGESETS) == CHANGESETS) {
-          callback.changeset_callback(way.info().changeset());
+          elements.push_back(element_t{CHANGESETS, static_cast<uint64_t>(way.info().changeset())});
         }
       }
     }
@@ -237,18 +272,23 @@ void parse_primitive_block(char* unpack_buffer,
     // do the relations
     if ((interest & RELATIONS) == RELATIONS) {
       for (const auto& relation : primitive_group.relations()) {
-        uint64_t member = 0;
-        std::vector<Member> members;
-        members.reserve(relation.memids_size());
-        for (int l = 0; l < relation.memids_size(); ++l) {
-          member += relation.memids(l);
-          members.emplace_back(relation.types(l), member,
-                               primblock.stringtable().s(relation.roles_sid(l)));
+        auto tags = get_tags<Relation>(relation, primblock);
+        if (callback.transform_callback(thread, RELATIONS, relation.id(), tags)) {
+          uint64_t member = 0;
+          std::vector<Member> members;
+          members.reserve(relation.memids_size());
+          for (int l = 0; l < relation.memids_size(); ++l) {
+            member += relation.memids(l);
+            members.emplace_back(relation.types(l), member,
+                                 primblock.stringtable().s(relation.roles_sid(l)));
+          }
+          elements.push_back(element_t{RELATIONS, static_cast<uint64_t>(relation.id()), 0, 0,
+                                       std::move(tags), {}, std::move(members)});
         }
-        callback.relation_callback(relation.id(), get_tags<Relation>(relation, primblock), members);
         if (relation.has_info() && relation.info().has_changeset() &&
             (interest & CHANGESETS) == CHANGESETS) {
-          callback.changeset_callback(relation.info().changeset());
+          elements.push_back(
+              element_t{CHANGESETS, static_cast<uint64_t>(relation.info().changeset())});
         }
       }
     }
@@ -256,7 +296,7 @@ void parse_primitive_block(char* unpack_buffer,
     // do the changesets
     if ((interest & CHANGESETS) == CHANGESETS) {
       for (const auto& changeset : primitive_group.changesets()) {
-        callback.changeset_callback(changeset.id());
+        elements.push_back(element_t{CHANGESETS, static_cast<uint64_t>(changeset.id())});
       }
     }
   }
@@ -272,6 +312,56 @@ void parse_header_block(char* unpack_buffer, int32_t sz) {
   // TODO: do something with replication information?
 }
 
+// decompress and decode a blob, this is the part of the parsing that can happen in parallel
+void decode_blob(const BlobHeader& header,
+                 const std::string& blob,
+                 char* unpack_buffer,
+                 const Interest interest,
+                 Callback& callback,
+                 const size_t thread,
+                 elements_t& elements) {
+  int32_t sz = unpack_blob(blob, unpack_buffer);
+  // if its data parse it
+  if (header.type() == "OSMData") {
+    parse_primitive_block(unpack_buffer, sz, interest, callback, thread, elements);
+    // if its something other than a header
+  } else if (header.type() == "OSMHeader") {
+    parse_header_block(unpack_buffer, sz);
+  } else {
+    LOG_WARN("Unknown blob type: " + header.type());
+  }
+}
+
+// hand the decoded elements to the callback in the order they were in the blob
+void call_back(elements_t& elements, Callback& callback) {
+  for (const auto& element : elements) {
+    switch (element.type) {
+      case NODES:
+        callback.node_callback(element.osmid, element.lng, element.lat, element.tags);
+        break;
+      case WAYS:
+        callback.way_callback(element.osmid, element.tags, element.nodes);
+        break;
+      case RELATIONS:
+        callback.relation_callback(element.osmid, element.tags, element.members);
+        break;
+      default:
+        callback.changeset_callback(element.osmid);
+        break;
+    }
+  }
+  elements.clear();
+}
+
+// a blob read from the file, and then its decoded contents, as it is passed through the workers
+struct block_t {
+  BlobHeader header;
+  std::string blob;
+  elements_t elements;
+  std::exception_ptr error;
+  bool decoded;
+};
+
 } // namespace
 
 // extend the protobuf osmpbf namespace
@@ -285,38 +375,127 @@ Member::Member(Member&& other)
     : member_type(other.member_type), member_id(other.member_id), role(std::move(other.role)) {
 }
 
-void Parser::parse(std::ifstream& file, const Interest interest, Callback& callback) {
-  char* buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
-  char* unpack_buffer = new char[MAX_UNCOMPRESSED_BLOB_SIZE];
+void Parser::parse(std::ifstream& file,
+                   const Interest interest,
+                   Callback& callback,
+                   const size_t threads) {
+  std::unique_ptr<char[]> buffer(new char[MAX_BLOB_HEADER_SIZE]);
 
   // start from the top
   file.clear();
   file.seekg(0, std::ios::beg);
 
-  // while there is more to read
-  while (!file.eof()) {
-    // grab the blob header
-    bool finished = false;
-    BlobHeader header = read_header(buffer, file, finished);
-    // if we didnt hit the end
-    if (!finished) {
-      // grab the blob that goes with the blob header
-      int32_t sz = read_blob(buffer, unpack_buffer, file, header);
-      // if its data parse it
-      if (header.type() == "OSMData") {
-        parse_primitive_block(unpack_buffer, sz, interest, callback);
-        // if its something other than a header
-      } else if (header.type() == "OSMHeader") {
-        parse_header_block(unpack_buffer, sz);
-      } else {
-        LOG_WARN("Unknown blob type: " + header.type());
+  // with a single thread we just decode each blob as we read it
+  if (threads < 2) {
+    std::unique_ptr<char[]> unpack_buffer(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+    std::string blob;
+    elements_t elements;
+    // while there is more to read
+    while (!file.eof()) {
+      // grab the blob header
+      bool finished = false;
+      BlobHeader header = read_header(buffer.get(), file, finished);
+      // if we didnt hit the end
+      if (!finished) {
+        // grab the blob that goes with the blob header and parse it
+        read_blob(blob, file, header);
+        decode_blob(header, blob, unpack_buffer.get(), interest, callback, 0, elements);
+        call_back(elements, callback);
       }
     }
+    return;
   }
 
-  // done with protobuf and buffers
-  delete[] buffer;
-  delete[] unpack_buffer;
+  // otherwise this thread reads the blobs and queues them up for the workers to decode. the
+  // decoded blobs are handed to the callback in the order they were read so that the results
+  // are exactly the same as above. we bound the number of blobs in flight to bound the memory
+  std::mutex mutex;
+  std::condition_variable queued, decoded;
+  std::queue<block_t*> work;
+  bool stop = false;
+  std::vector<std::thread> workers;
+  for (size_t thread = 0; thread < threads; ++thread) {
+    workers.emplace_back([&, thread]() {
+      std::unique_ptr<char[]> unpack_buffer(new char[MAX_UNCOMPRESSED_BLOB_SIZE]);
+      while (true) {
+        // wait for something to do
+        block_t* block;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          queued.wait(lock, [&work, &stop]() { return stop || !work.empty(); });
+          if (stop) {
+            return;
+          }
+          block = work.front();
+          work.pop();
+        }
+        // do it and let the reader know, errors are rethrown from the reader's thread
+        try {
+          decode_blob(block->header, block->blob, unpack_buffer.get(), interest, callback, thread,
+                      block->elements);
+        } catch (...) { block->error = std::current_exception(); }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          block->decoded = true;
+        }
+        decoded.notify_all();
+      }
+    });
+  }
+
+  // stops the workers whether or not we finished successfully
+  auto join = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    queued.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  };
+
+  std::deque<std::unique_ptr<block_t>> in_flight;
+  try {
+    bool finished = false;
+    while (true) {
+      // keep the workers busy while there is more to read
+      while (!finished && in_flight.size() < threads * 2) {
+        BlobHeader header = read_header(buffer.get(), file, finished);
+        if (finished) {
+          break;
+        }
+        in_flight.emplace_back(new block_t{std::move(header)});
+        read_blob(in_flight.back()->blob, file, in_flight.back()->header);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          work.push(in_flight.back().get());
+        }
+        queued.notify_one();
+      }
+
+      // nothing left to do
+      if (in_flight.empty()) {
+        break;
+      }
+
+      // wait for the oldest blob to be decoded and hand it to the callback
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        decoded.wait(lock, [&in_flight]() { return in_flight.front()->decoded; });
+      }
+      std::unique_ptr<block_t> block = std::move(in_flight.front());
+      in_flight.pop_front();
+      if (block->error) {
+        std::rethrow_exception(block->error);
+      }
+      call_back(block->elements, callback);
+    }
+  } catch (...) {
+    join();
+    throw;
+  }
+  join();
 }
 
 void Parser::free() {
@@ -46,8 +46,14 @@ public:
   virtual ~graph_callback() {
   }
 
-  graph_callback(const boost::property_tree::ptree& pt, OSMData& osmdata)
-      : shape_(kMaxOSMNodeId), intersection_(kMaxOSMNodeId), osmdata_(osmdata), lua_(get_lua(pt)) {
+  graph_callback(const boost::property_tree::ptree& pt, OSMData& osmdata, const size_t threads)
+      : shape_(kMaxOSMNodeId), intersection_(kMaxOSMNodeId), osmdata_(osmdata) {
+
+    // each of the parser's threads needs its own lua state
+    auto lua = get_lua(pt);
+    for (size_t i = 0; i < threads; ++i) {
+      lua_.emplace_back(new LuaTagTransform(lua));
+    }
 
     current_way_node_index_ = last_node_ = last_way_ = last_relation_ = 0;
 
@@ -74,18 +80,37 @@ public:
     return std::string(lua_graph_lua, lua_graph_lua + lua_graph_lua_len);
   }
 
-  virtual void
-  node_callback(uint64_t osmid, double lng, double lat, const OSMPBF::Tags& tags) override {
-    // Check if it is in the list of nodes used by ways
-    if (!shape_.get(osmid)) {
-      return;
+  // Transform the tags on the parser's threads. Nodes, ways and relations which dont have tags
+  // suitable for use in routing never make it to their callbacks
+  virtual bool transform_callback(const size_t thread,
+                                  const OSMPBF::Interest type,
+                                  const uint64_t osmid,
+                                  OSMPBF::Tags& tags) override {
+    switch (type) {
+      case OSMPBF::Interest::NODES:
+        // Check if it is in the list of nodes used by ways. Ways are all parsed before nodes
+        // so this is read only by now
+        if (!shape_.get(osmid)) {
+          return false;
+        }
+        tags = lua_[thread]->Transform(OSMType::kNode, tags);
+        break;
+      case OSMPBF::Interest::WAYS:
+        tags = lua_[thread]->Transform(OSMType::kWay, tags);
+        break;
+      case OSMPBF::Interest::RELATIONS:
+        tags = lua_[thread]->Transform(OSMType::kRelation, tags);
+        break;
+      default:
+        break;
     }
+    return tags.size() != 0;
+  }
 
-    // Get tags
-    Tags results = lua_.Transform(OSMType::kNode, tags);
-    if (results.size() == 0) {
-      return;
-    }
+  virtual void
+  node_callback(uint64_t osmid, double lng, double lat, const OSMPBF::Tags& tags) override {
+    // Tags were already transformed
+    const Tags& results = tags;
 
     // unsorted extracts are just plain nasty, so they can bugger off!
     if (osmid < last_node_) {
@@ -216,12 +241,8 @@ public:
       return;
     }
 
-    // Transform tags. If no results that means the way does not have tags
-    // suitable for use in routing.
-    Tags results = lua_.Transform(OSMType::kWay, tags);
-    if (results.size() == 0) {
-      return;
-    }
+    // Tags were already transformed
+    const Tags& results = tags;
 
     // Throw away closed features with following tags: building, landuse,
     // leisure, natural. See: http://wiki.openstreetmap.org/wiki/Key:area
@@ -1085,11 +1106,8 @@ public:
   virtual void relation_callback(const uint64_t osmid,
                                  const OSMPBF::Tags& tags,
                                  const std::vector<OSMPBF::Member>& members) override {
-    // Get tags
-    Tags results = lua_.Transform(OSMType::kRelation, tags);
-    if (results.size() == 0) {
-      return;
-    }
+    // Tags were already transformed
+    const Tags& results = tags;
 
     // unsorted extracts are just plain nasty, so they can bugger off!
     if (osmid < last_relation_) {
@@ -1492,8 +1510,8 @@ public:
   // Road class assignment needs to be set to the highway cutoff for ferries and auto trains.
   RoadClass highway_cutoff_rc_;
 
-  // Lua Tag Transformation class
-  LuaTagTransform lua_;
+  // Lua Tag Transformation class, one per parsing thread
+  std::vector<std::unique_ptr<LuaTagTransform>> lua_;
 
   // Pointer to all the OSM data (for use by callbacks)
   OSMData& osmdata_;
@@ -1532,16 +1550,16 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
                               const std::string& way_nodes_file,
                               const std::string& access_file,
                               const std::string& complex_restriction_file) {
-  // TODO: option 1: each one threads makes an osmdata and we splice them together at the end
-  // option 2: synchronize around adding things to a single osmdata. will have to test to see
-  // which is the least expensive (memory and speed). leaning towards option 2
+  // The pbf blobs are decompressed, decoded and have their tags transformed in parallel but the
+  // callbacks which fill out the osmdata are called in file order on this thread. This way the
+  // output is exactly the same no matter how many threads are used
   unsigned int threads =
       std::max(static_cast<unsigned int>(1),
                pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
 
   // Create OSM data. Set the member pointer so that the parsing callback methods can use it.
   OSMData osmdata{};
-  graph_callback callback(pt, osmdata);
+  graph_callback callback(pt, osmdata, threads);
   callback.reset(new sequence<OSMWay>(ways_file, true),
                  new sequence<OSMWayNode>(way_nodes_file, true),
                  new sequence<OSMAccess>(access_file, true),
@@ -1567,7 +1585,7 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::WAYS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   callback.output_loops();
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_way_count) + " routable ways containing " +
@@ -1577,7 +1595,8 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm access tags by way id...");
   {
     sequence<OSMAccess> access(access_file, false);
-    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); });
+    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); },
+                threads);
   }
 
   // Parse relations.
@@ -1588,7 +1607,7 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::RELATIONS |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.restrictions.size()) + " simple restrictions");
   LOG_INFO("Finished with " + std::to_string(osmdata.lane_connectivity_map.size()) +
@@ -1599,7 +1618,8 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting complex restrictions by from id...");
   {
     sequence<OSMRestriction> complex_restrictions(complex_restriction_file, false);
-    complex_restrictions.sort([](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+    complex_restrictions.sort([](const OSMRestriction& a, const OSMRestriction& b) { return a < b; },
+                              threads);
   }
 
   // we need to sort the refs so that we can easily (sequentially) update them
@@ -1609,7 +1629,8 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
     way_nodes.sort(
-        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid < b.node.osmid; });
+        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid < b.node.osmid; },
+        threads);
   }
   LOG_INFO("Finished");
 
@@ -1626,7 +1647,7 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
     OSMPBF::Parser::parse(file_handle,
                           static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES |
                                                         OSMPBF::Interest::CHANGESETS),
-                          callback);
+                          callback, threads);
   }
   callback.reset(nullptr, nullptr, nullptr, nullptr);
   LOG_INFO("Finished with " + std::to_string(osmdata.osm_node_count) +
@@ -1637,13 +1658,15 @@ OSMData PBFGraphParser::Parse(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by way index and node shape index...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort([](const OSMWayNode& a, const OSMWayNode& b) {
-      if (a.way_index == b.way_index) {
-        // TODO: if its equal we have screwed something up, should we check and throw here?
-        return a.way_shape_node_index < b.way_shape_node_index;
-      }
-      return a.way_index < b.way_index;
-    });
+    way_nodes.sort(
+        [](const OSMWayNode& a, const OSMWayNode& b) {
+          if (a.way_index == b.way_index) {
+            // TODO: if its equal we have screwed something up, should we check and throw here?
+            return a.way_shape_node_index < b.way_shape_node_index;
+          }
+          return a.way_index < b.way_index;
+        },
+        threads);
   }
 
   LOG_INFO("Finished at changeset id " + std::to_string(osmdata.max_changeset_id_));
@@ -4,15 +4,21 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "baldr/filesystem_utils.h"
 #include "baldr/graphconstants.h"
 #include "baldr/graphid.h"
 #include "baldr/graphreader.h"
@@ -540,146 +546,235 @@ uint32_t AddShortcutEdges(GraphReader& reader,
   return shortcut_count;
 }
 
-// Form shortcuts for tiles in this level.
-uint32_t FormShortcuts(GraphReader& reader,
-                       const TileLevel& level,
-                       const std::unique_ptr<const valhalla::skadi::sample>& sample) {
-  // Iterate through the tiles at this level (TODO - can we mark the tiles
-  // the tiles that shortcuts end within?)
-  reader.Clear();
+// Form shortcuts for a tile. The new tile is written to the staging directory so that all of the
+// tiles on the level are formed from the original tiles, regardless of the order they are done in
+uint32_t FormShortcutsInTile(GraphReader& reader,
+                             const GraphId& new_tile,
+                             const std::string& staging_dir,
+                             const std::unique_ptr<const valhalla::skadi::sample>& sample) {
+  // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
+  const GraphTile* tile = reader.GetGraphTile(new_tile);
+  if (tile == nullptr || tile->header()->nodecount() == 0) {
+    return 0;
+  }
+
+  // Create GraphTileBuilder for the new tile, starting from the existing header
+  GraphTileBuilder tilebuilder(staging_dir, new_tile, false);
+  tilebuilder.header_builder() = *tile->header();
+  tilebuilder.header_builder().set_graphid(new_tile);
+
   bool added = false;
   uint32_t shortcut_count = 0;
-  uint32_t ntiles = level.tiles.TileCount();
-  uint32_t tile_level = (uint32_t)level.level;
-  const GraphTile* tile = nullptr;
-  for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
-    // Get the graph tile. Skip if no tile exists (common case)
-    tile = reader.GetGraphTile(GraphId(tileid, tile_level, 0));
-    if (tile == nullptr || tile->header()->nodecount() == 0) {
-      continue;
-    }
+  uint32_t tileid = new_tile.tileid();
+  uint32_t tile_level = new_tile.level();
+
+  // Iterate through the nodes in the tile
+  GraphId node_id(tileid, tile_level, 0);
+  for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
+    // Get the node info, copy node index and count from old tile
+    NodeInfo nodeinfo = *(tile->node(node_id));
+    uint32_t old_edge_index = nodeinfo.edge_index();
+    uint32_t old_edge_count = nodeinfo.edge_count();
+
+    // Update node information
+    const auto& admin = tile->admininfo(nodeinfo.admin_index());
+    nodeinfo.set_edge_index(tilebuilder.directededges().size());
+    nodeinfo.set_timezone(nodeinfo.timezone());
+    nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                  admin.country_iso(), admin.state_iso()));
+
+    // Current edge count
+    size_t edge_count = tilebuilder.directededges().size();
+
+    // Add shortcut edges first.
+    std::unordered_map<uint32_t, uint32_t> shortcuts;
+    shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
+                                       old_edge_count, shortcuts, sample);
+
+    // Copy the rest of the directed edges from this node
+    GraphId edgeid(tileid, tile_level, old_edge_index);
+    for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
+      // Copy the directed edge information and update end node,
+      // edge data offset, and opp_index
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      DirectedEdge newedge = *directededge;
 
-    // Create GraphTileBuilder for the new tile
-    GraphId new_tile(tileid, tile_level, 0);
-    GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
-
-    // Iterate through the nodes in the tile
-    GraphId node_id(tileid, tile_level, 0);
-    for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
-      // Get the node info, copy node index and count from old tile
-      NodeInfo nodeinfo = *(tile->node(node_id));
-      uint32_t old_edge_index = nodeinfo.edge_index();
-      uint32_t old_edge_count = nodeinfo.edge_count();
-
-      // Update node information
-      const auto& admin = tile->admininfo(nodeinfo.admin_index());
-      nodeinfo.set_edge_index(tilebuilder.directededges().size());
-      nodeinfo.set_timezone(nodeinfo.timezone());
-      nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                    admin.country_iso(), admin.state_iso()));
-
-      // Current edge count
-      size_t edge_count = tilebuilder.directededges().size();
-
-      // Add shortcut edges first.
-      std::unordered_map<uint32_t, uint32_t> shortcuts;
-      shortcut_count += AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
-                                         old_edge_count, shortcuts, sample);
-
-      // Copy the rest of the directed edges from this node
-      GraphId edgeid(tileid, tile_level, old_edge_index);
-      for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
-        // Copy the directed edge information and update end node,
-        // edge data offset, and opp_index
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        DirectedEdge newedge = *directededge;
-
-        // Transition edges are stored as is (no need for EdgeInfo, signs,
-        // or restrictions).
-        if (!directededge->trans_down() && !directededge->trans_up()) {
-          // Get signs from the base directed edge
-          if (directededge->exitsign()) {
-            std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-            if (signs.size() == 0) {
-              LOG_ERROR("Base edge should have signs, but none found");
-            }
-            tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+      // Transition edges are stored as is (no need for EdgeInfo, signs,
+      // or restrictions).
+      if (!directededge->trans_down() && !directededge->trans_up()) {
+        // Get signs from the base directed edge
+        if (directededge->exitsign()) {
+          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+          if (signs.size() == 0) {
+            LOG_ERROR("Base edge should have signs, but none found");
           }
+          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+        }
 
-          // Get access restrictions from the base directed edge. Add these to
-          // the list of access restrictions in the new tile. Update the
-          // edge index in the restriction to be the current directed edge Id
-          if (directededge->access_restriction()) {
-            auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-            for (const auto& res : restrictions) {
-              tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                                 res.type(), res.modes(),
-                                                                 res.value()));
-            }
+        // Get access restrictions from the base directed edge. Add these to
+        // the list of access restrictions in the new tile. Update the
+        // edge index in the restriction to be the current directed edge Id
+        if (directededge->access_restriction()) {
+          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+          for (const auto& res : restrictions) {
+            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                               res.type(), res.modes(), res.value()));
           }
+        }
 
-          // Copy lane connectivity
-          if (directededge->laneconnectivity()) {
-            auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-            if (laneconnectivity.size() == 0) {
-              LOG_ERROR("Base edge should have lane connectivity, but none found");
-            }
-            for (auto& lc : laneconnectivity) {
-              lc.set_to(tilebuilder.directededges().size());
-            }
-            tilebuilder.AddLaneConnectivity(laneconnectivity);
+        // Copy lane connectivity
+        if (directededge->laneconnectivity()) {
+          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+          if (laneconnectivity.size() == 0) {
+            LOG_ERROR("Base edge should have lane connectivity, but none found");
           }
-
-          // Get edge info, shape, and names from the old tile and add
-          // to the new. Use prior edgeinfo offset as the key to make sure
-          // edges that have the same end nodes are differentiated (this
-          // should be a valid key since tile sizes aren't changed)
-          auto edgeinfo = tile->edgeinfo(directededge->edgeinfo_offset());
-          uint32_t edge_info_offset =
-              tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id,
-                                      directededge->endnode(), edgeinfo.wayid(),
-                                      edgeinfo.encoded_shape(),
-                                      tile->GetNames(directededge->edgeinfo_offset()),
-                                      tile->GetTypes(directededge->edgeinfo_offset()), added);
-          newedge.set_edgeinfo_offset(edge_info_offset);
-
-          // Set the superseded mask - this is the shortcut mask that
-          // supersedes this edge (outbound from the node)
-          auto s = shortcuts.find(i);
-          uint32_t supersed_idx = (s != shortcuts.end()) ? s->second : 0;
-          newedge.set_superseded(supersed_idx);
+          for (auto& lc : laneconnectivity) {
+            lc.set_to(tilebuilder.directededges().size());
+          }
+          tilebuilder.AddLaneConnectivity(laneconnectivity);
         }
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
+        // Get edge info, shape, and names from the old tile and add
+        // to the new. Use prior edgeinfo offset as the key to make sure
+        // edges that have the same end nodes are differentiated (this
+        // should be a valid key since tile sizes aren't changed)
+        auto edgeinfo = tile->edgeinfo(directededge->edgeinfo_offset());
+        uint32_t edge_info_offset =
+            tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
+                                    edgeinfo.wayid(), edgeinfo.encoded_shape(),
+                                    tile->GetNames(directededge->edgeinfo_offset()),
+                                    tile->GetTypes(directededge->edgeinfo_offset()), added);
+        newedge.set_edgeinfo_offset(edge_info_offset);
+
+        // Set the superseded mask - this is the shortcut mask that
+        // supersedes this edge (outbound from the node)
+        auto s = shortcuts.find(i);
+        uint32_t supersed_idx = (s != shortcuts.end()) ? s->second : 0;
+        newedge.set_superseded(supersed_idx);
+      }
 
-        // Add existing edge elevation (if the tile has elevation information)
-        if (tile->header()->has_edge_elevation()) {
-          const EdgeElevation* elev = tile->edge_elevation(edgeid);
-          if (elev == nullptr) {
-            tilebuilder.edge_elevations().emplace_back(0.0f, 0.0f, 0.0f);
-          } else {
-            tilebuilder.edge_elevations().emplace_back(std::move(*elev));
-          }
+      // Add directed edge
+      tilebuilder.directededges().emplace_back(std::move(newedge));
+
+      // Add existing edge elevation (if the tile has elevation information)
+      if (tile->header()->has_edge_elevation()) {
+        const EdgeElevation* elev = tile->edge_elevation(edgeid);
+        if (elev == nullptr) {
+          tilebuilder.edge_elevations().emplace_back(0.0f, 0.0f, 0.0f);
+        } else {
+          tilebuilder.edge_elevations().emplace_back(std::move(*elev));
         }
       }
-
-      // Set the edge count for the new node
-      nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
-      tilebuilder.nodes().emplace_back(std::move(nodeinfo));
     }
 
-    // Store the new tile
-    tilebuilder.StoreTileData();
-    LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
-               tilebuilder.header_builder().end_offset())
-                  .str());
+    // Set the edge count for the new node
+    nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
+    tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+  }
+
+  // Store the new tile
+  tilebuilder.StoreTileData();
+  LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
+             tilebuilder.header_builder().end_offset())
+                .str());
+  return shortcut_count;
+}
+
+// Form shortcuts for tiles from the queue until there are none left.
+void FormShortcutsInTiles(const boost::property_tree::ptree& pt,
+                          std::deque<GraphId>& tilequeue,
+                          std::mutex& lock,
+                          const std::string& staging_dir,
+                          std::promise<uint32_t>& result) {
+  // Local Graphreader
+  GraphReader reader(pt.get_child("mjolnir"));
+
+  // Crack open some elevation data if its there. Each thread needs its own since sampling caches
+  boost::optional<std::string> elevation = pt.get_optional<std::string>("additional_data.elevation");
+  std::unique_ptr<const valhalla::skadi::sample> sample;
+  if (elevation && boost::filesystem::exists(*elevation)) {
+    sample.reset(new valhalla::skadi::sample(*elevation));
+  }
+
+  uint32_t shortcut_count = 0;
+  while (true) {
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    GraphId tile_id = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    try {
+      shortcut_count += FormShortcutsInTile(reader, tile_id, staging_dir, sample);
+    } // Send the failure back to the main thread
+    catch (std::exception& e) {
+      result.set_exception(std::current_exception());
+      LOG_ERROR((boost::format("Failed tile %1%: %2%") % tile_id % e.what()).str());
+      return;
+    }
 
     // Check if we need to clear the tile cache.
     if (reader.OverCommitted()) {
       reader.Clear();
     }
   }
+  result.set_value(shortcut_count);
+}
+
+// Removes the staging directory and any tiles left in it when it goes out of scope, so that
+// they are not left behind in the tile directory if forming the shortcuts fails
+struct staging_dir_t {
+  std::string path;
+  ~staging_dir_t() {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(path, ec);
+  }
+};
+
+// Form shortcuts for tiles in this level.
+uint32_t FormShortcuts(const boost::property_tree::ptree& pt,
+                       const TileLevel& level,
+                       unsigned int threads) {
+  // Queue up the tiles at this level
+  GraphReader reader(pt.get_child("mjolnir"));
+  auto tileset = reader.GetTileSet(level.level);
+  std::deque<GraphId> tilequeue(tileset.begin(), tileset.end());
+  staging_dir_t staging{reader.tile_dir() + filesystem::path_separator + "shortcuts"};
+  const std::string& staging_dir = staging.path;
+  boost::filesystem::remove_all(staging_dir);
+
+  // Spawn the threads
+  std::mutex lock;
+  std::vector<std::shared_ptr<std::thread>> workers(threads);
+  std::list<std::promise<uint32_t>> results;
+  for (auto& worker : workers) {
+    results.emplace_back();
+    worker.reset(new std::thread(FormShortcutsInTiles, std::cref(pt), std::ref(tilequeue),
+                                 std::ref(lock), std::cref(staging_dir), std::ref(results.back())));
+  }
+
+  // Wait for threads to finish and total up the shortcuts, a failed tile throws here and
+  // leaves the original tiles of the level in place
+  for (auto& worker : workers) {
+    worker->join();
+  }
+  uint32_t shortcut_count = 0;
+  for (auto& result : results) {
+    shortcut_count += result.get_future().get();
+  }
+
+  // Nothing is reading the original tiles anymore so move the new ones into their place
+  for (const auto& tile_id : tileset) {
+    std::string suffix = GraphTile::FileSuffix(tile_id);
+    std::string staged = staging_dir + filesystem::path_separator + suffix;
+    if (boost::filesystem::exists(staged)) {
+      boost::filesystem::rename(staged, reader.tile_dir() + filesystem::path_separator + suffix);
+    }
+  }
+  reader.Clear();
   return shortcut_count;
 }
 
@@ -692,20 +787,9 @@ namespace mjolnir {
 // only connect to 2 edges on the hierarchy level, and have compatible
 // attributes. Shortcut edges are inserted before regular edges.
 void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
-
-  // TODO: thread this. would need to make sure we dont make shortcuts
-  // across tile boundaries so that we are only messing with one tile
-  // in one thread at a time
-
-  // Get GraphReader
-  GraphReader reader(pt.get_child("mjolnir"));
-
-  // Crack open some elevation data if its there
-  boost::optional<std::string> elevation = pt.get_optional<std::string>("additional_data.elevation");
-  std::unique_ptr<const skadi::sample> sample;
-  if (elevation && boost::filesystem::exists(*elevation)) {
-    sample.reset(new skadi::sample(*elevation));
-  }
+  unsigned int threads =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
 
   auto level = TileHierarchy::levels().rbegin();
   level++;
@@ -713,7 +797,7 @@ void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
     // Create shortcuts on this level
     auto tile_level = level->second;
     LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level.level));
-    uint32_t count = FormShortcuts(reader, tile_level, sample);
+    uint32_t count = FormShortcuts(pt, tile_level, threads);
     LOG_INFO("Finished with " + std::to_string(count) + " shortcuts");
   }
 }
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cinttypes>
 #include <cstdint>
 #include <future>
@@ -41,15 +42,12 @@
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
 #include "midgard/util.h"
+#include "mjolnir/admin.h"
 
 namespace bpo = boost::program_options;
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
-
-// Geometry types for admin queries
-typedef boost::geometry::model::d2::point_xy<double> point_type;
-typedef boost::geometry::model::polygon<point_type> polygon_type;
-typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+using namespace valhalla::mjolnir;
 
 boost::filesystem::path config_file_path;
 
@@ -202,6 +200,8 @@ void Benchmark(const boost::property_tree::ptree& pt) {
   // Iterate through the tiles and perform enhancements
   std::unordered_map<uint32_t, multi_polygon_type> polys;
   std::unordered_map<uint32_t, bool> drive_on_right;
+  uint64_t lookups = 0, mismatches = 0;
+  std::chrono::duration<double> scan_time(0), index_time(0);
   for (uint32_t id = 0; id < tiles.TileCount(); id++) {
     // Get the admin polys if there is data for tiles that exist
     GraphId tile_id(id, local_level, 0);
@@ -211,6 +211,30 @@ void Benchmark(const boost::property_tree::ptree& pt) {
       if (polys.size() < 128) {
         counts[polys.size()]++;
       }
+
+      // Time the admin lookup of the nodes in tiles with more than one admin
+      // (like the graph builder) by checking each poly and with the index
+      const GraphTile* tile = reader.GetGraphTile(tile_id);
+      if (polys.size() < 2 || !tile) {
+        continue;
+      }
+      std::vector<uint32_t> scanned;
+      scanned.reserve(tile->header()->nodecount());
+      auto t0 = std::chrono::high_resolution_clock::now();
+      for (uint32_t i = 0; i < tile->header()->nodecount(); i++) {
+        scanned.push_back(GetMultiPolyId(polys, tile->node(i)->latlng()));
+      }
+      auto t1 = std::chrono::high_resolution_clock::now();
+      MultiPolygonIndex index{std::unordered_map<uint32_t, multi_polygon_type>(polys)};
+      for (uint32_t i = 0; i < tile->header()->nodecount(); i++) {
+        if (GetMultiPolyId(index, tile->node(i)->latlng()) != scanned[i]) {
+          mismatches++;
+        }
+      }
+      auto t2 = std::chrono::high_resolution_clock::now();
+      scan_time += t1 - t0;
+      index_time += t2 - t1;
+      lookups += scanned.size();
     }
   }
   for (uint32_t i = 0; i < 128; i++) {
@@ -218,6 +242,17 @@ void Benchmark(const boost::property_tree::ptree& pt) {
       LOG_INFO("Tiles with " + std::to_string(i) + " admin polys: " + std::to_string(counts[i]));
     }
   }
+
+  // Report the lookups (the index time includes building the index)
+  LOG_INFO("Admin lookups: " + std::to_string(lookups) + " in " +
+           std::to_string(scan_time.count()) + " secs checking each poly, " +
+           std::to_string(index_time.count()) + " secs with the index");
+  if (index_time.count() > 0) {
+    LOG_INFO("Speedup: " + std::to_string(scan_time.count() / index_time.count()) + "x");
+  }
+  if (mismatches > 0) {
+    LOG_ERROR("Index found a different admin for " + std::to_string(mismatches) + " nodes");
+  }
 }
 
 bool ParseArguments(int argc, char* argv[]) {
@@ -284,7 +284,7 @@ void get_stops(Transit_Fetch& tile,
                const ptree& response,
                const AABB2<PointLL>& filter,
                bool tile_within_one_tz,
-               const std::unordered_map<uint32_t, multi_polygon_type>& tz_polys) {
+               const MultiPolygonIndex& tz_polys) {
   for (const auto& stop_pt : response.get_child("stops")) {
     const auto& ll_pt = stop_pt.second.get_child("geometry_centroid.coordinates");
     auto lon = ll_pt.front().second.get_value<float>();
@@ -686,7 +686,7 @@ void fetch_tiles(const ptree& pt,
     LOG_INFO("Fetching " + transit_tile.string());
 
     bool tile_within_one_tz = false;
-    std::unordered_map<uint32_t, multi_polygon_type> tz_polys;
+    MultiPolygonIndex tz_polys;
     if (tz_db_handle) {
       tz_polys = GetTimeZones(tz_db_handle, filter);
       if (tz_polys.size() == 1) {
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <sstream>
@@ -11,6 +12,7 @@
 
 #include "baldr/json.h"
 #include "midgard/logging.h"
+#include "midgard/util.h"
 
 #include "odin/directionsbuilder.h"
 #include "odin/util.h"
@@ -27,7 +29,9 @@ using namespace valhalla::baldr;
 namespace valhalla {
 namespace odin {
 
-odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config) {
+odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config)
+    : narration_concurrency(std::max(config.get<size_t>("odin.narration_concurrency", 1),
+                                     static_cast<size_t>(1))) {
 }
 
 odin_worker_t::~odin_worker_t() {
@@ -41,8 +45,22 @@ std::list<TripDirections> odin_worker_t::narrate(const valhalla_request_t& reque
   // get some annotated directions
   std::list<TripDirections> narrated;
   try {
+    // The legs do not depend on each other so additional threads narrate
+    // some of them
+    std::vector<TripPath*> paths;
     for (auto& leg : legs) {
-      narrated.emplace_back(odin::DirectionsBuilder().Build(request.options, leg));
+      paths.push_back(&leg);
+    }
+    std::vector<TripDirections> directions(paths.size());
+    midgard::parallel_for(paths.size(), narration_concurrency,
+                          [&request, &paths, &directions](size_t i, size_t) {
+                            directions[i] =
+                                odin::DirectionsBuilder().Build(request.options, *paths[i]);
+                          });
+
+    // Hand them back in the order of the legs
+    for (auto& leg_directions : directions) {
+      narrated.emplace_back(std::move(leg_directions));
       LOG_INFO("maneuver_count::" + std::to_string(narrated.back().maneuver_size()));
     }
   } catch (...) { throw valhalla_exception_t{202}; }
@@ -57,11 +75,11 @@ worker_t::result_t odin_worker_t::work(const std::list<zmq::message_t>& job,
   LOG_INFO("Got Odin Request " + std::to_string(info.id));
   valhalla_request_t request;
   try {
-    // crack open the original request
-    std::string request_str(static_cast<const char*>(job.front().data()), job.front().size());
-    std::string serialized_options(static_cast<const char*>((++job.cbegin())->data()),
-                                   (++job.cbegin())->size());
-    request.parse(request_str, serialized_options);
+    // crack open the options, nothing in the request document is needed here
+    // since loki already parsed everything odin uses into them
+    const auto& serialized_options = *(++job.cbegin());
+    request.options.ParseFromArray(serialized_options.data(),
+                                   static_cast<int>(serialized_options.size()));
 
     // Set the interrupt function
     service_worker_t::set_interrupt(interrupt_function);
@@ -79,8 +97,6 @@ worker_t::result_t odin_worker_t::work(const std::list<zmq::message_t>& job,
     // narrate them and serialize them along
     auto narrated = narrate(request, legs);
     auto response = tyr::serializeDirections(request, legs, narrated);
-    auto* to_response =
-        request.options.format() == DirectionsOptions::gpx ? to_response_xml : to_response_json;
     return to_response(response, info, request);
   } catch (const std::exception& e) {
     return jsonify_error({299, std::string(e.what())}, info, request);
@@ -33,7 +33,9 @@ void AStarPathAlgorithm::Clear() {
   // and clear edge status.
   edgelabels_.clear();
   destinations_.clear();
-  adjacencylist_.reset();
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
   edgestatus_.clear();
 
   // Set the ferry flag to false
@@ -63,7 +65,12 @@ void AStarPathAlgorithm::Init(const PointLL& origll, const PointLL& destll) {
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(mincost, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(mincost, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(label_queue_type_, mincost, range,
+                                                             bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
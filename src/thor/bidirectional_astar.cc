@@ -42,8 +42,12 @@ BidirectionalAStar::~BidirectionalAStar() {
 void BidirectionalAStar::Clear() {
   edgelabels_forward_.clear();
   edgelabels_reverse_.clear();
-  adjacencylist_forward_.reset();
-  adjacencylist_reverse_.reset();
+  if (adjacencylist_forward_) {
+    adjacencylist_forward_->clear();
+  }
+  if (adjacencylist_reverse_) {
+    adjacencylist_reverse_->clear();
+  }
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
 
@@ -77,9 +81,19 @@ void BidirectionalAStar::Init(const PointLL& origll, const PointLL& destll) {
   uint32_t bucketsize = costing_->UnitSize();
   float range = kBucketCount * bucketsize;
   float mincostf = astarheuristic_forward_.Get(origll);
-  adjacencylist_forward_.reset(new DoubleBucketQueue(mincostf, range, bucketsize, forward_edgecost));
+  if (adjacencylist_forward_) {
+    adjacencylist_forward_->reuse(mincostf, range, bucketsize, forward_edgecost);
+  } else {
+    adjacencylist_forward_.reset(LabelQueueFactory::createLabelQueue(
+        label_queue_type_, mincostf, range, bucketsize, forward_edgecost));
+  }
   float mincostr = astarheuristic_reverse_.Get(destll);
-  adjacencylist_reverse_.reset(new DoubleBucketQueue(mincostr, range, bucketsize, reverse_edgecost));
+  if (adjacencylist_reverse_) {
+    adjacencylist_reverse_->reuse(mincostr, range, bucketsize, reverse_edgecost);
+  } else {
+    adjacencylist_reverse_.reset(LabelQueueFactory::createLabelQueue(
+        label_queue_type_, mincostr, range, bucketsize, reverse_edgecost));
+  }
   edgestatus_forward_.clear();
   edgestatus_reverse_.clear();
 
@@ -1,5 +1,10 @@
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "exception.h"
@@ -25,6 +30,97 @@ bool equals(const valhalla::odin::LatLng& a, const valhalla::odin::LatLng& b) {
          (!a.has_lat() || a.lat() == b.lat()) && (!a.has_lng() || a.lng() == b.lng());
 }
 
+/**
+ * Threads which run a job together as many times as needed. The job is split
+ * into parts, one per thread, and the calling thread runs the first part. The
+ * threads are kept between runs since the searches of a matrix are iterated
+ * many times and each iteration does little work.
+ */
+class thread_team_t {
+public:
+  thread_team_t(const uint32_t parts, const std::function<void(const uint32_t)>& job)
+      : job_(job), generation_(0), running_(0), stop_(false) {
+    for (uint32_t part = 1; part < parts; ++part) {
+      threads_.emplace_back(&thread_team_t::work, this, part);
+    }
+  }
+
+  ~thread_team_t() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // Run all parts of the job and wait for them to be done. Rethrows an
+  // exception thrown by any of the parts.
+  void run() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = threads_.size();
+      ++generation_;
+    }
+    start_.notify_all();
+
+    std::exception_ptr error;
+    try {
+      job_(0);
+    } catch (...) { error = std::current_exception(); }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return running_ == 0; });
+    if (!error) {
+      error = error_;
+    }
+    error_ = nullptr;
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  void work(const uint32_t part) {
+    uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+        if (stop_) {
+          return;
+        }
+        generation = generation_;
+      }
+
+      std::exception_ptr error;
+      try {
+        job_(part);
+      } catch (...) { error = std::current_exception(); }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error && !error_) {
+        error_ = error;
+      }
+      if (--running_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  std::function<void(const uint32_t)> job_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  uint64_t generation_;
+  size_t running_;
+  bool stop_;
+  std::exception_ptr error_;
+};
+
 } // namespace
 
 namespace valhalla {
@@ -33,7 +129,8 @@ namespace thor {
 // Constructor with cost threshold.
 CostMatrix::CostMatrix()
     : mode_(TravelMode::kDrive), access_mode_(kAutoAccess), source_count_(0), remaining_sources_(0),
-      target_count_(0), remaining_targets_(0), current_cost_threshold_(0) {
+      target_count_(0), remaining_targets_(0), current_cost_threshold_(0),
+      label_queue_type_(LabelQueueType::kDoubleBucket) {
 }
 
 float CostMatrix::GetCostThreshold(const float max_matrix_distance) {
@@ -60,42 +157,43 @@ void CostMatrix::Clear() {
   // Clear the target edge markings
   targets_.clear();
 
-  // Clear all source adjacency lists, edge labels, and edge status
-  for (auto adj : source_adjacency_) {
-    adj.reset();
+  // Clear all source adjacency lists, edge labels, and edge status. Their
+  // storage is kept so that it can be reused by the next matrix
+  for (auto& adj : source_adjacency_) {
+    if (adj) {
+      adj->clear();
+    }
   }
-  source_adjacency_.clear();
-
-  for (auto el : source_edgelabel_) {
+  for (auto& el : source_edgelabel_) {
     el.clear();
   }
-  source_edgelabel_.clear();
-
-  for (auto es : source_edgestatus_) {
+  for (auto& es : source_edgestatus_) {
     es.clear();
   }
-  source_edgestatus_.clear();
 
   // Clear all target adjacency lists, edge labels, and edge status
-  for (auto adj : target_adjacency_) {
-    adj.reset();
+  for (auto& adj : target_adjacency_) {
+    if (adj) {
+      adj->clear();
+    }
   }
-  target_adjacency_.clear();
-
-  for (auto el : target_edgelabel_) {
+  for (auto& el : target_edgelabel_) {
     el.clear();
   }
-  target_edgelabel_.clear();
-
-  for (auto es : target_edgestatus_) {
+  for (auto& es : target_edgestatus_) {
     es.clear();
   }
-  target_edgestatus_.clear();
 
   source_hierarchy_limits_.clear();
   target_hierarchy_limits_.clear();
   source_status_.clear();
   target_status_.clear();
+  for (auto& pending : source_pending_) {
+    pending.clear();
+  }
+  for (auto& pending : target_pending_) {
+    pending.clear();
+  }
 }
 
 // Form a time distance matrix from the set of source locations
@@ -127,38 +225,30 @@ std::vector<TimeDistance> CostMatrix::SourceToTarget(
   Initialize(source_location_list, target_location_list);
   LOG_INFO("Done initialize");
 
+  // Split the locations among the threads. The first part is searched on
+  // this thread with the graph reader passed in.
+  const uint32_t parts = std::max(std::min(static_cast<uint32_t>(thread_readers_.size() + 1),
+                                           std::max(source_count_, target_count_)),
+                                  1u);
+  bool forward = false;
+  int n = 0;
+  thread_team_t team(parts, [this, &forward, &n, &graphreader, parts](const uint32_t part) {
+    Search(forward, n, part, parts, part == 0 ? graphreader : *thread_readers_[part - 1]);
+  });
+
   // Perform backward search from all target locations. Perform forward
   // search from all source locations. Connections between the 2 search
   // spaces is checked during the forward search.
-  int n = 0;
   while (true) {
     // Iterate all target locations in a backwards search
-    for (uint32_t i = 0; i < target_count_; i++) {
-      if (target_status_[i].threshold > 0) {
-        target_status_[i].threshold--;
-        BackwardSearch(i, graphreader);
-        if (target_status_[i].threshold == 0) {
-          target_status_[i].threshold = -1;
-          if (remaining_targets_ > 0) {
-            remaining_targets_--;
-          }
-        }
-      }
-    }
+    forward = false;
+    team.run();
+    ApplyPending(forward);
 
     // Iterate all source locations in a forward search
-    for (uint32_t i = 0; i < source_count_; i++) {
-      if (source_status_[i].threshold > 0) {
-        source_status_[i].threshold--;
-        ForwardSearch(i, n, graphreader);
-        if (source_status_[i].threshold == 0) {
-          source_status_[i].threshold = -1;
-          if (remaining_sources_ > 0) {
-            remaining_sources_--;
-          }
-        }
-      }
-    }
+    forward = true;
+    team.run();
+    ApplyPending(forward);
 
     // Break out when remaining sources and targets to expand are both 0
     if (remaining_sources_ == 0 && remaining_targets_ == 0) {
@@ -233,6 +323,57 @@ void CostMatrix::Initialize(
   }
 }
 
+// Iterate the searches of a part of the source or target locations.
+void CostMatrix::Search(const bool forward,
+                        const uint32_t n,
+                        const uint32_t part,
+                        const uint32_t parts,
+                        GraphReader& graphreader) {
+  if (forward) {
+    for (uint32_t i = part; i < source_count_; i += parts) {
+      if (source_status_[i].threshold > 0) {
+        source_pending_[i].searched = true;
+        source_status_[i].threshold--;
+        ForwardSearch(i, n, graphreader);
+      }
+    }
+  } else {
+    for (uint32_t i = part; i < target_count_; i += parts) {
+      if (target_status_[i].threshold > 0) {
+        target_pending_[i].searched = true;
+        target_status_[i].threshold--;
+        BackwardSearch(i, graphreader);
+      }
+    }
+  }
+}
+
+// Apply the changes the searches made to other locations in location order.
+// Stop searching a location once its threshold has been reached.
+void CostMatrix::ApplyPending(const bool forward) {
+  auto& pending = forward ? source_pending_ : target_pending_;
+  auto& status = forward ? source_status_ : target_status_;
+  auto& remaining = forward ? remaining_sources_ : remaining_targets_;
+  for (uint32_t i = 0; i < pending.size(); i++) {
+    for (const auto& update : pending[i].updates) {
+      UpdateStatus(update);
+    }
+
+    // Add to the lists of targets that have reached these edges
+    for (const auto& edgeid : pending[i].reached) {
+      targets_[edgeid].push_back(i);
+    }
+
+    if (pending[i].searched && status[i].threshold == 0) {
+      status[i].threshold = -1;
+      if (remaining > 0) {
+        remaining--;
+      }
+    }
+    pending[i].clear();
+  }
+}
+
 // Iterate the forward search from the source/origin location.
 void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphReader& graphreader) {
   // Get the next edge from the adjacency list for this source location
@@ -243,7 +384,7 @@ void CostMatrix::ForwardSearch(const uint32_t index, const uint32_t n, GraphRead
     // Forward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t target = 0; target < target_count_; target++) {
-      UpdateStatus(index, target);
+      RecordStatus(source_pending_[index], index, target);
     }
     source_status_[index].threshold = 0;
     return;
@@ -435,7 +576,7 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
         // Update status and update threshold if this is the last location
         // to find for this source or target
-        UpdateStatus(source, target);
+        RecordStatus(source_pending_[source], source, target);
       } else {
         float oppcost = (predidx == kInvalidLabel) ? 0 : edgelabels[predidx].cost().cost;
         float c = pred.cost().cost + oppcost + opp_el.transition_cost();
@@ -457,38 +598,44 @@ void CostMatrix::CheckForwardConnections(const uint32_t source,
 
           // Update status and update threshold if this is the last location
           // to find for this source or target
-          UpdateStatus(source, target);
+          RecordStatus(source_pending_[source], source, target);
         }
       }
     }
   }
 }
 
+// Record a status update to apply once the iteration is done. The status of
+// other locations can not be changed while searches run in parallel.
+void CostMatrix::RecordStatus(PendingStatus& pending, const uint32_t source, const uint32_t target) {
+  pending.updates.push_back(
+      {source, target,
+       static_cast<uint32_t>(source_edgelabel_[source].size() + target_edgelabel_[target].size())});
+}
+
 // Update status when a connection is found.
-void CostMatrix::UpdateStatus(const uint32_t source, const uint32_t target) {
+void CostMatrix::UpdateStatus(const StatusUpdate& update) {
   // Remove the target from the source status
-  auto& s = source_status_[source].remaining_locations;
-  auto it = s.find(target);
+  auto& s = source_status_[update.source].remaining_locations;
+  auto it = s.find(update.target);
   if (it != s.end()) {
     s.erase(it);
-    if (s.empty() && source_status_[source].threshold > 0) {
+    if (s.empty() && source_status_[update.source].threshold > 0) {
       // At least 1 connection has been found to each target for this source.
       // Set a threshold to continue search for a limited number of times.
-      source_status_[source].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+      source_status_[update.source].threshold = GetThreshold(mode_, update.label_count);
     }
   }
 
   // Remove the source from the target status
-  auto& t = target_status_[target].remaining_locations;
-  it = t.find(source);
+  auto& t = target_status_[update.target].remaining_locations;
+  it = t.find(update.source);
   if (it != t.end()) {
     t.erase(it);
-    if (t.empty() && target_status_[target].threshold > 0) {
+    if (t.empty() && target_status_[update.target].threshold > 0) {
       // At least 1 connection has been found to each source for this target.
       // Set a threshold to continue search for a limited number of times.
-      target_status_[target].threshold =
-          GetThreshold(mode_, source_edgelabel_[source].size() + target_edgelabel_[target].size());
+      target_status_[update.target].threshold = GetThreshold(mode_, update.label_count);
     }
   }
 }
@@ -503,7 +650,7 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
     // Backward search is exhausted - mark this and update so we don't
     // extend searches more than we need to
     for (uint32_t source = 0; source < source_count_; source++) {
-      UpdateStatus(source, index);
+      RecordStatus(target_pending_[index], source, index);
     }
     target_status_[index].threshold = 0;
     return;
@@ -630,8 +777,9 @@ void CostMatrix::BackwardSearch(const uint32_t index, GraphReader& graphreader)
                               (pred.not_thru_pruning() || !directededge->not_thru()));
       adj->add(idx);
 
-      // Add to the list of targets that have reached this edge
-      targets_[edgeid].push_back(index);
+      // Add to the list of targets that have reached this edge once the
+      // iteration is done
+      target_pending_[index].reached.push_back(edgeid);
     }
   };
 
@@ -665,6 +813,7 @@ void CostMatrix::SetSources(GraphReader& graphreader,
   source_edgestatus_.resize(source_count_);
   source_adjacency_.resize(source_count_);
   source_hierarchy_limits_.resize(source_count_);
+  source_pending_.resize(source_count_);
 
   // Go through each source location
   uint32_t index = 0;
@@ -677,8 +826,12 @@ void CostMatrix::SetSources(GraphReader& graphreader,
 
     // Allocate the adjacency list and hierarchy limits for this source.
     // Use the cost threshold to size the adjacency list.
-    source_adjacency_[index].reset(
-        new DoubleBucketQueue(0, current_cost_threshold_, costing_->UnitSize(), edgecost));
+    if (source_adjacency_[index]) {
+      source_adjacency_[index]->reuse(0, current_cost_threshold_, costing_->UnitSize(), edgecost);
+    } else {
+      source_adjacency_[index].reset(LabelQueueFactory::createLabelQueue(
+          label_queue_type_, 0, current_cost_threshold_, costing_->UnitSize(), edgecost));
+    }
     source_hierarchy_limits_[index] = costing_->GetHierarchyLimits();
 
     // Iterate through edges and add to adjacency list
@@ -736,6 +889,7 @@ void CostMatrix::SetTargets(baldr::GraphReader& graphreader,
   target_edgestatus_.resize(targets.size());
   target_adjacency_.resize(targets.size());
   target_hierarchy_limits_.resize(targets.size());
+  target_pending_.resize(targets.size());
 
   // Go through each target location
   uint32_t index = 0;
@@ -748,8 +902,12 @@ void CostMatrix::SetTargets(baldr::GraphReader& graphreader,
 
     // Allocate the adjacency list and hierarchy limits for target location.
     // Use the cost threshold to size the adjacency list.
-    target_adjacency_[index].reset(
-        new DoubleBucketQueue(0, current_cost_threshold_, costing_->UnitSize(), edgecost));
+    if (target_adjacency_[index]) {
+      target_adjacency_[index]->reuse(0, current_cost_threshold_, costing_->UnitSize(), edgecost);
+    } else {
+      target_adjacency_[index].reset(LabelQueueFactory::createLabelQueue(
+          label_queue_type_, 0, current_cost_threshold_, costing_->UnitSize(), edgecost));
+    }
     target_hierarchy_limits_[index] = costing_->GetHierarchyLimits();
 
     // Iterate through edges and add to adjacency list
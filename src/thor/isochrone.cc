@@ -46,7 +46,7 @@ constexpr uint32_t kInitialEdgeLabelCount = 500000;
 // Default constructor
 Isochrone::Isochrone()
     : access_mode_(kAutoAccess), shape_interval_(50.0f), mode_(TravelMode::kDrive),
-      adjacencylist_(nullptr) {
+      adjacencylist_(nullptr), label_queue_type_(LabelQueueType::kDoubleBucket) {
 }
 
 // Destructor
@@ -61,8 +61,11 @@ void Isochrone::Clear() {
   edgelabels_.clear();
   bdedgelabels_.clear();
   mmedgelabels_.clear();
-  adjacencylist_.reset();
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
   edgestatus_.clear();
+  rasterizer_.Stop();
 }
 
 // Construct the isotile. Use a fixed grid size. Convert time in minutes to
@@ -148,6 +151,9 @@ void Isochrone::ConstructIsoTile(
              std::to_string(center_ll.lat() - grid_center.lat()) + "," +
              std::to_string(center_ll.lng() - grid_center.lng()));
   }
+
+  // Mark the settled edges in the new isotile
+  rasterizer_.Start(isotile_, shape_interval_);
 }
 
 // Initialize - create adjacency list, edgestatus support, and reserve
@@ -159,7 +165,12 @@ void Isochrone::Initialize(const uint32_t bucketsize) {
   const auto edgecost = [this](const uint32_t label) { return edgelabels_[label].sortcost(); };
 
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(label_queue_type_, 0.0f, range,
+                                                             bucketsize, edgecost));
+  }
   edgestatus_.clear();
 }
 
@@ -172,7 +183,12 @@ void Isochrone::InitializeReverse(const uint32_t bucketsize) {
   const auto edgecost = [this](const uint32_t label) { return bdedgelabels_[label].sortcost(); };
 
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(label_queue_type_, 0.0f, range,
+                                                             bucketsize, edgecost));
+  }
   edgestatus_.clear();
 }
 
@@ -185,7 +201,12 @@ void Isochrone::InitializeMultiModal(const uint32_t bucketsize) {
   const auto edgecost = [this](const uint32_t label) { return mmedgelabels_[label].sortcost(); };
 
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(label_queue_type_, 0.0f, range,
+                                                             bucketsize, edgecost));
+  }
   edgestatus_.clear();
 }
 
@@ -295,7 +316,7 @@ Isochrone::Compute(google::protobuf::RepeatedPtrField<valhalla::odin::Location>&
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
     if (predindex == kInvalidLabel) {
-      return isotile_;
+      return rasterizer_.Finish();
     }
 
     // Copy the EdgeLabel for use in costing and settle the edge.
@@ -309,10 +330,10 @@ Isochrone::Compute(google::protobuf::RepeatedPtrField<valhalla::odin::Location>&
     // Return after the time interval has been met
     if (pred.cost().secs > max_seconds || pred.cost().cost > max_seconds * 4) {
       LOG_DEBUG("Exceed time interval: n = " + std::to_string(n));
-      return isotile_;
+      return rasterizer_.Finish();
     }
   }
-  return isotile_; // Should never get here
+  return rasterizer_.Finish(); // Should never get here
 }
 
 // Expand from a node in reverse direction.
@@ -437,7 +458,7 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeReverse(
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
     if (predindex == kInvalidLabel) {
-      return isotile_;
+      return rasterizer_.Finish();
     }
 
     // Copy the EdgeLabel for use in costing and settle the edge.
@@ -456,10 +477,10 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeReverse(
     // Return after the time interval has been met
     if (pred.cost().secs > max_seconds || pred.cost().cost > max_seconds * 4) {
       LOG_DEBUG("Exceed time interval: n = " + std::to_string(n));
-      return isotile_;
+      return rasterizer_.Finish();
     }
   }
-  return isotile_; // Should never get here
+  return rasterizer_.Finish(); // Should never get here
 }
 
 // Compute isochrone for mulit-modal route.
@@ -497,7 +518,7 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeMultiModal(
   // For now the date_time must be set on the origin.
   if (!origin_locations.Get(0).has_date_time()) {
     LOG_ERROR("No date time set on the origin location");
-    return isotile_;
+    return rasterizer_.Finish();
   }
 
   // Update start time
@@ -521,7 +542,7 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeMultiModal(
     // invalid label indicates there are no edges that can be expanded.
     uint32_t predindex = adjacencylist_->pop();
     if (predindex == kInvalidLabel) {
-      return isotile_;
+      return rasterizer_.Finish();
     }
 
     // Copy the EdgeLabel for use in costing and settle the edge.
@@ -550,7 +571,7 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeMultiModal(
     // Return after the time interval has been met
     if (pred.cost().secs > max_seconds) {
       LOG_DEBUG("Exceed time interval: n = " + std::to_string(n));
-      return isotile_;
+      return rasterizer_.Finish();
     }
 
     // Check access at the node
@@ -800,7 +821,7 @@ std::shared_ptr<const GriddedData<PointLL>> Isochrone::ComputeMultiModal(
       adjacencylist_->add(idx);
     }
   }
-  return isotile_; // Should never get here
+  return rasterizer_.Finish(); // Should never get here
 }
 
 // Update the isotile
@@ -830,49 +851,18 @@ void Isochrone::UpdateIsoTile(const EdgeLabel& pred,
   // TODO - do we need partial shape from origin location to end of edge?
   float secs1 = pred.cost().secs;
 
-  // Avoid getting the shape for short edges
+  // Avoid getting the shape for short edges. Mark the cell at the begin node
+  // and the cells on the way to the end node
   if (edge->length() < shape_interval_) {
-    // Mark the cell at the begin node
     const auto* de = t2->directededge(opp);
     const auto* node = tile->node(de->endnode());
-    isotile_->SetIfLessThan(node->latlng(), secs0 * kMinPerSec);
-
-    // Mark the cell at the end node (and any intervening cells)
-    auto tiles = isotile_->Intersect(std::list<PointLL>{node->latlng(), ll});
-    for (auto t : tiles) {
-      isotile_->SetIfLessThan(t.first, secs1 * kMinPerSec);
-    }
+    rasterizer_.AddEdge(node->latlng(), ll, secs0, secs1);
     return;
   }
 
-  // Get the shape and make sure shape is forward direction. Resample it to
-  // the shape interval.
-  auto shape = tile->edgeinfo(edge->edgeinfo_offset()).shape();
-  if (!edge->forward()) {
-    std::reverse(shape.begin(), shape.end());
-  }
-  auto resampled = resample_spherical_polyline(shape, shape_interval_);
-
-  // Mark the initial grid cell and iterate through the shape pairs
-  float secs = secs0;
-  isotile_->SetIfLessThan(shape.front(), secs * kMinPerSec);
-  auto tiles = isotile_->Intersect(std::list<PointLL>{shape.front(), shape.back()});
-  for (auto t : tiles) {
-    isotile_->SetIfLessThan(t.first, secs * kMinPerSec);
-  }
-
-  // Mark grid cells along the shape if time is less than what is
-  // already populated. Get intersection of tiles along each segment
-  // so this doesn't miss shape that crosses tile corners
-  float delta = (shape_interval_ * (secs1 - secs0)) / edge->length();
-  auto itr1 = resampled.begin();
-  for (auto itr2 = itr1 + 1; itr2 < resampled.end(); itr1++, itr2++) {
-    secs += delta;
-    auto tiles = isotile_->Intersect(std::list<PointLL>{*itr1, *itr2});
-    for (auto t : tiles) {
-      isotile_->SetIfLessThan(t.first, secs * kMinPerSec);
-    }
-  }
+  // Mark the cells along the shape, interpolating the time along it
+  rasterizer_.AddEdge(tile->edgeinfo(edge->edgeinfo_offset()).shape(), edge->forward(), secs0,
+                      secs1, edge->length());
 }
 
 // Add edge(s) at each origin to the adjacency list
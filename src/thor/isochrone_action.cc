@@ -39,7 +39,8 @@ std::string thor_worker_t::isochrones(valhalla_request_t& request) {
                                           reader, mode_costing, mode);
 
   // turn it into geojson
-  auto isolines = grid->GenerateContours(contours, polygons, denoise, generalize);
+  auto isolines = grid->GenerateContours(contours, polygons, denoise, generalize,
+                                         isochrone_gen.concurrency());
 
   auto showLocations = rapidjson::get<bool>(request.document, "/show_locations", false);
   return tyr::serializeIsochrones<PointLL>(request, isolines, polygons, colors, showLocations);
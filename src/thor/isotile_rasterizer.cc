@@ -0,0 +1,232 @@
+#include "thor/isotile_rasterizer.h"
+#include "midgard/constants.h"
+#include "midgard/util.h"
+
+#include <algorithm>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// Number of edges gathered before they are handed to a thread
+constexpr size_t kBatchSize = 1024;
+
+} // namespace
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+IsoTileRasterizer::IsoTileRasterizer() : concurrency_(1), shape_interval_(50.0f), done_(false) {
+}
+
+// Destructor
+IsoTileRasterizer::~IsoTileRasterizer() {
+  Stop();
+}
+
+// Set the number of threads marking edges
+void IsoTileRasterizer::set_concurrency(const uint32_t concurrency) {
+  Stop();
+  concurrency_ = std::max(concurrency, 1u);
+}
+
+// Start marking edges in a new isotile
+void IsoTileRasterizer::Start(const std::shared_ptr<GriddedData<PointLL>>& isotile,
+                              const float shape_interval) {
+  Stop();
+  isotile_ = isotile;
+  shape_interval_ = shape_interval;
+}
+
+// Add an edge shorter than the shape interval
+void IsoTileRasterizer::AddEdge(const PointLL& begin,
+                                const PointLL& end,
+                                const float secs0,
+                                const float secs1) {
+  const uint32_t index = batch_.shape.size();
+  batch_.shape.push_back(begin);
+  batch_.shape.push_back(end);
+  batch_.edges.push_back({index, index + 2, secs0, secs1, 0.0f});
+  if (batch_.edges.size() >= kBatchSize) {
+    Flush();
+  }
+}
+
+// Add an edge given its shape, making sure the shape is in the forward direction
+void IsoTileRasterizer::AddEdge(const std::vector<PointLL>& shape,
+                                const bool forward,
+                                const float secs0,
+                                const float secs1,
+                                const float length) {
+  const uint32_t index = batch_.shape.size();
+  if (forward) {
+    batch_.shape.insert(batch_.shape.end(), shape.begin(), shape.end());
+  } else {
+    batch_.shape.insert(batch_.shape.end(), shape.rbegin(), shape.rend());
+  }
+  batch_.edges.push_back({index, static_cast<uint32_t>(batch_.shape.size()), secs0, secs1, length});
+  if (batch_.edges.size() >= kBatchSize) {
+    Flush();
+  }
+}
+
+// Hand the current batch to the threads
+void IsoTileRasterizer::Flush() {
+  // Without threads just mark the edges here
+  if (concurrency_ == 1) {
+    Rasterize(*isotile_, batch_, shape_);
+    batch_.shape.clear();
+    batch_.edges.clear();
+    return;
+  }
+
+  // Start the threads on the first batch. Nothing else writes to the isotile
+  // until they are done so they can copy it themselves.
+  if (threads_.empty()) {
+    done_ = false;
+    isotiles_.resize(concurrency_ - 1);
+    errors_.assign(concurrency_ - 1, nullptr);
+    for (size_t i = 0; i < isotiles_.size(); ++i) {
+      threads_.emplace_back(&IsoTileRasterizer::Work, this, i);
+    }
+  }
+
+  // Queue the batch and continue with an emptied one
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.emplace_back(std::move(batch_));
+    if (spare_.empty()) {
+      batch_ = batch_t{};
+    } else {
+      batch_ = std::move(spare_.back());
+      spare_.pop_back();
+    }
+  }
+  ready_.notify_one();
+}
+
+// Mark batches in a copy of the isotile until no more are coming
+void IsoTileRasterizer::Work(const size_t index) {
+  try {
+    isotiles_[index].reset(new GriddedData<PointLL>(*isotile_));
+    std::vector<PointLL> shape;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      ready_.wait(lock, [this]() { return done_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      batch_t batch = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+
+      Rasterize(*isotiles_[index], batch, shape);
+      batch.shape.clear();
+      batch.edges.clear();
+
+      lock.lock();
+      spare_.emplace_back(std::move(batch));
+    }
+  } catch (...) { errors_[index] = std::current_exception(); }
+}
+
+// Mark the remaining edges and merge the copies of the threads
+std::shared_ptr<const GriddedData<PointLL>> IsoTileRasterizer::Finish() {
+  // Small isochrones never fill a batch so they don't need the threads
+  if (threads_.empty()) {
+    Rasterize(*isotile_, batch_, shape_);
+    batch_.shape.clear();
+    batch_.edges.clear();
+    return isotile_;
+  }
+
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  ready_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+
+  // Keep the lowest time of each cell, it does not matter which thread marked it
+  std::exception_ptr error;
+  for (size_t i = 0; i < isotiles_.size(); ++i) {
+    if (errors_[i] && !error) {
+      error = errors_[i];
+    } else if (isotiles_[i]) {
+      isotile_->SetIfLessThan(*isotiles_[i]);
+    }
+  }
+  isotiles_.clear();
+  errors_.clear();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return isotile_;
+}
+
+// Stop the threads without marking the remaining edges
+void IsoTileRasterizer::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    for (auto& batch : queue_) {
+      batch.shape.clear();
+      batch.edges.clear();
+      spare_.emplace_back(std::move(batch));
+    }
+    queue_.clear();
+  }
+  ready_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+  isotiles_.clear();
+  errors_.clear();
+  batch_.shape.clear();
+  batch_.edges.clear();
+}
+
+// Mark the edges of a batch in the isotile
+void IsoTileRasterizer::Rasterize(GriddedData<PointLL>& isotile,
+                                  const batch_t& batch,
+                                  std::vector<PointLL>& shape) const {
+  for (const auto& edge : batch.edges) {
+    auto first = batch.shape.cbegin() + edge.begin;
+    auto last = batch.shape.cbegin() + edge.end;
+
+    // Mark the cell at the begin node and the cells on the way to the end node
+    if (edge.length == 0.0f) {
+      isotile.SetIfLessThan(*first, edge.secs0 * kMinPerSec);
+      isotile.SetIfLessThan(*first, *std::next(first), edge.secs1 * kMinPerSec);
+      continue;
+    }
+
+    // Resample the shape to the shape interval
+    shape.assign(first, last);
+    auto resampled = resample_spherical_polyline(shape, shape_interval_);
+
+    // Mark the initial grid cell and iterate through the shape pairs
+    float secs = edge.secs0;
+    isotile.SetIfLessThan(shape.front(), secs * kMinPerSec);
+    isotile.SetIfLessThan(shape.front(), shape.back(), secs * kMinPerSec);
+
+    // Mark grid cells along the shape if time is less than what is
+    // already populated. Mark the cells along each segment so this
+    // doesn't miss shape that crosses tile corners
+    float delta = (shape_interval_ * (edge.secs1 - edge.secs0)) / edge.length;
+    auto itr1 = resampled.cbegin();
+    for (auto itr2 = itr1 + 1; itr2 < resampled.cend(); itr1++, itr2++) {
+      secs += delta;
+      isotile.SetIfLessThan(*itr1, *itr2, secs * kMinPerSec);
+    }
+  }
+}
+
+} // namespace thor
+} // namespace valhalla
@@ -43,14 +43,13 @@ std::string thor_worker_t::matrix(valhalla_request_t& request) {
   // do the real work
   std::vector<TimeDistance> time_distances;
   auto costmatrix = [&]() {
-    thor::CostMatrix matrix;
-    return matrix.SourceToTarget(request.options.sources(), request.options.targets(), reader,
-                                 mode_costing, mode, max_matrix_distance.find(costing)->second);
+    return cost_matrix.SourceToTarget(request.options.sources(), request.options.targets(), reader,
+                                      mode_costing, mode, max_matrix_distance.find(costing)->second);
   };
   auto timedistancematrix = [&]() {
-    thor::TimeDistanceMatrix matrix;
-    return matrix.SourceToTarget(request.options.sources(), request.options.targets(), reader,
-                                 mode_costing, mode, max_matrix_distance.find(costing)->second);
+    return time_distance_matrix.SourceToTarget(request.options.sources(), request.options.targets(),
+                                               reader, mode_costing, mode,
+                                               max_matrix_distance.find(costing)->second);
   };
   switch (source_to_target_algorithm) {
     case SELECT_OPTIMAL:
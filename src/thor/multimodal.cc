@@ -1,5 +1,6 @@
 #include "thor/multimodal.h"
 #include "baldr/datetime.h"
+#include "baldr/double_bucket_queue.h"
 #include "exception.h"
 #include "midgard/logging.h"
 #include <algorithm>
@@ -69,7 +70,12 @@ void MultiModalPathAlgorithm::Init(const PointLL& origll,
   // Set bucket size and cost range based on DynamicCost.
   uint32_t bucketsize = costing->UnitSize();
   float range = kBucketCount * bucketsize;
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, range, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, range, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(label_queue_type_, 0.0f, range,
+                                                             bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Get hierarchy limits from the costing. Get a copy since we increment
@@ -84,7 +90,9 @@ void MultiModalPathAlgorithm::Clear() {
   destinations_.clear();
 
   // Clear elements from the adjacency list
-  adjacencylist_.reset();
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
 
   // Clear the edge status flags
   edgestatus_.clear();
@@ -61,7 +61,7 @@ std::list<valhalla::odin::TripPath> thor_worker_t::optimized_route(valhalla_requ
     request.options.mutable_locations()->Add()->CopyFrom(correlated.Get(optimal_order[i]));
   }
 
-  return path_depart_at(*request.options.mutable_locations(), costing);
+  return route_legs(request, costing, false);
 }
 
 } // namespace thor
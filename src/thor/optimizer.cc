@@ -1,6 +1,17 @@
 #include "thor/optimizer.h"
 #include "midgard/logging.h"
 
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// Least amount a move has to lower the cost of the tour by to be made. Keeps
+// rounding from making moves back and forth.
+constexpr double kMinImprovement = 0.001;
+
+} // namespace
+
 namespace valhalla {
 namespace thor {
 
@@ -10,162 +21,261 @@ namespace thor {
 std::vector<uint32_t> Optimizer::Solve(const uint32_t count, const std::vector<float>& costs) {
   // Handle trivial cases.
   count_ = count;
-  if (count == 2) {
-    return {0, 1};
-  } else if (count_ == 3) {
-    return {0, 1, 2};
-  } else if (count == 4) {
-    // Only one possible way to alter the path.
-    std::vector<uint32_t> tour1 = {0, 1, 2, 3};
-    std::vector<uint32_t> tour2 = {0, 2, 1, 3};
-    return (TourCost(costs, tour1) < TourCost(costs, tour2)) ? tour1 : tour2;
+  if (count_ < 4) {
+    std::vector<uint32_t> tour(count_);
+    std::iota(tour.begin(), tour.end(), 0);
+    return tour;
   }
 
-  // Populate the initial tour with a random order. The first and last
-  // locations must remain fixed as the tour begin and end locations do not
-  // change.
-  CreateRandomTour();
-
-  // Copy current tour to best tour and get the tour cost. Set the initial
-  // temperature based on tour cost
-  best_tour_ = tour_;
-  best_cost_ = TourCost(costs, tour_);
-  float temperature = best_cost_ / count_;
-
-  // Perform simulated annealing. Set a run limit per annealing step and a
-  // success limit to break out early if enough successes are found.
-  ntry_ = 0;
-  attempts_ = 400 * count_;
-  successes_ = 40 * count_;
-  for (uint32_t i = 0; i < 100; i++) {
-    // Break if no successes were found during this annealing step.
-    if (Anneal(costs, temperature) == 0) {
-      break;
-    }
-
-    // Reduce temperature
-    temperature *= kCoolingRate;
+  // Few enough locations to try every order of them
+  if (count_ <= kMaxExactLocations) {
+    auto tour = SolveExact(costs);
+    LOG_DEBUG("Exact tour cost = " + std::to_string(TourCost(costs, tour)));
+    return tour;
   }
 
-  // Return the best tour
-  LOG_DEBUG("Best tour cost = " + std::to_string(best_cost_) + " ntries = " + std::to_string(ntry_));
-  return best_tour_;
+  // Build a tour and improve it until no move lowers its cost
+  auto tour = CheapestInsertion(costs);
+  LocalSearch(costs, tour);
+  float cost = TourCost(costs, tour);
+
+  // Local search gets stuck where no single move helps. Swap two parts of
+  // the best tour and search from there, until that stops finding better
+  // tours. The swaps are pseudo random but always the same.
+  random_generator_.seed(count_);
+  uint32_t kicks = 0;
+  for (uint32_t failed = 0; failed < kMaxFailedKicks * count_; ++failed, ++kicks) {
+    auto kicked = tour;
+    Kick(kicked);
+    LocalSearch(costs, kicked);
+    float kicked_cost = TourCost(costs, kicked);
+    if (kicked_cost < cost) {
+      tour.swap(kicked);
+      cost = kicked_cost;
+      failed = 0;
+    }
+  }
+  LOG_DEBUG("Best tour cost = " + std::to_string(cost) + " kicks = " + std::to_string(kicks));
+  return tour;
 }
 
-// Perform the annealing process.
-uint32_t Optimizer::Anneal(const std::vector<float>& costs, float temperature) {
-  uint32_t success_count = 0;
-  for (uint32_t i = 0; i < attempts_; i++) {
-    // Select a potential tour alteration. Get temperature difference.
-    TourAlteration alteration = GetTourAlteration();
-    float diff = TemperatureDifference(costs, alteration);
-    ntry_++;
-
-    // Check if we should keep this as the new best path. The idea behind
-    // simulated annealing is that it tries to avoid becoming trapped in local
-    // optima by occasionally allowing worse solutions at a probability that
-    // declines with time.
-    // (http://www.technical-recipes.com/2012/c-implementation-of-hill-climbing-and-simulated-annealing-applied-to-travelling-salesman-problems/
-    if (diff < 0.0f || r01() < std::exp(-diff / temperature)) {
-      if (alteration.alt == kReverse) {
-        // Alter the tour by reversing the locations in the tour between a
-        // start and end location. Add 1 to the end index since STL algorithm
-        // reverse does not include the iterator at position it2.
-        auto it1 = tour_.begin() + alteration.start;
-        auto it2 = tour_.begin() + alteration.end + 1;
-        std::reverse(it1, it2);
-      } else {
-        // Alter the tour by rotating the locations about a middle point.
-        // The middle location becomes the new first location. Add 1 to
-        // the end index so that is included in the rotated set.
-        auto it1 = tour_.begin() + alteration.start;
-        auto it2 = tour_.begin() + alteration.mid;
-        auto it3 = tour_.begin() + alteration.end + 1;
-        std::rotate(it1, it2, it3);
-      }
-      success_count++;
+// Find the tour with the least cost with the Held-Karp dynamic program. For
+// each subset of the locations between the first and last one and each
+// location in it, keep the least cost of visiting the subset starting at the
+// first location and ending at that location, and where it came from.
+std::vector<uint32_t> Optimizer::SolveExact(const std::vector<float>& costs) const {
+  // Location i + 1 is bit i of a subset
+  const uint32_t n = count_ - 2;
+  const uint32_t subsets = 1u << n;
+  std::vector<float> best(subsets * n, std::numeric_limits<float>::max());
+  std::vector<uint8_t> previous(subsets * n, 0);
+  for (uint32_t i = 0; i < n; ++i) {
+    best[(1u << i) * n + i] = Cost(costs, 0, i + 1);
+  }
 
-      // Get the tour cost and update the best tour if less cost
-      float cost = TourCost(costs, tour_);
-      if (cost < best_cost_) {
-        best_cost_ = cost;
-        best_tour_ = tour_;
+  // Adding a location makes a larger subset so they are done in order
+  for (uint32_t subset = 1; subset < subsets; ++subset) {
+    for (uint32_t i = 0; i < n; ++i) {
+      if (!(subset & (1u << i))) {
+        continue;
+      }
+      const float cost = best[subset * n + i];
+      for (uint32_t j = 0; j < n; ++j) {
+        if (subset & (1u << j)) {
+          continue;
+        }
+        const uint32_t next = (subset | (1u << j)) * n + j;
+        const float c = cost + Cost(costs, i + 1, j + 1);
+        if (c < best[next]) {
+          best[next] = c;
+          previous[next] = static_cast<uint8_t>(i);
+        }
       }
     }
-    if (success_count >= successes_) {
-      break;
+  }
+
+  // Finish at the last location from whichever location costs the least
+  const uint32_t all = subsets - 1;
+  uint32_t last = 0;
+  float least = std::numeric_limits<float>::max();
+  for (uint32_t i = 0; i < n; ++i) {
+    const float c = best[all * n + i] + Cost(costs, i + 1, count_ - 1);
+    if (c < least) {
+      least = c;
+      last = i;
     }
   }
-  return success_count;
-}
 
-// Create a random initial tour. The first and last locations must remain
-// fixed as the tour begin and end locations do not change.
-void Optimizer::CreateRandomTour() {
-  tour_.clear();
-  for (uint32_t i = 1; i < count_ - 1; i++) {
-    tour_.push_back(i);
+  // Walk back from the last location to get the tour
+  std::vector<uint32_t> tour(count_);
+  tour.front() = 0;
+  tour.back() = count_ - 1;
+  for (uint32_t subset = all, k = n; k > 0; --k) {
+    tour[k] = last + 1;
+    const uint32_t prior = previous[subset * n + last];
+    subset &= ~(1u << last);
+    last = prior;
   }
-  std::random_shuffle(tour_.begin(), tour_.end());
-  tour_.insert(tour_.begin(), 0);
-  tour_.push_back(count_ - 1);
+  return tour;
 }
 
-// Select a potential alteration of the tour.
-TourAlteration Optimizer::GetTourAlteration() {
-  // Select three unique locations between 1 and count-2
-  std::vector<uint32_t> loc(3);
-  while (true) {
-    loc[0] = get_random_location();
-    loc[1] = get_random_location();
-    loc[2] = get_random_location();
-    if (loc[0] != loc[1] && loc[0] != loc[2] && loc[1] != loc[2]) {
-      break;
+// Improve the tour with 2-opt and Or-opt moves until they no longer lower its
+// cost or kMaxLocalSearchPasses passes have been made.
+void Optimizer::LocalSearch(const std::vector<float>& costs, std::vector<uint32_t>& tour) const {
+  for (uint32_t pass = 0; pass < kMaxLocalSearchPasses; ++pass) {
+    bool improved = TwoOpt(costs, tour);
+    improved = OrOpt(costs, tour) || improved;
+    if (!improved) {
+      return;
     }
   }
+}
 
-  // Sort location indexes so they have increasing values to use as
-  // a start location index, mid location index (for rotation), and an
-  // end location index.
-  std::sort(loc.begin(), loc.end());
+// Swap two neighbouring parts of the tour between the first and last location.
+// Unlike a 2-opt move neither part is reversed.
+void Optimizer::Kick(std::vector<uint32_t>& tour) {
+  std::uniform_int_distribution<uint32_t> cut(1, count_ - 1);
+  uint32_t cuts[3];
+  do {
+    cuts[0] = cut(random_generator_);
+    cuts[1] = cut(random_generator_);
+    cuts[2] = cut(random_generator_);
+  } while (cuts[0] == cuts[1] || cuts[0] == cuts[2] || cuts[1] == cuts[2]);
+  std::sort(cuts, cuts + 3);
+  std::rotate(tour.begin() + cuts[0], tour.begin() + cuts[1], tour.begin() + cuts[2]);
+}
 
-  // Randomly select the alteration type and return the
-  // tour alteration (indexes and type).
-  AlterationType t = (r01() < 0.5f) ? kReverse : kRotate;
-  return {loc[0], loc[1], loc[2], t};
+// Build a tour by repeatedly inserting the location which adds the least cost
+// where it adds the least cost.
+std::vector<uint32_t> Optimizer::CheapestInsertion(const std::vector<float>& costs) const {
+  std::vector<uint32_t> tour{0, count_ - 1};
+  std::vector<uint32_t> remaining(count_ - 2);
+  std::iota(remaining.begin(), remaining.end(), 1);
+  tour.reserve(count_);
+  while (!remaining.empty()) {
+    float least = std::numeric_limits<float>::max();
+    size_t location = 0, position = 0;
+    for (size_t r = 0; r < remaining.size(); ++r) {
+      for (size_t p = 0; p + 1 < tour.size(); ++p) {
+        const float c = Cost(costs, tour[p], remaining[r]) +
+                        Cost(costs, remaining[r], tour[p + 1]) - Cost(costs, tour[p], tour[p + 1]);
+        if (c < least) {
+          least = c;
+          location = r;
+          position = p + 1;
+        }
+      }
+    }
+    tour.insert(tour.begin() + position, remaining[location]);
+    remaining.erase(remaining.begin() + location);
+  }
+  return tour;
 }
 
-float Optimizer::TemperatureDifference(const std::vector<float>& costs,
-                                       const TourAlteration& alteration) {
-  float c = 0;
-  uint32_t start = alteration.start;
-  uint32_t end = alteration.end;
-  if (alteration.alt == kRotate) {
-    // Subtract costs of connections that are broken
-    uint32_t mid = alteration.mid;
-    c -= Cost(costs, tour_[start - 1], tour_[start]);
-    c -= Cost(costs, tour_[end], tour_[end + 1]);
-    c -= Cost(costs, tour_[mid - 1], tour_[mid]);
-
-    // Add costs for the new connections
-    c += Cost(costs, tour_[start - 1], tour_[mid]);
-    c += Cost(costs, tour_[end], tour_[start]);
-    c += Cost(costs, tour_[mid - 1], tour_[end + 1]);
-  } else {
-    // Reverse tour locations between a start and an end index.
-    // Subtract costs between successive locations from start-1 to end+1
-    for (uint32_t i = start - 1, j = i + 1; i <= end; i++, j++) {
-      c -= Cost(costs, tour_[i], tour_[j]);
+// Make a pass over the tour reversing the locations between a start and an
+// end location where that lowers the cost the most. The costs need not be
+// symmetric so the cost of the reversed locations changes as well.
+bool Optimizer::TwoOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const {
+  std::vector<double> forward, backward;
+  PathCosts(costs, tour, forward, backward);
+  bool improved = false;
+  for (uint32_t start = 1; start + 2 < count_; ++start) {
+    double least = -kMinImprovement;
+    uint32_t best_end = 0;
+    for (uint32_t end = start + 1; end + 1 < count_; ++end) {
+      const double change =
+          Cost(costs, tour[start - 1], tour[end]) + Cost(costs, tour[start], tour[end + 1]) -
+          Cost(costs, tour[start - 1], tour[start]) - Cost(costs, tour[end], tour[end + 1]) +
+          (backward[end] - backward[start]) - (forward[end] - forward[start]);
+      if (change < least) {
+        least = change;
+        best_end = end;
+      }
     }
+    if (best_end != 0) {
+      std::reverse(tour.begin() + start, tour.begin() + best_end + 1);
+      PathCosts(costs, tour, forward, backward);
+      improved = true;
+    }
+  }
+  return improved;
+}
+
+// Make a pass over the tour moving runs of up to kMaxOrOptLength locations,
+// in either direction, to where that lowers the cost the most.
+bool Optimizer::OrOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const {
+  std::vector<double> forward, backward;
+  PathCosts(costs, tour, forward, backward);
+  bool improved = false;
+  for (uint32_t length = 1; length <= kMaxOrOptLength; ++length) {
+    for (uint32_t start = 1; start + length < count_; ++start) {
+      // What taking the run out of the tour saves and what reversing it costs
+      const uint32_t end = start + length - 1;
+      const double removed = Cost(costs, tour[start - 1], tour[start]) +
+                             Cost(costs, tour[end], tour[end + 1]) -
+                             Cost(costs, tour[start - 1], tour[end + 1]);
+      const double reversed = (backward[end] - backward[start]) - (forward[end] - forward[start]);
 
-    // Add costs for the new connections and the reversed order
-    c += Cost(costs, tour_[start - 1], tour_[end]);
-    c += Cost(costs, tour_[start], tour_[end + 1]);
-    for (uint32_t i = end, j = i - 1; i > start; i--, j--) {
-      c += Cost(costs, tour_[i], tour_[j]);
+      // Find where putting it back in between two locations costs the least
+      double least = -kMinImprovement;
+      uint32_t best_after = 0;
+      bool best_reversed = false, found = false;
+      for (uint32_t after = 0; after + 1 < count_; ++after) {
+        if (after + 1 >= start && after <= end) {
+          continue;
+        }
+        const uint32_t from = tour[after], to = tour[after + 1];
+        const double skipped = Cost(costs, from, to) + removed;
+        double change = Cost(costs, from, tour[start]) + Cost(costs, tour[end], to) - skipped;
+        if (change < least) {
+          least = change;
+          best_after = after;
+          best_reversed = false;
+          found = true;
+        }
+        change = Cost(costs, from, tour[end]) + Cost(costs, tour[start], to) + reversed - skipped;
+        if (change < least) {
+          least = change;
+          best_after = after;
+          best_reversed = true;
+          found = true;
+        }
+      }
+      if (!found) {
+        continue;
+      }
+
+      // Move the run, it ends up right after the location it was put behind
+      uint32_t moved;
+      if (best_after > end) {
+        std::rotate(tour.begin() + start, tour.begin() + end + 1, tour.begin() + best_after + 1);
+        moved = best_after + 1 - length;
+      } else {
+        std::rotate(tour.begin() + best_after + 1, tour.begin() + start, tour.begin() + end + 1);
+        moved = best_after + 1;
+      }
+      if (best_reversed) {
+        std::reverse(tour.begin() + moved, tour.begin() + moved + length);
+      }
+      PathCosts(costs, tour, forward, backward);
+      improved = true;
     }
   }
-  return (c / static_cast<float>(count_));
+  return improved;
+}
+
+// Get the cost of following the tour up to each location in it, both
+// forwards and backwards.
+void Optimizer::PathCosts(const std::vector<float>& costs,
+                          const std::vector<uint32_t>& tour,
+                          std::vector<double>& forward,
+                          std::vector<double>& backward) const {
+  forward.assign(count_, 0.0);
+  backward.assign(count_, 0.0);
+  for (uint32_t i = 0; i + 1 < count_; ++i) {
+    forward[i + 1] = forward[i] + Cost(costs, tour[i], tour[i + 1]);
+    backward[i + 1] = backward[i] + Cost(costs, tour[i + 1], tour[i]);
+  }
 }
 
 // Get the cost for the specified tour (order of locations).
@@ -1,9 +1,13 @@
 #include "thor/worker.h"
+#include <algorithm>
 #include <cstdint>
+#include <exception>
+#include <iterator>
 
 #include "baldr/json.h"
 #include "midgard/constants.h"
 #include "midgard/logging.h"
+#include "midgard/util.h"
 #include "sif/autocost.h"
 #include "sif/bicyclecost.h"
 #include "sif/pedestriancost.h"
@@ -17,6 +21,20 @@ using namespace valhalla::baldr;
 using namespace valhalla::sif;
 using namespace valhalla::thor;
 
+namespace {
+
+// Half the size in degrees of the area around a location a path expands in on the local level
+constexpr float kPrefetchAreaSize = 0.05f;
+
+AABB2<PointLL> prefetch_area(const odin::Location& location) {
+  return {static_cast<float>(location.ll().lng()) - kPrefetchAreaSize,
+          static_cast<float>(location.ll().lat()) - kPrefetchAreaSize,
+          static_cast<float>(location.ll().lng()) + kPrefetchAreaSize,
+          static_cast<float>(location.ll().lat()) + kPrefetchAreaSize};
+}
+
+} // namespace
+
 namespace valhalla {
 namespace thor {
 
@@ -24,10 +42,10 @@ std::list<valhalla::odin::TripPath> thor_worker_t::route(valhalla_request_t& req
   parse_locations(request);
   auto costing = parse_costing(request);
 
-  auto trippaths = (request.options.has_date_time_type() &&
-                    request.options.date_time_type() == odin::DirectionsOptions::arrive_by)
-                       ? path_arrive_by(*request.options.mutable_locations(), costing)
-                       : path_depart_at(*request.options.mutable_locations(), costing);
+  auto trippaths = route_legs(request, costing,
+                              request.options.has_date_time_type() &&
+                                  request.options.date_time_type() ==
+                                      odin::DirectionsOptions::arrive_by);
 
   if (!request.options.do_not_track()) {
     for (const auto& tp : trippaths) {
@@ -37,25 +55,153 @@ std::list<valhalla::odin::TripPath> thor_worker_t::route(valhalla_request_t& req
   return trippaths;
 }
 
-thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routetype,
+thor_worker_t::leg_router_t thor_worker_t::get_leg_router() {
+  return {&astar, &bidir_astar, &multi_modal_astar, &timedep_forward, &timedep_reverse,
+          mode_costing, &reader, interrupt, false, false, false};
+}
+
+// The additional threads are not interrupted, the calling thread is
+thor_worker_t::leg_router_t thor_worker_t::get_leg_router(leg_thread_t& leg_thread) {
+  return {&leg_thread.astar,
+          &leg_thread.bidir_astar,
+          &leg_thread.multi_modal_astar,
+          &leg_thread.timedep_forward,
+          &leg_thread.timedep_reverse,
+          leg_thread.mode_costing,
+          leg_thread.reader.get(),
+          nullptr,
+          false,
+          false,
+          false};
+}
+
+std::list<valhalla::odin::TripPath>
+thor_worker_t::route_legs(valhalla_request_t& request, const std::string& costing, bool arrive_by) {
+  auto& correlated = *request.options.mutable_locations();
+  correlated.begin()->set_type(odin::Location::kBreak);
+  correlated.rbegin()->set_type(odin::Location::kBreak);
+
+  // The legs between two breaks make up one trip path, find where they start
+  std::vector<int> breaks;
+  bool has_date_time = false;
+  for (int i = 0; i < correlated.size(); ++i) {
+    if (correlated.Get(i).type() == odin::Location::kBreak) {
+      breaks.push_back(i);
+    }
+    has_date_time = has_date_time || correlated.Get(i).has_date_time();
+  }
+
+  // Route the legs in order on this thread if there is one trip path or no
+  // other thread to route them on. Time dependent legs depend on the time the
+  // legs before them arrive at and multimodal legs on the transit schedule
+  auto router = get_leg_router();
+  if (leg_threads.empty() || breaks.size() < 3 || has_date_time || costing == "multimodal" ||
+      costing == "transit") {
+    return arrive_by ? path_arrive_by(router, correlated.begin(), correlated.end(), costing)
+                     : path_depart_at(router, correlated.begin(), correlated.end(), costing);
+  }
+
+  // The legs of each trip path, in the order they are routed in, with their
+  // own copy of the locations and costing so that the threads share neither
+  struct leg_group_t {
+    int first;
+    int last;
+    google::protobuf::RepeatedPtrField<odin::Location> locations;
+    valhalla::sif::cost_ptr_t cost;
+    std::list<odin::TripPath> trip_paths;
+    std::exception_ptr error;
+    bool relaxed;
+    bool disallowed_destination_only;
+    bool used_destination_only;
+  };
+  std::vector<leg_group_t> groups(breaks.size() - 1);
+  for (size_t i = 0; i < groups.size(); ++i) {
+    auto& group = groups[i];
+    auto b = arrive_by ? breaks.size() - 2 - i : i;
+    group.first = breaks[b];
+    group.last = breaks[b + 1] + 1;
+    for (int j = group.first; j < group.last; ++j) {
+      group.locations.Add()->CopyFrom(correlated.Get(j));
+    }
+    group.cost = get_costing(request.document, costing);
+  }
+
+  // The additional threads each route with their own path algorithms, costing
+  // and graph reader, no more of them than there are other groups
+  std::vector<leg_router_t> routers{router};
+  for (size_t i = 0; i < leg_threads.size() && i + 1 < groups.size(); ++i) {
+    routers.push_back(get_leg_router(*leg_threads[i]));
+  }
+  midgard::parallel_for(groups.size(), routers.size(), [&](size_t i, size_t thread) {
+    auto& group = groups[i];
+    auto& group_router = routers[thread];
+    group_router.mode_costing[static_cast<uint32_t>(mode)] = group.cost;
+    group_router.relaxed = group_router.disallowed_destination_only =
+        group_router.used_destination_only = false;
+    try {
+      group.trip_paths =
+          arrive_by
+              ? path_arrive_by(group_router, group.locations.begin(), group.locations.end(), costing)
+              : path_depart_at(group_router, group.locations.begin(), group.locations.end(), costing);
+    } catch (...) { group.error = std::current_exception(); }
+    group.relaxed = group_router.relaxed;
+    group.disallowed_destination_only = group_router.disallowed_destination_only;
+    group.used_destination_only = group_router.used_destination_only;
+  });
+
+  // Take the groups in order as long as they were routed with the costing in
+  // the state the groups before them leave it in. A leg which needed a second
+  // pass relaxes the costing and bidirectional A* disallows destination only
+  // edges, so the first group which could have been affected by that is routed
+  // again along with the rest of them in order
+  std::list<odin::TripPath> trip_paths;
+  bool allow_destination_only = true;
+  for (auto& group : groups) {
+    if (group.relaxed || (group.used_destination_only && !allow_destination_only)) {
+      mode_costing[static_cast<uint32_t>(mode)] = get_costing(request.document, costing);
+      mode_costing[static_cast<uint32_t>(mode)]->set_allow_destination_only(allow_destination_only);
+      auto rest =
+          arrive_by
+              ? path_arrive_by(router, correlated.begin(), correlated.begin() + group.last, costing)
+              : path_depart_at(router, correlated.begin() + group.first, correlated.end(), costing);
+      trip_paths.splice(trip_paths.end(), rest);
+      return trip_paths;
+    }
+    if (group.error) {
+      std::rethrow_exception(group.error);
+    }
+
+    // Keep the locations as the legs left them, the throughs lose the edges
+    // which were not used
+    for (int j = group.first; j < group.last; ++j) {
+      correlated.Mutable(j)->Swap(group.locations.Mutable(j - group.first));
+    }
+    trip_paths.splice(trip_paths.end(), group.trip_paths);
+    allow_destination_only = allow_destination_only && !group.disallowed_destination_only;
+  }
+  return trip_paths;
+}
+
+thor::PathAlgorithm* thor_worker_t::get_path_algorithm(leg_router_t& router,
+                                                       const std::string& routetype,
                                                        const odin::Location& origin,
                                                        const odin::Location& destination) {
   // If the origin has date_time set use timedep_forward method.
   // TODO - what to do if the route is long?
   if (origin.has_date_time()) {
-    timedep_forward.set_interrupt(interrupt);
-    return &timedep_forward;
+    router.timedep_forward->set_interrupt(router.interrupt);
+    return router.timedep_forward;
   }
 
   // If the destination has date_time set use timedep_reverse method.
   // TODO - what to do if the route is long?
   if (destination.has_date_time()) {
-    timedep_reverse.set_interrupt(interrupt);
-    return &timedep_reverse;
+    router.timedep_reverse->set_interrupt(router.interrupt);
+    return router.timedep_reverse;
   }
   if (routetype == "multimodal" || routetype == "transit") {
-    multi_modal_astar.set_interrupt(interrupt);
-    return &multi_modal_astar;
+    router.multi_modal_astar->set_interrupt(router.interrupt);
+    return router.multi_modal_astar;
   }
 
   // Use A* if any origin and destination edges are the same - otherwise
@@ -64,28 +210,36 @@ thor::PathAlgorithm* thor_worker_t::get_path_algorithm(const std::string& routet
   for (auto& edge1 : origin.path_edges()) {
     for (auto& edge2 : destination.path_edges()) {
       if (edge1.graph_id() == edge2.graph_id()) {
-        astar.set_interrupt(interrupt);
-        return &astar;
+        router.astar->set_interrupt(router.interrupt);
+        return router.astar;
       }
     }
   }
-  bidir_astar.set_interrupt(interrupt);
-  return &bidir_astar;
+  router.bidir_astar->set_interrupt(router.interrupt);
+  return router.bidir_astar;
 }
 
-std::vector<thor::PathInfo> thor_worker_t::get_path(PathAlgorithm* path_algorithm,
+std::vector<thor::PathInfo> thor_worker_t::get_path(leg_router_t& router,
+                                                    PathAlgorithm* path_algorithm,
                                                     odin::Location& origin,
                                                     odin::Location& destination,
                                                     const std::string& costing) {
   // Find the path. If bidirectional A* disable use of destination only
   // edges on the first pass. If there is a failure, we allow them on the
   // second pass.
-  valhalla::sif::cost_ptr_t cost = mode_costing[static_cast<uint32_t>(mode)];
-  if (path_algorithm == &bidir_astar) {
+  valhalla::sif::cost_ptr_t cost = router.mode_costing[static_cast<uint32_t>(mode)];
+  if (path_algorithm == router.bidir_astar) {
     cost->set_allow_destination_only(false);
+    router.disallowed_destination_only = true;
+  } else if (!router.disallowed_destination_only) {
+    router.used_destination_only = true;
   }
   cost->set_pass(0);
-  auto path = path_algorithm->GetBestPath(origin, destination, reader, mode_costing, mode);
+
+  // Start loading the tiles the path is likely to need while we search for it
+  router.reader->PrefetchCorridor(prefetch_area(origin), prefetch_area(destination));
+  auto path = path_algorithm->GetBestPath(origin, destination, *router.reader, router.mode_costing,
+                                          mode);
 
   // If path is not found try again with relaxed limits (if allowed)
   if (path.empty() || (costing == "pedestrian" && path_algorithm->has_ferry())) {
@@ -99,12 +253,14 @@ std::vector<thor::PathInfo> thor_worker_t::get_path(PathAlgorithm* path_algorith
 
       path_algorithm->Clear();
       cost->set_pass(1);
-      bool using_astar = (path_algorithm == &astar);
+      bool using_astar = (path_algorithm == router.astar);
       float relax_factor = using_astar ? 16.0f : 8.0f;
       float expansion_within_factor = using_astar ? 4.0f : 2.0f;
       cost->RelaxHierarchyLimits(relax_factor, expansion_within_factor);
       cost->set_allow_destination_only(true);
-      path = path_algorithm->GetBestPath(origin, destination, reader, mode_costing, mode);
+      router.relaxed = true;
+      path = path_algorithm->GetBestPath(origin, destination, *router.reader, router.mode_costing,
+                                         mode);
     }
   }
 
@@ -115,20 +271,22 @@ std::vector<thor::PathInfo> thor_worker_t::get_path(PathAlgorithm* path_algorith
   return path;
 }
 
-std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
-    google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
-    const std::string& costing) {
+// Routes the locations from first to last, which are both breaks, backwards
+std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(leg_router_t& router,
+                                                                  location_iterator first,
+                                                                  location_iterator last,
+                                                                  const std::string& costing) {
   // Things we'll need
   std::vector<thor::PathInfo> path;
   std::list<valhalla::odin::TripPath> trip_paths;
-  correlated.begin()->set_type(odin::Location::kBreak);
-  correlated.rbegin()->set_type(odin::Location::kBreak);
+  std::reverse_iterator<location_iterator> rbegin(last), rend(first);
 
   // For each pair of locations
-  for (auto origin = ++correlated.rbegin(); origin != correlated.rend(); ++origin) {
+  for (auto origin = std::next(rbegin); origin != rend; ++origin) {
     // Get the algorithm type for this location pair
     auto destination = std::prev(origin);
-    thor::PathAlgorithm* path_algorithm = get_path_algorithm(costing, *origin, *destination);
+    thor::PathAlgorithm* path_algorithm =
+        get_path_algorithm(router, costing, *origin, *destination);
     path_algorithm->Clear();
 
     // If we are continuing through a location we need to make sure we
@@ -141,7 +299,7 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
     }
 
     // Get best path and keep it
-    auto temp_path = get_path(path_algorithm, *origin, *destination, costing);
+    auto temp_path = get_path(router, path_algorithm, *origin, *destination, costing);
     temp_path.swap(path);
 
     // Merge through legs by updating the time and splicing the lists
@@ -169,8 +327,9 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
       AttributesController controller;
 
       // Form output information based on path edges
-      auto trip_path = thor::TripPathBuilder::Build(controller, reader, mode_costing, path, *origin,
-                                                    *destination, throughs, interrupt);
+      auto trip_path = thor::TripPathBuilder::Build(controller, *router.reader, router.mode_costing,
+                                                    path, *origin, *destination, throughs,
+                                                    router.interrupt);
       path.clear();
 
       // Keep the protobuf path
@@ -182,20 +341,21 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_arrive_by(
   return trip_paths;
 }
 
-std::list<valhalla::odin::TripPath> thor_worker_t::path_depart_at(
-    google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
-    const std::string& costing) {
+// Routes the locations from first to last, which are both breaks, forwards
+std::list<valhalla::odin::TripPath> thor_worker_t::path_depart_at(leg_router_t& router,
+                                                                  location_iterator first,
+                                                                  location_iterator last,
+                                                                  const std::string& costing) {
   // Things we'll need
   std::vector<thor::PathInfo> path;
   std::list<valhalla::odin::TripPath> trip_paths;
-  correlated.begin()->set_type(odin::Location::kBreak);
-  correlated.rbegin()->set_type(odin::Location::kBreak);
 
   // For each pair of locations
-  for (auto destination = ++correlated.begin(); destination != correlated.end(); ++destination) {
+  for (auto destination = std::next(first); destination != last; ++destination) {
     // Get the algorithm type for this location pair
     auto origin = std::prev(destination);
-    thor::PathAlgorithm* path_algorithm = get_path_algorithm(costing, *origin, *destination);
+    thor::PathAlgorithm* path_algorithm =
+        get_path_algorithm(router, costing, *origin, *destination);
     path_algorithm->Clear();
 
     // If we are continuing through a location we need to make sure we
@@ -208,7 +368,7 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_depart_at(
     }
 
     // Get best path and keep it
-    auto temp_path = get_path(path_algorithm, *origin, *destination, costing);
+    auto temp_path = get_path(router, path_algorithm, *origin, *destination, costing);
 
     // Merge through legs by updating the time and splicing the lists
     if (!path.empty()) {
@@ -238,8 +398,9 @@ std::list<valhalla::odin::TripPath> thor_worker_t::path_depart_at(
       AttributesController controller;
 
       // Form output information based on path edges
-      auto trip_path = thor::TripPathBuilder::Build(controller, reader, mode_costing, path, *origin,
-                                                    *destination, throughs, interrupt);
+      auto trip_path = thor::TripPathBuilder::Build(controller, *router.reader, router.mode_costing,
+                                                    path, *origin, *destination, throughs,
+                                                    router.interrupt);
       path.clear();
 
       // Keep the protobuf path
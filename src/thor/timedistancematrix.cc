@@ -1,5 +1,6 @@
 #include "thor/timedistancematrix.h"
 #include "midgard/logging.h"
+#include "midgard/util.h"
 #include <algorithm>
 #include <vector>
 
@@ -28,7 +29,8 @@ namespace thor {
 
 // Constructor with cost threshold.
 TimeDistanceMatrix::TimeDistanceMatrix()
-    : mode_(TravelMode::kDrive), settled_count_(0), current_cost_threshold_(0) {
+    : mode_(TravelMode::kDrive), settled_count_(0), current_cost_threshold_(0),
+      label_queue_type_(LabelQueueType::kDoubleBucket) {
 }
 
 float TimeDistanceMatrix::GetCostThreshold(const float max_matrix_distance) const {
@@ -57,7 +59,9 @@ void TimeDistanceMatrix::Clear() {
   dest_edges_.clear();
 
   // Clear elements from the adjacency list
-  adjacencylist_.reset();
+  if (adjacencylist_) {
+    adjacencylist_->clear();
+  }
 
   // Clear the edge status flags
   edgestatus_.clear();
@@ -156,7 +160,12 @@ TimeDistanceMatrix::OneToMany(const odin::Location& origin,
   uint32_t bucketsize = costing_->UnitSize();
   // Set up lambda to get sort costs
   const auto edgecost = [this](const uint32_t label) { return edgelabels_[label].sortcost(); };
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, current_cost_threshold_, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, current_cost_threshold_, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(
+        label_queue_type_, 0.0f, current_cost_threshold_, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Initialize the origin and destination locations
@@ -316,7 +325,12 @@ TimeDistanceMatrix::ManyToOne(const odin::Location& dest,
   astarheuristic_.Init({dest.ll().lng(), dest.ll().lat()}, 0.0f);
   uint32_t bucketsize = costing_->UnitSize();
   const auto edgecost = [this](const uint32_t label) { return edgelabels_[label].sortcost(); };
-  adjacencylist_.reset(new DoubleBucketQueue(0.0f, current_cost_threshold_, bucketsize, edgecost));
+  if (adjacencylist_) {
+    adjacencylist_->reuse(0.0f, current_cost_threshold_, bucketsize, edgecost);
+  } else {
+    adjacencylist_.reset(LabelQueueFactory::createLabelQueue(
+        label_queue_type_, 0.0f, current_cost_threshold_, bucketsize, edgecost));
+  }
   edgestatus_.clear();
 
   // Initialize the origin and destination locations
@@ -386,22 +400,36 @@ std::vector<TimeDistance> TimeDistanceMatrix::SourceToTarget(
     const std::shared_ptr<sif::DynamicCost>* mode_costing,
     const sif::TravelMode mode,
     const float max_matrix_distance) {
-  // Run a series of one to many calls and concatenate the results.
+  // Run a series of one to many (or many to one) calls and concatenate the
+  // results. The calls do not depend on each other so additional threads
+  // run some of them, each with its own matrix and graph reader.
+  const bool one_to_many = source_location_list.size() <= target_location_list.size();
+  const auto& locations = one_to_many ? source_location_list : target_location_list;
+  const auto& others = one_to_many ? target_location_list : source_location_list;
+  std::vector<std::vector<TimeDistance>> results(locations.size());
+
+  // Start no more additional threads than there are other locations
+  const size_t thread_count =
+      std::min(thread_readers_.size(), results.empty() ? 0 : results.size() - 1);
+  while (thread_matrices_.size() < thread_count) {
+    thread_matrices_.emplace_back(new TimeDistanceMatrix());
+  }
+  for (size_t t = 0; t < thread_count; ++t) {
+    thread_matrices_[t]->set_label_queue_type(label_queue_type_);
+  }
+  midgard::parallel_for(results.size(), thread_count + 1, [&](size_t i, size_t thread) {
+    auto& matrix = thread == 0 ? *this : *thread_matrices_[thread - 1];
+    auto& reader = thread == 0 ? graphreader : *thread_readers_[thread - 1];
+    results[i] = one_to_many ? matrix.OneToMany(locations.Get(i), others, reader, mode_costing,
+                                                mode, max_matrix_distance)
+                             : matrix.ManyToOne(locations.Get(i), others, reader, mode_costing,
+                                                mode, max_matrix_distance);
+    matrix.Clear();
+  });
+
   std::vector<TimeDistance> many_to_many;
-  if (source_location_list.size() <= target_location_list.size()) {
-    for (const auto& origin : source_location_list) {
-      std::vector<TimeDistance> td = OneToMany(origin, target_location_list, graphreader,
-                                               mode_costing, mode, max_matrix_distance);
-      many_to_many.insert(many_to_many.end(), td.begin(), td.end());
-      Clear();
-    }
-  } else {
-    for (const auto& destination : target_location_list) {
-      std::vector<TimeDistance> td = ManyToOne(destination, source_location_list, graphreader,
-                                               mode_costing, mode, max_matrix_distance);
-      many_to_many.insert(many_to_many.end(), td.begin(), td.end());
-      Clear();
-    }
+  for (const auto& td : results) {
+    many_to_many.insert(many_to_many.end(), td.begin(), td.end());
   }
   return many_to_many;
 }
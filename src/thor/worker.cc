@@ -81,6 +81,49 @@ thor_worker_t::thor_worker_t(const boost::property_tree::ptree& config)
   } else {
     source_to_target_algorithm = SELECT_OPTIMAL;
   }
+
+  // Select the priority queue used by the path algorithms (defaults to the
+  // double bucket queue if not present)
+  auto label_queue =
+      LabelQueueFactory::type(config.get<std::string>("thor.label_queue", "double_bucket"));
+  astar.set_label_queue_type(label_queue);
+  bidir_astar.set_label_queue_type(label_queue);
+  multi_modal_astar.set_label_queue_type(label_queue);
+  timedep_forward.set_label_queue_type(label_queue);
+  timedep_reverse.set_label_queue_type(label_queue);
+  isochrone_gen.set_label_queue_type(label_queue);
+  cost_matrix.set_label_queue_type(label_queue);
+  time_distance_matrix.set_label_queue_type(label_queue);
+
+  // Additional threads expanding the locations of a matrix, each with its own
+  // graph reader (defaults to no additional threads if not present)
+  auto matrix_concurrency = config.get<unsigned int>("thor.matrix_concurrency", 1);
+  for (unsigned int i = 1; i < matrix_concurrency; ++i) {
+    matrix_readers.emplace_back(new GraphReader(config.get_child("mjolnir")));
+  }
+  cost_matrix.set_thread_readers(matrix_readers);
+  time_distance_matrix.set_thread_readers(matrix_readers);
+
+  // Additional threads routing the legs between the breaks of a route, each
+  // with its own graph reader (defaults to no additional threads if not present)
+  auto route_concurrency = config.get<unsigned int>("thor.route_concurrency", 1);
+  for (unsigned int i = 1; i < route_concurrency; ++i) {
+    std::shared_ptr<leg_thread_t> leg_thread(new leg_thread_t());
+    leg_thread->reader.reset(new GraphReader(config.get_child("mjolnir")));
+    leg_thread->astar.set_label_queue_type(label_queue);
+    leg_thread->bidir_astar.set_label_queue_type(label_queue);
+    leg_thread->multi_modal_astar.set_label_queue_type(label_queue);
+    leg_thread->timedep_forward.set_label_queue_type(label_queue);
+    leg_thread->timedep_reverse.set_label_queue_type(label_queue);
+    leg_threads.push_back(leg_thread);
+  }
+
+  // Additional threads marking the isotile while the isochrone expands and
+  // tracing its contours (defaults to no additional threads if not present)
+  isochrone_gen.set_concurrency(config.get<unsigned int>("thor.isochrone_concurrency", 1));
+
+  // Warm the tile cache before taking any requests
+  reader.Preload(config.get_child("mjolnir"));
 }
 
 thor_worker_t::~thor_worker_t() {
@@ -109,7 +152,7 @@ worker_t::result_t thor_worker_t::work(const std::list<zmq::message_t>& job,
     // do request specific processing
     switch (request.options.action()) {
       case odin::DirectionsOptions::sources_to_targets:
-        result = to_response_json(matrix(request), info, request);
+        result = to_response_json_or_pbf(matrix(request), info, request);
         denominator = request.options.sources_size() + request.options.targets_size();
         break;
       case odin::DirectionsOptions::optimized_route: {
@@ -148,7 +191,7 @@ worker_t::result_t thor_worker_t::work(const std::list<zmq::message_t>& job,
         break;
       }
       case odin::DirectionsOptions::trace_attributes:
-        result = to_response_json(trace_attributes(request), info, request);
+        result = to_response_json_or_pbf(trace_attributes(request), info, request);
         denominator = trace.size() / 1100;
         break;
       default:
@@ -160,8 +203,10 @@ worker_t::result_t thor_worker_t::work(const std::list<zmq::message_t>& job,
     if (!request.options.do_not_track() && elapsed_time / denominator > long_request) {
       LOG_WARN("thor::" + odin::DirectionsOptions::Action_Name(request.options.action()) +
                " request elapsed time (ms)::" + std::to_string(elapsed_time));
+      // The document loki forwards has no locations or shape, those are in the options
       LOG_WARN("thor::" + odin::DirectionsOptions::Action_Name(request.options.action()) +
-               " request exceeded threshold::" + request_str);
+               " request exceeded threshold::" + rapidjson::to_string(request.document) +
+               " options::" + request.options.ShortDebugString());
       midgard::logging::Log("valhalla_thor_long_request_" +
                                 odin::DirectionsOptions::Action_Name(request.options.action()),
                             " [ANALYTICS] ");
@@ -329,9 +374,18 @@ void thor_worker_t::cleanup() {
   multi_modal_astar.Clear();
   trace.clear();
   isochrone_gen.Clear();
+  cost_matrix.Clear();
+  time_distance_matrix.Clear();
   matcher_factory.ClearFullCache();
-  if (reader.OverCommitted()) {
-    reader.Clear();
+  reader.Trim();
+  for (auto& matrix_reader : matrix_readers) {
+    matrix_reader->Trim();
+  }
+  for (auto& leg_thread : leg_threads) {
+    leg_thread->astar.Clear();
+    leg_thread->bidir_astar.Clear();
+    leg_thread->multi_modal_astar.Clear();
+    leg_thread->reader->Trim();
   }
 }
 
@@ -6,6 +6,7 @@
 
 #include <cmath>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <utility>
 
@@ -25,9 +26,24 @@ serializeIsochrones(const valhalla_request_t& request,
                     bool polygons,
                     const std::unordered_map<float, std::string>& colors,
                     bool show_locations) {
+  // roughly what each point of each contour takes up in the output
+  size_t points = 0;
+  for (const auto& interval : grid_contours) {
+    for (const auto& feature : interval.second) {
+      for (const auto& contour : feature) {
+        points += contour.size();
+      }
+    }
+  }
+  Jwriter writer(1024 + points * 28);
+
+  // make the collection
+  writer.start_object();
+  writer("type", "FeatureCollection");
+  writer.start_array("features");
+
   // for each contour interval
   int i = 0;
-  auto features = array({});
   for (const auto& interval : grid_contours) {
     auto color_itr = colors.find(interval.first);
     // color was supplied
@@ -46,69 +62,77 @@ serializeIsochrones(const valhalla_request_t& request,
           << static_cast<int>(std::get<1>(color) * 255 + .5f) << std::hex
           << static_cast<int>(std::get<2>(color) * 255 + .5f);
     }
+    const std::string color = hex.str();
     ++i;
 
     // for each feature on that interval
     for (const auto& feature : interval.second) {
+      // add a feature
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("geometry");
+      writer("type", polygons ? "Polygon" : "LineString");
+      writer.start_array("coordinates");
       // for each contour in that feature
-      auto geom = array({});
-      for (const auto& contour : feature) {
+      for (auto contour = feature.begin(); contour != feature.end(); ++contour) {
+        // its either a ring or a single line, if someone has more than one contour per feature
+        // they messed up and only the last one is kept
+        if (!polygons && std::next(contour) != feature.end()) {
+          continue;
+        }
         // make some geometry
-        auto coords = array({});
-        for (const auto& coord : contour) {
-          coords->push_back(array({fp_t{coord.first, 6}, fp_t{coord.second, 6}}));
+        if (polygons) {
+          writer.start_array();
+        }
+        for (const auto& coord : *contour) {
+          writer.start_array();
+          writer(fp_t{coord.first, 6});
+          writer(fp_t{coord.second, 6});
+          writer.end_array();
         }
-        // its either a ring
         if (polygons) {
-          geom->emplace_back(coords);
-          // or a single line, if someone has more than one contour per feature they messed up
-        } else {
-          geom = coords;
+          writer.end_array();
         }
       }
-      // add a feature
-      features->emplace_back(map({
-          {"type", std::string("Feature")},
-          {"geometry", map({
-                           {"type", std::string(polygons ? "Polygon" : "LineString")},
-                           {"coordinates", geom},
-                       })},
-          {"properties", map({
-                             {"contour", static_cast<uint64_t>(interval.first)},
-                             {"color", hex.str()},            // lines
-                             {"fill", hex.str()},             // geojson.io polys
-                             {"fillColor", hex.str()},        // leaflet polys
-                             {"opacity", fp_t{.33f, 2}},      // lines
-                             {"fill-opacity", fp_t{.33f, 2}}, // geojson.io polys
-                             {"fillOpacity", fp_t{.33f, 2}},  // leaflet polys
-                         })},
-      }));
+      writer.end_array();
+      writer.end_object();
+      writer.start_object("properties");
+      writer("contour", static_cast<uint64_t>(interval.first));
+      writer("color", color);                // lines
+      writer("fill", color);                 // geojson.io polys
+      writer("fillColor", color);            // leaflet polys
+      writer("opacity", fp_t{.33f, 2});      // lines
+      writer("fill-opacity", fp_t{.33f, 2}); // geojson.io polys
+      writer("fillOpacity", fp_t{.33f, 2});  // leaflet polys
+      writer.end_object();
+      writer.end_object();
     }
   }
   // Add original locations to the geojson
   if (show_locations) {
     for (const auto& location : request.options.locations()) {
-      features->emplace_back(
-          map({{"type", std::string("Feature")},
-               {"properties", map({})},
-               {"geometry", map({{"type", std::string("Point")},
-                                 {"coordinates", array({fp_t{location.ll().lng(), 6},
-                                                        fp_t{location.ll().lat(), 6}})}})}}));
+      writer.start_object();
+      writer("type", "Feature");
+      writer.start_object("properties");
+      writer.end_object();
+      writer.start_object("geometry");
+      writer("type", "Point");
+      writer.start_array("coordinates");
+      writer(fp_t{location.ll().lng(), 6});
+      writer(fp_t{location.ll().lat(), 6});
+      writer.end_array();
+      writer.end_object();
+      writer.end_object();
     }
   }
-  // make the collection
-  auto feature_collection = map({
-      {"type", std::string("FeatureCollection")},
-      {"features", features},
-  });
+  writer.end_array();
 
   if (request.options.has_id()) {
-    feature_collection->emplace("id", request.options.id());
+    writer("id", request.options.id());
   }
+  writer.end_object();
 
-  std::stringstream ss;
-  ss << *feature_collection;
-  return ss.str();
+  return writer.release();
 }
 
 template std::string
@@ -11,63 +11,63 @@ using namespace valhalla::thor;
 
 namespace osrm_serializers {
 
-json::ArrayPtr
-serialize_duration(const std::vector<TimeDistance>& tds, size_t start_td, const size_t td_count) {
-  auto time = json::array({});
+void serialize_duration(json::Jwriter& writer,
+                        const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for time in matrix result
     if (tds[i].time != kMaxCost) {
-      time->emplace_back(static_cast<uint64_t>(tds[i].time));
+      writer(static_cast<uint64_t>(tds[i].time));
     } else {
-      time->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return time;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_distance(const std::vector<TimeDistance>& tds,
-                                  size_t start_td,
-                                  const size_t td_count,
-                                  const size_t source_index,
-                                  const size_t target_index,
-                                  double distance_scale) {
-  auto distance = json::array({});
+void serialize_distance(json::Jwriter& writer,
+                        const std::vector<TimeDistance>& tds,
+                        size_t start_td,
+                        const size_t td_count,
+                        double distance_scale) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance in matrix result
     if (tds[i].time != kMaxCost) {
-      distance->emplace_back(json::fp_t{tds[i].dist * distance_scale, 3});
+      writer(json::fp_t{tds[i].dist * distance_scale, 3});
     } else {
-      distance->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return distance;
+  writer.end_array();
 }
 
 // Serialize route response in OSRM compatible format.
-json::MapPtr serialize(const valhalla_request_t& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  auto json = json::map({});
-  auto time = json::array({});
-  auto distance = json::array({});
-
+void serialize(json::Jwriter& writer,
+               const valhalla_request_t& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale) {
   // If here then the matrix succeeded. Set status code to OK and serialize
   // waypoints (locations).
-  json->emplace("code", std::string("Ok"));
-  json->emplace("sources", osrm::waypoints(request.options.sources()));
-  json->emplace("destinations", osrm::waypoints(request.options.targets()));
+  writer.start_object();
+  writer("code", "Ok");
+  writer("sources", osrm::waypoints(request.options.sources()));
+  writer("destinations", osrm::waypoints(request.options.targets()));
 
+  const size_t targets = request.options.targets_size();
+  writer.start_array("durations");
+  for (size_t source_index = 0; source_index < request.options.sources_size(); ++source_index) {
+    serialize_duration(writer, time_distances, source_index * targets, targets);
+  }
+  writer.end_array();
+  writer.start_array("distances");
   for (size_t source_index = 0; source_index < request.options.sources_size(); ++source_index) {
-    time->emplace_back(serialize_duration(time_distances,
-                                          source_index * request.options.targets_size(),
-                                          request.options.targets_size()));
-    distance->emplace_back(
-        serialize_distance(time_distances, source_index * request.options.targets_size(),
-                           request.options.targets_size(), source_index, 0, distance_scale));
+    serialize_distance(writer, time_distances, source_index * targets, targets, distance_scale);
   }
-  json->emplace("durations", time);
-  json->emplace("distances", distance);
-  return json;
+  writer.end_array();
+  writer.end_object();
 }
 } // namespace osrm_serializers
 
@@ -78,77 +78,119 @@ valhalla output looks like this:
 
 */
 
-json::ArrayPtr locations(const google::protobuf::RepeatedPtrField<odin::Location>& correlated) {
-  auto input_locs = json::array({});
-  for (size_t i = 0; i < correlated.size(); i++) {
-    input_locs->emplace_back(json::map({{"lat", json::fp_t{correlated.Get(i).ll().lat(), 6}},
-                                        {"lon", json::fp_t{correlated.Get(i).ll().lng(), 6}}}));
+void locations(json::Jwriter& writer,
+               const google::protobuf::RepeatedPtrField<odin::Location>& correlated) {
+  writer.start_array();
+  for (const auto& location : correlated) {
+    writer.start_object();
+    writer("lat", json::fp_t{location.ll().lat(), 6});
+    writer("lon", json::fp_t{location.ll().lng(), 6});
+    writer.end_object();
   }
-  return input_locs;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_row(const std::vector<TimeDistance>& tds,
-                             size_t start_td,
-                             const size_t td_count,
-                             const size_t source_index,
-                             const size_t target_index,
-                             double distance_scale) {
-  auto row = json::array({});
+void serialize_row(json::Jwriter& writer,
+                   const std::vector<TimeDistance>& tds,
+                   size_t start_td,
+                   const size_t td_count,
+                   const size_t source_index,
+                   const size_t target_index,
+                   double distance_scale) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
+    writer.start_object();
+    writer("from_index", static_cast<uint64_t>(source_index));
+    writer("to_index", static_cast<uint64_t>(target_index + (i - start_td)));
     // check to make sure a route was found; if not, return null for distance & time in matrix
     // result
     if (tds[i].time != kMaxCost) {
-      row->emplace_back(json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                                   {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                                   {"time", static_cast<uint64_t>(tds[i].time)},
-                                   {"distance", json::fp_t{tds[i].dist * distance_scale, 3}}}));
+      writer("time", static_cast<uint64_t>(tds[i].time));
+      writer("distance", json::fp_t{tds[i].dist * distance_scale, 3});
     } else {
-      row->emplace_back(json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                                   {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                                   {"time", static_cast<std::nullptr_t>(nullptr)},
-                                   {"distance", static_cast<std::nullptr_t>(nullptr)}}));
+      writer("time", nullptr);
+      writer("distance", nullptr);
     }
+    writer.end_object();
   }
-  return row;
+  writer.end_array();
 }
 
-json::MapPtr serialize(const valhalla_request_t& request,
-                       const std::vector<TimeDistance>& time_distances,
-                       double distance_scale) {
-  json::ArrayPtr matrix = json::array({});
+void serialize(json::Jwriter& writer,
+               const valhalla_request_t& request,
+               const std::vector<TimeDistance>& time_distances,
+               double distance_scale) {
+  writer.start_object();
+  writer.start_array("sources_to_targets");
   for (size_t source_index = 0; source_index < request.options.sources_size(); ++source_index) {
-    matrix->emplace_back(serialize_row(time_distances, source_index * request.options.targets_size(),
-                                       request.options.targets_size(), source_index, 0,
-                                       distance_scale));
+    serialize_row(writer, time_distances, source_index * request.options.targets_size(),
+                  request.options.targets_size(), source_index, 0, distance_scale);
   }
-  auto json = json::map({
-      {"sources_to_targets", matrix},
-      {"units", odin::DirectionsOptions::Units_Name(request.options.units())},
-  });
-  json->emplace("targets", json::array({locations(request.options.targets())}));
-  json->emplace("sources", json::array({locations(request.options.sources())}));
+  writer.end_array();
+  writer("units", odin::DirectionsOptions::Units_Name(request.options.units()));
+  writer.start_array("targets");
+  locations(writer, request.options.targets());
+  writer.end_array();
+  writer.start_array("sources");
+  locations(writer, request.options.sources());
+  writer.end_array();
 
   if (request.options.has_id()) {
-    json->emplace("id", request.options.id());
+    writer("id", request.options.id());
   }
-  return json;
+  writer.end_object();
 }
 } // namespace valhalla_serializers
 
+namespace pbf_serializers {
+
+// Serialize the matrix without any json, pairs without a route are listed separately
+std::string serialize(const valhalla_request_t& request,
+                      const std::vector<TimeDistance>& time_distances,
+                      double distance_scale) {
+  odin::Response response;
+  if (request.options.has_id()) {
+    response.set_id(request.options.id());
+  }
+  response.set_units(request.options.units());
+
+  auto* matrix = response.mutable_matrix();
+  matrix->set_sources(request.options.sources_size());
+  matrix->set_targets(request.options.targets_size());
+  matrix->mutable_times()->Reserve(time_distances.size());
+  matrix->mutable_distances()->Reserve(time_distances.size());
+  for (size_t i = 0; i < time_distances.size(); ++i) {
+    if (time_distances[i].time != kMaxCost) {
+      matrix->add_times(time_distances[i].time);
+      matrix->add_distances(time_distances[i].dist * distance_scale);
+    } else {
+      matrix->add_times(0);
+      matrix->add_distances(0);
+      matrix->add_not_found(i);
+    }
+  }
+  return response.SerializeAsString();
+}
+} // namespace pbf_serializers
+
 namespace valhalla {
 namespace tyr {
 
 std::string serializeMatrix(const valhalla_request_t& request,
                             const std::vector<TimeDistance>& time_distances,
                             double distance_scale) {
+  if (request.options.format() == odin::DirectionsOptions::pbf) {
+    return pbf_serializers::serialize(request, time_distances, distance_scale);
+  }
 
-  auto json = request.options.format() == odin::DirectionsOptions::osrm
-                  ? osrm_serializers::serialize(request, time_distances, distance_scale)
-                  : valhalla_serializers::serialize(request, time_distances, distance_scale);
-
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  // roughly what each source to target pair takes up in the output
+  json::Jwriter writer(256 + time_distances.size() * 64);
+  if (request.options.format() == odin::DirectionsOptions::osrm) {
+    osrm_serializers::serialize(writer, request, time_distances, distance_scale);
+  } else {
+    valhalla_serializers::serialize(writer, request, time_distances, distance_scale);
+  }
+  return writer.release();
 }
 
 } // namespace tyr
@@ -1003,7 +1003,7 @@ valhalla output looks like this:
 */
 using namespace std;
 
-json::MapPtr summary(const std::list<valhalla::odin::TripDirections>& legs) {
+void summary(json::Jwriter& writer, const std::list<valhalla::odin::TripDirections>& legs) {
 
   uint64_t time = 0;
   long double length = 0;
@@ -1017,75 +1017,74 @@ json::MapPtr summary(const std::list<valhalla::odin::TripDirections>& legs) {
     bbox.Expand(leg_bbox);
   }
 
-  auto route_summary = json::map({});
-  route_summary->emplace("time", time);
-  route_summary->emplace("length", json::fp_t{length, 3});
-  route_summary->emplace("min_lat", json::fp_t{bbox.miny(), 6});
-  route_summary->emplace("min_lon", json::fp_t{bbox.minx(), 6});
-  route_summary->emplace("max_lat", json::fp_t{bbox.maxy(), 6});
-  route_summary->emplace("max_lon", json::fp_t{bbox.maxx(), 6});
+  writer.start_object("summary");
+  writer("time", time);
+  writer("length", json::fp_t{length, 3});
+  writer("min_lat", json::fp_t{bbox.miny(), 6});
+  writer("min_lon", json::fp_t{bbox.minx(), 6});
+  writer("max_lat", json::fp_t{bbox.maxy(), 6});
+  writer("max_lon", json::fp_t{bbox.maxx(), 6});
+  writer.end_object();
   LOG_DEBUG("trip_time::" + std::to_string(time) + "s");
-  return route_summary;
 }
 
-json::ArrayPtr locations(const std::list<valhalla::odin::TripDirections>& legs) {
-  auto locations = json::array({});
+void locations(json::Jwriter& writer, const std::list<valhalla::odin::TripDirections>& legs) {
+  writer.start_array("locations");
 
   int index = 0;
   for (auto leg = legs.begin(); leg != legs.end(); ++leg) {
     for (auto location = leg->location().begin() + index; location != leg->location().end();
          ++location) {
       index = 1;
-      auto loc = json::map({});
+      writer.start_object();
       if (location->type() == odin::Location_Type_kThrough) {
-        loc->emplace("type", std::string("through"));
+        writer("type", "through");
       } else {
-        loc->emplace("type", std::string("break"));
+        writer("type", "break");
       }
-      loc->emplace("lat", json::fp_t{location->ll().lat(), 6});
-      loc->emplace("lon", json::fp_t{location->ll().lng(), 6});
+      writer("lat", json::fp_t{location->ll().lat(), 6});
+      writer("lon", json::fp_t{location->ll().lng(), 6});
       if (!location->name().empty()) {
-        loc->emplace("name", location->name());
+        writer("name", location->name());
       }
       if (!location->street().empty()) {
-        loc->emplace("street", location->street());
+        writer("street", location->street());
       }
       if (!location->city().empty()) {
-        loc->emplace("city", location->city());
+        writer("city", location->city());
       }
       if (!location->state().empty()) {
-        loc->emplace("state", location->state());
+        writer("state", location->state());
       }
       if (!location->postal_code().empty()) {
-        loc->emplace("postal_code", location->postal_code());
+        writer("postal_code", location->postal_code());
       }
       if (!location->country().empty()) {
-        loc->emplace("country", location->country());
+        writer("country", location->country());
       }
       if (location->has_heading()) {
-        loc->emplace("heading", static_cast<uint64_t>(location->heading()));
+        writer("heading", static_cast<uint64_t>(location->heading()));
       }
       if (!location->date_time().empty()) {
-        loc->emplace("date_time", location->date_time());
+        writer("date_time", location->date_time());
       }
       if (location->has_side_of_street()) {
         if (location->side_of_street() == odin::Location::kLeft) {
-          loc->emplace("side_of_street", std::string("left"));
+          writer("side_of_street", "left");
         } else if (location->side_of_street() == odin::Location::kRight) {
-          loc->emplace("side_of_street", std::string("right"));
+          writer("side_of_street", "right");
         }
       }
       if (location->has_original_index()) {
-        loc->emplace("original_index", static_cast<uint64_t>(location->original_index()));
+        writer("original_index", static_cast<uint64_t>(location->original_index()));
       }
 
-      // loc->emplace("sideOfStreet",location->side_of_street());
+      // writer("sideOfStreet", location->side_of_street());
 
-      locations->emplace_back(loc);
+      writer.end_object();
     }
   }
-
-  return locations;
+  writer.end_array();
 }
 
 const std::unordered_map<int, std::string> vehicle_to_string{
@@ -1150,335 +1149,324 @@ travel_mode_type(const valhalla::odin::TripDirections_Maneuver& maneuver) {
   }
 }
 
-json::ArrayPtr legs(const std::list<valhalla::odin::TripDirections>& directions_legs) {
+void legs(json::Jwriter& writer, const std::list<valhalla::odin::TripDirections>& directions_legs) {
 
   // TODO: multiple legs.
-  auto legs = json::array({});
+  writer.start_array("legs");
   for (const auto& directions_leg : directions_legs) {
-    auto leg = json::map({});
-    auto summary = json::map({});
-    auto maneuvers = json::array({});
+    writer.start_object();
+    if (directions_leg.maneuver_size() > 0) {
+      writer.start_array("maneuvers");
+    }
 
     for (const auto& maneuver : directions_leg.maneuver()) {
 
-      auto man = json::map({});
+      writer.start_object();
 
       // Maneuver type
-      man->emplace("type", static_cast<uint64_t>(maneuver.type()));
+      writer("type", static_cast<uint64_t>(maneuver.type()));
 
       // Instruction and verbal instructions
-      man->emplace("instruction", maneuver.text_instruction());
+      writer("instruction", maneuver.text_instruction());
       if (maneuver.has_verbal_transition_alert_instruction()) {
-        man->emplace("verbal_transition_alert_instruction",
-                     maneuver.verbal_transition_alert_instruction());
+        writer("verbal_transition_alert_instruction", maneuver.verbal_transition_alert_instruction());
       }
       if (maneuver.has_verbal_pre_transition_instruction()) {
-        man->emplace("verbal_pre_transition_instruction",
-                     maneuver.verbal_pre_transition_instruction());
+        writer("verbal_pre_transition_instruction", maneuver.verbal_pre_transition_instruction());
       }
       if (maneuver.has_verbal_post_transition_instruction()) {
-        man->emplace("verbal_post_transition_instruction",
-                     maneuver.verbal_post_transition_instruction());
+        writer("verbal_post_transition_instruction", maneuver.verbal_post_transition_instruction());
       }
 
       // Set street names
       if (maneuver.street_name_size() > 0) {
-        auto street_names = json::array({});
+        writer.start_array("street_names");
         for (int i = 0; i < maneuver.street_name_size(); i++) {
-          street_names->emplace_back(maneuver.street_name(i));
+          writer(maneuver.street_name(i));
         }
-        man->emplace("street_names", std::move(street_names));
+        writer.end_array();
       }
 
       // Set begin street names
       if (maneuver.begin_street_name_size() > 0) {
-        auto begin_street_names = json::array({});
+        writer.start_array("begin_street_names");
         for (int i = 0; i < maneuver.begin_street_name_size(); i++) {
-          begin_street_names->emplace_back(maneuver.begin_street_name(i));
+          writer(maneuver.begin_street_name(i));
         }
-        man->emplace("begin_street_names", std::move(begin_street_names));
+        writer.end_array();
       }
 
       // Time, length, and shape indexes
-      man->emplace("time", static_cast<uint64_t>(maneuver.time()));
-      man->emplace("length", json::fp_t{maneuver.length(), 3});
-      man->emplace("begin_shape_index", static_cast<uint64_t>(maneuver.begin_shape_index()));
-      man->emplace("end_shape_index", static_cast<uint64_t>(maneuver.end_shape_index()));
+      writer("time", static_cast<uint64_t>(maneuver.time()));
+      writer("length", json::fp_t{maneuver.length(), 3});
+      writer("begin_shape_index", static_cast<uint64_t>(maneuver.begin_shape_index()));
+      writer("end_shape_index", static_cast<uint64_t>(maneuver.end_shape_index()));
 
       // Portions toll and rough
       if (maneuver.portions_toll()) {
-        man->emplace("toll", maneuver.portions_toll());
+        writer("toll", maneuver.portions_toll());
       }
       if (maneuver.portions_unpaved()) {
-        man->emplace("rough", maneuver.portions_unpaved());
+        writer("rough", maneuver.portions_unpaved());
       }
 
       // Process sign
       if (maneuver.has_sign()) {
-        auto sign = json::map({});
+        writer.start_object("sign");
 
         // Process exit number
         if (maneuver.sign().exit_number_elements_size() > 0) {
-          auto exit_number_elements = json::array({});
+          writer.start_array("exit_number_elements");
           for (int i = 0; i < maneuver.sign().exit_number_elements_size(); ++i) {
-            auto exit_number_element = json::map({});
+            writer.start_object();
 
             // Add the exit number text
-            exit_number_element->emplace("text", maneuver.sign().exit_number_elements(i).text());
+            writer("text", maneuver.sign().exit_number_elements(i).text());
 
             // Add the exit number consecutive count only if greater than zero
             if (maneuver.sign().exit_number_elements(i).consecutive_count() > 0) {
-              exit_number_element
-                  ->emplace("consecutive_count",
-                            static_cast<uint64_t>(
-                                maneuver.sign().exit_number_elements(i).consecutive_count()));
+              writer("consecutive_count",
+                     static_cast<uint64_t>(
+                         maneuver.sign().exit_number_elements(i).consecutive_count()));
             }
-
-            exit_number_elements->emplace_back(exit_number_element);
+            writer.end_object();
           }
-          sign->emplace("exit_number_elements", std::move(exit_number_elements));
+          writer.end_array();
         }
 
         // Process exit branch
         if (maneuver.sign().exit_branch_elements_size() > 0) {
-          auto exit_branch_elements = json::array({});
+          writer.start_array("exit_branch_elements");
           for (int i = 0; i < maneuver.sign().exit_branch_elements_size(); ++i) {
-            auto exit_branch_element = json::map({});
+            writer.start_object();
 
             // Add the exit branch text
-            exit_branch_element->emplace("text", maneuver.sign().exit_branch_elements(i).text());
+            writer("text", maneuver.sign().exit_branch_elements(i).text());
 
             // Add the exit branch consecutive count only if greater than zero
             if (maneuver.sign().exit_branch_elements(i).consecutive_count() > 0) {
-              exit_branch_element
-                  ->emplace("consecutive_count",
-                            static_cast<uint64_t>(
-                                maneuver.sign().exit_branch_elements(i).consecutive_count()));
+              writer("consecutive_count",
+                     static_cast<uint64_t>(
+                         maneuver.sign().exit_branch_elements(i).consecutive_count()));
             }
-
-            exit_branch_elements->emplace_back(exit_branch_element);
+            writer.end_object();
           }
-          sign->emplace("exit_branch_elements", std::move(exit_branch_elements));
+          writer.end_array();
         }
 
         // Process exit toward
         if (maneuver.sign().exit_toward_elements_size() > 0) {
-          auto exit_toward_elements = json::array({});
+          writer.start_array("exit_toward_elements");
           for (int i = 0; i < maneuver.sign().exit_toward_elements_size(); ++i) {
-            auto exit_toward_element = json::map({});
+            writer.start_object();
 
             // Add the exit toward text
-            exit_toward_element->emplace("text", maneuver.sign().exit_toward_elements(i).text());
+            writer("text", maneuver.sign().exit_toward_elements(i).text());
 
             // Add the exit toward consecutive count only if greater than zero
             if (maneuver.sign().exit_toward_elements(i).consecutive_count() > 0) {
-              exit_toward_element
-                  ->emplace("consecutive_count",
-                            static_cast<uint64_t>(
-                                maneuver.sign().exit_toward_elements(i).consecutive_count()));
+              writer("consecutive_count",
+                     static_cast<uint64_t>(
+                         maneuver.sign().exit_toward_elements(i).consecutive_count()));
             }
-
-            exit_toward_elements->emplace_back(exit_toward_element);
+            writer.end_object();
           }
-          sign->emplace("exit_toward_elements", std::move(exit_toward_elements));
+          writer.end_array();
         }
 
         // Process exit name
         if (maneuver.sign().exit_name_elements_size() > 0) {
-          auto exit_name_elements = json::array({});
+          writer.start_array("exit_name_elements");
           for (int i = 0; i < maneuver.sign().exit_name_elements_size(); ++i) {
-            auto exit_name_element = json::map({});
+            writer.start_object();
 
             // Add the exit name text
-            exit_name_element->emplace("text", maneuver.sign().exit_name_elements(i).text());
+            writer("text", maneuver.sign().exit_name_elements(i).text());
 
             // Add the exit name consecutive count only if greater than zero
             if (maneuver.sign().exit_name_elements(i).consecutive_count() > 0) {
-              exit_name_element
-                  ->emplace("consecutive_count",
-                            static_cast<uint64_t>(
-                                maneuver.sign().exit_name_elements(i).consecutive_count()));
+              writer("consecutive_count",
+                     static_cast<uint64_t>(
+                         maneuver.sign().exit_name_elements(i).consecutive_count()));
             }
-
-            exit_name_elements->emplace_back(exit_name_element);
+            writer.end_object();
           }
-          sign->emplace("exit_name_elements", std::move(exit_name_elements));
+          writer.end_array();
         }
 
-        man->emplace("sign", std::move(sign));
+        writer.end_object();
       }
 
       // Roundabout count
       if (maneuver.has_roundabout_exit_count()) {
-        man->emplace("roundabout_exit_count",
-                     static_cast<uint64_t>(maneuver.roundabout_exit_count()));
+        writer("roundabout_exit_count", static_cast<uint64_t>(maneuver.roundabout_exit_count()));
       }
 
       // Depart and arrive instructions
       if (maneuver.has_depart_instruction()) {
-        man->emplace("depart_instruction", maneuver.depart_instruction());
+        writer("depart_instruction", maneuver.depart_instruction());
       }
       if (maneuver.has_verbal_depart_instruction()) {
-        man->emplace("verbal_depart_instruction", maneuver.verbal_depart_instruction());
+        writer("verbal_depart_instruction", maneuver.verbal_depart_instruction());
       }
       if (maneuver.has_arrive_instruction()) {
-        man->emplace("arrive_instruction", maneuver.arrive_instruction());
+        writer("arrive_instruction", maneuver.arrive_instruction());
       }
       if (maneuver.has_verbal_arrive_instruction()) {
-        man->emplace("verbal_arrive_instruction", maneuver.verbal_arrive_instruction());
+        writer("verbal_arrive_instruction", maneuver.verbal_arrive_instruction());
       }
 
       // Process transit route
       if (maneuver.has_transit_info()) {
         const auto& transit_info = maneuver.transit_info();
-        auto json_transit_info = json::map({});
+        writer.start_object("transit_info");
 
         if (transit_info.has_onestop_id()) {
-          json_transit_info->emplace("onestop_id", transit_info.onestop_id());
+          writer("onestop_id", transit_info.onestop_id());
           valhalla::midgard::logging::Log("transit_route_stopid::" + transit_info.onestop_id(),
                                           " [ANALYTICS] ");
         }
         if (transit_info.has_short_name()) {
-          json_transit_info->emplace("short_name", transit_info.short_name());
+          writer("short_name", transit_info.short_name());
         }
         if (transit_info.has_long_name()) {
-          json_transit_info->emplace("long_name", transit_info.long_name());
+          writer("long_name", transit_info.long_name());
         }
         if (transit_info.has_headsign()) {
-          json_transit_info->emplace("headsign", transit_info.headsign());
+          writer("headsign", transit_info.headsign());
         }
         if (transit_info.has_color()) {
-          json_transit_info->emplace("color", static_cast<uint64_t>(transit_info.color()));
+          writer("color", static_cast<uint64_t>(transit_info.color()));
         }
         if (transit_info.has_text_color()) {
-          json_transit_info->emplace("text_color", static_cast<uint64_t>(transit_info.text_color()));
+          writer("text_color", static_cast<uint64_t>(transit_info.text_color()));
         }
         if (transit_info.has_description()) {
-          json_transit_info->emplace("description", transit_info.description());
+          writer("description", transit_info.description());
         }
         if (transit_info.has_operator_onestop_id()) {
-          json_transit_info->emplace("operator_onestop_id", transit_info.operator_onestop_id());
+          writer("operator_onestop_id", transit_info.operator_onestop_id());
         }
         if (transit_info.has_operator_name()) {
-          json_transit_info->emplace("operator_name", transit_info.operator_name());
+          writer("operator_name", transit_info.operator_name());
         }
         if (transit_info.has_operator_url()) {
-          json_transit_info->emplace("operator_url", transit_info.operator_url());
+          writer("operator_url", transit_info.operator_url());
         }
 
         // Add transit stops
         if (transit_info.transit_stops().size() > 0) {
-          auto json_transit_stops = json::array({});
+          writer.start_array("transit_stops");
           for (const auto& transit_stop : transit_info.transit_stops()) {
-            auto json_transit_stop = json::map({});
+            writer.start_object();
 
             // type
             if (transit_stop.has_type()) {
               if (transit_stop.type() == TransitPlatformInfo_Type_kStation) {
-                json_transit_stop->emplace("type", std::string("station"));
+                writer("type", "station");
               } else {
-                json_transit_stop->emplace("type", std::string("stop"));
+                writer("type", "stop");
               }
             }
 
             // onestop_id - using the station onestop_id
             if (transit_stop.has_station_onestop_id()) {
-              json_transit_stop->emplace("onestop_id", transit_stop.station_onestop_id());
+              writer("onestop_id", transit_stop.station_onestop_id());
               valhalla::midgard::logging::Log("transit_stopid::" + transit_stop.station_onestop_id(),
                                               " [ANALYTICS] ");
             }
 
             // name - using the station name
             if (transit_stop.has_station_name()) {
-              json_transit_stop->emplace("name", transit_stop.station_name());
+              writer("name", transit_stop.station_name());
             }
 
             // arrival_date_time
             if (transit_stop.has_arrival_date_time()) {
-              json_transit_stop->emplace("arrival_date_time", transit_stop.arrival_date_time());
+              writer("arrival_date_time", transit_stop.arrival_date_time());
             }
 
             // departure_date_time
             if (transit_stop.has_departure_date_time()) {
-              json_transit_stop->emplace("departure_date_time", transit_stop.departure_date_time());
+              writer("departure_date_time", transit_stop.departure_date_time());
             }
 
             // assumed_schedule
             if (transit_stop.has_assumed_schedule()) {
-              json_transit_stop->emplace("assumed_schedule", transit_stop.assumed_schedule());
+              writer("assumed_schedule", transit_stop.assumed_schedule());
             }
 
             // latitude and longitude
             if (transit_stop.has_ll()) {
-              json_transit_stop->emplace("lat", json::fp_t{transit_stop.ll().lat(), 6});
-              json_transit_stop->emplace("lon", json::fp_t{transit_stop.ll().lng(), 6});
+              writer("lat", json::fp_t{transit_stop.ll().lat(), 6});
+              writer("lon", json::fp_t{transit_stop.ll().lng(), 6});
             }
-
-            json_transit_stops->emplace_back(json_transit_stop);
+            writer.end_object();
           }
-          json_transit_info->emplace("transit_stops", std::move(json_transit_stops));
+          writer.end_array();
         }
 
-        man->emplace("transit_info", std::move(json_transit_info));
+        writer.end_object();
       }
 
       if (maneuver.verbal_multi_cue()) {
-        man->emplace("verbal_multi_cue", maneuver.verbal_multi_cue());
+        writer("verbal_multi_cue", maneuver.verbal_multi_cue());
       }
 
       // Travel mode
       auto mode_type = travel_mode_type(maneuver);
-      man->emplace("travel_mode", mode_type.first);
+      writer("travel_mode", mode_type.first);
 
       // Travel type
-      man->emplace("travel_type", mode_type.second);
+      writer("travel_type", mode_type.second);
 
-      //  man->emplace("hasGate", maneuver.);
-      //  man->emplace("hasFerry", maneuver.);
+      //  writer("hasGate", maneuver.);
+      //  writer("hasFerry", maneuver.);
       //“portionsTollNote” : “<portionsTollNote>”,
       //“portionsUnpavedNote” : “<portionsUnpavedNote>”,
       //“gateAccessRequiredNote” : “<gateAccessRequiredNote>”,
       //“checkFerryInfoNote” : “<checkFerryInfoNote>”
-      maneuvers->emplace_back(man);
+      writer.end_object();
     }
     if (directions_leg.maneuver_size() > 0) {
-      leg->emplace("maneuvers", maneuvers);
+      writer.end_array();
     }
-    summary->emplace("time", static_cast<uint64_t>(directions_leg.summary().time()));
-    summary->emplace("length", json::fp_t{directions_leg.summary().length(), 3});
-    summary->emplace("min_lat", json::fp_t{directions_leg.summary().bbox().min_ll().lat(), 6});
-    summary->emplace("min_lon", json::fp_t{directions_leg.summary().bbox().min_ll().lng(), 6});
-    summary->emplace("max_lat", json::fp_t{directions_leg.summary().bbox().max_ll().lat(), 6});
-    summary->emplace("max_lon", json::fp_t{directions_leg.summary().bbox().max_ll().lng(), 6});
-    leg->emplace("summary", summary);
-    leg->emplace("shape", directions_leg.shape());
+    writer.start_object("summary");
+    writer("time", static_cast<uint64_t>(directions_leg.summary().time()));
+    writer("length", json::fp_t{directions_leg.summary().length(), 3});
+    writer("min_lat", json::fp_t{directions_leg.summary().bbox().min_ll().lat(), 6});
+    writer("min_lon", json::fp_t{directions_leg.summary().bbox().min_ll().lng(), 6});
+    writer("max_lat", json::fp_t{directions_leg.summary().bbox().max_ll().lat(), 6});
+    writer("max_lon", json::fp_t{directions_leg.summary().bbox().max_ll().lng(), 6});
+    writer.end_object();
+    writer("shape", directions_leg.shape());
 
-    legs->emplace_back(leg);
+    writer.end_object();
   }
-  return legs;
+  writer.end_array();
 }
 
 std::string serialize(const valhalla::odin::DirectionsOptions& directions_options,
                       const std::list<valhalla::odin::TripDirections>& directions_legs) {
   // build up the json object
-  auto json = json::map(
-      {{"trip", json::map({{"locations", locations(directions_legs)},
-                           {"summary", summary(directions_legs)},
-                           {"legs", legs(directions_legs)},
-                           {"status_message",
-                            string("Found route between points")}, // found route between points OR
-                                                                   // cannot find route between points
-                           {"status", static_cast<uint64_t>(0)},   // 0 success
-                           {"units", valhalla::odin::DirectionsOptions::Units_Name(
-                                         directions_options.units())},
-                           {"language", directions_options.language()}})}});
+  json::Jwriter writer(4096);
+  writer.start_object();
+  writer.start_object("trip");
+  locations(writer, directions_legs);
+  summary(writer, directions_legs);
+  legs(writer, directions_legs);
+  writer("status_message", "Found route between points"); // found route between points OR
+                                                           // cannot find route between points
+  writer("status", static_cast<uint64_t>(0));              // 0 success
+  writer("units", valhalla::odin::DirectionsOptions::Units_Name(directions_options.units()));
+  writer("language", directions_options.language());
+  writer.end_object();
   if (directions_options.has_id()) {
-    json->emplace("id", directions_options.id());
+    writer("id", directions_options.id());
   }
+  writer.end_object();
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return writer.release();
 }
 } // namespace valhalla_serializers
 
@@ -2282,6 +2270,17 @@ std::string serializeDirections(const valhalla_request_t& request,
       return pathToGPX(path_legs);
     case DirectionsOptions_Format_json:
       return valhalla_serializers::serialize(request.options, directions_legs);
+    case DirectionsOptions_Format_pbf: {
+      Response response;
+      if (request.options.has_id()) {
+        response.set_id(request.options.id());
+      }
+      response.set_units(request.options.units());
+      for (const auto& directions_leg : directions_legs) {
+        *response.add_legs() = directions_leg;
+      }
+      return response.SerializeAsString();
+    }
     default:
       throw;
   }
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <cstdint>
+#include <ctime>
 #include <iostream>
 #include <queue>
 #include <random>
@@ -12,6 +14,7 @@
 #include "sif/edgelabel.h"
 
 #include "baldr/double_bucket_queue.h"
+#include "baldr/radix_queue.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -19,12 +22,123 @@ using namespace valhalla::sif;
 
 namespace bpo = boost::program_options;
 
+// Number of buckets the path algorithms size their double bucket queues to
+constexpr uint32_t kBucketCount = 20000;
+
+/**
+ * Add EdgeLabels with the given costs to a label queue and then remove them
+ * all, checking the order matches the sorted costs.
+ * @param  adjlist      Label queue to use.
+ * @param  edgelabels   Edge labels the queue gets its costs from.
+ * @param  costs        Sort costs of the labels.
+ * @param  ordered_cost Costs sorted by the STL priority queue.
+ * @return Returns the number of milliseconds it took.
+ */
+uint32_t AddRemove(LabelQueue& adjlist,
+                   std::vector<EdgeLabel>& edgelabels,
+                   const std::vector<uint32_t>& costs,
+                   const std::vector<uint32_t>& ordered_cost) {
+  std::clock_t start = std::clock();
+  edgelabels.clear();
+  for (uint32_t i = 0; i < costs.size(); i++) {
+    EdgeLabel el;
+    el.SetSortCost(costs[i]);
+    edgelabels.push_back(std::move(el));
+    adjlist.add(i);
+  }
+
+  // Get edge label indexes from the adj list. Accumulate total cost to make
+  // sure compiler doesn't optimize too much.
+  uint32_t count = 0;
+  std::vector<uint32_t> ordered_cost2;
+  while (true) {
+    uint32_t idx = adjlist.pop();
+    if (idx == kInvalidLabel) {
+      break;
+    }
+
+    // Copy the edge label - simulates what is done in PathAlgorithm
+    EdgeLabel el = edgelabels[idx];
+    ordered_cost2.push_back(el.sortcost());
+    count++;
+  }
+  uint32_t ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+
+  // Verify order
+  for (uint32_t i = 0; i < count; i++) {
+    if (ordered_cost[i] != ordered_cost2[i]) {
+      LOG_INFO("Costs: " + std::to_string(ordered_cost[i]) + "," + std::to_string(ordered_cost2[i]));
+    }
+  }
+  return ms;
+}
+
+/**
+ * Simulate the use of a label queue by a path algorithm. Each label popped
+ * is expanded to a few new labels whose costs are the popped cost plus an
+ * edge cost, and some already queued labels get a lower cost. Edge costs
+ * are mostly short with a long tail, like the edges of a road network, so
+ * the costs in the queue drift well past its initial range.
+ * @param  adjlist      Label queue to use.
+ * @param  edgelabels   Edge labels the queue gets its costs from.
+ * @param  n            Number of labels to create.
+ * @return Returns the number of milliseconds it took.
+ */
+uint32_t Expand(LabelQueue& adjlist, std::vector<EdgeLabel>& edgelabels, const uint32_t n) {
+  std::mt19937 gen(n);
+  std::lognormal_distribution<float> edgecost(2.5f, 1.0f);
+  std::uniform_int_distribution<uint32_t> fanout(1, 4);
+  std::uniform_int_distribution<uint32_t> coin(0, 9);
+  std::vector<bool> settled;
+
+  std::clock_t start = std::clock();
+  edgelabels.clear();
+  edgelabels.emplace_back();
+  settled.push_back(false);
+  adjlist.add(0);
+  float sum = 0.0f;
+  while (true) {
+    uint32_t idx = adjlist.pop();
+    if (idx == kInvalidLabel) {
+      break;
+    }
+    settled[idx] = true;
+    float cost = edgelabels[idx].sortcost();
+    sum += cost;
+    if (edgelabels.size() >= n) {
+      continue;
+    }
+
+    for (uint32_t i = 0, count = fanout(gen); i < count; ++i) {
+      float newcost = cost + edgecost(gen);
+      // Every so often reach a label which is already in the queue
+      uint32_t other = edgelabels.size() - 1 - std::min(coin(gen) * 16, idx);
+      if (coin(gen) == 0 && !settled[other] && newcost < edgelabels[other].sortcost()) {
+        adjlist.decrease(other, newcost);
+        edgelabels[other].SetSortCost(newcost);
+      } else {
+        EdgeLabel el;
+        el.SetSortCost(newcost);
+        edgelabels.push_back(std::move(el));
+        settled.push_back(false);
+        adjlist.add(edgelabels.size() - 1);
+      }
+    }
+  }
+  uint32_t ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  if (sum < 0.0f) {
+    LOG_INFO("Negative costs");
+  }
+  return ms;
+}
+
 /**
  * Benchmark of adjacency list. Constructs a large number of random numbers,
  * adds EdgeLabels to the AdjacencyList with those as the sortcost. Then
  * removes them from the list. This compares performance of an STL
  * priority_queue with the custom approximate double bucket sorting used
- * in adjacencylist.cc.
+ * in adjacencylist.cc and with the radix heap. Then compares the double
+ * bucket queue and the radix heap in a simulated path expansion.
  */
 int Benchmark(const uint32_t n, const float maxcost, const float bucketsize) {
   // Create a set of random costs
@@ -66,43 +180,27 @@ int Benchmark(const uint32_t n, const float maxcost, const float bucketsize) {
   std::vector<EdgeLabel> edgelabels;
   // Set up lambda to get sort costs
   const auto edgecost = [&edgelabels](const uint32_t label) { return edgelabels[label].sortcost(); };
-  start = std::clock();
   DoubleBucketQueue adjlist(0, maxcost / 2, bucketsize, edgecost);
-
-  // Construct EdgeLabels and add to adjacency list
-
-  for (uint32_t i = 0; i < n; i++) {
-    EdgeLabel el;
-    el.SetSortCost(costs[i]);
-    edgelabels.push_back(std::move(el));
-    adjlist.add(i);
-  }
-
-  // Get edge label indexes from the adj list. Accumulate total cost to make
-  // sure compiler doesn't optimize too much.
-  count = 0;
-  std::vector<uint32_t> ordered_cost2;
-  while (true) {
-    uint32_t idx = adjlist.pop();
-    if (idx == kInvalidLabel) {
-      break;
-    }
-
-    // Copy the edge label - simulates what is done in PathAlgorithm
-    EdgeLabel el = edgelabels[idx];
-    ordered_cost2.push_back(el.sortcost());
-    count++;
-  }
-  ms = (std::clock() - start) / static_cast<double>(CLOCKS_PER_SEC / 1000);
+  ms = AddRemove(adjlist, edgelabels, costs, ordered_cost1);
   LOG_INFO("Bucketed Adj. List: Added and removed " + std::to_string(count) + " edgelabels in " +
            std::to_string(ms) + " ms");
 
-  // Verify order
-  for (uint32_t i = 0; i < count; i++) {
-    if (ordered_cost1[i] != ordered_cost2[i]) {
-      LOG_INFO("Costs: " + std::to_string(ordered_cost1[i]) + "," + std::to_string(ordered_cost2[i]));
-    }
-  }
+  // Test performance of the radix heap
+  RadixQueue radix(0, maxcost / 2, bucketsize, edgecost);
+  ms = AddRemove(radix, edgelabels, costs, ordered_cost1);
+  LOG_INFO("Radix Heap: Added and removed " + std::to_string(count) + " edgelabels in " +
+           std::to_string(ms) + " ms");
+
+  // Simulated path expansion. The double bucket queue gets the range the
+  // path algorithms give it.
+  adjlist.reuse(0, kBucketCount * bucketsize, bucketsize, edgecost);
+  ms = Expand(adjlist, edgelabels, n);
+  LOG_INFO("Bucketed Adj. List: Expanded " + std::to_string(edgelabels.size()) + " edgelabels in " +
+           std::to_string(ms) + " ms");
+  radix.reuse(0, kBucketCount * bucketsize, bucketsize, edgecost);
+  ms = Expand(radix, edgelabels, n);
+  LOG_INFO("Radix Heap: Expanded " + std::to_string(edgelabels.size()) + " edgelabels in " +
+           std::to_string(ms) + " ms");
   return 0;
 }
 
@@ -114,7 +212,8 @@ int main(int argc, char* argv[]) {
       " Usage: adjlistbenchmark [options]\n"
       "\n"
       "adjlistbenchmark is benchmark comparing performance of an STL priority_queue"
-      "to the approximate double bucket adjacency list class supplied with Valhalla."
+      "to the approximate double bucket adjacency list and radix heap classes supplied with "
+      "Valhalla."
       "\n"
       "\n");
 
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "baldr/graphtile.h"
+#include "config.h"
+#include "midgard/logging.h"
+#include "thor/edgestatus.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// a tile whose header we can fill in without any data behind it
+struct benchmark_tile : public GraphTile {
+  benchmark_tile(const uint32_t edge_count) {
+    header_ = new GraphTileHeader();
+    header_->set_directededgecount(edge_count);
+  }
+  ~benchmark_tile() {
+    delete header_;
+    header_ = nullptr;
+  }
+};
+
+/**
+ * The edge status as it was before it had a flat table, every lookup goes
+ * through a std::unordered_map keyed by tile id
+ */
+class MapEdgeStatus {
+public:
+  void clear() {
+    edgestatus_.clear();
+  }
+
+  void Set(const GraphId& edgeid, const EdgeSet set, const uint32_t index, const GraphTile* tile) {
+    GetPtr(edgeid, tile)[0] = {set, index};
+  }
+
+  EdgeStatusInfo Get(const GraphId& edgeid) const {
+    const auto p = edgestatus_.find(edgeid.tile_value());
+    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+  }
+
+  EdgeStatusInfo* GetPtr(const GraphId& edgeid, const GraphTile* tile) {
+    auto& edges = edgestatus_[edgeid.tile_value()];
+    if (!edges) {
+      edges.reset(new EdgeStatusInfo[tile->header()->directededgecount()]);
+    }
+    return &edges[edgeid.id()];
+  }
+
+private:
+  std::unordered_map<uint32_t, std::unique_ptr<EdgeStatusInfo[]>> edgestatus_;
+};
+
+// an edge the search would relax along with the tile it is in
+struct relaxation_t {
+  GraphId edgeid;
+  const GraphTile* tile;
+};
+
+/**
+ * Make up the edges a search would touch. Like a real expansion, the edges
+ * leaving a node are sequential and most nodes lead to a node in the same
+ * tile. Every so often the search crosses into a neighbouring tile.
+ */
+std::vector<relaxation_t> Relaxations(const std::vector<std::unique_ptr<benchmark_tile>>& tiles,
+                                      const uint32_t tiles_wide,
+                                      const uint32_t edge_count,
+                                      const size_t count) {
+  std::mt19937 gen(count);
+  std::uniform_int_distribution<uint32_t> edge(0, edge_count - 8);
+  std::uniform_int_distribution<uint32_t> fanout(1, 6);
+  std::uniform_int_distribution<uint32_t> cross(0, 99);
+  std::uniform_int_distribution<int32_t> neighbour(-1, 1);
+
+  std::vector<relaxation_t> relaxations;
+  relaxations.reserve(count);
+  int32_t x = tiles_wide / 2, y = tiles_wide / 2;
+  while (relaxations.size() < count) {
+    if (cross(gen) < 2) {
+      x = std::min(std::max(x + neighbour(gen), 0), static_cast<int32_t>(tiles_wide) - 1);
+      y = std::min(std::max(y + neighbour(gen), 0), static_cast<int32_t>(tiles_wide) - 1);
+    }
+    const uint32_t tile_id = y * tiles_wide + x;
+    const uint32_t first = edge(gen);
+    for (uint32_t i = 0, n = fanout(gen); i < n; ++i) {
+      relaxations.push_back({GraphId(tile_id, 2, first + i), tiles[tile_id].get()});
+    }
+  }
+  return relaxations;
+}
+
+/**
+ * Run the edge status through the same relaxations a number of times,
+ * clearing it in between like a path algorithm does between requests
+ * @return the number of milliseconds it took
+ */
+template <typename status_t>
+uint64_t Expand(status_t& edgestatus,
+                const std::vector<relaxation_t>& relaxations,
+                const uint32_t searches) {
+  uint64_t reached = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t s = 0; s < searches; ++s) {
+    uint32_t index = 0;
+    for (const auto& relaxation : relaxations) {
+      // check the edge, label it if its new otherwise look it up again
+      EdgeStatusInfo* es = edgestatus.GetPtr(relaxation.edgeid, relaxation.tile);
+      if (es->set() == EdgeSet::kUnreached) {
+        edgestatus.Set(relaxation.edgeid, EdgeSet::kTemporary, index++, relaxation.tile);
+      } else {
+        reached += edgestatus.Get(relaxation.edgeid).index();
+      }
+    }
+    edgestatus.clear();
+  }
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                  start)
+                .count();
+  // keep the compiler from throwing the loop away
+  if (reached == std::numeric_limits<uint64_t>::max()) {
+    LOG_INFO("Unlikely");
+  }
+  return ms;
+}
+
+/**
+ * Benchmark of the flat edge status against the one with a std::unordered_map
+ */
+int Benchmark(const uint32_t tiles_wide,
+              const uint32_t edge_count,
+              const size_t count,
+              const uint32_t searches) {
+  std::vector<std::unique_ptr<benchmark_tile>> tiles;
+  for (uint32_t i = 0; i < tiles_wide * tiles_wide; ++i) {
+    tiles.emplace_back(new benchmark_tile(edge_count));
+  }
+  auto relaxations = Relaxations(tiles, tiles_wide, edge_count, count);
+  LOG_INFO(std::to_string(searches) + " searches of " + std::to_string(relaxations.size()) +
+           " edge relaxations");
+
+  MapEdgeStatus map_status;
+  auto ms = Expand(map_status, relaxations, searches);
+  LOG_INFO("std::unordered_map edge status: " + std::to_string(ms) + " ms");
+
+  EdgeStatus flat_status;
+  ms = Expand(flat_status, relaxations, searches);
+  LOG_INFO("Flat edge status: " + std::to_string(ms) + " ms");
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t tiles_wide, edge_count, searches;
+  size_t count;
+
+  bpo::options_description options(
+      "valhalla " VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_edgestatus [options]\n"
+      "\n"
+      "valhalla_benchmark_edgestatus is a benchmark comparing the lookups of edge status "
+      "done by the path algorithms."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "tiles,t", bpo::value<uint32_t>(&tiles_wide)->default_value(16),
+      "Number of tiles wide (and high) the searched area is.")(
+      "edges,e", bpo::value<uint32_t>(&edge_count)->default_value(100000),
+      "Number of directed edges in each tile.")(
+      "count,n", bpo::value<size_t>(&count)->default_value(2000000),
+      "Number of edge relaxations per search.")(
+      "searches,s", bpo::value<uint32_t>(&searches)->default_value(10),
+      "Number of searches to run.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_edgestatus " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (tiles_wide < 1 || edge_count < 8 || count < 1 || searches < 1) {
+    std::cerr << "Need at least one tile, eight edges, one relaxation and one search\n";
+    return EXIT_FAILURE;
+  }
+
+  Benchmark(tiles_wide, edge_count, count, searches);
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
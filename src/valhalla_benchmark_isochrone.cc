@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "midgard/constants.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/gridded_data.h"
+#include "midgard/logging.h"
+#include "midgard/pointll.h"
+#include "midgard/util.h"
+#include "thor/isotile_rasterizer.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// average speed of the made up road network
+constexpr float kSpeed = 40.0f * kMPHtoMetersPerSec;
+
+// an edge the expansion settles with the time it was reached at either end
+struct settled_t {
+  std::vector<PointLL> shape;
+  float secs0;
+  float secs1;
+  float length;
+};
+
+/**
+ * Make up the edges a driving isochrone would settle: a grid of roads around
+ * the center with some wiggle in their shape and some noise in how fast they
+ * are driven. Edges come out in the order the expansion would settle them.
+ */
+std::vector<settled_t>
+Expansion(const PointLL& center, const float spacing, const uint32_t max_minutes) {
+  const float max_seconds = max_minutes * 60;
+  const float radius = max_seconds * kSpeed;
+  const int32_t n = std::ceil(radius / spacing);
+  const float dlat = spacing / kMetersPerDegreeLat;
+  const float dlon = spacing / DistanceApproximator::MetersPerLngDegree(center.lat());
+  std::mt19937 gen(max_minutes);
+  std::uniform_real_distribution<float> wiggle(-0.1f, 0.1f), slow(1.0f, 1.5f);
+
+  const auto node = [&](int32_t i, int32_t j) {
+    return PointLL(center.lng() + i * dlon, center.lat() + j * dlat);
+  };
+  std::vector<settled_t> edges;
+  for (int32_t i = -n; i <= n; ++i) {
+    for (int32_t j = -n; j <= n; ++j) {
+      const PointLL a = node(i, j);
+      const float secs0 = a.Distance(center) / kSpeed * slow(gen);
+      if (secs0 > max_seconds) {
+        continue;
+      }
+      for (const auto& d : {std::make_pair(1, 0), std::make_pair(0, 1)}) {
+        const PointLL b = node(i + d.first, j + d.second);
+        settled_t edge{{a}, secs0, 0.0f, 0.0f};
+        for (float f : {0.33f, 0.66f}) {
+          edge.shape.emplace_back(a.lng() + (b.lng() - a.lng()) * f + wiggle(gen) * dlon,
+                                  a.lat() + (b.lat() - a.lat()) * f + wiggle(gen) * dlat);
+        }
+        edge.shape.push_back(b);
+        for (size_t k = 1; k < edge.shape.size(); ++k) {
+          edge.length += edge.shape[k - 1].Distance(edge.shape[k]);
+        }
+        edge.secs1 = secs0 + edge.length / kSpeed * slow(gen);
+        edges.emplace_back(std::move(edge));
+      }
+    }
+  }
+  std::sort(edges.begin(), edges.end(),
+            [](const settled_t& a, const settled_t& b) { return a.secs1 < b.secs1; });
+  return edges;
+}
+
+// the isotile the isochrone would construct for driving, see Isochrone::ConstructIsoTile
+std::shared_ptr<GriddedData<PointLL>>
+IsoTile(const PointLL& center, const uint32_t max_minutes, float& shape_interval) {
+  const float max_distance = max_minutes * 60 * 70.0f * kMPHtoMetersPerSec;
+  const float dlat = max_distance / kMetersPerDegreeLat;
+  const float dlon = max_distance / DistanceApproximator::MetersPerLngDegree(center.lat());
+  const float grid_size =
+      std::min(std::max(std::round(dlat / 300.0f * 1000.0f) * 0.001f, 0.001f), 0.005f);
+  shape_interval = grid_size * kMetersPerDegreeLat * 0.25f;
+  AABB2<PointLL> bounds(center.lng() - dlon, center.lat() - dlat, center.lng() + dlon,
+                        center.lat() + dlat);
+  return std::make_shared<GriddedData<PointLL>>(bounds, grid_size, max_minutes);
+}
+
+// mark the edges the way the isochrone did before it had the rasterizer
+void IntersectEdges(GriddedData<PointLL>& isotile,
+                    const std::vector<settled_t>& edges,
+                    const float shape_interval) {
+  for (const auto& edge : edges) {
+    auto resampled = resample_spherical_polyline(edge.shape, shape_interval);
+    float secs = edge.secs0;
+    isotile.SetIfLessThan(edge.shape.front(), secs * kMinPerSec);
+    auto tiles = isotile.Intersect(std::list<PointLL>{edge.shape.front(), edge.shape.back()});
+    for (auto t : tiles) {
+      isotile.SetIfLessThan(t.first, secs * kMinPerSec);
+    }
+    float delta = (shape_interval * (edge.secs1 - edge.secs0)) / edge.length;
+    for (auto itr1 = resampled.begin(), itr2 = itr1 + 1; itr2 < resampled.end(); itr1++, itr2++) {
+      secs += delta;
+      auto tiles = isotile.Intersect(std::list<PointLL>{*itr1, *itr2});
+      for (auto t : tiles) {
+        isotile.SetIfLessThan(t.first, secs * kMinPerSec);
+      }
+    }
+  }
+}
+
+// mark the edges with a rasterizer using the given number of threads
+void RasterizeEdges(const std::shared_ptr<GriddedData<PointLL>>& isotile,
+                    const std::vector<settled_t>& edges,
+                    const float shape_interval,
+                    const uint32_t concurrency) {
+  IsoTileRasterizer rasterizer;
+  rasterizer.set_concurrency(concurrency);
+  rasterizer.Start(isotile, shape_interval);
+  for (const auto& edge : edges) {
+    rasterizer.AddEdge(edge.shape, true, edge.secs0, edge.secs1, edge.length);
+  }
+  rasterizer.Finish();
+}
+
+template <class function_t> uint64_t Time(const function_t& function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                               start)
+      .count();
+}
+
+/**
+ * Benchmark marking the isotile of a 30, 60 and 120 minute isochrone and
+ * contouring it
+ */
+int Benchmark(const float spacing, const uint32_t concurrency) {
+  const PointLL center(-76.3, 40.04);
+  std::vector<uint32_t> thread_counts{1};
+  if (concurrency > 1) {
+    thread_counts.push_back(concurrency);
+  }
+  for (uint32_t max_minutes : {30u, 60u, 120u}) {
+    const auto edges = Expansion(center, spacing, max_minutes);
+    LOG_INFO(std::to_string(max_minutes) + " minutes: " + std::to_string(edges.size()) +
+             " settled edges");
+
+    float shape_interval;
+    auto intersected = IsoTile(center, max_minutes, shape_interval);
+    auto ms = Time([&]() { IntersectEdges(*intersected, edges, shape_interval); });
+    LOG_INFO("Intersect: " + std::to_string(ms) + " ms");
+
+    for (uint32_t threads : thread_counts) {
+      auto rasterized = IsoTile(center, max_minutes, shape_interval);
+      ms = Time([&]() { RasterizeEdges(rasterized, edges, shape_interval, threads); });
+      LOG_INFO("Rasterizer with " + std::to_string(threads) + " threads: " + std::to_string(ms) +
+               " ms");
+      if (rasterized->data() != intersected->data()) {
+        LOG_ERROR("Rasterized isotile differs from the intersected isotile");
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::vector<float> contours;
+    for (uint32_t minutes = 10; minutes <= max_minutes; minutes += 10) {
+      contours.push_back(minutes);
+    }
+    for (uint32_t threads : thread_counts) {
+      ms = Time([&]() { intersected->GenerateContours(contours, true, 1.f, 200.f, threads); });
+      LOG_INFO("Contours with " + std::to_string(threads) + " threads: " + std::to_string(ms) +
+               " ms");
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  float spacing;
+  uint32_t concurrency;
+
+  bpo::options_description options(
+      "valhalla " VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_isochrone [options]\n"
+      "\n"
+      "valhalla_benchmark_isochrone is a benchmark marking the grid of 30, 60 and 120 minute "
+      "isochrones with the edges of a made up road network and tracing its contours."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "spacing,s", bpo::value<float>(&spacing)->default_value(500.0f),
+      "Distance in meters between the roads of the made up network.")(
+      "concurrency,j",
+      bpo::value<uint32_t>(&concurrency)->default_value(std::thread::hardware_concurrency()),
+      "Number of threads to compare a single thread with.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_isochrone " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (spacing < 10.0f || concurrency < 1) {
+    std::cerr << "Need at least 10 meters between roads and one thread\n";
+    return EXIT_FAILURE;
+  }
+
+  auto result = Benchmark(spacing, concurrency);
+  LOG_INFO("Done Benchmark!");
+
+  return result;
+}
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "midgard/logging.h"
+#include "thor/optimizer.h"
+
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+/**
+ * The optimizer as it was before it solved tours exactly or with local
+ * search. Simulated annealing from a random tour, rotating or reversing part
+ * of the tour at random and keeping worse tours at a probability which
+ * declines with the temperature.
+ */
+class AnnealingOptimizer {
+public:
+  std::vector<uint32_t> Solve(const uint32_t count, const std::vector<float>& costs) {
+    count_ = count;
+    if (count == 2) {
+      return {0, 1};
+    } else if (count_ == 3) {
+      return {0, 1, 2};
+    } else if (count == 4) {
+      std::vector<uint32_t> tour1 = {0, 1, 2, 3};
+      std::vector<uint32_t> tour2 = {0, 2, 1, 3};
+      return (TourCost(costs, tour1) < TourCost(costs, tour2)) ? tour1 : tour2;
+    }
+
+    // Random tour keeping the first and last locations fixed
+    tour_.clear();
+    for (uint32_t i = 1; i < count_ - 1; i++) {
+      tour_.push_back(i);
+    }
+    std::random_shuffle(tour_.begin(), tour_.end());
+    tour_.insert(tour_.begin(), 0);
+    tour_.push_back(count_ - 1);
+
+    best_tour_ = tour_;
+    best_cost_ = TourCost(costs, tour_);
+    float temperature = best_cost_ / count_;
+    attempts_ = 400 * count_;
+    successes_ = 40 * count_;
+    for (uint32_t i = 0; i < 100; i++) {
+      if (Anneal(costs, temperature) == 0) {
+        break;
+      }
+      temperature *= 0.93f;
+    }
+    return best_tour_;
+  }
+
+  void Seed(const uint32_t seed) {
+    random_generator_.seed(seed);
+  }
+
+protected:
+  std::mt19937_64 random_generator_;
+  std::uniform_real_distribution<float> uniform_distribution_{0.0, 1.0};
+  uint32_t count_;
+  uint32_t attempts_;
+  uint32_t successes_;
+  float best_cost_;
+  std::vector<uint32_t> tour_;
+  std::vector<uint32_t> best_tour_;
+
+  uint32_t Anneal(const std::vector<float>& costs, float temperature) {
+    uint32_t success_count = 0;
+    for (uint32_t i = 0; i < attempts_; i++) {
+      // Three unique locations between the first and last one, in order
+      std::vector<uint32_t> loc(3);
+      do {
+        loc[0] = get_random_location();
+        loc[1] = get_random_location();
+        loc[2] = get_random_location();
+      } while (loc[0] == loc[1] || loc[0] == loc[2] || loc[1] == loc[2]);
+      std::sort(loc.begin(), loc.end());
+      bool reverse = r01() < 0.5f;
+
+      float diff = TemperatureDifference(costs, loc[0], loc[1], loc[2], reverse);
+      if (diff < 0.0f || r01() < std::exp(-diff / temperature)) {
+        if (reverse) {
+          std::reverse(tour_.begin() + loc[0], tour_.begin() + loc[2] + 1);
+        } else {
+          std::rotate(tour_.begin() + loc[0], tour_.begin() + loc[1], tour_.begin() + loc[2] + 1);
+        }
+        success_count++;
+
+        float cost = TourCost(costs, tour_);
+        if (cost < best_cost_) {
+          best_cost_ = cost;
+          best_tour_ = tour_;
+        }
+      }
+      if (success_count >= successes_) {
+        break;
+      }
+    }
+    return success_count;
+  }
+
+  float TemperatureDifference(const std::vector<float>& costs,
+                              const uint32_t start,
+                              const uint32_t mid,
+                              const uint32_t end,
+                              const bool reverse) const {
+    float c = 0;
+    if (!reverse) {
+      c -= Cost(costs, tour_[start - 1], tour_[start]);
+      c -= Cost(costs, tour_[end], tour_[end + 1]);
+      c -= Cost(costs, tour_[mid - 1], tour_[mid]);
+      c += Cost(costs, tour_[start - 1], tour_[mid]);
+      c += Cost(costs, tour_[end], tour_[start]);
+      c += Cost(costs, tour_[mid - 1], tour_[end + 1]);
+    } else {
+      for (uint32_t i = start - 1, j = i + 1; i <= end; i++, j++) {
+        c -= Cost(costs, tour_[i], tour_[j]);
+      }
+      c += Cost(costs, tour_[start - 1], tour_[end]);
+      c += Cost(costs, tour_[start], tour_[end + 1]);
+      for (uint32_t i = end, j = i - 1; i > start; i--, j--) {
+        c += Cost(costs, tour_[i], tour_[j]);
+      }
+    }
+    return (c / static_cast<float>(count_));
+  }
+
+  float TourCost(const std::vector<float>& costs, const std::vector<uint32_t>& tour) const {
+    float c = 0;
+    for (uint32_t i = 0; i < count_ - 1; i++) {
+      c += costs[(tour[i] * count_) + tour[i + 1]];
+    }
+    return c;
+  }
+
+  float Cost(const std::vector<float>& costs, const uint32_t loc1, const uint32_t loc2) const {
+    return costs[(loc1 * count_) + loc2];
+  }
+
+  uint32_t get_random_location() {
+    return static_cast<uint32_t>(r01() * (count_ - 2) + 1);
+  }
+
+  float r01() {
+    return uniform_distribution_(random_generator_);
+  }
+};
+
+/**
+ * Make up the time costs a matrix would have between locations spread over
+ * a city. Going between two locations takes longer than the straight line
+ * and not as long in both directions.
+ */
+std::vector<float> Costs(const uint32_t count, std::mt19937& gen) {
+  std::uniform_real_distribution<float> coordinate(0.0f, 20000.0f);
+  std::uniform_real_distribution<float> detour(1.2f, 1.6f);
+  std::vector<float> x(count), y(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    x[i] = coordinate(gen);
+    y[i] = coordinate(gen);
+  }
+  std::vector<float> costs(count * count, 0.0f);
+  for (uint32_t i = 0; i < count; ++i) {
+    for (uint32_t j = 0; j < count; ++j) {
+      if (i != j) {
+        // about 10 meters per second
+        costs[i * count + j] = std::round(std::hypot(x[i] - x[j], y[i] - y[j]) * detour(gen) / 10);
+      }
+    }
+  }
+  return costs;
+}
+
+float TourCost(const uint32_t count,
+               const std::vector<float>& costs,
+               const std::vector<uint32_t>& tour) {
+  float c = 0;
+  for (uint32_t i = 0; i + 1 < count; ++i) {
+    c += costs[tour[i] * count + tour[i + 1]];
+  }
+  return c;
+}
+
+/**
+ * Solve the tour with the optimizer
+ * @return the number of microseconds it took
+ */
+template <typename optimizer_t>
+uint64_t Solve(optimizer_t& optimizer,
+               const uint32_t count,
+               const std::vector<float>& costs,
+               std::vector<uint32_t>& tour) {
+  auto start = std::chrono::steady_clock::now();
+  tour = optimizer.Solve(count, costs);
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                               start)
+      .count();
+}
+
+/**
+ * Benchmark of the optimizer against the annealing it used before, on the
+ * same tours, comparing the time taken and the cost of the tours found
+ */
+int Benchmark(const uint32_t count, const uint32_t tours, const uint32_t seed) {
+  std::mt19937 gen(seed);
+  uint64_t annealing_us = 0, optimizer_us = 0;
+  double annealing_cost = 0, optimizer_cost = 0;
+  uint32_t better = 0, worse = 0;
+  for (uint32_t i = 0; i < tours; ++i) {
+    auto costs = Costs(count, gen);
+    std::vector<uint32_t> annealing_tour, optimizer_tour;
+
+    AnnealingOptimizer annealing;
+    annealing.Seed(seed + i);
+    annealing_us += Solve(annealing, count, costs, annealing_tour);
+
+    Optimizer optimizer;
+    optimizer_us += Solve(optimizer, count, costs, optimizer_tour);
+
+    auto a = TourCost(count, costs, annealing_tour);
+    auto o = TourCost(count, costs, optimizer_tour);
+    annealing_cost += a;
+    optimizer_cost += o;
+    better += o < a;
+    worse += o > a;
+  }
+
+  LOG_INFO(std::to_string(tours) + " tours of " + std::to_string(count) + " locations");
+  LOG_INFO("Simulated annealing: " + std::to_string(annealing_us / 1000.0 / tours) +
+           " ms and cost " + std::to_string(annealing_cost / tours) + " per tour");
+  LOG_INFO("Optimizer: " + std::to_string(optimizer_us / 1000.0 / tours) + " ms and cost " +
+           std::to_string(optimizer_cost / tours) + " per tour");
+  LOG_INFO("Optimizer tour cost less on " + std::to_string(better) + " and more on " +
+           std::to_string(worse) + " tours, " +
+           std::to_string(100.0 * (optimizer_cost - annealing_cost) / annealing_cost) +
+           "% in total");
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t count, tours, seed;
+
+  bpo::options_description options(
+      "valhalla " VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_optimizer [options]\n"
+      "\n"
+      "valhalla_benchmark_optimizer is a benchmark comparing the tours found for "
+      "optimized routes, and the time it takes, against simulated annealing."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "count,n", bpo::value<uint32_t>(&count)->default_value(20),
+      "Number of locations in each tour.")(
+      "tours,t", bpo::value<uint32_t>(&tours)->default_value(100), "Number of tours to solve.")(
+      "seed,s", bpo::value<uint32_t>(&seed)->default_value(1),
+      "Seed for the random locations and annealing.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_optimizer " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (count < 2 || tours < 1) {
+    std::cerr << "Need at least two locations and one tour\n";
+    return EXIT_FAILURE;
+  }
+
+  Benchmark(count, tours, seed);
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
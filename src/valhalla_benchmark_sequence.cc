@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "config.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+
+using namespace valhalla::midgard;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+// roughly the size and shape of the way node references the graph parser sorts
+struct way_node_t {
+  uint64_t osmid;
+  float lng;
+  float lat;
+  uint64_t attributes;
+  uint32_t way_index;
+  uint32_t way_shape_node_index;
+};
+
+/**
+ * Write a file full of randomly ordered elements and time how long it takes to sort it
+ * @param file_name    the file to write to and sort
+ * @param count        how many elements to write
+ * @param threads      how many threads to sort with
+ * @param buffer_size  how many elements fit in the sort buffer, fewer than count means an external
+ *                     sort is done
+ * @return the number of milliseconds it took to sort
+ */
+uint64_t Sort(const std::string& file_name,
+              const size_t count,
+              const size_t threads,
+              const size_t buffer_size) {
+  // always the same data
+  {
+    std::mt19937_64 gen(count);
+    std::uniform_int_distribution<uint64_t> dis(0, count);
+    sequence<way_node_t> way_nodes(file_name, true);
+    for (size_t i = 0; i < count; ++i) {
+      way_nodes.push_back({dis(gen), 0.f, 0.f, i, static_cast<uint32_t>(i), 0});
+    }
+  }
+
+  // time the sort
+  sequence<way_node_t> way_nodes(file_name, false);
+  auto start = std::chrono::steady_clock::now();
+  way_nodes.sort([](const way_node_t& a, const way_node_t& b) { return a.osmid < b.osmid; },
+                 threads, buffer_size);
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                  start)
+                .count();
+
+  // make sure it worked
+  way_node_t last = *way_nodes[0];
+  for (size_t i = 1; i < way_nodes.size(); ++i) {
+    way_node_t current = *way_nodes[i];
+    if (current.osmid < last.osmid) {
+      throw std::runtime_error("Sequence was not sorted");
+    }
+    last = current;
+  }
+  return ms;
+}
+
+/**
+ * Benchmark of sorting a sequence in memory, in memory with threads and externally with threads
+ */
+int Benchmark(const std::string& file_name,
+              const size_t count,
+              const size_t threads,
+              const size_t buffer_size) {
+  LOG_INFO("Sorting " + std::to_string(count) + " elements of " +
+           std::to_string(sizeof(way_node_t)) + " bytes");
+  auto ms = Sort(file_name, count, 1, count);
+  LOG_INFO("In memory with 1 thread: " + std::to_string(ms) + " ms");
+  ms = Sort(file_name, count, threads, count);
+  LOG_INFO("In memory with " + std::to_string(threads) + " threads: " + std::to_string(ms) + " ms");
+  ms = Sort(file_name, count, threads, buffer_size);
+  LOG_INFO("External with " + std::to_string(threads) + " threads and " +
+           std::to_string((count + buffer_size - 1) / buffer_size) +
+           " runs: " + std::to_string(ms) + " ms");
+  std::remove(file_name.c_str());
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  std::string file_name;
+  size_t count, threads, buffer_mb;
+
+  bpo::options_description options(
+      "valhalla " VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_sequence [options]\n"
+      "\n"
+      "valhalla_benchmark_sequence is a benchmark comparing the ways a file backed sequence "
+      "can be sorted."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "file,f", bpo::value<std::string>(&file_name)->default_value("benchmark_sequence.bin"),
+      "File to write the sequence to, it is removed when finished.")(
+      "count,n", bpo::value<size_t>(&count)->default_value(50000000),
+      "Number of elements in the sequence.")(
+      "concurrency,j",
+      bpo::value<size_t>(&threads)->default_value(
+          std::max(static_cast<size_t>(1), static_cast<size_t>(std::thread::hardware_concurrency()))),
+      "Number of threads to sort with.")("buffer,b",
+                                         bpo::value<size_t>(&buffer_mb)->default_value(256),
+                                         "Megabytes of memory to use for the external sort.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_sequence " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  size_t buffer_size = buffer_mb * 1024 * 1024 / sizeof(way_node_t);
+  if (count < 1 || threads < 1 || buffer_size < 1) {
+    std::cerr << "Need at least one element, one thread and one megabyte of buffer\n";
+    return EXIT_FAILURE;
+  }
+
+  Benchmark(file_name, count, threads, buffer_size);
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baldr/graphreader.h"
+#include "config.h"
+#include "midgard/logging.h"
+
+using namespace valhalla::baldr;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+/**
+ * Have a number of threads hammer on the same cache. Each thread looks up
+ * random tiles and puts the ones that are missing, the same way that the
+ * GraphReader does when it is handed a shared cache.
+ * @param caches     one cache per thread (all of which share the same tiles)
+ * @param tile_count number of distinct tiles being requested
+ * @param gets       number of lookups each thread does
+ * @return the number of milliseconds it took for all the threads to finish
+ */
+uint64_t Contend(std::vector<std::unique_ptr<TileCache>>& caches,
+                 const uint32_t tile_count,
+                 const uint32_t gets) {
+  // Tiles are spread out over the local level like they would be for a real route
+  const auto& tiles = TileHierarchy::levels().rbegin()->second.tiles;
+  const uint32_t stride = std::max(tiles.TileCount() / tile_count, static_cast<uint32_t>(1));
+  const GraphTile tile;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < caches.size(); ++i) {
+    threads.emplace_back([&caches, i, tile_count, gets, stride, &tile]() {
+      std::mt19937 gen(i);
+      std::uniform_int_distribution<uint32_t> dis(0, tile_count - 1);
+      auto& cache = *caches[i];
+      for (uint32_t j = 0; j < gets; ++j) {
+        GraphId id(dis(gen) * stride, 2, 0);
+        if (!cache.Get(id)) {
+          cache.Put(id, tile, 1);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                               start)
+      .count();
+}
+
+/**
+ * Benchmark of a shared tile cache under contention. Compares the mutex
+ * synchronized simple tile cache with the concurrent tile cache whose
+ * reads are lock free.
+ */
+int Benchmark(const uint32_t thread_count, const uint32_t tile_count, const uint32_t gets) {
+  // One mutex shared by all threads wrapping one simple cache
+  SimpleTileCache simple_cache(std::numeric_limits<size_t>::max());
+  std::mutex mutex;
+  std::vector<std::unique_ptr<TileCache>> synchronized_caches;
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    synchronized_caches.emplace_back(new SynchronizedTileCache(simple_cache, mutex));
+  }
+  uint64_t ms = Contend(synchronized_caches, tile_count, gets);
+  LOG_INFO("Synchronized cache: " + std::to_string(thread_count) + " threads did " +
+           std::to_string(gets) + " lookups each in " + std::to_string(ms) + " ms");
+
+  // Copies of the concurrent cache share the same tiles
+  ConcurrentTileCache concurrent_cache(std::numeric_limits<size_t>::max());
+  std::vector<std::unique_ptr<TileCache>> concurrent_caches;
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    concurrent_caches.emplace_back(new ConcurrentTileCache(concurrent_cache));
+  }
+  ms = Contend(concurrent_caches, tile_count, gets);
+  LOG_INFO("Concurrent cache: " + std::to_string(thread_count) + " threads did " +
+           std::to_string(gets) + " lookups each in " + std::to_string(ms) + " ms");
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t thread_count, tile_count, gets;
+
+  bpo::options_description options(
+      "valhalla " VERSION "\n"
+      "\n"
+      " Usage: valhalla_benchmark_tile_cache [options]\n"
+      "\n"
+      "valhalla_benchmark_tile_cache is a benchmark comparing the performance of the "
+      "tile caches which can be shared between threads."
+      "\n"
+      "\n");
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "concurrency,j",
+      bpo::value<uint32_t>(&thread_count)
+          ->default_value(std::max(static_cast<uint32_t>(1), std::thread::hardware_concurrency())),
+      "Number of threads sharing the cache.")(
+      "tiles,t", bpo::value<uint32_t>(&tile_count)->default_value(2000),
+      "Number of distinct tiles to look up.")("gets,g",
+                                              bpo::value<uint32_t>(&gets)->default_value(5000000),
+                                              "Number of lookups per thread.");
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), vm);
+    bpo::notify(vm);
+
+  } catch (std::exception& e) {
+    std::cerr << "Unable to parse command line options because: " << e.what() << "\n"
+              << "This is a bug, please report it at " PACKAGE_BUGREPORT << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "valhalla_benchmark_tile_cache " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  const auto max_tiles = TileHierarchy::levels().rbegin()->second.tiles.TileCount();
+  if (thread_count < 1 || tile_count < 1 || tile_count > max_tiles) {
+    std::cerr << "Need at least one thread and between 1 and " << max_tiles << " tiles\n";
+    return EXIT_FAILURE;
+  }
+
+  Benchmark(thread_count, tile_count, gets);
+  LOG_INFO("Done Benchmark!");
+
+  return EXIT_SUCCESS;
+}
@@ -552,6 +552,13 @@ void from_json(rapidjson::Document& doc, odin::DirectionsOptions& options) {
   doc.AddMember({"format", allocator},
                 {odin::DirectionsOptions::Format_Name(options.format()), allocator}, allocator);
 }
+
+// the members of the request which are still read after loki, everything else
+// has already been parsed into the options
+const std::vector<std::string> kDownstreamMembers{
+    "costing",     "costing_options", "trace_options", "shape_match", "filters",       "best_paths",
+    "contours",    "polygons",        "denoise",       "generalize",  "show_locations",
+};
 } // namespace
 
 namespace valhalla {
@@ -570,6 +577,19 @@ void valhalla_request_t::parse(const std::string& request, const std::string& se
   options.ParseFromString(serialized_options);
   // TODO: sanity check the parsed values
 }
+std::string valhalla_request_t::downstream_document() const {
+  rapidjson::Document downstream;
+  downstream.SetObject();
+  auto& allocator = downstream.GetAllocator();
+  for (const auto& name : kDownstreamMembers) {
+    auto member = document.FindMember(name.c_str());
+    if (member != document.MemberEnd()) {
+      downstream.AddMember(rapidjson::Value(member->name, allocator),
+                           rapidjson::Value(member->value, allocator), allocator);
+    }
+  }
+  return rapidjson::to_string(downstream);
+}
 
 #ifdef HAVE_HTTP
 void valhalla_request_t::parse(const http_request_t& request) {
@@ -639,6 +659,7 @@ const headers_t::value_type JS_MIME{"Content-type", "application/javascript;char
 const headers_t::value_type XML_MIME{"Content-type", "text/xml;charset=utf-8"};
 const headers_t::value_type GPX_MIME{"Content-type", "application/gpx+xml;charset=utf-8"};
 const headers_t::value_type ATTACHMENT{"Content-Disposition", "attachment; filename=route.gpx"};
+const headers_t::value_type PBF_MIME{"Content-type", "application/x-protobuf"};
 
 worker_t::result_t jsonify_error(const valhalla_exception_t& exception,
                                  http_request_info_t& request_info,
@@ -750,6 +771,38 @@ worker_t::result_t to_response_xml(const std::string& xml,
   return result;
 }
 
+worker_t::result_t to_response_pbf(const std::string& pbf,
+                                   http_request_info_t& request_info,
+                                   const valhalla_request_t& request) {
+  worker_t::result_t result{false};
+  http_response_t response(200, "OK", pbf, headers_t{CORS, PBF_MIME});
+  response.from_info(request_info);
+  result.messages.emplace_back(response.to_string());
+  return result;
+}
+
+worker_t::result_t to_response(const std::string& body,
+                               http_request_info_t& request_info,
+                               const valhalla_request_t& request) {
+  switch (request.options.format()) {
+    case odin::DirectionsOptions::gpx:
+      return to_response_xml(body, request_info, request);
+    case odin::DirectionsOptions::pbf:
+      return to_response_pbf(body, request_info, request);
+    default:
+      return to_response_json(body, request_info, request);
+  }
+}
+
+worker_t::result_t to_response_json_or_pbf(const std::string& body,
+                                           http_request_info_t& request_info,
+                                           const valhalla_request_t& request) {
+  if (request.options.format() == odin::DirectionsOptions::pbf) {
+    return to_response_pbf(body, request_info, request);
+  }
+  return to_response_json(body, request_info, request);
+}
+
 #endif
 
 service_worker_t::service_worker_t() : interrupt(nullptr) {
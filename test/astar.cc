@@ -6,6 +6,7 @@
 #include "baldr/location.h"
 #include "baldr/tilehierarchy.h"
 #include "loki/search.h"
+#include "loki/worker.h"
 #include "midgard/pointll.h"
 #include "midgard/vector2.h"
 #include "mjolnir/graphbuilder.h"
@@ -20,6 +21,7 @@
 #include "thor/astar.h"
 #include "thor/attributes_controller.h"
 #include "thor/trippathbuilder.h"
+#include "thor/worker.h"
 
 #include <valhalla/proto/directions_options.pb.h>
 #include <valhalla/proto/tripdirections.pb.h>
@@ -30,6 +32,7 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <fstream>
+#include <sstream>
 
 namespace bpt = boost::property_tree;
 
@@ -378,6 +381,87 @@ void TestTrivialPathNoUturns() {
   trivial_path_no_uturns(config_file);
 }
 
+// Routes the legs of a request without the date time the request would set
+// for arrive by, so that those legs can be routed on more than one thread too
+class route_legs_worker_t : public vt::thor_worker_t {
+public:
+  using vt::thor_worker_t::thor_worker_t;
+  std::list<vo::TripPath> legs(valhalla::valhalla_request_t& request, bool arrive_by) {
+    parse_locations(request);
+    return route_legs(request, parse_costing(request), arrive_by);
+  }
+};
+
+bpt::ptree utrecht_conf() {
+  std::stringstream json;
+  json << R"({
+    "mjolnir":{"tile_dir":"test/data/utrecht_tiles", "concurrency": 1},
+    "loki":{
+      "actions":["route"],
+      "logging":{"long_request": 100},
+      "service_defaults":{"minimum_reachability": 50,"radius": 0}
+    },
+    "thor":{"logging":{"long_request": 110}},
+    "meili":{"mode":"auto","grid":{"cache_size":100240,"size":500},"default":{}},
+    "service_limits": {
+      "isochrone": {"max_contours": 4,"max_distance": 25000.0,"max_locations": 1,"max_time": 120},
+      "max_avoid_locations": 50,"max_radius": 200,"max_reachability": 100,
+      "pedestrian": {"max_distance": 250000.0,"max_locations": 50,"max_matrix_distance": 200000.0,
+                     "max_matrix_locations": 50,"max_transit_walking_distance": 10000,
+                     "min_transit_walking_distance": 1},
+      "skadi": {"max_shape": 750000,"min_resample": 10.0},
+      "trace": {"max_distance": 200000.0,"max_gps_accuracy": 100.0,"max_search_radius": 100,
+                "max_shape": 16000,"max_best_paths":4,"max_best_paths_shape":100}
+    }
+  })";
+  bpt::ptree conf;
+  bpt::read_json(json, conf);
+  return conf;
+}
+
+void TestRouteLegsConcurrency() {
+  // The second and third location are on the same edge, so the leg between
+  // them is routed with A* right after a leg routed with bidirectional A*
+  const std::string request_str = R"({"costing":"pedestrian","locations":[
+      {"lat":52.096672,"lon":5.110825},
+      {"lat":52.09595728238367,"lon":5.114587247480813},
+      {"lat":52.096141834552945,"lon":5.114506781210365},
+      {"lat":52.088548,"lon":5.15357,"type":"through"},
+      {"lat":52.09579,"lon":5.13137},
+      {"lat":52.081371,"lon":5.125671}]})";
+
+  // The trip paths of the legs routed on one thread, depart at and arrive by
+  std::vector<std::string> expected[2];
+  for (unsigned int concurrency : {1, 2, 4}) {
+    auto conf = utrecht_conf();
+    conf.put("thor.route_concurrency", concurrency);
+    valhalla::loki::loki_worker_t loki_worker(conf);
+    route_legs_worker_t thor_worker(conf);
+    for (bool arrive_by : {false, true}) {
+      valhalla::valhalla_request_t request;
+      request.parse(request_str, vo::DirectionsOptions::route);
+      loki_worker.route(request);
+      std::vector<std::string> trip_paths;
+      for (const auto& trip_path : thor_worker.legs(request, arrive_by)) {
+        trip_paths.push_back(trip_path.SerializeAsString());
+      }
+      if (trip_paths.size() != 4) {
+        throw std::logic_error("Expected a trip path for each pair of breaks but got " +
+                               std::to_string(trip_paths.size()));
+      }
+      if (concurrency == 1) {
+        expected[arrive_by] = trip_paths;
+      } else if (trip_paths != expected[arrive_by]) {
+        throw std::logic_error(std::string(arrive_by ? "Arrive by" : "Depart at") +
+                               " trip paths differ when routed on " +
+                               std::to_string(concurrency) + " threads");
+      }
+      thor_worker.cleanup();
+      loki_worker.cleanup();
+    }
+  }
+}
+
 void DoConfig() {
   // make a config file
   write_config(config_file);
@@ -399,5 +483,7 @@ int main() {
   suite.test(TEST_CASE(DoConfig));
   suite.test(TEST_CASE(TestTrivialPathNoUturns));
 
+  suite.test(TEST_CASE(TestRouteLegsConcurrency));
+
   return suite.tear_down();
 }
@@ -80,6 +80,44 @@ void TestClear() {
   TryClear(costs);
 }
 
+void TestReuse() {
+  std::vector<float> edgelabels;
+  const auto edgecost = [&edgelabels](const uint32_t label) { return edgelabels[label]; };
+  DoubleBucketQueue adjlist(0, 10000, 50, edgecost);
+
+  // Leave some labels in the queue (including the overflow) and reuse it with
+  // a different range, nothing from the first search should come back out
+  std::vector<uint32_t> costs = {67, 325, 25, 466, 1000, 100005, 758, 167, 258, 16442, 278};
+  for (auto cost : costs) {
+    edgelabels.emplace_back(cost);
+    adjlist.add(edgelabels.size() - 1);
+  }
+  adjlist.pop();
+
+  std::vector<float> otherlabels;
+  const auto othercost = [&otherlabels](const uint32_t label) { return otherlabels[label]; };
+  adjlist.reuse(500, 1000, 5, othercost);
+  for (auto cost : {1600.f, 505.f, 999.f, 3000.f, 501.f}) {
+    otherlabels.emplace_back(cost);
+    adjlist.add(otherlabels.size() - 1);
+  }
+  float previous = 0.f;
+  for (size_t i = 0; i < otherlabels.size(); ++i) {
+    auto label = adjlist.pop();
+    if (label == kInvalidLabel || otherlabels[label] < previous)
+      throw runtime_error("TestReuse: expected order test failed");
+    previous = otherlabels[label];
+  }
+  if (adjlist.pop() != kInvalidLabel)
+    throw runtime_error("TestReuse: labels from before reuse were returned");
+
+  // Reuse still validates its arguments
+  try {
+    adjlist.reuse(0, 0.0f, 1, othercost);
+    throw runtime_error("Invalid cost range not caught");
+  } catch (...) {}
+}
+
 /**
    void TestDecreseCost() {
    std::vector<uint32_t> costs = { 67, 325, 25, 466, 1000, 100005, 758, 167,
@@ -199,6 +237,8 @@ int main() {
 
   suite.test(TEST_CASE(TestClear));
 
+  suite.test(TEST_CASE(TestReuse));
+
   //  suite.test(TEST_CASE(TestDecreaseCost));
 
   suite.test(TEST_CASE(TestSimulation));
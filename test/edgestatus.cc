@@ -66,6 +66,81 @@ void TestStatus() {
   TryGet(edgestatus, GraphId(555, 3, 1), EdgeSet::kUnreached);
 }
 
+void TestReuse() {
+  // Only allow a couple of tiles worth of status to be kept
+  EdgeStatus edgestatus(250);
+
+  GraphTileHeader header;
+  header.set_directededgecount(100);
+  test_tile tt;
+  tt.header_ = &header;
+  const GraphTile* tile = &tt;
+
+  // Set some edges, clear them and make sure they are unreached and can be set again
+  for (int i = 0; i < 3; ++i) {
+    edgestatus.Set(GraphId(555, 2, 10), EdgeSet::kTemporary, 1, tile);
+    edgestatus.Set(GraphId(556, 2, 99), EdgeSet::kTemporary, 2, tile);
+    edgestatus.Update(GraphId(555, 2, 10), EdgeSet::kPermanent);
+    TryGet(edgestatus, GraphId(555, 2, 10), EdgeSet::kPermanent);
+    TryGet(edgestatus, GraphId(556, 2, 99), EdgeSet::kTemporary);
+    TryGet(edgestatus, GraphId(555, 2, 11), EdgeSet::kUnreached);
+    if (edgestatus.GetPtr(GraphId(556, 2, 99), tile)->index() != 2)
+      throw runtime_error("EdgeStatus index was not kept");
+    edgestatus.clear();
+    TryGet(edgestatus, GraphId(555, 2, 10), EdgeSet::kUnreached);
+    TryGet(edgestatus, GraphId(556, 2, 99), EdgeSet::kUnreached);
+    if (edgestatus.GetPtr(GraphId(556, 2, 99), tile)->index() != 0)
+      throw runtime_error("EdgeStatus index was not reset");
+  }
+
+  // A tile which grew gets a bigger array but keeps what was already set
+  edgestatus.Set(GraphId(555, 2, 10), EdgeSet::kTemporary, 3, tile);
+  header.set_directededgecount(200);
+  edgestatus.Set(GraphId(555, 2, 150), EdgeSet::kTemporary, 4, tile);
+  TryGet(edgestatus, GraphId(555, 2, 10), EdgeSet::kTemporary);
+  TryGet(edgestatus, GraphId(555, 2, 150), EdgeSet::kTemporary);
+
+  // Going over the reserved size frees everything but still reads as unreached
+  edgestatus.Set(GraphId(557, 2, 0), EdgeSet::kPermanent, 5, tile);
+  edgestatus.clear();
+  TryGet(edgestatus, GraphId(555, 2, 10), EdgeSet::kUnreached);
+  TryGet(edgestatus, GraphId(555, 2, 150), EdgeSet::kUnreached);
+  TryGet(edgestatus, GraphId(557, 2, 0), EdgeSet::kUnreached);
+}
+
+void TestWriteThroughPointer() {
+  EdgeStatus edgestatus;
+
+  GraphTileHeader header;
+  header.set_directededgecount(100);
+  test_tile tt;
+  tt.header_ = &header;
+  const GraphTile* tile = &tt;
+
+  // Path algorithms label edges through the pointer, including the edges after
+  // the one it was asked for, without setting them
+  for (int i = 0; i < 2; ++i) {
+    EdgeStatusInfo* es = edgestatus.GetPtr(GraphId(555, 2, 10), tile);
+    *es = {EdgeSet::kTemporary, 42};
+    *(es + 5) = {EdgeSet::kPermanent, 43};
+    edgestatus.Set(GraphId(555, 2, 20), EdgeSet::kTemporary, 44, tile);
+    edgestatus.Update(GraphId(555, 2, 10), EdgeSet::kPermanent);
+    TryGet(edgestatus, GraphId(555, 2, 10), EdgeSet::kPermanent);
+    TryGet(edgestatus, GraphId(555, 2, 15), EdgeSet::kPermanent);
+    edgestatus.clear();
+    for (uint32_t id : {10, 15, 20}) {
+      EdgeStatusInfo r = edgestatus.Get(GraphId(555, 2, id));
+      if (r.set() != EdgeSet::kUnreached || r.index() != 0)
+        throw runtime_error("EdgeStatus written through a pointer was not cleared");
+    }
+  }
+
+  // Once cleared only the edges that are set are reset again
+  edgestatus.Set(GraphId(555, 2, 30), EdgeSet::kTemporary, 1, tile);
+  edgestatus.clear();
+  TryGet(edgestatus, GraphId(555, 2, 30), EdgeSet::kUnreached);
+}
+
 } // namespace
 
 int main() {
@@ -74,5 +149,11 @@ int main() {
   // Test setting status, getting status, and clearing
   suite.test(TEST_CASE(TestStatus));
 
+  // Test that clearing resets everything that was set so the arrays can be reused
+  suite.test(TEST_CASE(TestReuse));
+
+  // Test that edges written through a pointer are cleared too
+  suite.test(TEST_CASE(TestWriteThroughPointer));
+
   return suite.tear_down();
 }
@@ -0,0 +1,84 @@
+#include "test.h"
+
+#include <random>
+#include <unordered_map>
+
+#include "baldr/flat_id_map.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+
+namespace {
+
+void TestFindEmplace() {
+  FlatIdMap<uint32_t> map;
+  if (map.find(GraphId(1, 2, 3).value) != nullptr)
+    throw runtime_error("Empty map should not find anything");
+
+  // Add a value and try adding another for the same id
+  auto added = map.emplace(GraphId(1, 2, 3).value, 7);
+  if (!added.second || *added.first != 7)
+    throw runtime_error("Value should have been added");
+  added = map.emplace(GraphId(1, 2, 3).value, 8);
+  if (added.second || *added.first != 7)
+    throw runtime_error("Value should not have been replaced");
+
+  // Ids which differ only by level or tile are different keys
+  if (map.find(GraphId(1, 1, 3).value) != nullptr || map.find(GraphId(2, 2, 3).value) != nullptr)
+    throw runtime_error("Different id should not be found");
+  *map.find(GraphId(1, 2, 3).value) = 9;
+  if (*map.find(GraphId(1, 2, 3).value) != 9 || map.size() != 1)
+    throw runtime_error("Value should have been modified in place");
+}
+
+void TestGrowAndClear() {
+  // Compare against a std::unordered_map through enough inserts to rehash a few times
+  FlatIdMap<uint32_t> map;
+  std::unordered_map<uint64_t, uint32_t> expected;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<uint32_t> tile(0, 4000), id(0, 200);
+  for (int round = 0; round < 2; ++round) {
+    for (uint32_t i = 0; i < 10000; ++i) {
+      const GraphId key(tile(gen), 2, id(gen));
+      const bool added = map.emplace(key.value, i).second;
+      if (added != expected.emplace(key.value, i).second)
+        throw runtime_error("Emplace should agree with std::unordered_map");
+    }
+    if (map.size() != expected.size())
+      throw runtime_error("Size should agree with std::unordered_map");
+    for (const auto& kv : expected) {
+      const auto index = map.find_index(kv.first);
+      if (index == FlatIdMap<uint32_t>::kEmptyIndex || map.at_index(index) != kv.second)
+        throw runtime_error("Value should agree with std::unordered_map");
+    }
+
+    // Clearing keeps the memory but nothing is found anymore
+    map.clear();
+    for (const auto& kv : expected) {
+      if (map.find(kv.first) != nullptr)
+        throw runtime_error("Cleared map should not find anything");
+    }
+    expected.clear();
+  }
+
+  map.release();
+  if (!map.empty() || map.find(GraphId(1, 2, 3).value) != nullptr)
+    throw runtime_error("Released map should be empty");
+  map.emplace(GraphId(1, 2, 3).value, 1);
+  if (*map.find(GraphId(1, 2, 3).value) != 1)
+    throw runtime_error("Released map should be usable again");
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("flat_id_map");
+
+  // Test finding and adding values
+  suite.test(TEST_CASE(TestFindEmplace));
+
+  // Test that growing and clearing the table keeps all the values right
+  suite.test(TEST_CASE(TestGrowAndClear));
+
+  return suite.tear_down();
+}
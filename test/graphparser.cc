@@ -1,5 +1,6 @@
 #include "midgard/sequence.h"
 #include "mjolnir/osmnode.h"
+#include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfgraphparser.h"
 #include "test.h"
 #include <cstdint>
@@ -8,6 +9,10 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <sstream>
 
 #include "baldr/directededge.h"
 #include "baldr/graphconstants.h"
@@ -456,6 +461,103 @@ void BicycleTrafficSignals(const std::string& config_file) {
   boost::filesystem::remove(access_file);
 }
 
+// remembers everything the pbf parser hands to it, in order
+struct recording_callback : public OSMPBF::Callback {
+  virtual void
+  node_callback(const uint64_t osmid, const double lng, const double lat, const OSMPBF::Tags& tags) {
+    std::stringstream ss;
+    ss << std::setprecision(17) << "n" << osmid << " " << lng << " " << lat;
+    record(ss, tags);
+  }
+  virtual void
+  way_callback(const uint64_t osmid, const OSMPBF::Tags& tags, const std::vector<uint64_t>& nodes) {
+    std::stringstream ss;
+    ss << "w" << osmid;
+    for (auto node : nodes)
+      ss << " " << node;
+    record(ss, tags);
+  }
+  virtual void relation_callback(const uint64_t osmid,
+                                 const OSMPBF::Tags& tags,
+                                 const std::vector<OSMPBF::Member>& members) {
+    std::stringstream ss;
+    ss << "r" << osmid;
+    for (const auto& member : members)
+      ss << " " << member.member_type << member.member_id << member.role;
+    record(ss, tags);
+  }
+  virtual void changeset_callback(const uint64_t changeset_id) {
+    parsed.push_back("c" + std::to_string(changeset_id));
+  }
+  // skip untagged nodes and mark everything else so we know this was called
+  virtual bool transform_callback(const size_t thread,
+                                  const OSMPBF::Interest type,
+                                  const uint64_t osmid,
+                                  OSMPBF::Tags& tags) {
+    tags["transformed"] = "true";
+    return type != OSMPBF::Interest::NODES || tags.size() > 1;
+  }
+  void record(std::stringstream& ss, const OSMPBF::Tags& tags) {
+    std::map<std::string, std::string> sorted(tags.begin(), tags.end());
+    for (const auto& tag : sorted)
+      ss << " " << tag.first << "=" << tag.second;
+    parsed.push_back(ss.str());
+  }
+  std::vector<std::string> parsed;
+};
+
+void TestParallelParse() {
+  // parse the same file in serial and in parallel
+  std::ifstream file("test/data/liechtenstein-latest.osm.pbf", std::ios::binary);
+  auto interest = static_cast<OSMPBF::Interest>(OSMPBF::Interest::NODES | OSMPBF::Interest::WAYS |
+                                                 OSMPBF::Interest::RELATIONS |
+                                                 OSMPBF::Interest::CHANGESETS);
+  recording_callback serial, parallel;
+  OSMPBF::Parser::parse(file, interest, serial);
+  OSMPBF::Parser::parse(file, interest, parallel, 4);
+
+  // the callbacks should have been called with the same things in the same order
+  if (serial.parsed.empty() || serial.parsed.front().find("transformed=true") == std::string::npos)
+    throw std::runtime_error("Expected transformed osm objects");
+  if (serial.parsed != parallel.parsed)
+    throw std::runtime_error("Parallel parsing should match serial parsing");
+}
+
+void TestParallelGraphParse() {
+  boost::property_tree::ptree conf;
+  boost::property_tree::json_parser::read_json(config_file, conf);
+  auto read = [](const std::string& file_name) {
+    std::ifstream file(file_name, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  };
+
+  // parse with one thread and then with several
+  std::vector<std::string> files[2];
+  OSMData osmdata[2];
+  for (size_t i = 0; i < 2; ++i) {
+    conf.put("mjolnir.concurrency", i == 0 ? 1 : 4);
+    osmdata[i] = PBFGraphParser::Parse(conf.get_child("mjolnir"), {"test/data/harrisburg.osm.pbf"},
+                                       "test_ways.bin", "test_way_nodes.bin", "test_access.bin",
+                                       "test_complex_restrictions.bin");
+    for (const auto& file_name : {"test_ways.bin", "test_way_nodes.bin", "test_access.bin",
+                                  "test_complex_restrictions.bin"}) {
+      files[i].push_back(read(file_name));
+      boost::filesystem::remove(file_name);
+    }
+  }
+
+  // we should get exactly the same results
+  if (files[0] != files[1])
+    throw std::runtime_error("Parallel parsing should write the same files as serial parsing");
+  if (osmdata[0].osm_way_count != osmdata[1].osm_way_count ||
+      osmdata[0].osm_node_count != osmdata[1].osm_node_count ||
+      osmdata[0].edge_count != osmdata[1].edge_count ||
+      osmdata[0].intersection_count != osmdata[1].intersection_count ||
+      osmdata[0].restrictions.size() != osmdata[1].restrictions.size() ||
+      osmdata[0].name_offset_map.Size() != osmdata[1].name_offset_map.Size())
+    throw std::runtime_error("Parallel parsing should produce the same osm data as serial parsing");
+}
+
 void DoConfig() {
   std::ofstream file;
   try {
@@ -526,6 +628,8 @@ int main() {
   suite.test(TEST_CASE(TestBaltimoreArea));
   suite.test(TEST_CASE(TestBike));
   suite.test(TEST_CASE(TestBus));
+  suite.test(TEST_CASE(TestParallelParse));
+  suite.test(TEST_CASE(TestParallelGraphParse));
 
   return suite.tear_down();
 }
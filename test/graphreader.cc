@@ -6,7 +6,10 @@
 #include "baldr/tilehierarchy.h"
 
 #include <boost/filesystem.hpp>
+#include <chrono>
 #include <fcntl.h>
+#include <fstream>
+#include <thread>
 
 using namespace std;
 using namespace valhalla::baldr;
@@ -59,6 +62,219 @@ void TestCacheLimits() {
     throw std::runtime_error("Cache should be over committed");
 }
 
+void TestLRUCache() {
+  GraphTile tile;
+  const size_t entry = TileCacheLRU::EntrySize(10);
+
+  // hard control evicts the least recently used tile during put
+  TileCacheLRU hard(entry * 2, TileCacheLRU::MemoryLimitControl::HARD);
+  hard.Put({0, 2, 0}, tile, 10);
+  hard.Put({1, 2, 0}, tile, 10);
+  if (!hard.Get({0, 2, 0}) || hard.OverCommitted())
+    throw std::runtime_error("Both tiles should fit in the cache");
+  hard.Put({2, 2, 0}, tile, 10);
+  if (hard.Contains({1, 2, 0}) || !hard.Contains({0, 2, 0}) || !hard.Contains({2, 2, 0}))
+    throw std::runtime_error("The least recently used tile should have been evicted");
+  if (hard.OverCommitted())
+    throw std::runtime_error("Cache should be under committed after eviction");
+
+  // even if a single tile doesn't fit we keep it
+  if (!hard.Put({3, 2, 0}, tile, entry * 3) || !hard.Contains({3, 2, 0}) || hard.Contains({2, 2, 0}))
+    throw std::runtime_error("The most recently put tile should never be evicted");
+  hard.Clear();
+  if (hard.OverCommitted() || hard.Contains({3, 2, 0}))
+    throw std::runtime_error("Cache should be empty after clearing");
+
+  // soft control only evicts when trimmed
+  TileCacheLRU soft(entry * 2, TileCacheLRU::MemoryLimitControl::SOFT);
+  const auto* first = soft.Put({0, 2, 0}, tile, 10);
+  soft.Put({1, 2, 0}, tile, 10);
+  soft.Put({2, 2, 0}, tile, 10);
+  if (!soft.OverCommitted() || soft.Get({0, 2, 0}) != first)
+    throw std::runtime_error("Soft control should not evict during put");
+  soft.Trim();
+  if (soft.OverCommitted() || soft.Contains({1, 2, 0}) || soft.Get({0, 2, 0}) != first)
+    throw std::runtime_error("Trimming should evict the least recently used tile");
+}
+
+void TestConcurrentCache() {
+  ConcurrentTileCache cache(10);
+  GraphId id(10, 2, 0);
+  if (cache.Contains(id) || cache.Get(id))
+    throw std::runtime_error("Cache should be empty");
+
+  GraphTile tile;
+  const auto* cached = cache.Put(id, tile, 6);
+  if (!cached || cache.Get(id) != cached || !cache.Contains(id))
+    throw std::runtime_error("Tile should be in the cache");
+  if (cache.Put(id, tile, 6) != cached || cache.OverCommitted())
+    throw std::runtime_error("Putting the same tile again should return the cached one");
+
+  // copies share the same cache
+  ConcurrentTileCache copy(cache);
+  if (copy.Get(id) != cached)
+    throw std::runtime_error("Copies of the cache should share tiles");
+  copy.Put({11, 2, 0}, tile, 6);
+  if (!cache.OverCommitted())
+    throw std::runtime_error("Cache should be over committed");
+  cache.Clear();
+  if (cache.OverCommitted() || copy.Contains(id))
+    throw std::runtime_error("Cache should be empty after clearing");
+
+  // ids outside of the hierarchy are never cached
+  if (cache.Put({0, TileHierarchy::get_max_level() + 1, 0}, tile, 1))
+    throw std::runtime_error("Tiles outside of the hierarchy should not be cached");
+
+  // racing writers all get the same copy back
+  std::vector<std::thread> threads;
+  std::vector<std::vector<const GraphTile*>> results(4);
+  for (auto& result : results) {
+    threads.emplace_back([&cache, &tile, &result]() {
+      for (uint32_t i = 0; i < 1000; ++i) {
+        result.push_back(cache.Put({i, 2, 0}, tile, 1));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    if (result != results.front())
+      throw std::runtime_error("Every thread should see the same cached tiles");
+  }
+}
+
+class test_prefetcher : public TilePrefetcher {
+public:
+  using TilePrefetcher::TilePrefetcher;
+
+  // wait for the background threads to finish loading a tile
+  bool wait_for(const GraphId& id) {
+    for (int i = 0; i < 1000; ++i) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto entry = tiles_.find(id);
+        if (entry != tiles_.end() && entry->second.state == State::kLoaded)
+          return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+};
+
+void TestPrefetcher() {
+  test_prefetcher prefetcher("test/traffic_matcher_tiles", false, 2, 2);
+  GraphId id(752094, 2, 0);
+  GraphTile tile;
+  if (prefetcher.Take(id, tile))
+    throw std::runtime_error("Tiles that were not requested should not be taken");
+
+  prefetcher.Prefetch(id);
+  if (!prefetcher.wait_for(id))
+    throw std::runtime_error("Tile should have been loaded in the background");
+  if (!prefetcher.Take(id, tile) || !tile.header() || tile.header()->graphid() != id)
+    throw std::runtime_error("Loaded tile should be taken");
+  if (prefetcher.size() != 0 || prefetcher.Take(id, tile))
+    throw std::runtime_error("Tile should only be taken once");
+
+  // missing tiles are loaded without a header
+  GraphId missing(0, 2, 0);
+  prefetcher.Prefetch(missing);
+  if (!prefetcher.wait_for(missing) || !prefetcher.Take(missing, tile) || tile.header())
+    throw std::runtime_error("Missing tile should be loaded without a header");
+
+  // only a few tiles are held, the oldest ones are dropped
+  for (uint32_t i = 1; i < 10; ++i) {
+    prefetcher.Prefetch({i, 2, 0});
+    if (prefetcher.size() > 2)
+      throw std::runtime_error("Prefetcher should not hold more than its maximum");
+  }
+  prefetcher.Clear();
+  if (prefetcher.size() != 0)
+    throw std::runtime_error("Prefetcher should be empty after clearing");
+}
+
+void TestPrefetchCorridor() {
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/traffic_matcher_tiles");
+  GraphReader reader(pt);
+  pt.put("prefetch_threads", 2);
+  pt.put("prefetch_max_tiles", 16);
+  GraphReader prefetching(pt);
+
+  // the corridor between two spots in the tiles, prefetching has to give the same tiles
+  auto box = TileHierarchy::levels().rbegin()->second.tiles.TileBounds(752094);
+  auto center = box.Center();
+  prefetching.PrefetchCorridor({center.lng() - 0.01f, center.lat() - 0.01f, center.lng(),
+                                center.lat()},
+                               {center.lng(), center.lat(), center.lng() + 0.01f,
+                                center.lat() + 0.01f});
+  for (const auto& id : {GraphId(752094, 2, 0), GraphId(46903, 1, 0), GraphId(0, 2, 0)}) {
+    const auto* a = reader.GetGraphTile(id);
+    const auto* b = prefetching.GetGraphTile(id);
+    if (!a != !b)
+      throw std::runtime_error("Prefetching should find the same tiles");
+    if (a && (a->header()->graphid() != b->header()->graphid() ||
+              a->header()->directededgecount() != b->header()->directededgecount() ||
+              a->header()->nodecount() != b->header()->nodecount()))
+      throw std::runtime_error("Prefetched tile should be the same");
+  }
+}
+
+void TestPreload() {
+  boost::property_tree::ptree pt;
+  pt.put("tile_dir", "test/traffic_matcher_tiles");
+  GraphReader reader(pt);
+  if (!reader.GetPreloadTiles(pt).empty())
+    throw std::runtime_error("Nothing should be preloaded without a preload section");
+
+  // a recorded tile list with some noise in it
+  std::string tile_list = "test/gphrdr_preload.txt";
+  {
+    std::ofstream file(tile_list);
+    file << "# hot tiles" << std::endl
+         << "2/752094" << std::endl
+         << "not a tile" << std::endl
+         << "1/46903" << std::endl
+         << "2/752094" << std::endl;
+  }
+  pt.put("preload.tile_list", tile_list);
+  auto tiles = reader.GetPreloadTiles(pt);
+  if (tiles != std::vector<GraphId>{{752094, 2, 0}, {46903, 1, 0}})
+    throw std::runtime_error("Listed tiles should be preloaded in order without duplicates");
+
+  // whole levels and areas add the tiles which exist after the listed ones
+  pt.put("preload.bbox", "-180,-90,180,90");
+  boost::property_tree::ptree levels, level;
+  level.put("", 1);
+  levels.push_back({"", level});
+  pt.put_child("preload.levels", levels);
+  if (reader.GetPreloadTiles(pt) != tiles)
+    throw std::runtime_error("Only tiles which exist should be preloaded");
+  pt.erase("preload");
+  pt.put("preload.bbox", "-180,-90,180,90");
+  if (reader.GetPreloadTiles(pt).size() != 2)
+    throw std::runtime_error("Tiles in the bbox should be preloaded");
+  pt.put("preload.bbox", "-180,-90");
+  try {
+    reader.GetPreloadTiles(pt);
+    throw std::logic_error("Bad bbox should throw");
+  } catch (const std::runtime_error&) {}
+
+  // loading stops before the size is exceeded
+  size_t size = 0, first = 0;
+  if (reader.Preload(tiles, 1, size) != 0 || size != 0)
+    throw std::runtime_error("No tile should be preloaded past the maximum size");
+  reader.Preload({tiles.front()}, 1 << 30, first);
+  reader.Clear();
+  if (reader.Preload(tiles, first, size) != 1 || size != first || reader.OverCommitted())
+    throw std::runtime_error("Preloading should stop before the maximum size");
+  if (reader.Preload(tiles, 1 << 30, size) != 2)
+    throw std::runtime_error("All the tiles should be preloaded");
+  boost::filesystem::remove(tile_list);
+}
+
 void touch_tile(const uint32_t tile_id, const std::string& tile_dir) {
   auto suffix = GraphTile::FileSuffix({tile_id, 2, 0});
   auto fullpath = tile_dir + '/' + suffix;
@@ -136,6 +352,16 @@ int main() {
 
   suite.test(TEST_CASE(TestCacheLimits));
 
+  suite.test(TEST_CASE(TestLRUCache));
+
+  suite.test(TEST_CASE(TestConcurrentCache));
+
+  suite.test(TEST_CASE(TestPrefetcher));
+
+  suite.test(TEST_CASE(TestPrefetchCorridor));
+
+  suite.test(TEST_CASE(TestPreload));
+
   suite.test(TEST_CASE(TestConnectivityMap));
 
   return suite.tear_down();
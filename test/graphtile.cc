@@ -3,6 +3,8 @@
 
 #include "baldr/graphtile.h"
 
+#include <boost/filesystem.hpp>
+#include <fstream>
 #include <vector>
 
 using namespace valhalla::baldr;
@@ -115,6 +117,42 @@ void bin() {
   }
 }
 
+void memory_map() {
+  // write a tile that only has a header
+  std::string tile_dir = "test/graphtile_mmap_test";
+  GraphId id(1197468, 2, 0);
+  GraphTileHeader header;
+  header.set_graphid(id);
+  header.set_end_offset(sizeof(GraphTileHeader));
+  auto file_name = tile_dir + "/" + GraphTile::FileSuffix(id);
+  boost::filesystem::remove_all(tile_dir);
+  boost::filesystem::create_directories(boost::filesystem::path(file_name).parent_path());
+  std::ofstream file(file_name, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.close();
+
+  // mapped and read tiles should be the same
+  GraphTile read(tile_dir, id);
+  GraphTile mapped(tile_dir, id, true);
+  if (!read.header() || !mapped.header())
+    throw std::logic_error("Tile should have been loaded");
+  if (read.id() != id || mapped.id() != id ||
+      mapped.header()->end_offset() != read.header()->end_offset())
+    throw std::logic_error("Mapped tile should match the read tile");
+
+  // copies share the same mapping and keep it alive
+  GraphTile copy(mapped);
+  mapped = GraphTile();
+  if (copy.id() != id)
+    throw std::logic_error("Copy of a mapped tile should still be valid");
+
+  // missing tiles are still missing
+  if (GraphTile(tile_dir, GraphId(0, 2, 0), true).header())
+    throw std::logic_error("Tile should not exist");
+
+  boost::filesystem::remove_all(tile_dir);
+}
+
 } // namespace
 
 int main() {
@@ -126,5 +164,7 @@ int main() {
 
   suite.test(TEST_CASE(bin));
 
+  suite.test(TEST_CASE(memory_map));
+
   return suite.tear_down();
 }
@@ -250,6 +250,31 @@ void TestBinEdges() {
     throw std::logic_error("This edge leaves a tile for 1 other tile and comes back.");
 }
 
+void TestReplaceTile() {
+  // write a tile and open it like a reader would
+  GraphId id(744881, 2, 0);
+  GraphTile t("test/data/bin_tiles/no_bin", id);
+  std::array<std::vector<GraphId>, kBinCount> bins;
+  std::string bin_dir = "test/data/bin_tiles/bin";
+  GraphTileBuilder::AddBins(bin_dir, &t, bins);
+  std::string file = bin_dir + "/2/000/744/881.gph";
+  ifstream reader(file, std::ios::binary);
+  reader.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+  // rewriting the tile replaces it, the reader still reads the old tile whole
+  for (auto& bin : bins)
+    bin.emplace_back(id);
+  GraphTileBuilder::AddBins(bin_dir, &t, bins);
+  std::string bytes((std::istreambuf_iterator<char>(reader)), std::istreambuf_iterator<char>());
+  if (bytes.size() != t.header()->end_offset())
+    throw std::logic_error("Open tile should not change when the tile is rewritten");
+  GraphTile n(bin_dir, id);
+  if (n.header()->end_offset() != t.header()->end_offset() + bins.size() * sizeof(GraphId))
+    throw std::logic_error("Rewritten tile should have the new bins");
+  if (std::ifstream(file + ".tmp").is_open())
+    throw std::logic_error("Temporary tile file should have replaced the tile");
+}
+
 } // namespace
 
 int main() {
@@ -264,5 +289,8 @@ int main() {
   // Test bin edges of some tricky edges
   suite.test(TEST_CASE(TestBinEdges));
 
+  // Test rewriting a tile replaces it instead of writing over it
+  suite.test(TEST_CASE(TestReplaceTile));
+
   return suite.tear_down();
 }
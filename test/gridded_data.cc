@@ -1,7 +1,13 @@
 #include "midgard/gridded_data.h"
 #include "midgard/pointll.h"
 #include "test.h"
+#include <cmath>
 #include <limits>
+#include <list>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 //#include <iostream>
 
 using namespace valhalla::midgard;
@@ -68,6 +74,160 @@ void test_gridded() {
   std::cout << "]}";*/
 }
 
+void test_segment() {
+  // setting along a segment marks the same cells as setting each intersected tile
+  GriddedData<PointLL> a({-76.5, 39.9, -76.1, 40.2}, .002f, 1000);
+  GriddedData<PointLL> b({-76.5, 39.9, -76.1, 40.2}, .002f, 1000);
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> lng(-76.55f, -76.05f), lat(39.85f, 40.25f);
+  std::uniform_real_distribution<float> offset(-.01f, .01f), value(0, 1000);
+  for (int i = 0; i < 5000; ++i) {
+    // mostly short segments like the shape of an edge, some long enough to be resampled
+    PointLL u(lng(gen), lat(gen));
+    PointLL v = i % 10 ? PointLL(u.lng() + offset(gen), u.lat() + offset(gen))
+                       : PointLL(lng(gen), lat(gen));
+    auto secs = value(gen);
+    a.SetIfLessThan(u, v, secs);
+    for (const auto& t : b.Intersect(std::list<PointLL>{u, v}))
+      b.SetIfLessThan(t.first, secs);
+  }
+  if (a.data() != b.data())
+    throw std::logic_error("Setting along the segments should mark the intersected cells");
+
+  // merging keeps the lesser value of each cell
+  GriddedData<PointLL> c({-76.5, 39.9, -76.1, 40.2}, .002f, 500);
+  c.SetIfLessThan(a);
+  for (size_t i = 0; i < c.data().size(); ++i)
+    if (c.data()[i] != std::min(a.data()[i], 500.f))
+      throw std::logic_error("Merged cell should have the lesser value");
+}
+
+void test_contour_threads() {
+  // a noisy cone so there are plenty of lines to stitch together
+  GriddedData<PointLL> g({-5, -5, 5, 5}, .05f, 1000);
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<float> noise(0.f, 20.f);
+  for (int i = 0; i < 200; ++i) {
+    for (int j = 0; j < 200; ++j) {
+      PointLL p(-5 + i * .05f, -5 + j * .05f);
+      g.Set(p, PointLL(0, 0).Distance(p) / 1000.f + noise(gen));
+    }
+  }
+
+  // every contour is traced on its own so the lines must not depend on the threads
+  std::vector<float> iso_markers{100, 200, 300, 400};
+  for (bool rings : {false, true}) {
+    auto contours = g.GenerateContours(iso_markers, rings, 0.f, 0.f);
+    if (contours != g.GenerateContours(iso_markers, rings, 0.f, 0.f, 3))
+      throw std::logic_error("Contours traced on more threads should be the same");
+    if (contours.begin()->second.empty())
+      throw std::logic_error("There should be some contour lines");
+  }
+}
+
+void test_contour_golden() {
+  // a ring shaped valley with a bump on one side, so that the contours have
+  // several rings and one of them a hole
+  GriddedData<PointLL> g({-5, -5, 5, 5}, 1, std::numeric_limits<float>::max());
+  for (int i = 0; i < 10; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      PointLL c(-4.5f + i, -4.5f + j);
+      float r = std::sqrt(c.first * c.first + c.second * c.second);
+      g.Set(c, std::abs(r - 2.f) * 10.f + (i == 6 && j == 3) * 5.f);
+    }
+  }
+
+  // the rings as the contouring made them before the lines were stitched in place
+  const std::vector<std::pair<float, std::vector<std::vector<PointLL>>>> expected{
+      {14.f,
+       {{{1.83436728f, 2.83436728f}, {1.5f, 3.04293847f}, {1.16334057f, 3.16334057f},
+         {0.703240454f, 3.29675961f}, {0.5f, 3.36254501f}, {0.362545043f, 3.36254501f},
+         {-0.362545013f, 3.36254501f}, {-0.5f, 3.36254501f}, {-0.703240514f, 3.29675961f},
+         {-1.16334057f, 3.16334057f}, {-1.5f, 3.04293847f}, {-1.83436728f, 2.83436728f},
+         {-2.28141737f, 2.5f}, {-2.39787722f, 2.39787722f}, {-2.5f, 2.28141737f},
+         {-2.83436704f, 1.83436728f}, {-3.04293847f, 1.5f}, {-3.16334057f, 1.16334057f},
+         {-3.29675961f, 0.703240454f}, {-3.36254501f, 0.5f}, {-3.36254501f, 0.362545043f},
+         {-3.36254501f, -0.362545013f}, {-3.36254501f, -0.5f}, {-3.29675961f, -0.703240514f},
+         {-3.16334057f, -1.16334057f}, {-3.04293847f, -1.5f}, {-2.83436704f, -1.83436728f},
+         {-2.5f, -2.28141737f}, {-2.39787722f, -2.39787722f}, {-2.28141737f, -2.5f},
+         {-1.83436728f, -2.83436704f}, {-1.5f, -3.04293847f}, {-1.16334057f, -3.16334057f},
+         {-0.703240514f, -3.29675961f}, {-0.5f, -3.36254501f}, {-0.362545013f, -3.36254501f},
+         {0.362545043f, -3.36254501f}, {0.5f, -3.36254501f}, {0.703240454f, -3.29675961f},
+         {1.16334057f, -3.16334057f}, {1.5f, -3.04293847f}, {1.83436728f, -2.83436704f},
+         {2.28141737f, -2.5f}, {2.37417531f, -2.37417531f}, {2.5f, -2.28141737f},
+         {2.83436728f, -1.83436728f}, {3.04293847f, -1.5f}, {3.16334057f, -1.16334057f},
+         {3.29675961f, -0.703240514f}, {3.36254501f, -0.5f}, {3.36254501f, -0.362545013f},
+         {3.36254501f, 0.362545043f}, {3.36254501f, 0.5f}, {3.29675961f, 0.703240454f},
+         {3.16334057f, 1.16334057f}, {3.04293847f, 1.5f}, {2.83436728f, 1.83436728f},
+         {2.5f, 2.28141737f}, {2.39787722f, 2.39787722f}, {2.28141737f, 2.5f},
+         {1.83436728f, 2.83436728f}}}},
+      {8.f,
+       {{{0.691919565f, 2.69191957f}, {0.5f, 2.75404072f}, {0.245959312f, 2.75404072f},
+         {-0.245959342f, 2.75404072f}, {-0.5f, 2.75404072f}, {-0.691919565f, 2.69191957f},
+         {-1.18446302f, 2.5f}, {-1.36059844f, 2.36059856f}, {-1.5f, 2.3545928f},
+         {-1.95207262f, 1.95207274f}, {-2.35459304f, 1.5f}, {-2.36059833f, 1.36059833f},
+         {-2.50000024f, 1.18446302f}, {-2.69191957f, 0.691919565f}, {-2.75404072f, 0.5f},
+         {-2.75404072f, 0.245959312f}, {-2.75404072f, -0.245959342f}, {-2.75404072f, -0.5f},
+         {-2.69191957f, -0.691919565f}, {-2.50000024f, -1.18446302f},
+         {-2.36059833f, -1.36059844f}, {-2.35459304f, -1.5f}, {-1.95207262f, -1.95207262f},
+         {-1.5f, -2.35459304f}, {-1.36059844f, -2.36059833f}, {-1.18446302f, -2.50000024f},
+         {-0.691919565f, -2.69191957f}, {-0.5f, -2.75404072f}, {-0.245959342f, -2.75404072f},
+         {0.245959342f, -2.75404072f}, {0.5f, -2.75404072f}, {0.691919565f, -2.69191957f},
+         {1.18446302f, -2.50000024f}, {1.30034196f, -2.30034208f}, {1.5f, -2.10743284f},
+         {1.73783922f, -1.73783922f}, {2.10743284f, -1.5f}, {2.30034208f, -1.30034196f},
+         {2.5f, -1.18446302f}, {2.69191957f, -0.691919565f}, {2.75404072f, -0.5f},
+         {2.75404072f, -0.245959342f}, {2.75404072f, 0.245959342f}, {2.75404072f, 0.5f},
+         {2.69191957f, 0.691919565f}, {2.5f, 1.18446302f}, {2.36059856f, 1.36059833f},
+         {2.3545928f, 1.5f}, {1.95207274f, 1.95207274f}, {1.5f, 2.3545928f},
+         {1.36059833f, 2.36059856f}, {1.18446302f, 2.5f}, {0.691919565f, 2.69191957f}},
+        {{0.837640047f, 0.837640047f}, {0.5f, 1.06393039f}, {0.0639303327f, 1.06393039f},
+         {-0.0639303923f, 1.06393039f}, {-0.5f, 1.06393039f}, {-0.837640166f, 0.837640047f},
+         {-1.06393039f, 0.5f}, {-1.06393051f, 0.0639303327f}, {-1.06393051f, -0.0639303923f},
+         {-1.06393039f, -0.5f}, {-0.837640166f, -0.837640166f}, {-0.5f, -1.06393039f},
+         {-0.0639303923f, -1.06393051f}, {0.0639303327f, -1.06393051f}, {0.5f, -1.06393039f},
+         {0.90741086f, -0.907410979f}, {1.06393039f, -0.5f}, {1.06393039f, -0.0639303923f},
+         {1.06393039f, 0.0639303327f}, {1.06393039f, 0.5f}, {0.837640047f, 0.837640047f}}}},
+      {4.f,
+       {{{-1.5f, -0.563390136f}, {-1.18451142f, -1.18451142f}, {-0.563390136f, -1.5f},
+         {-1.13328862f, -1.86671114f}, {-1.5f, -1.85091352f}, {-1.68563032f, -1.68563032f},
+         {-1.85091352f, -1.5f}, {-1.86671114f, -1.13328862f}, {-1.5f, -0.563390136f}},
+        {{-1.5f, 1.85091329f}, {-1.68563032f, 1.68563032f}, {-1.85091352f, 1.5f},
+         {-1.86671114f, 1.13328862f}, {-1.5f, 0.563390136f}, {-1.1845113f, 1.18451142f},
+         {-0.563390136f, 1.5f}, {-1.13328862f, 1.86671138f}, {-1.5f, 1.85091329f}},
+        {{1.5f, 1.85091329f}, {1.68563032f, 1.68563032f}, {1.85091329f, 1.5f},
+         {1.86671138f, 1.13328862f}, {1.5f, 0.563390136f}, {1.18451142f, 1.18451142f},
+         {0.563390136f, 1.5f}, {1.13328862f, 1.86671138f}, {1.5f, 1.85091329f}}}}
+  };
+
+  auto contours = g.GenerateContours({4, 8, 14}, true, 0.f, 0.f);
+  if (contours.size() != expected.size())
+    throw std::logic_error("There should be 3 contours");
+  auto contour = contours.cbegin();
+  for (const auto& expected_contour : expected) {
+    const auto name = "Contour " + std::to_string(expected_contour.first);
+    if (contour->first != expected_contour.first || contour->second.size() != 1)
+      throw std::logic_error(name + " should be a single feature in descending order");
+    const auto& rings = contour->second.front();
+    if (rings.size() != expected_contour.second.size())
+      throw std::logic_error(name + " has " + std::to_string(rings.size()) + " rings");
+    auto ring = rings.cbegin();
+    for (const auto& expected_ring : expected_contour.second) {
+      if (ring->size() != expected_ring.size())
+        throw std::logic_error(name + " has a ring of " + std::to_string(ring->size()) +
+                               " points instead of " + std::to_string(expected_ring.size()));
+      auto point = ring->cbegin();
+      for (const auto& expected_point : expected_ring) {
+        if (std::abs(point->first - expected_point.first) > 1e-5f ||
+            std::abs(point->second - expected_point.second) > 1e-5f)
+          throw std::logic_error(name + " has a ring which differs from the expected one");
+        ++point;
+      }
+      ++ring;
+    }
+    ++contour;
+  }
+}
+
 } // namespace
 
 int main() {
@@ -75,5 +235,11 @@ int main() {
 
   suite.test(TEST_CASE(test_gridded));
 
+  suite.test(TEST_CASE(test_segment));
+
+  suite.test(TEST_CASE(test_contour_threads));
+
+  suite.test(TEST_CASE(test_contour_golden));
+
   return suite.tear_down();
 }
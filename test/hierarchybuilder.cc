@@ -0,0 +1,130 @@
+#include "test.h"
+
+#include "baldr/tilehierarchy.h"
+#include "mjolnir/graphbuilder.h"
+#include "mjolnir/graphenhancer.h"
+#include "mjolnir/hierarchybuilder.h"
+#include "mjolnir/pbfgraphparser.h"
+#include "mjolnir/shortcutbuilder.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+const std::string base_dir = "test/data/hierarchy_base_tiles";
+const std::string serial_dir = "test/data/hierarchy_serial_tiles";
+const std::string parallel_dir = "test/data/hierarchy_parallel_tiles";
+
+boost::property_tree::ptree make_conf(const std::string& tile_dir, unsigned int concurrency) {
+  std::stringstream json;
+  json << R"({"mjolnir":{"tile_dir":")" << tile_dir << R"(","concurrency":)" << concurrency
+       << R"(,"hierarchy":true,"shortcuts":true}})";
+  boost::property_tree::ptree conf;
+  boost::property_tree::read_json(json, conf);
+  return conf;
+}
+
+std::string read_file(const boost::filesystem::path& path) {
+  std::ifstream file(path.string(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void copy_tiles(const std::string& from, const std::string& to) {
+  boost::filesystem::remove_all(to);
+  boost::filesystem::create_directories(to);
+  for (boost::filesystem::recursive_directory_iterator i(from), end; i != end; ++i) {
+    auto path = to + i->path().string().substr(from.size());
+    if (boost::filesystem::is_directory(i->path())) {
+      boost::filesystem::create_directories(path);
+    } else {
+      boost::filesystem::copy_file(i->path(), path);
+    }
+  }
+}
+
+// Files in a tile directory keyed by their path within it
+std::map<std::string, std::string> read_tiles(const std::string& tile_dir) {
+  std::map<std::string, std::string> tiles;
+  for (boost::filesystem::recursive_directory_iterator i(tile_dir), end; i != end; ++i) {
+    if (boost::filesystem::is_regular_file(i->path())) {
+      tiles.emplace(i->path().string().substr(tile_dir.size()), read_file(i->path()));
+    }
+  }
+  return tiles;
+}
+
+void build_hierarchy(const std::string& tile_dir, unsigned int concurrency) {
+  copy_tiles(base_dir, tile_dir);
+  auto conf = make_conf(tile_dir, concurrency);
+  HierarchyBuilder::Build(conf);
+  ShortcutBuilder::Build(conf);
+  if (boost::filesystem::exists(tile_dir + "/shortcuts")) {
+    throw std::logic_error("Shortcut builder left its staging directory behind");
+  }
+}
+
+void TestSerialMatchesParallel() {
+  // Build the local level once for both
+  auto conf = make_conf(base_dir, 1);
+  boost::filesystem::remove_all(base_dir);
+  boost::filesystem::create_directories(base_dir);
+  std::string ways_file = "test_ways_hierarchy.bin";
+  std::string way_nodes_file = "test_way_nodes_hierarchy.bin";
+  std::string access_file = "test_access_hierarchy.bin";
+  std::string restriction_file = "test_complex_restrictions_hierarchy.bin";
+  auto osmdata = PBFGraphParser::Parse(conf.get_child("mjolnir"), {"test/data/harrisburg.osm.pbf"},
+                                       ways_file, way_nodes_file, access_file, restriction_file);
+  GraphBuilder::Build(conf, osmdata, ways_file, way_nodes_file, restriction_file);
+  GraphEnhancer::Enhance(conf, access_file);
+
+  // Form the other levels and their shortcuts on one thread and on several
+  build_hierarchy(serial_dir, 1);
+  build_hierarchy(parallel_dir, 4);
+  auto serial = read_tiles(serial_dir);
+  auto parallel = read_tiles(parallel_dir);
+  for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
+    if (!boost::filesystem::exists(serial_dir + "/" + std::to_string(level.first))) {
+      throw std::logic_error("No tiles were built on level " + std::to_string(level.first));
+    }
+  }
+  if (serial.size() != parallel.size()) {
+    throw std::logic_error("Expected " + std::to_string(serial.size()) + " tiles but got " +
+                           std::to_string(parallel.size()));
+  }
+  for (const auto& tile : serial) {
+    auto other = parallel.find(tile.first);
+    if (other == parallel.end()) {
+      throw std::logic_error("Tile " + tile.first + " was not built in parallel");
+    }
+    if (other->second != tile.second) {
+      throw std::logic_error("Tile " + tile.first + " differs when built in parallel");
+    }
+  }
+
+  boost::filesystem::remove(ways_file);
+  boost::filesystem::remove(way_nodes_file);
+  boost::filesystem::remove(access_file);
+  boost::filesystem::remove(restriction_file);
+  boost::filesystem::remove_all(base_dir);
+  boost::filesystem::remove_all(serial_dir);
+  boost::filesystem::remove_all(parallel_dir);
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("hierarchybuilder");
+
+  suite.test(TEST_CASE(TestSerialMatchesParallel));
+
+  return suite.tear_down();
+}
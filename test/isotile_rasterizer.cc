@@ -0,0 +1,159 @@
+#include "thor/isotile_rasterizer.h"
+#include "midgard/gridded_data.h"
+#include "midgard/pointll.h"
+#include "midgard/util.h"
+#include "test.h"
+
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace valhalla::midgard;
+using namespace valhalla::thor;
+
+namespace {
+
+const AABB2<PointLL> kBounds{-0.1f, -0.1f, 0.1f, 0.1f};
+
+// An edge as the isochrone expansion would hand it to the rasterizer
+struct edge_t {
+  std::vector<PointLL> shape;
+  bool forward;
+  float secs0;
+  float secs1;
+  float length;
+};
+
+// Random edges across the grid, a few of them shorter than the shape interval
+std::vector<edge_t> make_edges(size_t count) {
+  std::mt19937 gen(17);
+  std::uniform_real_distribution<float> coord(-0.099f, 0.099f);
+  std::uniform_real_distribution<float> step(-0.004f, 0.004f);
+  std::uniform_real_distribution<float> secs(0.f, 1800.f);
+  std::vector<edge_t> edges(count);
+  for (auto& edge : edges) {
+    edge.shape.emplace_back(coord(gen), coord(gen));
+    size_t points = 2 + gen() % 6;
+    while (edge.shape.size() < points) {
+      const auto& last = edge.shape.back();
+      edge.shape.emplace_back(clamp(last.lng() + step(gen), -0.099f, 0.099f),
+                              clamp(last.lat() + step(gen), -0.099f, 0.099f));
+    }
+    edge.forward = gen() % 2 == 0;
+    edge.secs0 = secs(gen);
+    edge.secs1 = edge.secs0 + secs(gen) / 10.f;
+    edge.length = length(edge.shape);
+  }
+  return edges;
+}
+
+void add_edges(IsoTileRasterizer& rasterizer,
+               const std::vector<edge_t>& edges,
+               size_t begin,
+               size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    const auto& edge = edges[i];
+    if (edge.length < 50.f || i % 7 == 0) {
+      rasterizer.AddEdge(edge.shape.front(), edge.shape.back(), edge.secs0, edge.secs1);
+    } else {
+      rasterizer.AddEdge(edge.shape, edge.forward, edge.secs0, edge.secs1, edge.length);
+    }
+  }
+}
+
+std::shared_ptr<GriddedData<PointLL>> make_isotile() {
+  return std::make_shared<GriddedData<PointLL>>(kBounds, 0.001f, std::numeric_limits<float>::max());
+}
+
+// Rasterize all the edges on the given number of threads
+std::vector<float> rasterize(IsoTileRasterizer& rasterizer,
+                             const std::vector<edge_t>& edges,
+                             uint32_t concurrency) {
+  rasterizer.set_concurrency(concurrency);
+  rasterizer.Start(make_isotile(), 50.f);
+  add_edges(rasterizer, edges, 0, edges.size());
+  return rasterizer.Finish()->data();
+}
+
+void compare(const std::vector<float>& expected,
+             const std::vector<float>& grid,
+             const std::string& what) {
+  if (expected.size() != grid.size())
+    throw std::logic_error(what + ": the grid has the wrong number of cells");
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (expected[i] != grid[i])
+      throw std::logic_error(what + ": cell " + std::to_string(i) + " is " +
+                             std::to_string(grid[i]) + " instead of " +
+                             std::to_string(expected[i]));
+  }
+}
+
+void test_concurrency() {
+  // enough edges for several batches so that the threads are used
+  auto edges = make_edges(5000);
+  IsoTileRasterizer rasterizer;
+  auto expected = rasterize(rasterizer, edges, 1);
+  size_t marked = 0;
+  for (auto cell : expected) {
+    marked += cell != std::numeric_limits<float>::max();
+  }
+  if (marked < expected.size() / 4)
+    throw std::logic_error("The edges should mark a good part of the grid");
+
+  // the lowest time of a cell does not depend on which thread marked it
+  for (uint32_t concurrency : {2, 3, 4}) {
+    compare(expected, rasterize(rasterizer, edges, concurrency),
+            std::to_string(concurrency) + " threads");
+  }
+
+  // fewer edges than a batch are marked without the threads
+  auto few = make_edges(100);
+  auto few_expected = rasterize(rasterizer, few, 1);
+  compare(few_expected, rasterize(rasterizer, few, 4), "Fewer edges than a batch");
+}
+
+void test_stop() {
+  auto edges = make_edges(5000);
+  IsoTileRasterizer rasterizer;
+  auto expected = rasterize(rasterizer, edges, 1);
+
+  // stop part way through, with batches handed to the threads, and reuse the rasterizer
+  for (uint32_t concurrency : {1, 3}) {
+    rasterizer.set_concurrency(concurrency);
+    rasterizer.Start(make_isotile(), 50.f);
+    add_edges(rasterizer, edges, 0, 3000);
+    rasterizer.Stop();
+    compare(expected, rasterize(rasterizer, edges, concurrency),
+            "After stopping on " + std::to_string(concurrency) + " threads");
+
+    // starting a new isotile stops what was left of the last one too
+    rasterizer.Start(make_isotile(), 50.f);
+    add_edges(rasterizer, edges, 0, 2500);
+    rasterizer.Start(make_isotile(), 50.f);
+    add_edges(rasterizer, edges, 0, edges.size());
+    compare(expected, rasterizer.Finish()->data(),
+            "After starting again on " + std::to_string(concurrency) + " threads");
+  }
+
+  // the destructor stops threads which are still marking
+  {
+    IsoTileRasterizer unfinished;
+    unfinished.set_concurrency(4);
+    unfinished.Start(make_isotile(), 50.f);
+    add_edges(unfinished, edges, 0, edges.size());
+  }
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("isotile_rasterizer");
+
+  suite.test(TEST_CASE(test_concurrency));
+
+  suite.test(TEST_CASE(test_stop));
+
+  return suite.tear_down();
+}
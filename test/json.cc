@@ -88,6 +88,55 @@ void TestJsonSerialize() {
       throw std::runtime_error("Wrong json!");
 }
 
+void TestJsonWriter() {
+  using namespace std;
+  using namespace valhalla::baldr;
+
+  // members come out in the order they were written, formatted like the dom
+  json::Jwriter writer;
+  writer.start_object();
+  writer("type", "Feature");
+  writer("escaped_string", string("\"\t\r\n\\/\a"));
+  writer("count", uint64_t(18446744073709551615ull));
+  writer("offset", int64_t(-9223372036854775807ll - 1));
+  writer("found", true);
+  writer("missing", nullptr);
+  writer("infinite", json::fp_t{INFINITY, 3});
+  writer.start_array("coordinates");
+  writer(json::fp_t{-73.990433, 6});
+  writer(json::fp_t{40.744377, 3});
+  writer.start_object();
+  writer.end_object();
+  writer.start_array();
+  writer.end_array();
+  writer.end_array();
+  writer("dom", json::array({string("a"), json::map({{"b", uint64_t(0)}})}));
+  writer.end_object();
+
+  string answer = "{\"type\":\"Feature\",\"escaped_string\":\"\\\"\\t\\r\\n\\\\\\/\\u0007\","
+                  "\"count\":18446744073709551615,\"offset\":-9223372036854775808,\"found\":true,"
+                  "\"missing\":null,\"infinite\":\"inf\",\"coordinates\":[-73.990433,40.744,{},[]],"
+                  "\"dom\":[\"a\",{\"b\":0}]}";
+  if (writer.get_buffer() != answer)
+    throw std::runtime_error("Wrong json: " + writer.get_buffer());
+
+  // the same values through the dom
+  stringstream dom;
+  dom << *json::array({string("\"\t\r\n\\/\a"), json::fp_t{-73.990433, 6}, json::fp_t{INFINITY, 3},
+                       int64_t(-9223372036854775807ll - 1)});
+  writer.clear();
+  writer.start_array();
+  writer(string("\"\t\r\n\\/\a"));
+  writer(json::fp_t{-73.990433, 6});
+  writer(json::fp_t{INFINITY, 3});
+  writer(int64_t(-9223372036854775807ll - 1));
+  writer.end_array();
+  if (writer.release() != dom.str())
+    throw std::runtime_error("Writer and dom json differ");
+  if (!writer.get_buffer().empty())
+    throw std::runtime_error("Released writer should be empty");
+}
+
 } // namespace
 
 int main() {
@@ -95,5 +144,7 @@ int main() {
 
   suite.test(TEST_CASE(TestJsonSerialize));
 
+  suite.test(TEST_CASE(TestJsonWriter));
+
   return suite.tear_down();
 }
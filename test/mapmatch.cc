@@ -514,6 +514,55 @@ void test_topk_frontage_alternate() {
         "The raw score of the first result is always less than that of the second");
 }
 
+void test_transition_cache() {
+  // the same matcher with its paths cached between requests
+  auto cached_conf = conf;
+  cached_conf.put("meili.transition_cache_size", 100000);
+  tyr::actor_t actor(conf, true);
+  tyr::actor_t cached_actor(cached_conf, true);
+
+  // some short traces with forks and loops and the shapes of some longer routes
+  std::vector<std::string> traces{
+      R"("shape":[{"lat":52.09110,"lon":5.09806,"accuracy":10},
+         {"lat":52.09050,"lon":5.09769,"accuracy":100},
+         {"lat":52.09098,"lon":5.09679,"accuracy":10}])",
+      R"("shape":[{"lat":52.08511,"lon":5.15085,"accuracy":10},
+         {"lat":52.08533,"lon":5.15109,"accuracy":20},
+         {"lat":52.08539,"lon":5.15100,"accuracy":20}])",
+      R"("shape":[{"lat":52.0886,"lon":5.1535,"accuracy":10},
+         {"lat":52.088619,"lon":5.15315,"accuracy":20},
+         {"lat":52.08855,"lon":5.152652,"accuracy":25},
+         {"lat":52.0883,"lon":5.152183,"accuracy":20},
+         {"lat":52.088062,"lon":5.151963,"accuracy":20}])"};
+  while (traces.size() < 8) {
+    PointLL start, end;
+    boost::property_tree::ptree route;
+    try {
+      route = json_to_pt(actor.route(make_test_case(start, end)));
+    } catch (...) { continue; }
+    auto shape = route.get_child("trip.legs").front().second.get<std::string>("shape");
+    traces.push_back(R"("encoded_polyline":")" + json_escape(shape) + "\"");
+  }
+
+  // matching with cached paths, the first time and when they are reused, gives the same
+  // result as searching for them every time. paths cached with one turn penalty factor are
+  // not used with another
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto& trace : traces) {
+      for (const auto* turn_penalty_factor : {"200", "0", "500"}) {
+        std::string request = R"({"costing":"auto","shape_match":"map_snap",)"
+                              R"("trace_options":{"turn_penalty_factor":)" +
+                              std::string(turn_penalty_factor) + "}," + trace + "}";
+        auto expected = actor.trace_attributes(request);
+        auto matched = cached_actor.trace_attributes(request);
+        if (matched != expected)
+          throw std::logic_error("Matching with cached paths should give the same result for " +
+                                 request);
+      }
+    }
+  }
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -540,5 +589,7 @@ int main(int argc, char* argv[]) {
 
   suite.test(TEST_CASE(test_topk_frontage_alternate));
 
+  suite.test(TEST_CASE(test_transition_cache));
+
   return suite.tear_down();
 }
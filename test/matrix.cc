@@ -370,11 +370,72 @@ void test_matrix_osrm() {
   }
 }
 
+void test_matrix_threads() {
+  loki_worker_t loki_worker(config);
+
+  valhalla::valhalla_request_t request;
+  request.parse(test_request, valhalla::odin::DirectionsOptions::sources_to_targets);
+  loki_worker.matrix(request);
+  adjust_scores(request);
+
+  auto request_pt = json_to_pt(test_request);
+
+  GraphReader reader(config.get_child("mjolnir"));
+  std::vector<std::shared_ptr<GraphReader>> thread_readers;
+  for (int i = 0; i < 2; ++i) {
+    thread_readers.emplace_back(new GraphReader(config.get_child("mjolnir")));
+  }
+
+  cost_ptr_t costing = CreateSimpleCost(request_pt);
+
+  // Searching on more threads must give exactly the same results
+  const auto expect_same = [](const std::vector<TimeDistance>& serial,
+                              const std::vector<TimeDistance>& parallel, const std::string& name) {
+    if (serial.size() != parallel.size()) {
+      throw std::runtime_error(name + " on more threads has the wrong number of results");
+    }
+    for (uint32_t i = 0; i < serial.size(); ++i) {
+      if (serial[i].dist != parallel[i].dist || serial[i].time != parallel[i].time) {
+        throw std::runtime_error("result " + std::to_string(i) + " of " + name +
+                                 " on more threads differs. Expected: " +
+                                 std::to_string(serial[i].time) + "," +
+                                 std::to_string(serial[i].dist) +
+                                 " Actual: " + std::to_string(parallel[i].time) + "," +
+                                 std::to_string(parallel[i].dist));
+      }
+    }
+  };
+
+  CostMatrix cost_matrix;
+  auto serial = cost_matrix.SourceToTarget(request.options.sources(), request.options.targets(),
+                                           reader, &costing, TravelMode::kDrive, 400000.0);
+  cost_matrix.set_thread_readers(thread_readers);
+  for (int i = 0; i < 3; ++i) {
+    auto parallel = cost_matrix.SourceToTarget(request.options.sources(), request.options.targets(),
+                                               reader, &costing, TravelMode::kDrive, 400000.0);
+    expect_same(serial, parallel, "CostMatrix");
+  }
+
+  TimeDistanceMatrix timedist_matrix;
+  serial = timedist_matrix.SourceToTarget(request.options.sources(), request.options.targets(),
+                                          reader, &costing, TravelMode::kDrive, 400000.0);
+  timedist_matrix.set_thread_readers(thread_readers);
+  for (int i = 0; i < 3; ++i) {
+    auto parallel =
+        timedist_matrix.SourceToTarget(request.options.sources(), request.options.targets(), reader,
+                                       &costing, TravelMode::kDrive, 400000.0);
+    expect_same(serial, parallel, "TimeDistanceMatrix");
+  }
+}
+
 int main(int argc, char* argv[]) {
   test::suite suite("matrix");
   logging::Configure({{"type", ""}}); // silence logs
 
   suite.test(TEST_CASE(test_matrix));
+
+  // Test that searching on more threads gives the same results
+  suite.test(TEST_CASE(test_matrix_threads));
   // suite.test(TEST_CASE(test_matrix_osrm));
 
   return suite.tear_down();
@@ -0,0 +1,78 @@
+#include "mjolnir/admin.h"
+#include "test.h"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+using namespace valhalla::midgard;
+using namespace valhalla::mjolnir;
+
+namespace {
+
+multi_polygon_type Poly(const std::string& wkt) {
+  multi_polygon_type multi_poly;
+  boost::geometry::read_wkt(wkt, multi_poly);
+  return multi_poly;
+}
+
+// Side by side squares, one made of two polygons and one with a hole, and a
+// square overlapping two of the others
+std::unordered_map<uint32_t, multi_polygon_type> Polys() {
+  std::unordered_map<uint32_t, multi_polygon_type> polys;
+  polys.emplace(1, Poly("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)),((0 1,0 2,1 2,1 1,0 1)))"));
+  polys.emplace(2, Poly("MULTIPOLYGON(((1 0,1 2,2 2,2 0,1 0),(1.25 0.25,1.75 0.25,1.75 0.75,"
+                        "1.25 0.75,1.25 0.25)))"));
+  polys.emplace(3, Poly("MULTIPOLYGON(((1.5 1.5,1.5 3,3 3,3 1.5,1.5 1.5)))"));
+  polys.emplace(4, Poly("MULTIPOLYGON(((2 0,2 1,3 1,3 0,2 0)))"));
+  return polys;
+}
+
+void TestFind() {
+  auto polys = Polys();
+  MultiPolygonIndex index(Polys());
+  if (index.size() != polys.size())
+    throw std::runtime_error("Index should have all the polys");
+
+  // Points inside, in a hole, on shared edges and corners and outside all of
+  // them find the same poly as checking each poly in turn
+  std::vector<PointLL> points{{0.5f, 0.5f}, {0.5f, 1.5f}, {1.5f, 0.5f}, {1.5f, 1.25f},
+                              {2.5f, 2.5f}, {2.5f, 0.5f}, {1.f, 0.5f},  {1.f, 1.f},
+                              {2.f, 1.f},   {1.75f, 1.75f}, {4.f, 4.f}, {-1.f, 0.5f}};
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> distribution(-0.5f, 3.5f);
+  for (int i = 0; i < 1000; ++i) {
+    points.emplace_back(distribution(generator), distribution(generator));
+  }
+  for (const auto& point : points) {
+    if (GetMultiPolyId(index, point) != GetMultiPolyId(polys, point))
+      throw std::runtime_error("Wrong poly found for " + std::to_string(point.lng()) + "," +
+                               std::to_string(point.lat()));
+  }
+
+  if (index.Find({1.5f, 0.5f}) != 0 || index.Find({4.f, 4.f}) != 0)
+    throw std::runtime_error("Points outside all the polys should not find one");
+  if (index.Find({0.5f, 1.5f}) != 1 || index.Find({2.5f, 0.5f}) != 4)
+    throw std::runtime_error("Points inside a poly should find it");
+}
+
+void TestEmpty() {
+  MultiPolygonIndex index;
+  if (index.size() != 0 || index.begin() != index.end() || index.Find({0.5f, 0.5f}) != 0)
+    throw std::runtime_error("Empty index should not find a poly");
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("multipolygon_index");
+
+  // Test the index finds the same polys as checking each one
+  suite.test(TEST_CASE(TestFind));
+
+  // Test an index without polys
+  suite.test(TEST_CASE(TestEmpty));
+
+  return suite.tear_down();
+}
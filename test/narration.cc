@@ -0,0 +1,135 @@
+#include "test.h"
+
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "exception.h"
+#include "loki/worker.h"
+#include "odin/worker.h"
+#include "thor/worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+boost::property_tree::ptree make_conf() {
+  std::stringstream json;
+  json << R"({
+    "mjolnir":{"tile_dir":"test/data/utrecht_tiles", "concurrency": 1},
+    "loki":{
+      "actions":["route"],
+      "logging":{"long_request": 100},
+      "service_defaults":{"minimum_reachability": 50,"radius": 0}
+    },
+    "thor":{"logging":{"long_request": 110}},
+    "meili":{"mode":"auto","grid":{"cache_size":100240,"size":500},"default":{}},
+    "service_limits": {
+      "auto": {"max_distance": 5000000.0, "max_locations": 20,"max_matrix_distance": 400000.0,
+               "max_matrix_locations": 50},
+      "isochrone": {"max_contours": 4,"max_distance": 25000.0,"max_locations": 1,"max_time": 120},
+      "max_avoid_locations": 50,"max_radius": 200,"max_reachability": 100,
+      "pedestrian": {"max_distance": 250000.0,"max_locations": 50,"max_matrix_distance": 200000.0,
+                     "max_matrix_locations": 50,"max_transit_walking_distance": 10000,
+                     "min_transit_walking_distance": 1},
+      "skadi": {"max_shape": 750000,"min_resample": 10.0},
+      "trace": {"max_distance": 200000.0,"max_gps_accuracy": 100.0,"max_search_radius": 100,
+                "max_shape": 16000,"max_best_paths":4,"max_best_paths_shape":100}
+    }
+  })";
+  boost::property_tree::ptree conf;
+  boost::property_tree::read_json(json, conf);
+  return conf;
+}
+
+// A route with a leg between each pair of locations
+const std::string request_str = R"({"costing":"auto","locations":[
+    {"lat":52.096672,"lon":5.110825},
+    {"lat":52.09110,"lon":5.09806},
+    {"lat":52.081371,"lon":5.125671},
+    {"lat":52.09579,"lon":5.13137},
+    {"lat":52.088548,"lon":5.15357}]})";
+
+std::list<odin::TripPath> route(valhalla_request_t& request) {
+  auto conf = make_conf();
+  loki::loki_worker_t loki_worker(conf);
+  thor::thor_worker_t thor_worker(conf);
+  request.parse(request_str, odin::DirectionsOptions::route);
+  loki_worker.route(request);
+  auto legs = thor_worker.route(request);
+  if (legs.size() != 4) {
+    throw std::logic_error("Expected a leg between each pair of locations but got " +
+                           std::to_string(legs.size()));
+  }
+  return legs;
+}
+
+std::list<odin::TripDirections>
+narrate(const valhalla_request_t& request, std::list<odin::TripPath> legs, size_t concurrency) {
+  auto conf = make_conf();
+  conf.put("odin.narration_concurrency", concurrency);
+  return odin::odin_worker_t(conf).narrate(request, legs);
+}
+
+void TestLegOrder() {
+  valhalla_request_t request;
+  auto legs = route(request);
+
+  // The directions of each leg as narrated on one thread
+  std::vector<std::string> expected;
+  auto leg = legs.cbegin();
+  for (const auto& directions : narrate(request, legs, 1)) {
+    if (directions.location(0).SerializeAsString() != leg->location(0).SerializeAsString() ||
+        directions.maneuver_size() == 0) {
+      throw std::logic_error("Directions should be narrated for each leg in order");
+    }
+    expected.push_back(directions.SerializeAsString());
+    ++leg;
+  }
+
+  for (size_t concurrency : {2, 3, 4, 8}) {
+    std::vector<std::string> narrated;
+    for (const auto& directions : narrate(request, legs, concurrency)) {
+      narrated.push_back(directions.SerializeAsString());
+    }
+    if (narrated != expected) {
+      throw std::logic_error("Directions differ when narrated on " + std::to_string(concurrency) +
+                             " threads");
+    }
+  }
+}
+
+void TestLegError() {
+  valhalla_request_t request;
+  auto legs = route(request);
+
+  // A leg without nodes can't be narrated, whichever thread gets it
+  legs.emplace(std::next(legs.begin(), 2));
+  for (size_t concurrency : {1, 2, 4, 8}) {
+    try {
+      narrate(request, legs, concurrency);
+      throw std::logic_error("Narrating a leg without nodes should throw on " +
+                             std::to_string(concurrency) + " threads");
+    } catch (const valhalla_exception_t& e) {
+      if (e.code != 202) {
+        throw std::logic_error("Expected code 202 but got " + std::to_string(e.code));
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("narration");
+
+  suite.test(TEST_CASE(TestLegOrder));
+  suite.test(TEST_CASE(TestLegError));
+
+  return suite.tear_down();
+}
@@ -2,8 +2,11 @@
 #include "config.h"
 #include "test.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <vector>
 
 using namespace std;
@@ -15,7 +18,6 @@ void TryOptimizer(const uint32_t nlocs,
                   const std::vector<float>& costs,
                   const std::vector<uint32_t>& expected_order) {
   Optimizer optimizer;
-  optimizer.Seed(111111);
   auto order = optimizer.Solve(nlocs, costs);
   if (order != expected_order) {
     throw runtime_error("TryOptimizer: expected order failed");
@@ -38,6 +40,102 @@ void TestOptimizer() {
   TryOptimizer(11, costs, expected_order);
 }
 
+float TourCost(const uint32_t nlocs,
+               const std::vector<float>& costs,
+               const std::vector<uint32_t>& order) {
+  float cost = 0.0f;
+  for (uint32_t i = 0; i + 1 < nlocs; ++i) {
+    cost += costs[order[i] * nlocs + order[i + 1]];
+  }
+  return cost;
+}
+
+// Costs between random points which are not the same in both directions
+std::vector<float> RandomCosts(const uint32_t nlocs, std::mt19937& generator) {
+  std::uniform_real_distribution<float> coordinate(0.0f, 10000.0f);
+  std::uniform_real_distribution<float> detour(1.0f, 1.5f);
+  std::vector<float> x(nlocs), y(nlocs);
+  for (uint32_t i = 0; i < nlocs; ++i) {
+    x[i] = coordinate(generator);
+    y[i] = coordinate(generator);
+  }
+  std::vector<float> costs(nlocs * nlocs, 0.0f);
+  for (uint32_t i = 0; i < nlocs; ++i) {
+    for (uint32_t j = 0; j < nlocs; ++j) {
+      if (i != j) {
+        costs[i * nlocs + j] = std::round(std::hypot(x[i] - x[j], y[i] - y[j]) * detour(generator));
+      }
+    }
+  }
+  return costs;
+}
+
+bool IsTour(const uint32_t nlocs, const std::vector<uint32_t>& order) {
+  std::vector<uint32_t> sorted(order);
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<uint32_t> all(nlocs);
+  std::iota(all.begin(), all.end(), 0);
+  return sorted == all && order.front() == 0 && order.back() == nlocs - 1;
+}
+
+void TestExact() {
+  // Compare against trying every order of the locations in between
+  std::mt19937 generator(5);
+  for (uint32_t nlocs = 2; nlocs < 10; ++nlocs) {
+    for (int i = 0; i < 10; ++i) {
+      auto costs = RandomCosts(nlocs, generator);
+      Optimizer optimizer;
+      auto order = optimizer.Solve(nlocs, costs);
+      if (!IsTour(nlocs, order)) {
+        throw runtime_error("TestExact: not a tour of all the locations");
+      }
+
+      std::vector<uint32_t> permutation(nlocs);
+      std::iota(permutation.begin(), permutation.end(), 0);
+      float least = TourCost(nlocs, costs, permutation);
+      while (nlocs > 2 && std::next_permutation(permutation.begin() + 1, permutation.end() - 1)) {
+        least = std::min(least, TourCost(nlocs, costs, permutation));
+      }
+      if (TourCost(nlocs, costs, order) != least) {
+        throw runtime_error("TestExact: tour does not have the least cost");
+      }
+    }
+  }
+}
+
+void TestLocalSearch() {
+  // Larger tours visit every location once, and do so the same way each time
+  std::mt19937 generator(9);
+  for (uint32_t nlocs : {kMaxExactLocations + 1, 30u, 50u}) {
+    auto costs = RandomCosts(nlocs, generator);
+    Optimizer optimizer;
+    auto order = optimizer.Solve(nlocs, costs);
+    if (!IsTour(nlocs, order)) {
+      throw runtime_error("TestLocalSearch: not a tour of all the locations");
+    }
+    if (optimizer.Solve(nlocs, costs) != order) {
+      throw runtime_error("TestLocalSearch: tour should only depend on the costs");
+    }
+  }
+
+  // Locations along a line in shuffled order are visited from one end to the other
+  const uint32_t nlocs = 40;
+  std::vector<float> position(nlocs);
+  std::iota(position.begin(), position.end(), 0.0f);
+  std::shuffle(position.begin() + 1, position.end() - 1, generator);
+  std::vector<float> costs(nlocs * nlocs);
+  for (uint32_t i = 0; i < nlocs; ++i) {
+    for (uint32_t j = 0; j < nlocs; ++j) {
+      costs[i * nlocs + j] = std::abs(position[i] - position[j]);
+    }
+  }
+  Optimizer optimizer;
+  auto order = optimizer.Solve(nlocs, costs);
+  if (!IsTour(nlocs, order) || TourCost(nlocs, costs, order) != nlocs - 1) {
+    throw runtime_error("TestLocalSearch: locations along a line should be visited in order");
+  }
+}
+
 } // namespace
 
 int main() {
@@ -45,5 +143,11 @@ int main() {
 
   suite.test(TEST_CASE(TestOptimizer));
 
+  // Test small tours have the least cost of any order
+  suite.test(TEST_CASE(TestExact));
+
+  // Test the local search on larger tours
+  suite.test(TEST_CASE(TestLocalSearch));
+
   return suite.tear_down();
 }
@@ -0,0 +1,155 @@
+#include "baldr/radix_queue.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace valhalla::baldr;
+
+namespace {
+
+void TryAddRemove(const std::vector<float>& costs, const uint32_t bucketsize) {
+  std::vector<float> edgelabels;
+  const auto edgecost = [&edgelabels](const uint32_t label) { return edgelabels[label]; };
+
+  RadixQueue queue(0, 10000, bucketsize, edgecost);
+  for (auto cost : costs) {
+    edgelabels.emplace_back(cost);
+    queue.add(edgelabels.size() - 1);
+  }
+
+  // Labels must come out in order of their bucket
+  float previous = 0.0f;
+  for (size_t i = 0; i < costs.size(); ++i) {
+    const uint32_t label = queue.pop();
+    if (label == kInvalidLabel)
+      throw runtime_error("TryAddRemove: queue ran out of labels");
+    if (std::floor(edgelabels[label] / bucketsize) < std::floor(previous / bucketsize))
+      throw runtime_error("TryAddRemove: expected order test failed");
+    previous = edgelabels[label];
+  }
+  if (queue.pop() != kInvalidLabel)
+    throw runtime_error("TryAddRemove: queue should be empty");
+}
+
+void TestInvalidConstruction() {
+  std::vector<float> edgelabels;
+  const auto edgecost = [&edgelabels](const uint32_t label) { return edgelabels[label]; };
+  test::assert_throw<std::runtime_error>([&edgecost]() { RadixQueue queue(0, 10000, 0, edgecost); },
+                                         "Invalid bucket size not caught");
+  test::assert_throw<std::runtime_error>([&edgecost]() { RadixQueue queue(0, 0.0f, 1, edgecost); },
+                                         "Invalid cost range not caught");
+}
+
+void TestAddRemove() {
+  TryAddRemove({67, 325, 25, 466, 1000, 100005, 758, 167, 258, 16442, 278, 111111000}, 1);
+  TryAddRemove({67, 325, 25, 466, 1000, 100005, 758, 167, 258, 16442, 278, 111111000}, 5);
+  TryAddRemove({0, 0, 1, 1, 2, 2, 0.5f, 4e9f, 3e9f}, 1);
+}
+
+void TestDecrease() {
+  std::vector<float> costs = {500, 100, 600, 700, 10000};
+  const auto edgecost = [&costs](const uint32_t label) { return costs[label]; };
+  RadixQueue queue(0, 100, 1, edgecost);
+  for (uint32_t i = 0; i < costs.size(); ++i) {
+    queue.add(i);
+  }
+  if (queue.pop() != 1)
+    throw runtime_error("TestDecrease: expected the lowest cost label");
+
+  // Decrease across buckets and within the same bucket
+  queue.decrease(4, 200);
+  costs[4] = 200;
+  queue.decrease(3, 650);
+  costs[3] = 650;
+  std::vector<uint32_t> expected = {4, 0, 2, 3};
+  for (auto label : expected) {
+    if (queue.pop() != label)
+      throw runtime_error("TestDecrease: labels popped in the wrong order");
+  }
+  if (queue.pop() != kInvalidLabel)
+    throw runtime_error("TestDecrease: queue should be empty");
+}
+
+void TestReuse() {
+  std::vector<float> costs = {5000, 10, 20};
+  const auto edgecost = [&costs](const uint32_t label) { return costs[label]; };
+  RadixQueue queue(0, 100, 1, edgecost);
+  queue.add(0);
+  queue.add(1);
+  if (queue.pop() != 1)
+    throw runtime_error("TestReuse: expected the lowest cost label");
+
+  // A reused queue forgets what was in it and what was last popped
+  queue.reuse(0, 100, 1, edgecost);
+  queue.add(2);
+  queue.add(1);
+  if (queue.pop() != 1 || queue.pop() != 2 || queue.pop() != kInvalidLabel)
+    throw runtime_error("TestReuse: reused queue popped the wrong labels");
+}
+
+void TestSimulation() {
+  // Expand like a path algorithm: costs only grow from the last popped label
+  // and some labels get decreased. Every label must come out once, in order.
+  std::vector<float> costs;
+  std::vector<bool> popped;
+  const auto edgecost = [&costs](const uint32_t label) { return costs[label]; };
+  RadixQueue queue(0, 1000, 1, edgecost);
+  std::mt19937 gen(17);
+  std::uniform_real_distribution<float> increment(1, 5000);
+  std::uniform_int_distribution<uint32_t> coin(0, 3);
+
+  costs.push_back(0);
+  popped.push_back(false);
+  queue.add(0);
+  float last = 0;
+  for (uint32_t label = queue.pop(); label != kInvalidLabel; label = queue.pop()) {
+    if (popped[label] || std::floor(costs[label]) < std::floor(last))
+      throw runtime_error("TestSimulation: label popped out of order");
+    popped[label] = true;
+    last = costs[label];
+    if (costs.size() > 50000) {
+      continue;
+    }
+    for (int i = 0; i < 4; ++i) {
+      const float cost = std::floor(last + increment(gen));
+      const uint32_t other = std::uniform_int_distribution<uint32_t>(0, costs.size() - 1)(gen);
+      if (coin(gen) == 0 && !popped[other] && cost < costs[other]) {
+        queue.decrease(other, cost);
+        costs[other] = cost;
+      } else {
+        costs.push_back(cost);
+        popped.push_back(false);
+        queue.add(costs.size() - 1);
+      }
+    }
+  }
+  if (std::find(popped.begin(), popped.end(), false) != popped.end())
+    throw runtime_error("TestSimulation: not every label was popped");
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("radix_queue");
+
+  suite.test(TEST_CASE(TestInvalidConstruction));
+
+  // Test adding and removing labels including costs far outside the range
+  suite.test(TEST_CASE(TestAddRemove));
+
+  // Test decreasing the cost of labels
+  suite.test(TEST_CASE(TestDecrease));
+
+  // Test that a queue can be reused for another search
+  suite.test(TEST_CASE(TestReuse));
+
+  // Test a simulated path expansion
+  suite.test(TEST_CASE(TestSimulation));
+
+  return suite.tear_down();
+}
@@ -1,6 +1,9 @@
 #include "midgard/sequence.h"
 #include "test.h"
+#include <algorithm>
 #include <cstdint>
+#include <fstream>
+#include <vector>
 
 using namespace valhalla::midgard;
 
@@ -72,6 +75,75 @@ void test_iterator() {
     throw std::runtime_error("Pre-decrement operator wasn't right");
 }
 
+void test_sort() {
+  // lots of duplicates and in no particular order
+  std::vector<osm_node> nodes;
+  for (uint64_t i = 0; i < 100000; ++i)
+    nodes.push_back({(i * 7919) % 30011, static_cast<float>(i), 0.f, 0});
+  auto less_than = [](const osm_node& a, const osm_node& b) { return a.id < b.id; };
+
+  // in memory with and without threads and external with several runs
+  for (const auto& threads_buffer : std::vector<std::pair<size_t, size_t>>{{1, 1000000},
+                                                                           {4, 1000000},
+                                                                           {1, 10000},
+                                                                           {3, 7777}}) {
+    {
+      sequence<osm_node> sequence("sort.nd", true);
+      for (const auto& node : nodes)
+        sequence.push_back(node);
+      sequence.sort(less_than, threads_buffer.first, threads_buffer.second);
+    }
+
+    // should be sorted with nothing missing
+    sequence<osm_node> sequence("sort.nd", false);
+    if (sequence.size() != nodes.size())
+      throw std::runtime_error("Sorting should not change the number of elements");
+    std::vector<size_t> seen(nodes.size());
+    for (size_t i = 0; i < sequence.size(); ++i) {
+      osm_node node = *sequence[i];
+      if (i > 0 && less_than(node, *sequence[i - 1]))
+        throw std::runtime_error("Sequence was not sorted");
+      if (nodes[static_cast<size_t>(node.lng)].id != node.id || seen[node.lng]++)
+        throw std::runtime_error("Sorting should not add, remove or change elements");
+    }
+    if (std::ifstream("sort.nd.run0"))
+      throw std::runtime_error("Sorting should not leave temporary files behind");
+  }
+  std::remove("sort.nd");
+}
+
+void test_sort_stable() {
+  // many elements share each id and tell apart by their position
+  std::vector<osm_node> nodes;
+  for (uint64_t i = 0; i < 100000; ++i)
+    nodes.push_back({(i * 7919) % 101, static_cast<float>(i), 0.f, 0});
+  auto less_than = [](const osm_node& a, const osm_node& b) { return a.id < b.id; };
+  std::vector<osm_node> expected(nodes);
+  std::stable_sort(expected.begin(), expected.end(), less_than);
+
+  // equal ids keep their order however many threads and runs the sort uses
+  for (const auto& threads_buffer : std::vector<std::pair<size_t, size_t>>{{1, 1000000},
+                                                                           {4, 1000000},
+                                                                           {7, 1000000},
+                                                                           {1, 10000},
+                                                                           {3, 7777}}) {
+    {
+      sequence<osm_node> sequence("sort.nd", true);
+      for (const auto& node : nodes)
+        sequence.push_back(node);
+      sequence.sort(less_than, threads_buffer.first, threads_buffer.second);
+    }
+    sequence<osm_node> sequence("sort.nd", false);
+    for (size_t i = 0; i < sequence.size(); ++i) {
+      osm_node node = *sequence[i];
+      if (node.id != expected[i].id || node.lng != expected[i].lng)
+        throw std::runtime_error("Equal elements should keep their order with " +
+                                 std::to_string(threads_buffer.first) + " threads");
+    }
+  }
+  std::remove("sort.nd");
+}
+
 int main() {
   test::suite suite("sequence");
 
@@ -79,5 +151,9 @@ int main() {
 
   suite.test(TEST_CASE(test_iterator));
 
+  suite.test(TEST_CASE(test_sort));
+
+  suite.test(TEST_CASE(test_sort_stable));
+
   return suite.tear_down();
 }
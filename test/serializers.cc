@@ -1,4 +1,9 @@
+#include <cmath>
+#include <list>
 #include <string>
+#include <tuple>
+#include <vector>
+#include <valhalla/proto/response.pb.h>
 #include <valhalla/proto/route.pb.h>
 
 #include "midgard/logging.h"
@@ -1811,6 +1816,102 @@ void testSignElements() {
   }
 }
 
+void testPbfMatrix() {
+  valhalla_request_t request;
+  request.options.set_format(odin::DirectionsOptions::pbf);
+  request.options.set_id("matrix");
+  request.options.add_sources()->mutable_ll()->set_lat(40.f);
+  request.options.add_targets()->mutable_ll()->set_lat(40.1f);
+  request.options.add_targets()->mutable_ll()->set_lat(40.2f);
+  std::vector<thor::TimeDistance> time_distances{{61, 1500},
+                                                 {static_cast<uint32_t>(thor::kMaxCost),
+                                                  static_cast<uint32_t>(thor::kMaxCost)}};
+
+  odin::Response response;
+  if (!response.ParseFromString(serializeMatrix(request, time_distances, 0.001)))
+    throw std::runtime_error("Matrix response is not a protobuf Response");
+  if (response.id() != "matrix" || !response.has_matrix() || response.legs_size() != 0)
+    throw std::runtime_error("Matrix response has the wrong members");
+  const auto& matrix = response.matrix();
+  if (matrix.sources() != 1 || matrix.targets() != 2 || matrix.times_size() != 2 ||
+      matrix.distances_size() != 2)
+    throw std::runtime_error("Matrix should have a time and distance per pair");
+  if (matrix.times(0) != 61 || std::abs(matrix.distances(0) - 1.5f) > 1e-5f)
+    throw std::runtime_error("Matrix has the wrong time or distance");
+  if (matrix.not_found_size() != 1 || matrix.not_found(0) != 1 || matrix.times(1) != 0)
+    throw std::runtime_error("Matrix should list the pair without a route");
+}
+
+void testPbfDirections() {
+  valhalla_request_t request;
+  request.options.set_format(odin::DirectionsOptions::pbf);
+  request.options.set_units(odin::DirectionsOptions::miles);
+  std::list<odin::TripDirections> directions_legs(2);
+  directions_legs.front().add_maneuver()->set_text_instruction("Drive north.");
+  directions_legs.back().set_shape("gysalAlg|zpC");
+
+  odin::Response response;
+  if (!response.ParseFromString(serializeDirections(request, {}, directions_legs)))
+    throw std::runtime_error("Directions response is not a protobuf Response");
+  if (response.has_id() || response.units() != odin::DirectionsOptions::miles ||
+      response.legs_size() != 2)
+    throw std::runtime_error("Directions response has the wrong members");
+  if (response.legs(0).maneuver(0).text_instruction() != "Drive north." ||
+      response.legs(1).shape() != "gysalAlg|zpC")
+    throw std::runtime_error("Directions response legs differ from the directions");
+}
+
+void testPbfTraceAttributes() {
+  valhalla_request_t request;
+  request.options.set_format(odin::DirectionsOptions::pbf);
+  request.options.set_id("trace");
+  thor::AttributesController controller;
+  controller.enable_all();
+
+  odin::TripPath trip_path;
+  trip_path.set_shape("gysalAlg|zpC");
+  trip_path.add_node()->mutable_edge()->set_length(0.25f);
+  thor::MatchResult matched(meili::MatchResult{{-76.3f, 40.1f},
+                                               2.5f,
+                                               baldr::GraphId(1, 2, 3),
+                                               0.5f,
+                                               0,
+                                               meili::StateId(0, 0)});
+  matched.edge_index = 0;
+  thor::MatchResult unmatched(meili::MatchResult{{-76.4f, 40.2f}, 0, {}, 0, 0, {}});
+  std::vector<std::tuple<float, float, std::vector<thor::MatchResult>, odin::TripPath>> results;
+  results.emplace_back(0.75f, 12.f, std::vector<thor::MatchResult>{matched, unmatched}, trip_path);
+  results.emplace_back(0.25f, 40.f, std::vector<thor::MatchResult>{}, trip_path);
+
+  odin::Response response;
+  if (!response.ParseFromString(serializeTraceAttributes(request, controller, results)))
+    throw std::runtime_error("Trace attributes response is not a protobuf Response");
+  if (response.id() != "trace" || response.traces_size() != 2 || response.has_matrix() ||
+      response.legs_size() != 0)
+    throw std::runtime_error("Trace attributes response has the wrong members");
+  const auto& best = response.traces(0);
+  if (std::abs(best.confidence_score() - 0.75f) > 1e-5f || std::abs(best.raw_score() - 12.f) > 1e-5f)
+    throw std::runtime_error("Best path has the wrong scores");
+  if (best.path().shape() != "gysalAlg|zpC" || best.path().node_size() != 1 ||
+      std::abs(best.path().node(0).edge().length() - 0.25f) > 1e-5f)
+    throw std::runtime_error("Best path differs from the trip path");
+  if (best.matched_points_size() != 2)
+    throw std::runtime_error("Best path should have a matched point per trace point");
+  const auto& point = best.matched_points(0);
+  if (point.type() != odin::Response::MatchedPoint::kMatched || !point.has_edge_index() ||
+      point.edge_index() != 0 || std::abs(point.ll().lat() - 40.1f) > 1e-5f ||
+      std::abs(point.distance_along_edge() - 0.5f) > 1e-5f ||
+      std::abs(point.distance_from_trace_point() - 2.5f) > 1e-5f)
+    throw std::runtime_error("Matched point has the wrong members");
+  const auto& missing = best.matched_points(1);
+  if (missing.type() != odin::Response::MatchedPoint::kUnmatched || missing.has_edge_index() ||
+      missing.has_distance_along_edge())
+    throw std::runtime_error("Unmatched point should only have its location and type");
+  if (std::abs(response.traces(1).raw_score() - 40.f) > 1e-5f ||
+      response.traces(1).matched_points_size() != 0)
+    throw std::runtime_error("Alternate path has the wrong members");
+}
+
 } // namespace
 
 int main() {
@@ -1845,4 +1946,13 @@ int main() {
 
   // Test sign message parsing
   suite.test(TEST_CASE(testSignElements));
+
+  // Test the protobuf matrix response
+  suite.test(TEST_CASE(testPbfMatrix));
+
+  // Test the protobuf directions response
+  suite.test(TEST_CASE(testPbfDirections));
+
+  // Test the protobuf trace attributes response
+  suite.test(TEST_CASE(testPbfTraceAttributes));
 }
@@ -93,7 +93,7 @@ std::vector<std::pair<std::string, ots_matches_t>> test_cases{
     // of the partial in it
 };
 
-void test_matcher() {
+boost::property_tree::ptree make_config() {
   // fake config
   std::stringstream conf_json;
   conf_json << R"({
@@ -106,9 +106,12 @@ void test_matcher() {
     })";
   boost::property_tree::ptree conf;
   boost::property_tree::read_json(conf_json, conf);
+  return conf;
+}
 
+void test_matcher() {
   // find me a find, catch me a catch
-  testable_matcher matcher(conf);
+  testable_matcher matcher(make_config());
 
   // some edges should have no matches and most will have no segments
   for (const auto& test_case : test_cases) {
@@ -148,6 +151,41 @@ void test_matcher() {
   }
 }
 
+void test_match_batch() {
+  meili::TrafficSegmentMatcher matcher(make_config());
+
+  // the same traces a few times over and one which can't be parsed
+  std::vector<std::string> traces;
+  for (int i = 0; i < 5; ++i) {
+    for (const auto& test_case : test_cases) {
+      traces.push_back(test_case.first);
+    }
+  }
+  traces.insert(traces.begin() + 3, "not a trace");
+
+  std::vector<std::string> expected;
+  for (const auto& trace : traces) {
+    try {
+      expected.push_back(matcher.match(trace));
+    } catch (...) { expected.push_back(""); }
+  }
+
+  // results have to come back in order and match the ones of a single thread
+  for (uint32_t concurrency : {1, 2, 4}) {
+    auto results = matcher.match_batch(traces, concurrency);
+    if (results.size() != traces.size())
+      throw std::logic_error("wrong number of results in batch");
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (expected[i].empty()) {
+        if (results[i].find("\"error\"") == std::string::npos)
+          throw std::logic_error("bad trace should give back an error");
+      } else if (results[i] != expected[i]) {
+        throw std::logic_error("batch result does not match the single result");
+      }
+    }
+  }
+}
+
 } // namespace
 
 int main() {
@@ -155,5 +193,7 @@ int main() {
 
   suite.test(TEST_CASE(test_matcher));
 
+  suite.test(TEST_CASE(test_match_batch));
+
   return suite.tear_down();
 }
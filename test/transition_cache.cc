@@ -0,0 +1,111 @@
+#include "meili/transition_cache.h"
+#include "test.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace valhalla::baldr;
+using namespace valhalla::meili;
+
+namespace {
+
+TransitionCache::key_t Key(uint32_t origin, uint32_t destination, uint64_t costing = 1) {
+  return {GraphId(100, 2, origin), GraphId(100, 2, destination), costing};
+}
+
+TransitionCache::path_t Path(const std::vector<uint32_t>& ids) {
+  TransitionCache::path_t path{true, 0.f, {}};
+  for (auto id : ids) {
+    path.edges.emplace_back(100, 2, id);
+  }
+  return path;
+}
+
+void TestGetPut() {
+  TransitionCache cache(10);
+  TransitionCache::path_t path;
+  if (cache.Get(Key(1, 2), path))
+    throw std::runtime_error("Empty cache should not have a path");
+
+  cache.Put(Key(1, 2), Path({5, 6, 7}));
+  cache.Put(Key(1, 3), {false, 120.f, {}});
+  if (!cache.Get(Key(1, 2), path) || !path.found || path.edges != Path({5, 6, 7}).edges)
+    throw std::runtime_error("Cached path does not match");
+  if (!cache.Get(Key(1, 3), path) || path.found || path.min_cost != 120.f || !path.edges.empty())
+    throw std::runtime_error("Cached path which was not found does not match");
+
+  // Paths are told apart by their direction and costing
+  if (cache.Get(Key(2, 1), path) || cache.Get(Key(1, 2, 2), path))
+    throw std::runtime_error("Path should only be found for its own key");
+
+  // Putting a key again replaces its path
+  cache.Put(Key(1, 2), Path({8}));
+  if (!cache.Get(Key(1, 2), path) || path.edges != Path({8}).edges || cache.size() != 2)
+    throw std::runtime_error("Path should have been replaced");
+}
+
+void TestEviction() {
+  TransitionCache cache(3);
+  TransitionCache::path_t path;
+  cache.Put(Key(1, 2), Path({1}));
+  cache.Put(Key(1, 3), Path({2}));
+  cache.Put(Key(1, 4), Path({3}));
+
+  // Using the oldest path keeps it over the next oldest one
+  cache.Get(Key(1, 2), path);
+  cache.Put(Key(1, 5), Path({4}));
+  if (cache.size() != 3)
+    throw std::runtime_error("Cache should not grow past its maximum size");
+  if (cache.Get(Key(1, 3), path))
+    throw std::runtime_error("Least recently used path should have been evicted");
+  for (auto destination : {2u, 4u, 5u}) {
+    if (!cache.Get(Key(1, destination), path))
+      throw std::runtime_error("Recently used paths should be kept");
+  }
+
+  // A cache without room keeps nothing
+  TransitionCache none(0);
+  none.Put(Key(1, 2), Path({1}));
+  if (none.size() != 0 || none.Get(Key(1, 2), path))
+    throw std::runtime_error("Cache of size 0 should keep nothing");
+}
+
+void TestStats() {
+  TransitionCache cache(10);
+  TransitionCache::path_t path;
+  if (cache.hit_rate() != 0.f)
+    throw std::runtime_error("Hit rate without lookups should be 0");
+
+  cache.Put(Key(1, 2), Path({1}));
+  cache.Get(Key(1, 2), path);
+  cache.Get(Key(1, 2), path);
+  cache.Get(Key(1, 3), path);
+  cache.Get(Key(1, 4), path);
+  if (cache.hits() != 2 || cache.misses() != 2 || cache.hit_rate() != 0.5f)
+    throw std::runtime_error("Wrong hit and miss counts");
+
+  // Clearing drops the paths but not the counts
+  cache.Clear();
+  if (cache.size() != 0 || cache.Get(Key(1, 2), path))
+    throw std::runtime_error("Cleared cache should be empty");
+  if (cache.hits() != 2 || cache.misses() != 3)
+    throw std::runtime_error("Clearing should keep the counts");
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("transition_cache");
+
+  // Test getting and putting paths
+  suite.test(TEST_CASE(TestGetPut));
+
+  // Test the least recently used paths are evicted
+  suite.test(TEST_CASE(TestEviction));
+
+  // Test the hit and miss counts
+  suite.test(TEST_CASE(TestStats));
+
+  return suite.tear_down();
+}
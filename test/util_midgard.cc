@@ -3,8 +3,12 @@
 #include "midgard/encoded.h"
 #include "midgard/util.h"
 #include "test.h"
+#include <atomic>
 #include <cmath>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <list>
 
@@ -372,6 +376,47 @@ void TestExpandLocation() {
   }
 }
 
+void TestParallelFor() {
+  // Every index is visited once whatever the number of threads, and no thread beyond the
+  // concurrency is used
+  for (size_t concurrency : {0, 1, 2, 3, 8}) {
+    for (size_t count : {0, 1, 2, 100}) {
+      std::vector<std::atomic<int>> visits(count);
+      std::vector<std::atomic<int>> threads(std::max(concurrency, static_cast<size_t>(1)));
+      parallel_for(count, concurrency, [&visits, &threads](size_t i, size_t thread) {
+        ++visits[i];
+        ++threads.at(thread);
+      });
+      for (const auto& v : visits) {
+        if (v != 1) {
+          throw std::logic_error("parallel_for should visit every index once");
+        }
+      }
+    }
+  }
+
+  // A failure on any thread is rethrown after the others are done
+  for (size_t failing : {0, 57, 99}) {
+    std::atomic<size_t> visited(0);
+    try {
+      parallel_for(100, 4, [&visited, failing](size_t i, size_t) {
+        ++visited;
+        if (i == failing) {
+          throw std::runtime_error("failed " + std::to_string(i));
+        }
+      });
+      throw std::logic_error("parallel_for should rethrow the failure");
+    } catch (const std::runtime_error& e) {
+      if (std::string(e.what()) != "failed " + std::to_string(failing)) {
+        throw std::logic_error("parallel_for rethrew the wrong failure");
+      }
+    }
+    if (visited != 100) {
+      throw std::logic_error("parallel_for should keep going on the threads which did not fail");
+    }
+  }
+}
+
 } // namespace
 
 int main() {
@@ -402,5 +447,8 @@ int main() {
   // trim_front of a polyline
   suite.test(TEST_CASE(TestTrimFront));
 
+  // parallel_for over more than one thread
+  suite.test(TEST_CASE(TestParallelFor));
+
   return suite.tear_down();
 }
@@ -0,0 +1,168 @@
+#include "test.h"
+
+#include <set>
+#include <sstream>
+#include <string>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "baldr/rapidjson_utils.h"
+#include "loki/worker.h"
+#include "thor/worker.h"
+#include "worker.h"
+
+using namespace valhalla;
+
+namespace {
+
+boost::property_tree::ptree json_to_pt(const std::string& json) {
+  std::stringstream ss;
+  ss << json;
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(ss, pt);
+  return pt;
+}
+
+const auto conf = json_to_pt(R"({
+    "mjolnir":{"tile_dir":"test/data/utrecht_tiles", "concurrency": 1},
+    "loki":{
+      "actions":["isochrone","trace_attributes"],
+      "logging":{"long_request": 100},
+      "service_defaults":{"minimum_reachability": 50,"radius": 0}
+    },
+    "thor":{"logging":{"long_request": 110}},
+    "meili":{"customizable": ["turn_penalty_factor","max_route_distance_factor","max_route_time_factor","search_radius"],
+             "mode":"auto","grid":{"cache_size":100240,"size":500},
+             "default":{"beta":3,"breakage_distance":2000,"geometry":false,"gps_accuracy":5.0,"interpolation_distance":10,
+             "max_route_distance_factor":5,"max_route_time_factor":5,"max_search_radius":200,"route":true,
+             "search_radius":15.0,"sigma_z":4.07,"turn_penalty_factor":200}},
+    "service_limits": {
+      "auto": {"max_distance": 5000000.0, "max_locations": 20,"max_matrix_distance": 400000.0,"max_matrix_locations": 50},
+      "isochrone": {"max_contours": 4,"max_distance": 25000.0,"max_locations": 1,"max_time": 120},
+      "max_avoid_locations": 50,"max_radius": 200,"max_reachability": 100,
+      "pedestrian": {"max_distance": 250000.0,"max_locations": 50,"max_matrix_distance": 200000.0,"max_matrix_locations": 50,"max_transit_walking_distance": 10000,"min_transit_walking_distance": 1},
+      "skadi": {"max_shape": 750000,"min_resample": 10.0},
+      "trace": {"max_distance": 200000.0,"max_gps_accuracy": 100.0,"max_search_radius": 100,"max_shape": 16000,"max_best_paths":4,"max_best_paths_shape":100}
+    }
+  })");
+
+void test_downstream_members() {
+  // every member read after loki along with members only loki reads
+  valhalla_request_t request;
+  request.document.Parse(R"({
+      "costing":"auto","costing_options":{"auto":{"use_highways":0.5}},
+      "trace_options":{"search_radius":10},"shape_match":"map_snap",
+      "filters":{"attributes":["edge.names"],"action":"include"},"best_paths":2,
+      "contours":[{"time":5,"color":"ff0000"}],"polygons":true,"denoise":0.5,"generalize":20,
+      "show_locations":true,
+      "locations":[{"lat":52.09,"lon":5.11}],"sources":[{"lat":52.09,"lon":5.11}],
+      "targets":[{"lat":52.08,"lon":5.12}],"shape":[{"lat":52.09,"lon":5.11}],
+      "encoded_polyline":"_p~iF~ps|U","avoid_locations":[{"lat":52.1,"lon":5.1}],
+      "directions_options":{"units":"miles","language":"de-DE"},"date_time":{"type":0},
+      "id":"downstream","jsonp":"callback","format":"json"})");
+  if (request.document.HasParseError())
+    throw std::logic_error("The request should parse");
+
+  rapidjson::Document downstream;
+  downstream.Parse(request.downstream_document().c_str());
+  if (downstream.HasParseError() || !downstream.IsObject())
+    throw std::logic_error("The downstream document should be a json object");
+
+  // exactly the members read after loki are kept, with their values
+  std::set<std::string> kept;
+  for (const auto& member : downstream.GetObject()) {
+    kept.insert(member.name.GetString());
+    if (member.value != request.document[member.name])
+      throw std::logic_error(std::string("The value of ") + member.name.GetString() +
+                             " should be kept as it is");
+  }
+  const std::set<std::string> expected{"costing",     "costing_options", "trace_options",
+                                       "shape_match", "filters",         "best_paths",
+                                       "contours",    "polygons",        "denoise",
+                                       "generalize",  "show_locations"};
+  if (kept != expected) {
+    std::string members;
+    for (const auto& name : kept)
+      members += name + " ";
+    throw std::logic_error("The downstream document kept the wrong members: " + members);
+  }
+
+  // members which are not in the request are not added
+  request.document.Parse(R"({"costing":"pedestrian","locations":[{"lat":52.09,"lon":5.11}]})");
+  if (request.downstream_document() != R"({"costing":"pedestrian"})")
+    throw std::logic_error("Only the members in the request should be kept");
+}
+
+// Runs the request through loki and has thor answer it from the full request
+// document, from the document loki forwards and from a document without the
+// optional members. The first two should be the same and differ from the last.
+template <typename loki_action_t, typename thor_action_t>
+void round_trip(const std::string& request_str,
+                const std::string& required_str,
+                odin::DirectionsOptions::Action action,
+                const loki_action_t& loki_action,
+                const thor_action_t& thor_action) {
+  loki::loki_worker_t loki_worker(conf);
+  thor::thor_worker_t thor_worker(conf);
+
+  valhalla_request_t request;
+  request.parse(request_str, action);
+  (loki_worker.*loki_action)(request);
+  auto options = request.options.SerializeAsString();
+  auto downstream = request.downstream_document();
+
+  std::string results[3];
+  const std::string* documents[3] = {&request_str, &downstream, &required_str};
+  for (size_t i = 0; i < 3; ++i) {
+    valhalla_request_t thor_request;
+    thor_request.parse(*documents[i], options);
+    results[i] = (thor_worker.*thor_action)(thor_request);
+    thor_worker.cleanup();
+  }
+  loki_worker.cleanup();
+
+  const auto& name = odin::DirectionsOptions::Action_Name(action);
+  if (results[0] != results[1])
+    throw std::logic_error(name + " should be the same from the forwarded document:\n" +
+                           results[0] + "\n" + results[1]);
+  if (results[0] == results[2])
+    throw std::logic_error(name + " should depend on the optional members of the request");
+}
+
+void test_isochrone_round_trip() {
+  round_trip(R"({"costing":"pedestrian","costing_options":{"pedestrian":{"walking_speed":4}},
+      "locations":[{"lat":52.078937,"lon":5.115321}],
+      "contours":[{"time":5,"color":"ff0000"},{"time":10}],"polygons":true,"denoise":0.5,
+      "generalize":20,"show_locations":true})",
+             R"({"costing":"pedestrian","contours":[{"time":5},{"time":10}]})",
+             odin::DirectionsOptions::isochrone, &loki::loki_worker_t::isochrones,
+             &thor::thor_worker_t::isochrones);
+}
+
+void test_trace_attributes_round_trip() {
+  round_trip(R"({"trace_options":{"turn_penalty_factor":100},"costing":"auto",
+      "best_paths":2,"shape_match":"map_snap",
+      "filters":{"attributes":["edge.names","edge.length","matched.point"],"action":"include"},
+      "shape":[{"lat":52.08511,"lon":5.15085,"accuracy":10},
+               {"lat":52.08533,"lon":5.15109,"accuracy":20},
+               {"lat":52.08539,"lon":5.15100,"accuracy":20}]})",
+             R"({"costing":"auto","shape_match":"map_snap"})",
+             odin::DirectionsOptions::trace_attributes, &loki::loki_worker_t::trace,
+             &thor::thor_worker_t::trace_attributes);
+}
+
+} // namespace
+
+int main() {
+  test::suite suite("worker");
+
+  // The members of the request forwarded after loki
+  suite.test(TEST_CASE(test_downstream_members));
+
+  // Thor answers the same from the forwarded members
+  suite.test(TEST_CASE(test_isochrone_round_trip));
+  suite.test(TEST_CASE(test_trace_attributes_round_trip));
+
+  return suite.tear_down();
+}
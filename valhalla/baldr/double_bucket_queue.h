@@ -4,19 +4,13 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <valhalla/baldr/label_queue.h>
 #include <valhalla/midgard/util.h>
 #include <vector>
 
 namespace valhalla {
 namespace baldr {
 
-constexpr uint32_t kInvalidLabel = std::numeric_limits<uint32_t>::max();
-
-/**
- * A callable element which returns the cost for a label.
- */
-using LabelCost = std::function<float(const uint32_t label)>;
-
 // Bucket type and bucket list type.
 using bucket_t = std::vector<uint32_t>;
 using buckets_t = std::vector<bucket_t>;
@@ -28,7 +22,7 @@ using buckets_t = std::vector<bucket_t>;
  * into the overflow bucket and are moved into the low-level buckets as
  * needed. Each bucket stores label indexes into external data.
  */
-class DoubleBucketQueue {
+class DoubleBucketQueue : public LabelQueue {
 public:
   /**
    * Constructor given a minimum cost, a range of costs held within the
@@ -44,7 +38,27 @@ public:
   DoubleBucketQueue(const float mincost,
                     const float range,
                     const uint32_t bucketsize,
-                    const LabelCost& labelcost) {
+                    const LabelCost& labelcost)
+      : mincost_(0.0f), currentbucket_(buckets_.begin()) {
+    reuse(mincost, range, bucketsize, labelcost);
+  }
+
+  /**
+   * Empties the queue and sets it up for another search given a minimum cost,
+   * a range of costs held within the bucket sort, and a bucket size. The
+   * buckets keep their memory so that a queue can be reused for many searches
+   * without allocating it again.
+   * @param mincost    Minimum cost. Used to create the initial range for
+   *                   bucket sorting.
+   * @param range      Cost range for low-level buckets.
+   * @param bucketsize Bucket size (range of costs within same bucket).
+   *                   Must be an integer value.
+   * @param labelcost  Functor to get a cost given a label index.
+   */
+  void reuse(const float mincost,
+             const float range,
+             const uint32_t bucketsize,
+             const LabelCost& labelcost) override {
     // We need at least a bucketsize of 1 or more
     if (bucketsize < 1) {
       throw std::runtime_error("Bucketsize must be 1 or greater");
@@ -55,6 +69,9 @@ public:
       throw std::runtime_error("Bucketrange must be greater than 0");
     }
 
+    // Empty anything left over from the last search
+    clear();
+
     // Adjust min cost to be the start of a bucket
     uint32_t c = static_cast<uint32_t>(mincost);
     currentcost_ = (c - (c % bucketsize));
@@ -87,7 +104,7 @@ public:
   /**
    * Clear all labels from the low-level buckets and the overflow buckets.
    */
-  void clear() {
+  void clear() override {
     // Empty the overflow bucket and each bucket
     overflowbucket_.clear();
     while (currentbucket_ != buckets_.end()) {
@@ -107,7 +124,7 @@ public:
    * cost then the label is placed in the current bucket to prevent underflow.
    * @param   label  Label index to add to the queue.
    */
-  void add(const uint32_t label) {
+  void add(const uint32_t label) override {
     get_bucket(labelcost_(label)).push_back(label);
   }
 
@@ -118,7 +135,7 @@ public:
    * @param  label        Label index to reorder.
    * @param  newcost      New sort cost.
    */
-  void decrease(const uint32_t label, const float newcost) {
+  void decrease(const uint32_t label, const float newcost) override {
     // Get the buckets of the previous and new costs. Nothing needs to be done
     // if old cost and the new cost are in the same buckets.
     bucket_t& prevbucket = get_bucket(labelcost_(label));
@@ -135,7 +152,7 @@ public:
    * @return  Returns the label index of the lowest cost label. Returns
    *          kInvalidLabel if the buckets are empty.
    */
-  uint32_t pop() {
+  uint32_t pop() override {
     if (empty()) {
       // No labels found in the low-level buckets.
       if (overflowbucket_.empty()) {
@@ -230,20 +247,20 @@ private:
       }
       maxcost_ = mincost_ + bucketrange_;
 
-      // Move elements within the range from overflow to buckets
-      bucket_t tmp;
-      for (const auto& label : overflowbucket_) {
-        // Get the cost (using the label cost function)
-        float cost = labelcost_(label);
-        if (cost < maxcost_) {
-          buckets_[static_cast<uint32_t>((cost - mincost_) * inv_)].push_back(label);
-        } else {
-          tmp.push_back(label);
-        }
-      }
-
-      // Add any labels that lie outside the new range back to overflow bucket
-      overflowbucket_ = std::move(tmp);
+      // Move elements within the range from overflow to buckets. Any labels
+      // that lie outside the new range stay in the overflow bucket
+      auto last = std::remove_if(overflowbucket_.begin(), overflowbucket_.end(),
+                                 [this](const uint32_t label) {
+                                   // Get the cost (using the label cost function)
+                                   float cost = labelcost_(label);
+                                   if (cost < maxcost_) {
+                                     buckets_[static_cast<uint32_t>((cost - mincost_) * inv_)]
+                                         .push_back(label);
+                                     return true;
+                                   }
+                                   return false;
+                                 });
+      overflowbucket_.erase(last, overflowbucket_.end());
     }
 
     // Reset current cost and bucket to beginning of low level buckets
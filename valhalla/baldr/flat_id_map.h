@@ -0,0 +1,209 @@
+#ifndef VALHALLA_BALDR_FLAT_ID_MAP_H_
+#define VALHALLA_BALDR_FLAT_ID_MAP_H_
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Hash map from graph ids (or any part of one, like a tile id) to values
+ * which is tuned for the lookups done on every edge relaxation of a path
+ * algorithm. Keys live in a flat, open addressed table that is probed
+ * linearly so a lookup touches a cache line or two rather than chasing the
+ * node pointers of a std::unordered_map. The values are stored densely, in
+ * insertion order, in a separate vector.
+ *
+ * Values can not be erased individually. Clearing the map keeps its memory
+ * so that it can be reused by another search without allocating again.
+ * Pointers to values are only valid until the next insert.
+ */
+template <typename Value> class FlatIdMap {
+public:
+  /**
+   * Constructor.
+   * @param  capacity  Number of values to make room for up front.
+   */
+  explicit FlatIdMap(const size_t capacity = 0) : mask_(0), shift_(64) {
+    reserve(capacity);
+  }
+
+  /**
+   * Find the value for an id.
+   * @param   key  Id to look up. Must not be kInvalidGraphId.
+   * @return  Returns a pointer to the value or nullptr if the id has no value.
+   */
+  Value* find(const uint64_t key) {
+    const uint32_t index = find_index(key);
+    return index == kEmptyIndex ? nullptr : &values_[index];
+  }
+
+  const Value* find(const uint64_t key) const {
+    const uint32_t index = find_index(key);
+    return index == kEmptyIndex ? nullptr : &values_[index];
+  }
+
+  /**
+   * Add a value for an id unless the id already has one.
+   * @param   key   Id to add the value for. Must not be kInvalidGraphId.
+   * @param   args  Arguments to construct the value with.
+   * @return  Returns a pointer to the value for the id and whether it was added.
+   */
+  template <typename... Args> std::pair<Value*, bool> emplace(const uint64_t key, Args&&... args) {
+    const auto added = emplace_index(key, std::forward<Args>(args)...);
+    return {&values_[added.first], added.second};
+  }
+
+  /**
+   * Add a value for an id unless the id already has one.
+   * @param   key   Id to add the value for. Must not be kInvalidGraphId.
+   * @param   args  Arguments to construct the value with.
+   * @return  Returns the position of the value in insertion order and whether it was added.
+   */
+  template <typename... Args>
+  std::pair<uint32_t, bool> emplace_index(const uint64_t key, Args&&... args) {
+    // Keep the table at most half full so probe sequences stay short
+    if ((values_.size() + 1) * 2 > slots_.size()) {
+      rehash(slots_.empty() ? kMinSlots : slots_.size() * 2);
+    }
+
+    slot_t* slot = &slots_[hash(key)];
+    while (slot->key != kInvalidGraphId) {
+      if (slot->key == key) {
+        return {slot->index, false};
+      }
+      slot = slot == &slots_.back() ? &slots_.front() : slot + 1;
+    }
+    slot->key = key;
+    slot->index = static_cast<uint32_t>(values_.size());
+    values_.emplace_back(std::forward<Args>(args)...);
+    return {slot->index, true};
+  }
+
+  /**
+   * Get the value at a position in insertion order.
+   * @param   index  Position of the value, less than size().
+   * @return  Returns a reference to the value.
+   */
+  Value& at_index(const uint32_t index) {
+    return values_[index];
+  }
+
+  /**
+   * Get the position of the value for an id in insertion order.
+   * @param   key  Id to look up.
+   * @return  Returns the position or kEmptyIndex if the id has no value.
+   */
+  uint32_t find_index(const uint64_t key) const {
+    if (values_.empty()) {
+      return kEmptyIndex;
+    }
+    const slot_t* slot = &slots_[hash(key)];
+    while (slot->key != kInvalidGraphId) {
+      if (slot->key == key) {
+        return slot->index;
+      }
+      slot = slot == &slots_.back() ? &slots_.front() : slot + 1;
+    }
+    return kEmptyIndex;
+  }
+
+  /**
+   * Make room for at least this many values without rehashing.
+   * @param  capacity  Number of values.
+   */
+  void reserve(const size_t capacity) {
+    size_t slots = kMinSlots;
+    while (slots < capacity * 2) {
+      slots *= 2;
+    }
+    if (slots > slots_.size() && capacity > 0) {
+      rehash(slots);
+    }
+    values_.reserve(capacity);
+  }
+
+  /**
+   * Remove all of the values. The memory of the table is kept.
+   */
+  void clear() {
+    if (!values_.empty()) {
+      for (auto& slot : slots_) {
+        slot.key = kInvalidGraphId;
+      }
+      values_.clear();
+    }
+  }
+
+  /**
+   * Free all of the memory held by the map.
+   */
+  void release() {
+    std::vector<slot_t>().swap(slots_);
+    std::vector<Value>().swap(values_);
+    mask_ = 0;
+    shift_ = 64;
+  }
+
+  size_t size() const {
+    return values_.size();
+  }
+
+  bool empty() const {
+    return values_.empty();
+  }
+
+  // Returned by find_index when an id has no value
+  static constexpr uint32_t kEmptyIndex = std::numeric_limits<uint32_t>::max();
+
+private:
+  static constexpr size_t kMinSlots = 16;
+
+  // An id and the position of its value
+  struct slot_t {
+    uint64_t key = kInvalidGraphId;
+    uint32_t index = kEmptyIndex;
+  };
+
+  // Fibonacci hashing so that sequential tile and node ids are spread out
+  size_t hash(const uint64_t key) const {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_) & mask_;
+  }
+
+  // Rebuild the table with a new (power of 2) number of slots
+  void rehash(const size_t slots) {
+    std::vector<slot_t> old(slots);
+    old.swap(slots_);
+    mask_ = slots - 1;
+    shift_ = 64;
+    for (size_t s = slots; s > 1; s >>= 1) {
+      --shift_;
+    }
+    for (const auto& o : old) {
+      if (o.key != kInvalidGraphId) {
+        slot_t* slot = &slots_[hash(o.key)];
+        while (slot->key != kInvalidGraphId) {
+          slot = slot == &slots_.back() ? &slots_.front() : slot + 1;
+        }
+        *slot = o;
+      }
+    }
+  }
+
+  size_t mask_;
+  uint32_t shift_;
+  std::vector<slot_t> slots_;
+  std::vector<Value> values_;
+};
+
+template <typename Value> constexpr uint32_t FlatIdMap<Value>::kEmptyIndex;
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_FLAT_ID_MAP_H_
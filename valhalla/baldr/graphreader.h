@@ -2,15 +2,19 @@
 #define VALHALLA_BALDR_GRAPHREADER_H_
 
 #include <cstdint>
+#include <list>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 #include <valhalla/baldr/curler.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/tile_prefetcher.h>
 #include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/midgard/aabb2.h>
 
 namespace valhalla {
 namespace baldr {
@@ -63,6 +67,12 @@ public:
    * Clears the cache.
    */
   virtual void Clear() = 0;
+
+  /**
+   * Brings the cache back within its limit if it is over committed. Callers
+   * should do this in between requests, when no tile pointers are held.
+   */
+  virtual void Trim() = 0;
 };
 
 /**
@@ -116,6 +126,11 @@ public:
    */
   virtual void Clear();
 
+  /**
+   * Clears the cache if it is over committed.
+   */
+  virtual void Trim();
+
 protected:
   // The actual cached GraphTile objects
   std::unordered_map<GraphId, GraphTile> cache_;
@@ -127,6 +142,114 @@ protected:
   size_t max_cache_size_;
 };
 
+/**
+ * Tile cache which evicts the least recently used tiles to stay within its
+ * limit instead of dropping everything at once. The size of each entry
+ * includes its bookkeeping in addition to the size of the tile itself.
+ * With hard memory control tiles are evicted as soon as a Put goes over the
+ * limit, so any tile pointer obtained earlier may be invalidated by a later
+ * Put. With soft memory control tiles are only evicted when Trim is called.
+ * It is NOT thread-safe!
+ */
+class TileCacheLRU : public TileCache {
+public:
+  enum class MemoryLimitControl {
+    HARD, // evict during Put
+    SOFT  // evict during Trim
+  };
+
+  /**
+   * Constructor.
+   * @param max_size  maximum size of the cache
+   * @param mem_control  when to evict tiles to stay within the maximum size
+   */
+  TileCacheLRU(size_t max_size, MemoryLimitControl mem_control);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache. With hard memory control this
+   * evicts the least recently used tiles until the cache fits its limit.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId. The tile becomes
+   * the most recently used one.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   * Evicts the least recently used tiles until the cache fits its limit.
+   */
+  void Trim() override;
+
+  /**
+   * Gets the number of bytes an entry takes up in the cache.
+   * @param size size of the tile in memory
+   * @return the size of the tile plus the bookkeeping needed to cache it
+   */
+  static size_t EntrySize(size_t size);
+
+protected:
+  struct KeyValue {
+    GraphId id;
+    GraphTile tile;
+    size_t size;
+  };
+  using KeyValueIter = std::list<KeyValue>::iterator;
+
+  /**
+   * Evicts the least recently used tiles until the cache fits the given size.
+   * The most recently used tile is never evicted.
+   * @param max_size the size to fit in
+   * @return the number of bytes that were freed
+   */
+  size_t TrimToFit(size_t max_size);
+
+  // Most recently used tiles are at the front of the list
+  mutable std::list<KeyValue> key_val_lru_list_;
+
+  // Lookup into the list by tile id
+  std::unordered_map<GraphId, KeyValueIter> cache_;
+
+  // The current cache size in bytes
+  size_t cache_size_;
+
+  // The max cache size in bytes
+  size_t max_cache_size_;
+
+  // When to evict tiles
+  MemoryLimitControl mem_control_;
+};
+
 /**
  * Tile cache synchronized using external mutex.
  * It is thread-safe.
@@ -178,11 +301,85 @@ public:
    */
   void Clear() override;
 
+  /**
+   * Brings the cache back within its limit if it is over committed.
+   */
+  void Trim() override;
+
 private:
   TileCache& cache_;
   std::mutex& mutex_ref_;
 };
 
+/**
+ * Tile cache that can be shared between threads without a global lock.
+ * Cached tiles are published into a table that is directly indexed by
+ * level and tile id, so reads are a single atomic load and never block.
+ * Writes are serialized per shard (based on the tile id) so that threads
+ * loading different tiles do not contend with each other. Copies of this
+ * object share the same underlying cache.
+ * It is thread-safe.
+ */
+class ConcurrentTileCache : public TileCache {
+public:
+  /**
+   * Constructor.
+   * @param max_size  maximum size of the cache
+   */
+  ConcurrentTileCache(size_t max_size);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * The table is sized from the tile hierarchy so this does nothing.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Puts a copy of a tile of into the cache. If another thread already
+   * put the same tile the previously cached copy is returned.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  const GraphTile* Put(const GraphId& graphid, const GraphTile& tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  const GraphTile* Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache.
+   */
+  void Clear() override;
+
+  /**
+   * Clears the cache if it is over committed.
+   */
+  void Trim() override;
+
+protected:
+  // The tile table, shard locks and accounting shared between all copies
+  struct shared_state_t;
+  std::shared_ptr<shared_state_t> state_;
+};
+
 /**
  * Creates tile caches.
  */
@@ -260,10 +457,55 @@ public:
   }
 
   /**
-   * Clears the cache
+   * Requests the tiles a route between two areas is likely to expand into to
+   * be loaded in the background, if prefetching is enabled. These are the
+   * tiles around both areas on every level and the highway tiles along the
+   * line between them. Tiles which are already cached are skipped.
+   * @param origin       area around the origin of the route
+   * @param destination  area around the destination of the route
+   */
+  void PrefetchCorridor(const midgard::AABB2<midgard::PointLL>& origin,
+                        const midgard::AABB2<midgard::PointLL>& destination);
+
+  /**
+   * Gets the tiles to load before taking requests as configured in the preload
+   * section: the tiles listed in the file preload.tile_list (one level/tileid
+   * per line, e.g. as recorded by valhalla_build_preload_list), all the tiles
+   * on the preload.levels and the tiles within preload.bbox (minx,miny,maxx,maxy)
+   * on every level, in that order and without duplicates.
+   * @param pt  Property tree listing the configuration for the tile storage.
+   * @return the tiles to preload
+   */
+  std::vector<GraphId> GetPreloadTiles(const boost::property_tree::ptree& pt) const;
+
+  /**
+   * Loads tiles into the cache, stopping at the first tile which would make
+   * them take up more than the given size so the cache isn't over committed
+   * right away. Tiles which are already cached count towards the size too.
+   * @param tiles     the tiles to load, the most important ones first
+   * @param max_size  maximum number of bytes to load
+   * @param size      set to the number of bytes the loaded tiles take up
+   * @return the number of tiles loaded
+   */
+  size_t Preload(const std::vector<GraphId>& tiles, size_t max_size, size_t& size);
+
+  /**
+   * Warms the cache with the tiles configured in the preload section, up to
+   * preload.max_size bytes (defaults to three quarters of max_cache_size),
+   * and logs how long that took and how much memory the tiles take up.
+   * Does nothing if there is no preload section.
+   * @param pt  Property tree listing the configuration for the tile storage.
+   */
+  void Preload(const boost::property_tree::ptree& pt);
+
+  /**
+   * Clears the cache and drops any prefetched tiles
    */
   void Clear() {
     cache_->Clear();
+    if (prefetcher_) {
+      prefetcher_->Clear();
+    }
   }
 
   /**
@@ -274,6 +516,14 @@ public:
     return cache_->OverCommitted();
   }
 
+  /**
+   * Brings the cache back within its limit if it is over committed. Depending
+   * on the cache this either evicts some tiles or clears it entirely.
+   */
+  void Trim() {
+    cache_->Trim();
+  }
+
   /**
    * Convenience method to get an opposing directed edge.
    * @param  edgeid  Graph Id of the directed edge.
@@ -553,6 +803,33 @@ public:
   }
 
 protected:
+  /**
+   * Loads a tile which is not in the cache from the extract, the tile_dir or
+   * the tile_url, without adding it to the cache.
+   * @param base  the graphid of the tile
+   * @param tile  set to the loaded tile
+   * @param size  set to the number of bytes the tile counts for in the cache
+   * @return true if the tile was found
+   */
+  bool LoadGraphTile(const GraphId& base, GraphTile& tile, size_t& size);
+
+  /**
+   * Requests the tiles around a tile on the same level to be loaded in the
+   * background, an expansion which reached a tile often continues into them.
+   * @param graphid  the graphid of the tile
+   */
+  void PrefetchNeighbors(const GraphId& graphid);
+
+  /**
+   * Requests a tile to be loaded in the background unless it is cached.
+   * @param graphid  the graphid of the tile
+   */
+  void Prefetch(const GraphId& graphid) {
+    if (!cache_->Contains(graphid)) {
+      prefetcher_->Prefetch(graphid);
+    }
+  }
+
   // (Tar) extract of tiles - the contents are empty if not being used
   struct tile_extract_t;
   std::shared_ptr<const tile_extract_t> tile_extract_;
@@ -565,8 +842,15 @@ protected:
   std::unordered_set<GraphId> _404s;
   // Information about where the tiles are kept
   std::string tile_dir_;
+  // Whether tiles in the tile_dir are memory mapped rather than read into memory
+  bool mmap_tiles_;
+  // Whether to log every tile that is loaded into the cache, to record the hot tile set
+  bool log_tile_loads_;
 
   std::unique_ptr<TileCache> cache_;
+
+  // Loads tiles from the tile_dir in the background - null if not being used
+  std::unique_ptr<TilePrefetcher> prefetcher_;
 };
 
 } // namespace baldr
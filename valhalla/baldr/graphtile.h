@@ -28,6 +28,10 @@
 #include <valhalla/baldr/signinfo.h>
 
 namespace valhalla {
+namespace midgard {
+template <class T> class mem_map;
+} // namespace midgard
+
 namespace baldr {
 
 /**
@@ -42,11 +46,15 @@ public:
 
   /**
    * Constructor given a GraphId. Reads the graph tile from file
-   * into memory.
-   * @param  tile_dir   Tile directory.
-   * @param  graphid    GraphId (tileid and level)
+   * into memory or memory maps it. Memory mapped tiles share their
+   * pages with every other process that maps the same file. Only
+   * uncompressed tiles can be memory mapped, gzipped tiles are always
+   * read into memory.
+   * @param  tile_dir    Tile directory.
+   * @param  graphid     GraphId (tileid and level)
+   * @param  memory_map  Whether to memory map the tile file.
    */
-  GraphTile(const std::string& tile_dir, const GraphId& graphid);
+  GraphTile(const std::string& tile_dir, const GraphId& graphid, bool memory_map = false);
 
   /**
    * Constructor given the graph Id, pointer to the tile data, and the
@@ -414,6 +422,9 @@ protected:
   // Graph tile memory, this must be shared so that we can put it into cache
   std::shared_ptr<std::vector<char>> graphtile_;
 
+  // Memory mapped graph tile file, used instead of the above when mapping
+  std::shared_ptr<midgard::mem_map<char>> memory_map_;
+
   // Header information for the tile
   GraphTileHeader* header_;
 
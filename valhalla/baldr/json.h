@@ -5,6 +5,7 @@
 #include <cinttypes>
 #include <cmath>
 #include <cstddef>
+#include <cstdio>
 #include <iomanip>
 #include <list>
 #include <memory>
@@ -173,6 +174,250 @@ inline std::ostream& operator<<(std::ostream& stream, const Jarray& json) {
   return stream;
 }
 
+/**
+ * Writes json straight into a string instead of building up a tree of maps
+ * and arrays first. Objects and arrays are opened and closed explicitly and
+ * their members are written in the order they are given. Strings and numbers
+ * are formatted just like the Jmap and Jarray output. Clearing the writer
+ * keeps the memory of its buffer so it can be reused for another document.
+ *
+ * Keys are given for the members of objects and left out for the elements of
+ * arrays, for example:
+ *   writer.start_object();
+ *   writer("type", "Point");
+ *   writer.start_array("coordinates");
+ *   writer(fp_t{lon, 6});
+ *   writer(fp_t{lat, 6});
+ *   writer.end_array();
+ *   writer.end_object();
+ */
+class Jwriter {
+public:
+  /**
+   * Constructor.
+   * @param reserve  Number of bytes to reserve in the buffer up front.
+   */
+  explicit Jwriter(size_t reserve = 1024) {
+    buffer_.reserve(reserve);
+  }
+
+  // open and close an object, either as an element or as the member with the given key
+  void start_object() {
+    element();
+    open('{');
+  }
+  void start_object(const char* key) {
+    member(key);
+    open('{');
+  }
+  void end_object() {
+    close('}');
+  }
+
+  // open and close an array, either as an element or as the member with the given key
+  void start_array() {
+    element();
+    open('[');
+  }
+  void start_array(const char* key) {
+    member(key);
+    open('[');
+  }
+  void end_array() {
+    close(']');
+  }
+
+  // write a value as the next element of the current array
+  template <class T> void operator()(const T& value) {
+    element();
+    write(value);
+  }
+
+  // write a value as the member of the current object with the given key
+  template <class T> void operator()(const char* key, const T& value) {
+    member(key);
+    write(value);
+  }
+
+  /**
+   * Get the json written so far.
+   * @return the buffer
+   */
+  const std::string& get_buffer() const {
+    return buffer_;
+  }
+
+  /**
+   * Moves the json written so far out of the writer leaving it empty.
+   * @return the json
+   */
+  std::string release() {
+    std::string json(std::move(buffer_));
+    clear();
+    return json;
+  }
+
+  /**
+   * Forget what has been written so far but keep the memory for the next document.
+   */
+  void clear() {
+    buffer_.clear();
+    separator_ = false;
+  }
+
+private:
+  // comma before anything but the first value in an object or array
+  void element() {
+    if (separator_) {
+      buffer_.push_back(',');
+    }
+    separator_ = true;
+  }
+  void member(const char* key) {
+    element();
+    write(key);
+    buffer_.push_back(':');
+  }
+  void open(char c) {
+    buffer_.push_back(c);
+    separator_ = false;
+  }
+  void close(char c) {
+    buffer_.push_back(c);
+    separator_ = true;
+  }
+
+  void write(const char* value) {
+    buffer_.push_back('"');
+    for (; *value != '\0'; ++value) {
+      escape(*value);
+    }
+    buffer_.push_back('"');
+  }
+  void write(const std::string& value) {
+    buffer_.push_back('"');
+    for (const auto& c : value) {
+      escape(c);
+    }
+    buffer_.push_back('"');
+  }
+  void write(uint64_t value) {
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    do {
+      *--begin = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    buffer_.append(begin, end);
+  }
+  void write(int64_t value) {
+    if (value < 0) {
+      buffer_.push_back('-');
+      write(static_cast<uint64_t>(0) - static_cast<uint64_t>(value));
+    } else {
+      write(static_cast<uint64_t>(value));
+    }
+  }
+  void write(const fp_t& value) {
+    bool finite = std::isfinite(value.value);
+    if (!finite) {
+      buffer_.push_back('"');
+    }
+    // the same fixed notation the stream gets in operator<<(fp_t)
+    char digits[64];
+    int length = std::snprintf(digits, sizeof(digits), "%.*Lf", static_cast<int>(value.precision),
+                               value.value);
+    if (length < static_cast<int>(sizeof(digits))) {
+      buffer_.append(digits, length);
+    } else {
+      size_t size = buffer_.size();
+      buffer_.resize(size + length + 1);
+      std::snprintf(&buffer_[size], length + 1, "%.*Lf", static_cast<int>(value.precision),
+                    value.value);
+      buffer_.resize(size + length);
+    }
+    if (!finite) {
+      buffer_.push_back('"');
+    }
+  }
+  void write(bool value) {
+    buffer_.append(value ? "true" : "false");
+  }
+  void write(std::nullptr_t) {
+    buffer_.append("null");
+  }
+  void write(const MapPtr& value) {
+    open('{');
+    for (const auto& key_value : *value) {
+      member(key_value.first.c_str());
+      boost::apply_visitor(ValueVisitor{*this}, key_value.second);
+    }
+    close('}');
+  }
+  void write(const ArrayPtr& value) {
+    open('[');
+    for (const auto& element_value : *value) {
+      element();
+      boost::apply_visitor(ValueVisitor{*this}, element_value);
+    }
+    close(']');
+  }
+
+  // the same escaping as OstreamVisitor
+  void escape(char c) {
+    switch (c) {
+      case '\\':
+        buffer_.append("\\\\");
+        break;
+      case '"':
+        buffer_.append("\\\"");
+        break;
+      case '/':
+        buffer_.append("\\/");
+        break;
+      case '\b':
+        buffer_.append("\\b");
+        break;
+      case '\f':
+        buffer_.append("\\f");
+        break;
+      case '\n':
+        buffer_.append("\\n");
+        break;
+      case '\r':
+        buffer_.append("\\r");
+        break;
+      case '\t':
+        buffer_.append("\\t");
+        break;
+      default:
+        if (c >= 0 && c < 32) {
+          static const char* hex = "0123456789ABCDEF";
+          buffer_.append("\\u00");
+          buffer_.push_back(hex[c >> 4]);
+          buffer_.push_back(hex[c & 15]);
+        } else {
+          buffer_.push_back(c);
+        }
+        break;
+    }
+  }
+
+  // so that values of a Jmap or Jarray can be written as well
+  struct ValueVisitor : public boost::static_visitor<> {
+    ValueVisitor(Jwriter& writer) : writer_(writer) {
+    }
+    template <class T> void operator()(const T& value) const {
+      writer_.write(value);
+    }
+    Jwriter& writer_;
+  };
+
+  std::string buffer_;
+  bool separator_ = false;
+};
+
 inline MapPtr map(std::initializer_list<Jmap::value_type> list) {
   return MapPtr(new Jmap(list));
 }
@@ -0,0 +1,114 @@
+#ifndef VALHALLA_BALDR_LABEL_QUEUE_H_
+#define VALHALLA_BALDR_LABEL_QUEUE_H_
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+
+namespace valhalla {
+namespace baldr {
+
+constexpr uint32_t kInvalidLabel = std::numeric_limits<uint32_t>::max();
+
+/**
+ * A callable element which returns the cost for a label.
+ */
+using LabelCost = std::function<float(const uint32_t label)>;
+
+/**
+ * Priority queue of label indexes used by the path algorithms to find the
+ * next lowest cost label to expand. The labels themselves are stored
+ * externally, the queue gets their costs using a LabelCost functor.
+ */
+class LabelQueue {
+public:
+  /**
+   * Destructor.
+   */
+  virtual ~LabelQueue() = default;
+
+  /**
+   * Empties the queue and sets it up for another search given a minimum cost,
+   * a range of costs expected to be in the queue at once, and a bucket size.
+   * Implementations keep their memory so that a queue can be reused for many
+   * searches without allocating it again.
+   * @param mincost    Minimum cost.
+   * @param range      Range of costs.
+   * @param bucketsize Bucket size (range of costs which are not sorted relative
+   *                   to each other). Must be an integer value.
+   * @param labelcost  Functor to get a cost given a label index.
+   */
+  virtual void reuse(const float mincost,
+                     const float range,
+                     const uint32_t bucketsize,
+                     const LabelCost& labelcost) = 0;
+
+  /**
+   * Clear all labels from the queue.
+   */
+  virtual void clear() = 0;
+
+  /**
+   * Adds a label index to the queue.
+   * @param   label  Label index to add to the queue.
+   */
+  virtual void add(const uint32_t label) = 0;
+
+  /**
+   * The specified label index now has a smaller cost. Reorders it in the
+   * queue. This must be called before the label's cost is changed.
+   * @param  label        Label index to reorder.
+   * @param  newcost      New sort cost.
+   */
+  virtual void decrease(const uint32_t label, const float newcost) = 0;
+
+  /**
+   * Removes the lowest cost label index from the queue.
+   * @return  Returns the label index of the lowest cost label. Returns
+   *          kInvalidLabel if the queue is empty.
+   */
+  virtual uint32_t pop() = 0;
+};
+
+/**
+ * The kinds of label queue which can be used
+ */
+enum class LabelQueueType : uint8_t {
+  kDoubleBucket = 0, // Fixed range of buckets with an overflow bucket
+  kRadix = 1         // Radix heap, no fixed range
+};
+
+/**
+ * Creates label queues.
+ */
+class LabelQueueFactory final {
+  LabelQueueFactory() = delete;
+
+public:
+  /**
+   * Get the type of label queue given its name in the configuration.
+   * @param name  Either "double_bucket" or "radix".
+   * @return Returns the type. Throws if the name is not known.
+   */
+  static LabelQueueType type(const std::string& name);
+
+  /**
+   * Constructs a label queue.
+   * @param type       The kind of queue.
+   * @param mincost    Minimum cost.
+   * @param range      Range of costs.
+   * @param bucketsize Bucket size.
+   * @param labelcost  Functor to get a cost given a label index.
+   */
+  static LabelQueue* createLabelQueue(const LabelQueueType type,
+                                      const float mincost,
+                                      const float range,
+                                      const uint32_t bucketsize,
+                                      const LabelCost& labelcost);
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_LABEL_QUEUE_H_
@@ -0,0 +1,233 @@
+#ifndef VALHALLA_BALDR_RADIX_QUEUE_H_
+#define VALHALLA_BALDR_RADIX_QUEUE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <valhalla/baldr/label_queue.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Radix heap - a monotone priority queue. Costs are quantized to integer
+ * keys by the bucket size, the same granularity the double bucket queue
+ * sorts to. Bucket i holds the keys which first differ from the last popped
+ * key in bit i - 1, so the buckets cover exponentially growing ranges of
+ * keys above the last popped key. When the lowest bucket is empty the next
+ * non-empty bucket is redistributed into the lower buckets. Each label moves
+ * down at most once per bit, so there is no fixed cost range and no overflow
+ * bucket to re-sort.
+ *
+ * The position of each label within its bucket is stored so that a label
+ * is removed in constant time when its cost is decreased. Like the double
+ * bucket queue, costs below the last popped cost are treated as equal to it.
+ */
+class RadixQueue : public LabelQueue {
+public:
+  /**
+   * Constructor given a minimum cost, a range of costs and a bucket size.
+   * @param mincost    Minimum cost. Lower costs are sorted as this cost.
+   * @param range      Range of costs. Unused since the queue has no fixed
+   *                   range but it must still be greater than 0.
+   * @param bucketsize Bucket size (range of costs within the same key).
+   *                   Must be an integer value.
+   * @param labelcost  Functor to get a cost given a label index.
+   */
+  RadixQueue(const float mincost,
+             const float range,
+             const uint32_t bucketsize,
+             const LabelCost& labelcost) {
+    reuse(mincost, range, bucketsize, labelcost);
+  }
+
+  /**
+   * Empties the queue and sets it up for another search. The buckets and
+   * label positions keep their memory.
+   * @param mincost    Minimum cost. Lower costs are sorted as this cost.
+   * @param range      Range of costs. Must be greater than 0.
+   * @param bucketsize Bucket size (range of costs within the same key).
+   *                   Must be an integer value.
+   * @param labelcost  Functor to get a cost given a label index.
+   */
+  void reuse(const float mincost,
+             const float range,
+             const uint32_t bucketsize,
+             const LabelCost& labelcost) override {
+    // We need at least a bucketsize of 1 or more
+    if (bucketsize < 1) {
+      throw std::runtime_error("Bucketsize must be 1 or greater");
+    }
+
+    // We need at least a bucketrange of something larger than 0
+    if (range <= 0.f) {
+      throw std::runtime_error("Bucketrange must be greater than 0");
+    }
+
+    inv_ = 1.0f / static_cast<float>(bucketsize);
+    lastkey_ = 0;
+    minkey_ = key(mincost);
+    labelcost_ = labelcost;
+    clear();
+  }
+
+  /**
+   * Clear all labels from the queue.
+   */
+  void clear() override {
+    for (auto& bucket : buckets_) {
+      bucket.clear();
+    }
+    lastkey_ = minkey_;
+  }
+
+  /**
+   * Adds a label index to the queue.
+   * @param   label  Label index to add to the queue.
+   */
+  void add(const uint32_t label) override {
+    if (label >= positions_.size()) {
+      positions_.resize(std::max(static_cast<size_t>(label) + 1, positions_.size() * 2));
+    }
+    push(label, key(labelcost_(label)));
+  }
+
+  /**
+   * The specified label index now has a smaller cost. Moves it to the bucket
+   * of the new cost.
+   * @param  label        Label index to reorder.
+   * @param  newcost      New sort cost.
+   */
+  void decrease(const uint32_t label, const float newcost) override {
+    const uint32_t newkey = key(newcost);
+    const position_t position = positions_[label];
+    if (bucket(newkey) == position.bucket) {
+      buckets_[position.bucket][position.index].key = newkey;
+      return;
+    }
+
+    // Swap the last label of the bucket into the place of this one
+    auto& entries = buckets_[position.bucket];
+    entries[position.index] = entries.back();
+    positions_[entries.back().label].index = position.index;
+    entries.pop_back();
+    push(label, newkey);
+  }
+
+  /**
+   * Removes the lowest cost label index from the queue.
+   * @return  Returns the label index of the lowest cost label. Returns
+   *          kInvalidLabel if the queue is empty.
+   */
+  uint32_t pop() override {
+    if (buckets_[0].empty()) {
+      // Find the first non-empty bucket, there is nothing left if none is found
+      auto itr = std::find_if(buckets_.begin() + 1, buckets_.end(),
+                              [](const bucket_t& bucket) { return !bucket.empty(); });
+      if (itr == buckets_.end()) {
+        return kInvalidLabel;
+      }
+
+      // Its lowest key becomes the last popped key. All of its labels then
+      // differ from it in a lower bit so they move to lower buckets.
+      lastkey_ = std::min_element(itr->begin(), itr->end(),
+                                  [](const entry_t& a, const entry_t& b) { return a.key < b.key; })
+                     ->key;
+      for (const auto& entry : *itr) {
+        push(entry.label, entry.key);
+      }
+      itr->clear();
+    }
+
+    // Return a label with the lowest key
+    uint32_t label = buckets_[0].back().label;
+    buckets_[0].pop_back();
+    return label;
+  }
+
+private:
+  // Number of buckets: one for the last popped key and one per bit of the key
+  static constexpr size_t kBucketCount = 33;
+
+  // A label and its key
+  struct entry_t {
+    uint32_t key;
+    uint32_t label;
+  };
+  using bucket_t = std::vector<entry_t>;
+
+  // The bucket a label is in and where it is within the bucket
+  struct position_t {
+    uint32_t bucket;
+    uint32_t index;
+  };
+
+  float inv_;        // 1/bucketsize (so we can avoid division)
+  uint32_t minkey_;  // Key of the minimum cost
+  uint32_t lastkey_; // Key of the label last popped
+
+  // Buckets of labels
+  std::array<bucket_t, kBucketCount> buckets_;
+
+  // Position of each label, indexed by label
+  std::vector<position_t> positions_;
+
+  // Cost function to get cost given the label index.
+  LabelCost labelcost_;
+
+  /**
+   * Returns the key of a cost, never less than the last popped key.
+   * @param  cost  Cost.
+   * @return Returns the key.
+   */
+  uint32_t key(const float cost) const {
+    const float k = cost * inv_;
+    if (k >= static_cast<float>(std::numeric_limits<uint32_t>::max())) {
+      return std::numeric_limits<uint32_t>::max();
+    }
+    return std::max(k > 0.f ? static_cast<uint32_t>(k) : 0, lastkey_);
+  }
+
+  /**
+   * Returns the bucket of a key: 0 if it is the last popped key otherwise
+   * one more than the highest bit in which it differs from it.
+   * @param  key  Key, not less than the last popped key.
+   * @return Returns the bucket index.
+   */
+  uint32_t bucket(const uint32_t key) const {
+    if (key == lastkey_) {
+      return 0;
+    }
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanReverse(&bit, key ^ lastkey_);
+    return bit + 1;
+#else
+    return 32 - __builtin_clz(key ^ lastkey_);
+#endif
+  }
+
+  /**
+   * Adds a label to the bucket of its key and records where it is.
+   * @param  label  Label index.
+   * @param  key    Key of the label.
+   */
+  void push(const uint32_t label, const uint32_t key) {
+    const uint32_t b = bucket(key);
+    positions_[label] = {b, static_cast<uint32_t>(buckets_[b].size())};
+    buckets_[b].push_back({key, label});
+  }
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_RADIX_QUEUE_H_
@@ -0,0 +1,117 @@
+#ifndef VALHALLA_BALDR_TILE_PREFETCHER_H_
+#define VALHALLA_BALDR_TILE_PREFETCHER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+
+namespace valhalla {
+namespace baldr {
+
+/**
+ * Loads tiles from the tile directory on a pool of background threads before
+ * they are needed. Loaded tiles are held until the owner takes them, the
+ * owner then caches them like any tile it loaded itself. Only a limited
+ * number of tiles is held, when there is no room left the tiles requested
+ * the longest time ago which are not being loaded are dropped.
+ * Prefetch, Take and Clear must be called from the thread which owns it.
+ */
+class TilePrefetcher {
+public:
+  /**
+   * Constructor. Starts the threads.
+   * @param tile_dir      directory to load the tiles from
+   * @param memory_map    whether to memory map uncompressed tiles
+   * @param thread_count  number of threads loading tiles
+   * @param max_tiles     maximum number of tiles to request and hold
+   */
+  TilePrefetcher(const std::string& tile_dir,
+                 bool memory_map,
+                 size_t thread_count,
+                 size_t max_tiles);
+
+  /**
+   * Destructor. Stops the threads, tiles being loaded are discarded.
+   */
+  ~TilePrefetcher();
+
+  TilePrefetcher(const TilePrefetcher&) = delete;
+  TilePrefetcher& operator=(const TilePrefetcher&) = delete;
+
+  /**
+   * Requests a tile to be loaded in the background. Does nothing if it was
+   * already requested.
+   * @param graphid  the graphid of the tile
+   */
+  void Prefetch(const GraphId& graphid);
+
+  /**
+   * Takes a tile which was requested, waiting for it if it is being loaded.
+   * A tile which no thread has started on yet is no longer requested.
+   * @param graphid  the graphid of the tile
+   * @param tile     set to the loaded tile, which has no header if the file
+   *                 was not found
+   * @return true if the tile was loaded, otherwise the caller has to load it
+   */
+  bool Take(const GraphId& graphid, GraphTile& tile);
+
+  /**
+   * Drops all the requested and loaded tiles.
+   */
+  void Clear();
+
+  /**
+   * Gets the number of tiles requested and not yet taken.
+   * @return the number of tiles
+   */
+  size_t size() const;
+
+protected:
+  enum class State : uint8_t { kQueued, kLoading, kLoaded };
+
+  struct entry_t {
+    State state;
+    uint64_t sequence;
+    GraphTile tile;
+  };
+
+  /**
+   * Loads the requested tiles until the prefetcher is destroyed.
+   */
+  void Load();
+
+  /**
+   * Drops the tile requested the longest time ago which is not being loaded.
+   * @return true if a tile was dropped
+   */
+  bool Evict();
+
+  std::string tile_dir_;
+  bool memory_map_;
+  size_t max_tiles_;
+
+  // Requested tiles by id and the order in which they should be loaded. The
+  // queue may still have ids which were taken or dropped, they are skipped.
+  std::unordered_map<GraphId, entry_t> tiles_;
+  std::deque<GraphId> queue_;
+  uint64_t sequence_;
+  bool stop_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable requested_;
+  std::condition_variable loaded_;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace baldr
+} // namespace valhalla
+
+#endif // VALHALLA_BALDR_TILE_PREFETCHER_H_
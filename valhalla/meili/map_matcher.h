@@ -16,6 +16,7 @@
 #include <valhalla/meili/routing.h>
 #include <valhalla/meili/state.h>
 #include <valhalla/meili/topk_search.h>
+#include <valhalla/meili/transition_cache.h>
 #include <valhalla/meili/transition_cost_model.h>
 #include <valhalla/midgard/pointll.h>
 
@@ -29,7 +30,9 @@ public:
              baldr::GraphReader& graphreader,
              CandidateQuery& candidatequery,
              const sif::cost_ptr_t* mode_costing,
-             sif::TravelMode travelmode);
+             sif::TravelMode travelmode,
+             TransitionCache* transition_cache = nullptr,
+             uint64_t costing_hash = 0);
 
   ~MapMatcher();
 
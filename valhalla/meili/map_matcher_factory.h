@@ -14,6 +14,7 @@
 
 #include <valhalla/meili/candidate_search.h>
 #include <valhalla/meili/map_matcher.h>
+#include <valhalla/meili/transition_cache.h>
 
 namespace valhalla {
 namespace meili {
@@ -32,6 +33,12 @@ public:
     return candidatequery_;
   }
 
+  // Paths routed between candidates which the matchers share, it has a
+  // maximum size of 0 if they are not cached
+  TransitionCache& transitioncache() {
+    return transition_cache_;
+  }
+
   MapMatcher* Create(const std::string& name) {
     return Create(name, boost::property_tree::ptree());
   }
@@ -65,6 +72,8 @@ private:
 
   float max_grid_cache_size_;
 
+  TransitionCache transition_cache_;
+
   sif::cost_ptr_t get_costing(const boost::property_tree::ptree& request, const std::string& costing);
 };
 
@@ -9,9 +9,11 @@
 #include <vector>
 
 #include <valhalla/baldr/double_bucket_queue.h>
+#include <valhalla/baldr/flat_id_map.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/baldr/pathlocation.h>
+#include <valhalla/meili/transition_cache.h>
 #include <valhalla/midgard/distanceapproximator.h>
 #include <valhalla/sif/costconstants.h>
 #include <valhalla/sif/dynamiccost.h>
@@ -177,12 +179,11 @@ public:
    */
   void put(const baldr::GraphId& nodeid, const sif::TravelMode mode, const Label* edgelabel) {
     // Do not add a duplicate origin label for the same node
-    if (node_status_.find(nodeid) == node_status_.end()) {
+    const uint32_t idx = labels_.size();
+    if (node_status_.emplace(nodeid.value, idx).second) {
       // If edgelabel is not null, append it to the label set otherwise append
       // a dummy. In both cases add the label to the priority queue and set its
       // predecessor to kInvalidLabel
-      const uint32_t idx = labels_.size();
-      node_status_.emplace(nodeid, idx);
       labels_.emplace_back(edgelabel ? *edgelabel : Label());
       labels_.back().InitAsOrigin(mode, kInvalidDestination, nodeid);
       queue_->add(idx);
@@ -217,6 +218,17 @@ public:
            const baldr::DirectedEdge* edge,
            const sif::TravelMode mode);
 
+  /**
+   * Add a label without queueing it, e.g. a label of a path which was found
+   * by an earlier search.
+   * @param label  Label to add. Its predecessor must already be in the set.
+   * @return  Returns the index of the label.
+   */
+  uint32_t append(const Label& label) {
+    labels_.push_back(label);
+    return labels_.size() - 1;
+  }
+
   /**
    * Get the next label from the priority queue. Marks the popped label
    * as permanent (best path found).
@@ -249,10 +261,10 @@ public:
   }
 
 private:
-  std::shared_ptr<baldr::DoubleBucketQueue> queue_;        // Priority queue
-  std::unordered_map<baldr::GraphId, Status> node_status_; // Node status
-  std::unordered_map<uint16_t, Status> dest_status_;       // Destination status
-  std::vector<Label> labels_;                              // Label list.
+  std::shared_ptr<baldr::DoubleBucketQueue> queue_;  // Priority queue
+  baldr::FlatIdMap<Status> node_status_;             // Node status
+  std::unordered_map<uint16_t, Status> dest_status_; // Destination status
+  std::vector<Label> labels_;                        // Label list.
 };
 
 using labelset_ptr_t = std::shared_ptr<LabelSet>;
@@ -273,6 +285,47 @@ find_shortest_path(baldr::GraphReader& reader,
                    const float max_dist,
                    const float max_time);
 
+/**
+ * Get the cost of going from the origin to the end node of one of its edges
+ * the way find_shortest_path does from the origin label.
+ * @return  Returns false if the end node is not reached within the limits.
+ */
+bool leave_origin(baldr::GraphReader& reader,
+                  const baldr::PathLocation::PathEdge& origin,
+                  const Label& origin_label,
+                  sif::cost_ptr_t costing,
+                  const float turn_cost_table[181],
+                  const float max_dist,
+                  const float max_time,
+                  sif::Cost& cost,
+                  float& turn_cost);
+
+// Outcome of following a path found by an earlier search
+enum class PathStatus : uint8_t {
+  kReached,     // the destination was reached within the limits
+  kUnreachable, // no path reaches the destination within the limits
+  kUnknown      // only a new search can tell
+};
+
+/**
+ * Add the labels of a path from an origin edge to a destination edge which was
+ * found by an earlier search, computing the costs the way find_shortest_path
+ * would from the origin label. The path is not needed if the destination is
+ * ahead of the origin on the same edge.
+ */
+PathStatus follow_path(baldr::GraphReader& reader,
+                       const baldr::PathLocation::PathEdge& origin,
+                       const baldr::PathLocation::PathEdge& destination,
+                       const uint16_t dest,
+                       const TransitionCache::path_t* path,
+                       labelset_ptr_t labelset,
+                       const uint32_t origin_label_idx,
+                       sif::cost_ptr_t costing,
+                       const float turn_cost_table[181],
+                       const float max_dist,
+                       const float max_time,
+                       uint32_t& label_idx);
+
 // Route path iterator. Methods to assist recovering route paths from Labels.
 class RoutePathIterator : public std::iterator<std::forward_iterator_tag, const Label> {
 public:
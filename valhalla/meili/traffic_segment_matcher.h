@@ -3,7 +3,9 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <cstdint>
+#include <functional>
 #include <list>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -64,6 +66,31 @@ public:
    */
   virtual std::string match(const std::string& json);
 
+  /**
+   * Matches a stream of GPS traces on a pool of threads. Each thread has its
+   * own matchers but they all share one tile cache. The results are handed
+   * back in the order of the traces. A trace which can't be matched gives
+   * back {"error":"<reason>"} instead of its segments.
+   * @param  next         Sets the next GPS trace as JSON, returns false when
+   *                      there are no more traces.
+   * @param  emit         Takes the result of each trace as JSON.
+   * @param  concurrency  Number of threads matching traces. Both callbacks
+   *                      are only called from the calling thread but the
+   *                      virtual methods below are called from all of them.
+   */
+  void match_batch(const std::function<bool(std::string&)>& next,
+                   const std::function<void(const std::string&)>& emit,
+                   const uint32_t concurrency);
+
+  /**
+   * Matches many GPS traces on a pool of threads, see above.
+   * @param   jsons        GPS traces as JSON.
+   * @param   concurrency  Number of threads matching traces.
+   * @return  Returns the result of each trace in the order of the traces.
+   */
+  std::vector<std::string> match_batch(const std::vector<std::string>& jsons,
+                                       const uint32_t concurrency);
+
   /**
    * Parses the input to the traffic matcher, mainly the trace array
    * @param  request request with data {"trace":[{"lat":0,"lon":0,time:0},...]}
@@ -81,6 +108,14 @@ public:
   static std::string serialize(const std::vector<traffic_segment_t>& traffic_segments);
 
 protected:
+  /**
+   * Matches the GPS trace using the matchers of the given factory.
+   * @param   json     GPS trace as JSON.
+   * @param   factory  Makes the matcher for the trace.
+   * @return  Returns the traffic segments as JSON.
+   */
+  std::string match_trace(const std::string& json, MapMatcherFactory& factory) const;
+
   /**
    * Updates the matching results include the begin and end points of the edges on the path
    * in doing so it interpolates the times at those points and gives back a distance along
@@ -121,6 +156,11 @@ protected:
 
   valhalla::meili::MapMatcherFactory matcher_factory;
   std::unordered_set<std::string> customizable;
+
+  // Config of the factories used by the threads of a batch, which share their
+  // tile cache, and the factories themselves which are kept between batches
+  boost::property_tree::ptree batch_config;
+  std::vector<std::unique_ptr<valhalla::meili::MapMatcherFactory>> batch_factories;
 };
 
 } // namespace meili
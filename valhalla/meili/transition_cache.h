@@ -0,0 +1,140 @@
+// -*- mode: c++ -*-
+#ifndef MMP_TRANSITION_CACHE_H_
+#define MMP_TRANSITION_CACHE_H_
+#include <cstdint>
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace meili {
+
+/**
+ * Cache of the shortest paths routed between the edges of map-matching
+ * candidates. A path is kept from the end node of the origin edge to the
+ * begin node of the destination edge, so it can be reused wherever the
+ * candidates are along those edges and whatever edge was matched before the
+ * origin. Paths are keyed by the costing that found them. The least recently
+ * used paths are evicted to stay within the maximum number of paths. It is
+ * thread-safe so one cache can be shared by all the matchers of a factory.
+ */
+class TransitionCache {
+public:
+  struct key_t {
+    baldr::GraphId origin;
+    baldr::GraphId destination;
+    uint64_t costing;
+
+    bool operator==(const key_t& other) const {
+      return origin == other.origin && destination == other.destination &&
+             costing == other.costing;
+    }
+  };
+
+  struct path_t {
+    // Whether a path was found. If not, no path reached the destination edge
+    // within the limits of the search.
+    bool found;
+
+    // Lower bound of the cost from the end of the origin edge to the begin of
+    // the destination edge when no path was found
+    float min_cost;
+
+    // Edges between the origin edge and the destination edge when a path was
+    // found. Transition edges are not included.
+    std::vector<baldr::GraphId> edges;
+  };
+
+  /**
+   * Constructor.
+   * @param max_size  Maximum number of paths to keep.
+   */
+  explicit TransitionCache(const size_t max_size);
+
+  /**
+   * Get a path. The path becomes the most recently used one.
+   * @param key   Origin edge, destination edge and costing of the path.
+   * @param path  Set to the path if it is cached.
+   * @return Returns true if the path is cached.
+   */
+  bool Get(const key_t& key, path_t& path);
+
+  /**
+   * Put a path as the most recently used one, replacing any path with the
+   * same key and evicting the least recently used path if the cache is full.
+   * @param key   Origin edge, destination edge and costing of the path.
+   * @param path  Path to keep.
+   */
+  void Put(const key_t& key, const path_t& path);
+
+  /**
+   * Drop all the paths, e.g. when the tiles they were found in are reloaded.
+   * The hit and miss counts are kept.
+   */
+  void Clear();
+
+  /**
+   * Get the number of cached paths.
+   * @return Returns the number of cached paths.
+   */
+  size_t size() const;
+
+  /**
+   * Get the maximum number of paths to keep.
+   * @return Returns the maximum number of paths.
+   */
+  size_t max_size() const {
+    return max_size_;
+  }
+
+  /**
+   * Get the number of times Get found a path.
+   * @return Returns the number of hits.
+   */
+  uint64_t hits() const;
+
+  /**
+   * Get the number of times Get did not find a path.
+   * @return Returns the number of misses.
+   */
+  uint64_t misses() const;
+
+  /**
+   * Get the fraction of Get calls which found a path.
+   * @return Returns the hit rate or 0 if Get was never called.
+   */
+  float hit_rate() const;
+
+protected:
+  struct key_hash_t {
+    size_t operator()(const key_t& key) const {
+      size_t seed = std::hash<uint64_t>()(key.origin.value);
+      seed ^= std::hash<uint64_t>()(key.destination.value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      seed ^= std::hash<uint64_t>()(key.costing) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      return seed;
+    }
+  };
+
+  using entry_t = std::pair<key_t, path_t>;
+
+  size_t max_size_;
+
+  // Most recently used paths are at the front of the list
+  std::list<entry_t> entries_;
+
+  // Lookup into the list by key
+  std::unordered_map<key_t, std::list<entry_t>::iterator, key_hash_t> index_;
+
+  uint64_t hits_;
+  uint64_t misses_;
+
+  mutable std::mutex mutex_;
+};
+
+} // namespace meili
+} // namespace valhalla
+#endif // MMP_TRANSITION_CACHE_H_
@@ -7,6 +7,7 @@
 #include <valhalla/meili/measurement.h>
 #include <valhalla/meili/state.h>
 #include <valhalla/meili/topk_search.h>
+#include <valhalla/meili/transition_cache.h>
 #include <valhalla/meili/viterbi_search.h>
 #include <valhalla/sif/dynamiccost.h>
 
@@ -50,9 +51,30 @@ public:
 
   float operator()(const StateId& lhs, const StateId& rhs) const;
 
+  /**
+   * Reuse the paths routed between candidate edges from a cache and put the
+   * paths routed here into it.
+   * @param cache         Cache shared with other matchers or nullptr for none.
+   * @param costing_hash  Hash of the costing and its options which tells
+   *                      apart the paths of different costings in the cache.
+   */
+  void set_cache(TransitionCache* cache, const uint64_t costing_hash) {
+    cache_ = cache;
+    costing_hash_ = costing_hash;
+  }
+
 private:
   void UpdateRoute(const StateId& lhs, const StateId& rhs) const;
 
+  std::unordered_map<uint16_t, uint32_t>
+  UpdateRouteFromCache(const std::vector<baldr::PathLocation>& locations,
+                       const labelset_ptr_t& labelset,
+                       const midgard::DistanceApproximator& approximator,
+                       const float search_radius,
+                       const Label* edgelabel,
+                       const float max_route_distance,
+                       const float max_route_time) const;
+
   float ClockDistance(const StateId::Time& lhs, const StateId::Time& rhs) const {
     double clk_dist = -1.0;
 
@@ -90,6 +112,10 @@ private:
 
   // Cost for each degree in [0, 180]
   float turn_cost_table_[181];
+
+  // Paths routed between candidate edges, if caching them
+  TransitionCache* cache_;
+  uint64_t costing_hash_;
 };
 
 } // namespace meili
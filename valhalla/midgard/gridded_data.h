@@ -1,9 +1,11 @@
 #ifndef VALHALLA_MIDGARD_GRIDDEDDATA_H_
 #define VALHALLA_MIDGARD_GRIDDEDDATA_H_
 
+#include <cstdint>
 #include <limits>
 #include <list>
 #include <map>
+#include <utility>
 #include <valhalla/midgard/tiles.h>
 #include <vector>
 
@@ -56,6 +58,24 @@ public:
    */
   bool SetIfLessThan(const coord_t& pt, const float value);
 
+  /**
+   * Set the value at each grid location the segment uv passes through if the
+   * value is less than the current value set at the grid location. Marks the
+   * same locations as Intersect does for the segment but without allocating.
+   * @param  u      Start of the segment.
+   * @param  v      End of the segment.
+   * @param  value  Value to set at the tile/grid locations.
+   */
+  void SetIfLessThan(const coord_t& u, const coord_t& v, const float value);
+
+  /**
+   * Set the value at each grid location to the value of the other gridded data
+   * at the same location if it is less than the current value. The other data
+   * must have the same tiles.
+   * @param  other  Gridded data to take the lesser values from.
+   */
+  void SetIfLessThan(const GriddedData<coord_t>& other);
+
   /**
    * Get the array of data.
    * @return  Returns the data associated with the tiles.
@@ -81,17 +101,36 @@ public:
    * @param generalize           Generalization factor in meters. A special value
    *                             kOptimalGeneralization will let the method choose
    *                             an optimal generalization factor based on grid size.
+   * @param concurrency          number of threads tracing the contours, each thread
+   *                             traces whole contours so the result does not depend on it
    *
    * @return contour line geometries with the larger intervals first (for rendering purposes)
    */
   contours_t GenerateContours(const std::vector<float>& contour_intervals,
                               const bool rings_only = false,
                               const float denoise = 1.f,
-                              const float generalize = 200.f) const;
+                              const float generalize = 200.f,
+                              const uint32_t concurrency = 1) const;
 
 protected:
   float max_value_;         // Maximum value stored in the tile
   std::vector<float> data_; // Data value within each tile
+
+  /**
+   * Generate the contour lines of a single contour value, see GenerateContours.
+   * @param contour     the value at which the contour lines occur
+   * @param row_ranges  the lowest and highest value of each row and the row above it
+   * @param rings_only  only include geometry of contours that are polygonal
+   * @param denoise     remove any contours whose size ratio is less than this
+   * @param gen_factor  generalization factor in meters
+   * @param features    the features of the contour, holding one empty feature
+   */
+  void GenerateContour(const float contour,
+                       const std::vector<std::pair<float, float>>& row_ranges,
+                       const bool rings_only,
+                       const float denoise,
+                       const float gen_factor,
+                       std::list<feature_t>& features) const;
 };
 
 } // namespace midgard
@@ -5,6 +5,7 @@
 #include <cerrno>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -14,8 +15,10 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -112,9 +115,12 @@ public:
   }
 
   // construct with file
-  mem_map(const std::string& file_name, size_t size, int advice = POSIX_MADV_NORMAL)
+  mem_map(const std::string& file_name,
+          size_t size,
+          int advice = POSIX_MADV_NORMAL,
+          bool copy_on_write = false)
       : ptr(nullptr), count(0), file_name("") {
-    map(file_name, size, advice);
+    map(file_name, size, advice, copy_on_write);
   }
 
   // unmap when done
@@ -122,8 +128,13 @@ public:
     unmap();
   }
 
-  // reset to another file or another size
-  void map(const std::string& new_file_name, size_t new_count, int advice = POSIX_MADV_NORMAL) {
+  // reset to another file or another size. copy on write maps the file read only such that the
+  // pages are shared with every other process mapping it until they are written to, which then
+  // happens to a private copy and never makes it back to the file
+  void map(const std::string& new_file_name,
+           size_t new_count,
+           int advice = POSIX_MADV_NORMAL,
+           bool copy_on_write = false) {
     // just in case there was already something
     unmap();
 
@@ -131,16 +142,24 @@ public:
     if (new_count > 0) {
       auto fd =
 #if defined(_MSC_VER)
-          _open(new_file_name.c_str(), O_RDWR, 0);
+          _open(new_file_name.c_str(), copy_on_write ? O_RDONLY : O_RDWR, 0);
 #else
-          open(new_file_name.c_str(), O_RDWR, 0);
+          open(new_file_name.c_str(), copy_on_write ? O_RDONLY : O_RDWR, 0);
 #endif
       if (fd == -1) {
         throw std::runtime_error(new_file_name + "(open): " + strerror(errno));
       }
-      ptr = mmap(nullptr, new_count * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ptr = mmap(nullptr, new_count * sizeof(T), PROT_READ | PROT_WRITE,
+                 copy_on_write ? MAP_PRIVATE : MAP_SHARED, fd, 0);
       if (ptr == MAP_FAILED) {
-        throw std::runtime_error(new_file_name + "(mmap): " + strerror(errno));
+        auto error = errno;
+        ptr = nullptr;
+#if defined(_MSC_VER)
+        _close(fd);
+#else
+        close(fd);
+#endif
+        throw std::runtime_error(new_file_name + "(mmap): " + strerror(error));
       }
 
 #if defined(_MSC_VER)
@@ -268,19 +287,102 @@ public:
     return npos;
   }
 
-  // sort the file based on the predicate
+  // sort the file based on the predicate. if the file fits in the buffer it is sorted in place,
+  // otherwise buffer sized runs of it are sorted and written to temporary files which are then
+  // merged back into this file. either way the in memory sorting is split over threads. the sort
+  // is stable so the result does not depend on the number of threads or the buffer size
   void sort(const std::function<bool(const T&, const T&)>& predicate,
+            size_t threads = 1,
             size_t buffer_size = 1024 * 1024 * 512 / sizeof(T)) {
-    using queue_t =
-        std::map<T, std::list<std::fstream>::iterator, std::function<bool(const T&, const T&)>>;
-
     flush();
     // if no elements we are done
     if (memmap.size() == 0) {
       return;
     }
-    std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate);
-    return;
+    buffer_size = std::max(buffer_size, static_cast<size_t>(1));
+    threads = std::max(threads, static_cast<size_t>(1));
+
+    // small enough to do in memory
+    T* data = static_cast<T*>(memmap);
+    if (memmap.size() <= buffer_size) {
+      sort_in_memory(data, data + memmap.size(), predicate, threads);
+      return;
+    }
+
+    // sort each run and put it into its own file, one sequential read and write of the data
+    std::vector<std::string> run_names;
+    try {
+      std::vector<T> buffer;
+      for (size_t i = 0; i < memmap.size(); i += buffer_size) {
+        buffer.assign(data + i, data + std::min(i + buffer_size, memmap.size()));
+        sort_in_memory(buffer.data(), buffer.data() + buffer.size(), predicate, threads);
+        run_names.push_back(file_name + ".run" + std::to_string(run_names.size()));
+        std::ofstream run(run_names.back(), std::ios_base::binary | std::ios_base::trunc);
+        run.write(static_cast<const char*>(static_cast<const void*>(buffer.data())),
+                  buffer.size() * sizeof(T));
+        if (!run) {
+          throw std::runtime_error(run_names.back() + ": " + strerror(errno));
+        }
+      }
+      buffer.clear();
+      buffer.shrink_to_fit();
+
+      // each run gets an equal share of the buffer to read through its file with
+      struct run_t {
+        std::ifstream file;
+        std::vector<char> buffer;
+        size_t index;
+      };
+      std::vector<run_t> runs(run_names.size());
+      size_t run_buffer_size = std::max(buffer_size / runs.size(), static_cast<size_t>(1));
+      auto next = [run_buffer_size](run_t& run) -> const T* {
+        if (run.index == run.buffer.size()) {
+          run.buffer.resize(run_buffer_size * sizeof(T));
+          run.file.read(run.buffer.data(), run.buffer.size());
+          run.buffer.resize(run.file.gcount() - run.file.gcount() % sizeof(T));
+          run.index = 0;
+          if (run.buffer.empty()) {
+            return nullptr;
+          }
+        }
+        run.index += sizeof(T);
+        return static_cast<const T*>(static_cast<const void*>(&run.buffer[run.index - sizeof(T)]));
+      };
+
+      // merge the runs back into the file by repeatedly taking the smallest element from the front
+      // of all the runs. ties go to the earlier run so the merge itself is stable
+      using head_t = std::pair<T, size_t>;
+      auto greater = [&predicate](const head_t& a, const head_t& b) {
+        return predicate(b.first, a.first) || (!predicate(a.first, b.first) && b.second < a.second);
+      };
+      std::priority_queue<head_t, std::vector<head_t>, decltype(greater)> heads(greater);
+      for (size_t i = 0; i < runs.size(); ++i) {
+        runs[i].file.open(run_names[i], std::ios_base::binary);
+        if (!runs[i].file) {
+          throw std::runtime_error(run_names[i] + ": " + strerror(errno));
+        }
+        runs[i].index = 0;
+        if (const T* element = next(runs[i])) {
+          heads.emplace(*element, i);
+        }
+      }
+      while (!heads.empty()) {
+        head_t head = heads.top();
+        heads.pop();
+        *data++ = head.first;
+        if (const T* element = next(runs[head.second])) {
+          heads.emplace(*element, head.second);
+        }
+      }
+    } catch (...) {
+      for (const auto& run_name : run_names) {
+        std::remove(run_name.c_str());
+      }
+      throw;
+    }
+    for (const auto& run_name : run_names) {
+      std::remove(run_name.c_str());
+    }
   }
 
   // perform an volatile operation on all the items of this sequence
@@ -465,6 +567,57 @@ public:
   }
 
 protected:
+  // sort a range by splitting it into one chunk per thread, sorting those in parallel and then
+  // merging neighbouring chunks in parallel until there is only one left. the chunks are sorted
+  // and merged stably so equal elements keep their order no matter how many threads there are
+  static void sort_in_memory(T* first,
+                             T* last,
+                             const std::function<bool(const T&, const T&)>& predicate,
+                             size_t threads) {
+    // not worth the threads for only a few elements
+    size_t count = last - first;
+    threads = std::min(threads, count / 4096 + 1);
+    if (threads < 2) {
+      std::stable_sort(first, last, predicate);
+      return;
+    }
+
+    // sort the chunks
+    std::vector<T*> bounds;
+    for (size_t i = 0; i < threads; ++i) {
+      bounds.push_back(first + count * i / threads);
+    }
+    bounds.push_back(last);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+      workers.emplace_back([&bounds, &predicate, i]() {
+        std::stable_sort(bounds[i], bounds[i + 1], predicate);
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    // merge pairs of chunks until there is only one
+    while (bounds.size() > 2) {
+      workers.clear();
+      std::vector<T*> merged;
+      for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+        merged.push_back(bounds[i]);
+        if (i + 2 < bounds.size()) {
+          workers.emplace_back([&bounds, &predicate, i]() {
+            std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], predicate);
+          });
+        }
+      }
+      merged.push_back(last);
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      bounds.swap(merged);
+    }
+  }
+
   std::shared_ptr<std::fstream> file;
   std::string file_name;
   std::vector<T> write_buffer;
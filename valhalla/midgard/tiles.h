@@ -292,6 +292,20 @@ public:
   std::unordered_map<int32_t, std::unordered_set<unsigned short>>
   Intersect(const container_t& line_string) const;
 
+  /**
+   * Rasterize the segment uv into the sub cells of the tiles. Finds the same sub cells as
+   * Intersect does for the linestring uv but hands them to the functor instead of collecting
+   * them, so nothing is allocated unless the segment has to be resampled along the sphere.
+   * @param u          the start of the segment
+   * @param v          the end of the segment
+   * @param set_pixel  called with the global column and row of each sub cell the segment
+   *                   crosses, possibly more than once. Returns true if the sub cell is outside
+   *                   of the tiles
+   */
+  void Rasterize(const coord_t& u,
+                 const coord_t& v,
+                 const std::function<bool(int32_t, int32_t)>& set_pixel) const;
+
   /**
    * Intersect the bounding box with the tiles to see which tiles and sub-cells
    * (a.k.a bins) it intersects with. This can be used to reduce the number of
@@ -332,6 +346,16 @@ protected:
   unsigned short nsubdivisions_;
 
   float subdivision_size_;
+
+  /**
+   * Rasterize the segment uv into the sub cells of the tiles without resampling it.
+   * @param u          the start of the segment
+   * @param v          the end of the segment
+   * @param set_pixel  called with the global column and row of each sub cell the segment crosses
+   */
+  void RasterizeSegment(const coord_t& u,
+                        const coord_t& v,
+                        const std::function<bool(int32_t, int32_t)>& set_pixel) const;
 };
 
 } // namespace midgard
@@ -1,13 +1,17 @@
 #ifndef VALHALLA_MIDGARD_UTIL_H_
 #define VALHALLA_MIDGARD_UTIL_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <exception>
 #include <limits>
 #include <memory>
 #include <ostream>
 #include <random>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -488,6 +492,52 @@ template <typename T> struct ring_queue_t {
   }
 };
 
+/**
+ * Calls fn(index, thread) for every index in [0, count). The calling thread takes part along with
+ * up to concurrency - 1 additional threads, no more than there are other indices. Each thread takes
+ * the next index nobody has taken yet. thread is 0 on the calling thread and 1 up to the number of
+ * additional threads otherwise, so that fn can keep state per thread. A thread stops taking indices
+ * when fn throws and once all of them are done the exception of the lowest thread is rethrown
+ *
+ * @param count        the number of indices
+ * @param concurrency  the most threads to use including the calling one
+ * @param fn           called with each index and the thread it is called on
+ */
+template <typename function_t>
+void parallel_for(const size_t count, const size_t concurrency, const function_t& fn) {
+  std::atomic<size_t> next(0);
+  const auto work = [&next, &fn, count](const size_t thread) {
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i, thread);
+    }
+  };
+
+  // Start the additional threads
+  const size_t thread_count =
+      std::min(std::max(concurrency, static_cast<size_t>(1)) - 1, count == 0 ? 0 : count - 1);
+  std::vector<std::exception_ptr> errors(thread_count + 1);
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (size_t t = 1; t <= thread_count; ++t) {
+    threads.emplace_back([&work, &errors, t]() {
+      try {
+        work(t);
+      } catch (...) { errors[t] = std::current_exception(); }
+    });
+  }
+  try {
+    work(0);
+  } catch (...) { errors[0] = std::current_exception(); }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 struct gps_segment_t {
   std::vector<midgard::PointLL> shape;
   float speed; // in meters/second
@@ -2,13 +2,17 @@
 #define VALHALLA_MJOLNIR_ADMIN_H_
 
 #include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
+#include <boost/geometry/index/rtree.hpp>
 #include <boost/geometry/io/wkt/wkt.hpp>
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 #include <cstdint>
 #include <sqlite3.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/midgard/aabb2.h>
 #include <valhalla/midgard/pointll.h>
@@ -25,6 +29,53 @@ namespace mjolnir {
 typedef boost::geometry::model::d2::point_xy<double> point_type;
 typedef boost::geometry::model::polygon<point_type> polygon_type;
 typedef boost::geometry::model::multi_polygon<polygon_type> multi_polygon_type;
+typedef boost::geometry::model::box<point_type> box_type;
+
+/**
+ * Admin or timezone multipolygons by index, in the order they were added,
+ * with an R-tree of the bounding boxes of their polygons. Finding the
+ * multipolygon covering a point only tests the polygons whose bounding box
+ * holds the point instead of every polygon.
+ */
+class MultiPolygonIndex {
+public:
+  typedef std::vector<std::pair<uint32_t, multi_polygon_type>>::const_iterator const_iterator;
+
+  MultiPolygonIndex() = default;
+
+  /**
+   * Constructor. Indexes the multipolygons in the order of the map.
+   * @param  polys   unordered map of polys by index.
+   */
+  explicit MultiPolygonIndex(std::unordered_map<uint32_t, multi_polygon_type>&& polys);
+
+  /**
+   * Get the index of the first multipolygon which covers a point, the same
+   * one a search through all the multipolygons in order would find.
+   * @param  ll      point that needs to be checked.
+   * @return the index of the multipolygon, 0 if none covers the point.
+   */
+  uint32_t Find(const PointLL& ll) const;
+
+  size_t size() const {
+    return polys_.size();
+  }
+
+  const_iterator begin() const {
+    return polys_.begin();
+  }
+
+  const_iterator end() const {
+    return polys_.end();
+  }
+
+protected:
+  // The position of the multipolygon and of the polygon within it
+  typedef std::pair<box_type, std::pair<uint32_t, uint32_t>> value_type;
+
+  std::vector<std::pair<uint32_t, multi_polygon_type>> polys_;
+  boost::geometry::index::rtree<value_type, boost::geometry::index::rstar<16>> rtree_;
+};
 
 /**
  * Get the dbhandle of a sqlite db.  Used for timezones and admins DBs.
@@ -41,13 +92,20 @@ sqlite3* GetDBHandle(const std::string& database);
 uint32_t GetMultiPolyId(const std::unordered_map<uint32_t, multi_polygon_type>& polys,
                         const PointLL& ll);
 
+/**
+ * Get the polygon index using the spatial index of the polys.  Finds the same
+ * poly as the search through the map they were loaded from.
+ * @param  polys   indexed polys.
+ * @param  ll      point that needs to be checked.
+ */
+uint32_t GetMultiPolyId(const MultiPolygonIndex& polys, const PointLL& ll);
+
 /**
  * Get the timezone polys from the db
  * @param  db_handle    sqlite3 db handle
  * @param  aabb         bb of the tile
  */
-std::unordered_map<uint32_t, multi_polygon_type> GetTimeZones(sqlite3* db_handle,
-                                                              const AABB2<PointLL>& aabb);
+MultiPolygonIndex GetTimeZones(sqlite3* db_handle, const AABB2<PointLL>& aabb);
 
 /**
  * Get the admin polys that intersect with the tile bounding box.
@@ -57,11 +115,10 @@ std::unordered_map<uint32_t, multi_polygon_type> GetTimeZones(sqlite3* db_handle
  * @param  aabb             bb of the tile
  * @param  tilebuilder      Graph tile builder
  */
-std::unordered_map<uint32_t, multi_polygon_type>
-GetAdminInfo(sqlite3* db_handle,
-             std::unordered_map<uint32_t, bool>& drive_on_right,
-             const AABB2<PointLL>& aabb,
-             GraphTileBuilder& tilebuilder);
+MultiPolygonIndex GetAdminInfo(sqlite3* db_handle,
+                               std::unordered_map<uint32_t, bool>& drive_on_right,
+                               const AABB2<PointLL>& aabb,
+                               GraphTileBuilder& tilebuilder);
 
 /**
  * Get all the country access records from the db and save them to a map.
@@ -33,6 +33,8 @@
 
 #include <fstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 // this describes the low-level blob storage
 #include <valhalla/proto/fileformat.pb.h>
@@ -75,14 +77,27 @@ struct Callback {
   virtual void
   relation_callback(const uint64_t osmid, const Tags& tags, const std::vector<Member>& members) = 0;
   virtual void changeset_callback(const uint64_t changeset_id) = 0;
+  // optionally called, before the matching callback above, for every node, way and relation. the
+  // parser may call this concurrently from its worker threads, thread being the index of the
+  // calling worker in [0, threads). its meant for expensive work which doesnt depend on the order
+  // of the objects, like tag transformation. returning false skips the object's callback entirely
+  virtual bool
+  transform_callback(const size_t thread, const Interest type, const uint64_t osmid, Tags& tags) {
+    return true;
+  }
 };
 
 // the parser used to get data out of the osmpbf file
 class Parser {
 public:
   Parser() = delete;
-  // parse the pbf file for the things you are interested in
-  static void parse(std::ifstream& file, const Interest interest, Callback& callback);
+  // parse the pbf file for the things you are interested in. with more than one thread the blobs
+  // are decompressed and decoded in parallel but the callbacks are still called in file order
+  // from the calling thread
+  static void parse(std::ifstream& file,
+                    const Interest interest,
+                    Callback& callback,
+                    const size_t threads = 1);
   // clean up protobuf library level memory, this will make protobuf unusable after its called
   static void free();
 };
@@ -26,6 +26,10 @@ public:
 
   std::list<TripDirections> narrate(const valhalla_request_t& request,
                                     std::list<TripPath>& legs) const;
+
+protected:
+  // number of threads narrating the legs of a single route
+  size_t narration_concurrency;
 };
 } // namespace odin
 } // namespace valhalla
@@ -8,7 +8,7 @@
 #include <utility>
 #include <vector>
 
-#include <valhalla/baldr/double_bucket_queue.h>
+#include <valhalla/baldr/label_queue.h>
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/sif/hierarchylimits.h>
@@ -92,9 +92,9 @@ protected:
   std::vector<sif::BDEdgeLabel> edgelabels_forward_;
   std::vector<sif::BDEdgeLabel> edgelabels_reverse_;
 
-  // Adjacency list - approximate double bucket sort
-  std::shared_ptr<baldr::DoubleBucketQueue> adjacencylist_forward_;
-  std::shared_ptr<baldr::DoubleBucketQueue> adjacencylist_reverse_;
+  // Adjacency list - priority queue of edge labels
+  std::shared_ptr<baldr::LabelQueue> adjacencylist_forward_;
+  std::shared_ptr<baldr::LabelQueue> adjacencylist_reverse_;
 
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_forward_;
@@ -9,9 +9,9 @@
 #include <utility>
 #include <vector>
 
-#include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/label_queue.h>
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
@@ -55,6 +55,38 @@ struct LocationStatus {
   }
 };
 
+/**
+ * Status changes of a source and target pair which found a connection or
+ * whose search ran out of edges. Records the number of edge labels of both
+ * at the time since that sets the new threshold.
+ */
+struct StatusUpdate {
+  uint32_t source;
+  uint32_t target;
+  uint32_t label_count;
+};
+
+/**
+ * Changes a search iteration of a location makes which affect other
+ * locations. The searches of an iteration may run in parallel so these are
+ * applied afterwards, in location order, which is the order in which the
+ * searches would make them when run one after another.
+ */
+struct PendingStatus {
+  bool searched;                       // Was the search iterated
+  std::vector<StatusUpdate> updates;   // Status updates
+  std::vector<baldr::GraphId> reached; // Edges reached by a backward search
+
+  PendingStatus() : searched(false) {
+  }
+
+  void clear() {
+    searched = false;
+    updates.clear();
+    reached.clear();
+  }
+};
+
 /**
  * Best connection. Information about the best connection found between
  * a source and target pair.
@@ -119,6 +151,25 @@ public:
    */
   void Clear();
 
+  /**
+   * Set the kind of priority queue used to sort the edge labels. It takes
+   * effect the next time the adjacency lists are created.
+   * @param type  The kind of label queue.
+   */
+  void set_label_queue_type(const baldr::LabelQueueType type) {
+    label_queue_type_ = type;
+  }
+
+  /**
+   * Set the graph readers of additional threads which run the searches of
+   * the source and target locations in parallel. The results are the same
+   * for any number of threads.
+   * @param readers  Graph readers, one for each additional thread.
+   */
+  void set_thread_readers(const std::vector<std::shared_ptr<baldr::GraphReader>>& readers) {
+    thread_readers_ = readers;
+  }
+
 protected:
   // Access mode used by the costing method
   uint32_t access_mode_;
@@ -138,21 +189,31 @@ protected:
   // The cost threshold being used for the currently executing query
   float current_cost_threshold_;
 
+  // Kind of adjacency lists
+  baldr::LabelQueueType label_queue_type_;
+
+  // Graph readers of the additional threads
+  std::vector<std::shared_ptr<baldr::GraphReader>> thread_readers_;
+
   // Status
   std::vector<LocationStatus> source_status_;
   std::vector<LocationStatus> target_status_;
 
+  // Changes to apply after each iteration of the searches
+  std::vector<PendingStatus> source_pending_;
+  std::vector<PendingStatus> target_pending_;
+
   // Adjacency lists, EdgeLabels, EdgeStatus, and hierarchy limits for each
   // source location (forward traversal)
   std::vector<std::vector<sif::HierarchyLimits>> source_hierarchy_limits_;
-  std::vector<std::shared_ptr<baldr::DoubleBucketQueue>> source_adjacency_;
+  std::vector<std::shared_ptr<baldr::LabelQueue>> source_adjacency_;
   std::vector<std::vector<sif::BDEdgeLabel>> source_edgelabel_;
   std::vector<EdgeStatus> source_edgestatus_;
 
   // Adjacency lists, EdgeLabels, EdgeStatus, and hierarchy limits for each
   // target location (reverse traversal)
   std::vector<std::vector<sif::HierarchyLimits>> target_hierarchy_limits_;
-  std::vector<std::shared_ptr<baldr::DoubleBucketQueue>> target_adjacency_;
+  std::vector<std::shared_ptr<baldr::LabelQueue>> target_adjacency_;
   std::vector<std::vector<sif::BDEdgeLabel>> target_edgelabel_;
   std::vector<EdgeStatus> target_edgestatus_;
 
@@ -195,12 +256,42 @@ protected:
    */
   void CheckForwardConnections(const uint32_t source, const sif::BDEdgeLabel& pred, const uint32_t n);
 
+  /**
+   * Record a status update for when the iteration is done.
+   * @param  pending  Pending changes of the location being searched.
+   * @param  source   Source index
+   * @param  target   Target index
+   */
+  void RecordStatus(PendingStatus& pending, const uint32_t source, const uint32_t target);
+
   /**
    * Update status when a connection is found.
-   * @param  source  Source index
-   * @param  target  Target index
+   * @param  update  Source, target and their number of edge labels.
+   */
+  void UpdateStatus(const StatusUpdate& update);
+
+  /**
+   * Iterate the searches of all source or target locations once. Locations
+   * are split among the threads, each using its own graph reader.
+   * @param  forward      Iterate the forward searches from the sources if
+   *                      true, the backward searches from the targets if not.
+   * @param  n            Iteration counter.
+   * @param  part         Part of the locations to search.
+   * @param  parts        Number of parts the locations are split into.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   */
+  void Search(const bool forward,
+              const uint32_t n,
+              const uint32_t part,
+              const uint32_t parts,
+              baldr::GraphReader& graphreader);
+
+  /**
+   * Apply the pending changes of the searches of all source or target
+   * locations in location order.
+   * @param  forward  Apply the changes of the forward searches if true.
    */
-  void UpdateStatus(const uint32_t source, const uint32_t target);
+  void ApplyPending(const bool forward);
 
   /**
    * Iterate the backward search from the target/destination location.
@@ -1,13 +1,22 @@
 #ifndef VALHALLA_THOR_EDGESTATUS_H_
 #define VALHALLA_THOR_EDGESTATUS_H_
 
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <valhalla/baldr/flat_id_map.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtile.h>
 
 namespace valhalla {
 namespace thor {
 
+// Maximum number of edge status entries kept for reuse when the status is
+// cleared, roughly 16MB worth. Past this the per tile arrays are freed.
+constexpr size_t kMaxReservedEdgeStatusCount = 4 * 1024 * 1024;
+
 // Edge label status
 enum class EdgeSet : uint8_t {
   kUnreached = 0, // Unreached - not yet encountered in search
@@ -44,26 +53,59 @@ struct EdgeStatusInfo {
  * list during shortest path algorithms. This method stores status info for
  * edges within arrays for each tile. This allows the path algorithms to get
  * a pointer to the first edge status and iterate that pointer over sequential
- * edges. This reduces the number of map lookups.
+ * edges. This reduces the number of map lookups. The arrays are found by
+ * tile id in a flat, open addressed table and the most recently used tile
+ * is remembered, since consecutive lookups are usually within one tile.
+ *
+ * The arrays are kept when the status is cleared so that a path algorithm
+ * which is reused for many requests does not allocate them over and over.
+ * Only the entries which were set since the last clear are reset, or the
+ * whole array of a tile if a pointer into it was handed out, since the path
+ * algorithms write through it to any edge leaving a node.
  */
 class EdgeStatus {
 public:
   /**
-   * Destructor. Delete any allocated EdgeStatusInfo arrays.
+   * Constructor.
+   * @param  max_reserved  Maximum number of edge status entries kept when cleared.
+   *                       If more than this many were allocated they are all freed.
    */
-  ~EdgeStatus() {
-    clear();
+  EdgeStatus(const size_t max_reserved = kMaxReservedEdgeStatusCount)
+      : max_reserved_(max_reserved), reserved_(0), last_tile_(baldr::kInvalidGraphId),
+        last_index_(0) {
   }
 
   /**
-   * Clear the EdgeStatusInfo arrays and the edge status map.
+   * Reset the status of every edge set or handed out since the last clear to unreached.
+   * The per tile arrays are kept for reuse unless more than the maximum
+   * reserved entries have been allocated.
    */
   void clear() {
-    // Delete any allocated arrays for tiles within the map.
-    for (auto iter : edgestatus_) {
-      delete[] iter.second;
+    // Too much memory is being held on to, let it all go
+    if (reserved_ > max_reserved_) {
+      edgestatus_.release();
+      touched_.clear();
+      reserved_ = 0;
+      last_tile_ = baldr::kInvalidGraphId;
+      return;
+    }
+
+    // Reset only the entries which were set, or the whole tile if any of
+    // them could have been written through a pointer
+    for (auto index : touched_) {
+      auto& status = edgestatus_.at_index(index);
+      if (status.whole) {
+        std::fill(status.edges.get(), status.edges.get() + status.count, EdgeStatusInfo());
+      } else {
+        for (auto id : status.touched) {
+          status.edges[id] = EdgeStatusInfo();
+        }
+      }
+      status.touched.clear();
+      status.whole = false;
+      status.dirty = false;
     }
-    edgestatus_.clear();
+    touched_.clear();
   }
 
   /**
@@ -77,16 +119,9 @@ public:
            const EdgeSet set,
            const uint32_t index,
            const baldr::GraphTile* tile) {
-    auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()] = {set, index};
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value(),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      inserted.first->second[edgeid.id()] = {set, index};
-    }
+    auto& status = get_tile_status(edgeid, tile);
+    touch(status, last_index_, edgeid.id());
+    status.edges[edgeid.id()] = {set, index};
   }
 
   /**
@@ -96,9 +131,11 @@ public:
    * @param  set      Label set for this directed edge.
    */
   void Update(const baldr::GraphId& edgeid, const EdgeSet set) {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      p->second[edgeid.id()].set_ = static_cast<uint32_t>(set);
+    const uint32_t index = edgestatus_.find_index(edgeid.tile_value());
+    auto* p = index == decltype(edgestatus_)::kEmptyIndex ? nullptr : &edgestatus_.at_index(index);
+    if (p != nullptr && p->edges) {
+      touch(*p, index, edgeid.id());
+      p->edges[edgeid.id()].set_ = static_cast<uint32_t>(set);
     } else {
       throw std::runtime_error("EdgeStatus Update on edge not previously set");
     }
@@ -110,36 +147,105 @@ public:
    * @return  Returns edge status info.
    */
   EdgeStatusInfo Get(const baldr::GraphId& edgeid) const {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    return (p == edgestatus_.end()) ? EdgeStatusInfo() : p->second[edgeid.id()];
+    const auto* p = edgestatus_.find(edgeid.tile_value());
+    return (p == nullptr) ? EdgeStatusInfo() : p->edges[edgeid.id()];
   }
 
   /**
    * Get a pointer to the edge status info of a directed edge. Since directed
    * edges are stored sequentially from a node this reduces the number of
-   * lookups by edgeid.
+   * lookups by edgeid. The whole tile is reset by the next clear since the
+   * status of any edge in it may be written through the pointer.
    * @param   edgeid  GraphId of the directed edge.
    * @param   tile    Graph tile of the directed edge.
    * @return  Returns a pointer to edge status info for this edge.
    */
   EdgeStatusInfo* GetPtr(const baldr::GraphId& edgeid, const baldr::GraphTile* tile) {
-    const auto p = edgestatus_.find(edgeid.tile_value());
-    if (p != edgestatus_.end()) {
-      return &p->second[edgeid.id()];
-    } else {
-      // Tile is not in the map. Add an array of EdgeStatusInfo, sized to
-      // the number of directed edges in the specified tile.
-      auto inserted = edgestatus_.emplace(edgeid.tile_value(),
-                                          new EdgeStatusInfo[tile->header()->directededgecount()]);
-      return &(inserted.first->second)[edgeid.id()];
+    auto& status = get_tile_status(edgeid, tile);
+    if (!status.dirty) {
+      touched_.push_back(last_index_);
+      status.dirty = true;
     }
+    status.whole = true;
+    return &status.edges[edgeid.id()];
   }
 
 private:
+  // The status of all of the directed edges in one tile along with the
+  // ids of the ones which have been set since the last clear. Once a pointer
+  // into the tile is handed out the ids are no longer kept, the whole tile
+  // is reset instead
+  struct tile_status_t {
+    std::unique_ptr<EdgeStatusInfo[]> edges;
+    uint32_t count = 0;
+    std::vector<uint32_t> touched;
+    bool dirty = false;
+    bool whole = false;
+  };
+
+  /**
+   * Remember that an edge of a tile is set so the next clear resets it.
+   * @param  status  Status of the tile.
+   * @param  index   Position of the tile's status.
+   * @param  id      Id of the directed edge within the tile.
+   */
+  void touch(tile_status_t& status, const uint32_t index, const uint32_t id) {
+    if (!status.dirty) {
+      touched_.push_back(index);
+      status.dirty = true;
+    }
+    if (!status.whole) {
+      status.touched.push_back(id);
+    }
+  }
+
+  /**
+   * Get the status array of the tile the edge is in, allocating it if
+   * this tile has not been seen before or if it has grown since it was.
+   * Afterwards last_index_ is the position of the tile's status.
+   * @param   edgeid  GraphId of the directed edge.
+   * @param   tile    Graph tile of the directed edge.
+   * @return  Returns the status of the tile.
+   */
+  tile_status_t& get_tile_status(const baldr::GraphId& edgeid, const baldr::GraphTile* tile) {
+    const uint32_t tile_value = edgeid.tile_value();
+    if (tile_value != last_tile_) {
+      last_index_ = edgestatus_.emplace_index(tile_value).first;
+      last_tile_ = tile_value;
+    }
+    auto& status = edgestatus_.at_index(last_index_);
+    const uint32_t count = tile->header()->directededgecount();
+    if (status.count < count || !status.edges) {
+      // Size the array to the number of directed edges in the specified tile
+      // and keep anything that was already set
+      std::unique_ptr<EdgeStatusInfo[]> edges(new EdgeStatusInfo[count]);
+      if (status.edges) {
+        std::copy(status.edges.get(), status.edges.get() + status.count, edges.get());
+      }
+      reserved_ += count - (status.edges ? status.count : 0);
+      status.edges = std::move(edges);
+      status.count = count;
+    }
+    return status;
+  }
+
+  // Maximum number of entries to keep around when cleared
+  size_t max_reserved_;
+
+  // Number of entries currently allocated across all tiles
+  size_t reserved_;
+
   // Edge status - keys are the tile Ids (level and tile Id) and the
-  // values are dynamically allocated arrays of EdgeStatusInfo (sized
-  // based on the directed edge count within the tile).
-  std::unordered_map<uint32_t, EdgeStatusInfo*> edgestatus_;
+  // values are arrays of EdgeStatusInfo (sized based on the directed
+  // edge count within the tile).
+  baldr::FlatIdMap<tile_status_t> edgestatus_;
+
+  // The tile looked up last and the position of its status
+  uint64_t last_tile_;
+  uint32_t last_index_;
+
+  // Positions of the tiles which have had an edge set or handed out since the last clear
+  std::vector<uint32_t> touched_;
 };
 
 } // namespace thor
@@ -8,15 +8,16 @@
 #include <utility>
 #include <vector>
 
-#include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/label_queue.h>
 #include <valhalla/baldr/location.h>
 #include <valhalla/midgard/gridded_data.h>
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/isotile_rasterizer.h>
 
 namespace valhalla {
 namespace thor {
@@ -43,6 +44,32 @@ public:
    */
   void Clear();
 
+  /**
+   * Set the kind of priority queue used to sort the edge labels. It takes
+   * effect the next time the adjacency list is created.
+   * @param type  The kind of label queue.
+   */
+  void set_label_queue_type(const baldr::LabelQueueType type) {
+    label_queue_type_ = type;
+  }
+
+  /**
+   * Set the number of threads marking the settled edges in the isotile while
+   * the expansion continues. The isotile does not depend on it.
+   * @param concurrency  Number of threads including the expanding thread.
+   */
+  void set_concurrency(const uint32_t concurrency) {
+    rasterizer_.set_concurrency(concurrency);
+  }
+
+  /**
+   * Get the number of threads working on a single isochrone.
+   * @return Returns the number of threads including the expanding thread.
+   */
+  uint32_t concurrency() const {
+    return rasterizer_.concurrency();
+  }
+
   /**
    * Compute an isochrone grid. This creates and populates a lat,lon grid with
    * time taken to reach each grid point. This gridded data is then contoured
@@ -103,8 +130,9 @@ protected:
   std::vector<sif::BDEdgeLabel> bdedgelabels_;
   std::vector<sif::MMEdgeLabel> mmedgelabels_;
 
-  // Adjacency list - approximate double bucket sort
-  std::shared_ptr<baldr::DoubleBucketQueue> adjacencylist_;
+  // Adjacency list - priority queue of edge labels
+  std::shared_ptr<baldr::LabelQueue> adjacencylist_;
+  baldr::LabelQueueType label_queue_type_;
 
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_;
@@ -112,6 +140,9 @@ protected:
   // Isochrone gridded time data
   std::shared_ptr<GriddedData<midgard::PointLL>> isotile_;
 
+  // Marks the settled edges in the isotile
+  IsoTileRasterizer rasterizer_;
+
   /**
    * Initialize prior to computing the isochrones. Creates adjacency list,
    * edgestatus support, and reserves edgelabels.
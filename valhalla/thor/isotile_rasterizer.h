@@ -0,0 +1,175 @@
+#ifndef VALHALLA_THOR_ISOTILE_RASTERIZER_H_
+#define VALHALLA_THOR_ISOTILE_RASTERIZER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <valhalla/midgard/gridded_data.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Marks the edges settled by an isochrone expansion in the isotile. Each
+ * edge sets the grid cells along its shape to the time (minutes) the shape
+ * is reached there if that is less than the time already in the cell. The
+ * lowest time of a cell does not depend on the order in which the edges are
+ * marked, so the edges can be rasterized by other threads while the expansion
+ * continues. Edges are gathered into batches which are handed to the threads,
+ * each marking its own copy of the isotile, and the copies are merged into the
+ * isotile when the expansion is done.
+ */
+class IsoTileRasterizer {
+public:
+  /**
+   * Constructor.
+   */
+  IsoTileRasterizer();
+
+  /**
+   * Destructor. Stops any rasterizing threads.
+   */
+  ~IsoTileRasterizer();
+
+  /**
+   * Set the number of threads marking edges in the isotile.
+   * @param concurrency  Number of threads including the expanding thread. With
+   *                     1 the edges are marked on the expanding thread.
+   */
+  void set_concurrency(const uint32_t concurrency);
+
+  /**
+   * Get the number of threads marking edges in the isotile.
+   * @return Returns the number of threads including the expanding thread.
+   */
+  uint32_t concurrency() const {
+    return concurrency_;
+  }
+
+  /**
+   * Start marking edges in a newly constructed isotile. Stops any threads
+   * left over from an expansion which did not finish.
+   * @param isotile         Isotile to mark.
+   * @param shape_interval  Interval (meters) along the shape at which times
+   *                        are marked.
+   */
+  void Start(const std::shared_ptr<midgard::GriddedData<midgard::PointLL>>& isotile,
+             const float shape_interval);
+
+  /**
+   * Add an edge shorter than the shape interval. Its begin node is marked with
+   * the time at the start of the edge and the cells on the way to its end node
+   * with the time at the end of the edge.
+   * @param begin  Lat,lon of the begin node.
+   * @param end    Lat,lon of the end node.
+   * @param secs0  Seconds at the start of the edge.
+   * @param secs1  Seconds at the end of the edge.
+   */
+  void AddEdge(const midgard::PointLL& begin,
+               const midgard::PointLL& end,
+               const float secs0,
+               const float secs1);
+
+  /**
+   * Add an edge given its shape. The shape is resampled to the shape interval
+   * and the time is interpolated along it.
+   * @param shape    Shape of the edge as stored in the edge info.
+   * @param forward  True if the shape is stored in the direction of the edge.
+   * @param secs0    Seconds at the start of the edge.
+   * @param secs1    Seconds at the end of the edge.
+   * @param length   Length of the edge in meters.
+   */
+  void AddEdge(const std::vector<midgard::PointLL>& shape,
+               const bool forward,
+               const float secs0,
+               const float secs1,
+               const float length);
+
+  /**
+   * Mark the edges which have not been marked yet, wait for the threads and
+   * merge their copies into the isotile. Rethrows any exception of a thread.
+   * @return Returns the isotile.
+   */
+  std::shared_ptr<const midgard::GriddedData<midgard::PointLL>> Finish();
+
+  /**
+   * Stop the threads without marking the remaining edges.
+   */
+  void Stop();
+
+protected:
+  // An edge to mark. Its shape is the range [begin, end) of the batch shape.
+  // Edges shorter than the shape interval have a length of 0.
+  struct edge_t {
+    uint32_t begin;
+    uint32_t end;
+    float secs0;
+    float secs1;
+    float length;
+  };
+
+  // Edges handed to a thread at once and the shape they share
+  struct batch_t {
+    std::vector<midgard::PointLL> shape;
+    std::vector<edge_t> edges;
+  };
+
+  uint32_t concurrency_;
+  float shape_interval_;
+  std::shared_ptr<midgard::GriddedData<midgard::PointLL>> isotile_;
+
+  // Edges added since the last batch was handed off
+  batch_t batch_;
+
+  // Scratch space for the shape of an edge when marking on this thread
+  std::vector<midgard::PointLL> shape_;
+
+  // The threads, their copies of the isotile and the exception each threw
+  std::vector<std::thread> threads_;
+  std::vector<std::unique_ptr<midgard::GriddedData<midgard::PointLL>>> isotiles_;
+  std::vector<std::exception_ptr> errors_;
+
+  // Batches waiting for a thread and emptied batches which can be reused.
+  // Guarded by the mutex, as is the flag telling the threads no more batches
+  // are coming.
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<batch_t> queue_;
+  std::vector<batch_t> spare_;
+  bool done_;
+
+  /**
+   * Hand the current batch to the threads, starting them if needed, or mark
+   * it on this thread if there are no threads.
+   */
+  void Flush();
+
+  /**
+   * Takes batches off the queue and marks them in a copy of the isotile
+   * until no more batches are coming.
+   * @param index  Index of the thread.
+   */
+  void Work(const size_t index);
+
+  /**
+   * Mark the edges of a batch.
+   * @param isotile  Isotile to mark.
+   * @param batch    Edges to mark.
+   * @param shape    Scratch space for the shape of an edge.
+   */
+  void Rasterize(midgard::GriddedData<midgard::PointLL>& isotile,
+                 const batch_t& batch,
+                 std::vector<midgard::PointLL>& shape) const;
+};
+
+} // namespace thor
+} // namespace valhalla
+
+#endif // VALHALLA_THOR_ISOTILE_RASTERIZER_H_
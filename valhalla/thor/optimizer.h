@@ -9,32 +9,32 @@
 namespace valhalla {
 namespace thor {
 
-// Annealing factor - the rate at which temperature is reduced between each
-// annealing step. Recommend setting this to a value between 0.85 and 0.95.
-// Cool too slowly and the probability of escaping local optima decreases and
-// setting too high takes longer to converge on a solution.
-constexpr float kCoolingRate = 0.93f;
-
-// Alteration type.
-// kRotate  - Alters a portion of the tour by rotating the locations about
-//            a middle point. The middle location becomes the new start
-//            location in the range.
-// kReverse - Alters the tour by reversing the locations in the tour between
-//            a start and end location.
-enum AlterationType { kRotate, kReverse };
-
-// Simple structure with 3 values describing a possible tour alteration
-struct TourAlteration {
-  uint32_t start;     // Index of 1st location
-  uint32_t mid;       // Index of middle location (for rotate)
-  uint32_t end;       // Index of 2nd location
-  AlterationType alt; // Type of alteration
-};
+// Most locations a tour is solved exactly for. The dynamic program keeps a
+// cost for every subset of the locations between the first and last one and
+// every location the subset can end at, so it grows exponentially.
+constexpr uint32_t kMaxExactLocations = 15;
+
+// Most passes the local search makes over the tour. It stops early once a
+// pass finds no move which lowers the cost.
+constexpr uint32_t kMaxLocalSearchPasses = 100;
+
+// Number of times per location the best tour is kicked and searched from
+// again without finding a better one before giving up.
+constexpr uint32_t kMaxFailedKicks = 4;
+
+// Longest run of successive locations an Or-opt move takes out of the tour
+// and puts back in elsewhere.
+constexpr uint32_t kMaxOrOptLength = 3;
 
 /**
- * Optimization method using simulated annealing. Optimizes the order of
- * locations - keeping the first location (origin) and last location
- * (destination) fixed.
+ * Optimizes the order of locations - keeping the first location (origin) and
+ * last location (destination) fixed. Tours with up to kMaxExactLocations are
+ * solved exactly with the Held-Karp dynamic program. Larger tours are built
+ * by cheapest insertion and then improved with 2-opt and Or-opt moves until
+ * none of them lowers the cost. To get out of local optima the best tour is
+ * then repeatedly kicked by swapping two parts of it and improved again,
+ * keeping it if it got better. Costs need not be symmetric and the kicks use
+ * a fixed seed, so the tour only depends on the costs.
  */
 class Optimizer {
 public:
@@ -49,56 +49,72 @@ public:
    */
   std::vector<uint32_t> Solve(const uint32_t count, const std::vector<float>& costs);
 
+protected:
+  uint32_t count_;                // # of locations
+  std::mt19937 random_generator_; // Picks the parts of the tour to swap
+
+  /**
+   * Find the tour with the least cost with the Held-Karp dynamic program.
+   * @param  costs  2-D cost matrix.
+   * @return Returns the optimal tour.
+   */
+  std::vector<uint32_t> SolveExact(const std::vector<float>& costs) const;
+
   /**
-   * Seed the random number generator. This is used by tests to create a
-   * repeatable sequence.
-   * @param  seed  Seed to use for the random number generator.
+   * Build a tour by repeatedly inserting the location which adds the least
+   * cost where it adds the least cost.
+   * @param  costs  2-D cost matrix.
+   * @return Returns the tour.
    */
-  void Seed(const uint32_t seed) {
-    random_generator_.seed(seed);
-  }
+  std::vector<uint32_t> CheapestInsertion(const std::vector<float>& costs) const;
 
-protected:
-  // Random number generation: 0 <= r < 1
-  std::mt19937_64 random_generator_;
-  std::uniform_real_distribution<float> uniform_distribution_{0.0, 1.0};
-
-  uint32_t ntry_;                   // # of attempts (for debugging)
-  uint32_t count_;                  // # of locations
-  uint32_t attempts_;               // # of attempts per annealing cycle
-  uint32_t successes_;              // # of success per annealing cycle
-  float best_cost_;                 // Current best cost
-  std::vector<uint32_t> tour_;      // Current tour (order of locations)
-  std::vector<uint32_t> best_tour_; // Best tour so far
-
-  /*
-   * Perform the annealing process.
-   * @param  costs        2-D cost matrix.
-   * @param  temperature  Current temperature.
-   * @return Returns number of successes.
+  /**
+   * Improve the tour with 2-opt and Or-opt moves until they no longer lower
+   * its cost, making at most kMaxLocalSearchPasses passes.
+   * @param  costs  2-D cost matrix.
+   * @param  tour   Tour to improve.
    */
-  uint32_t Anneal(const std::vector<float>& costs, float temperature);
+  void LocalSearch(const std::vector<float>& costs, std::vector<uint32_t>& tour) const;
 
   /**
-   * Select a potential alteration of the tour.
-   * @return  Returns a candidate tour alteration: type and location indexes.
+   * Swap two neighbouring parts of the tour, picked at random, between the
+   * first and last location.
+   * @param  tour  Tour to alter.
    */
-  TourAlteration GetTourAlteration();
+  void Kick(std::vector<uint32_t>& tour);
 
   /**
-   * Get the temperature difference (based on change in tour cost) given
-   * an alteration to the tour.
-   * @param  costs       2-D cost matrix.
-   * @param  alteration  Tour alteration.
-   * @return Returns the cost difference.
+   * Make a pass over the tour reversing the locations between a start and an
+   * end location where that lowers the cost the most.
+   * @param  costs  2-D cost matrix.
+   * @param  tour   Tour to improve.
+   * @return Returns true if the tour was improved.
    */
-  float TemperatureDifference(const std::vector<float>& costs, const TourAlteration& alteration);
+  bool TwoOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const;
 
   /**
-   * Create a random initial tour. The first and last locations must remain
-   * fixed as the tour begin and end locations do not change.
+   * Make a pass over the tour moving runs of up to kMaxOrOptLength locations,
+   * in either direction, to where that lowers the cost the most.
+   * @param  costs  2-D cost matrix.
+   * @param  tour   Tour to improve.
+   * @return Returns true if the tour was improved.
    */
-  void CreateRandomTour();
+  bool OrOpt(const std::vector<float>& costs, std::vector<uint32_t>& tour) const;
+
+  /**
+   * Get the cost of following the tour up to each location in it, both
+   * forwards and backwards, so the cost of reversing any part of it is
+   * known.
+   * @param  costs     2-D cost matrix.
+   * @param  tour      Order that locations are traversed.
+   * @param  forward   Set to the cost from the first location to each one.
+   * @param  backward  Set to the cost of going from each location back to
+   *                   the first location along the tour.
+   */
+  void PathCosts(const std::vector<float>& costs,
+                 const std::vector<uint32_t>& tour,
+                 std::vector<double>& forward,
+                 std::vector<double>& backward) const;
 
   /**
    * Get the cost for the specified tour (order of locations).
@@ -120,23 +136,6 @@ protected:
   float Cost(const std::vector<float>& costs, const uint32_t loc1, const uint32_t loc2) const {
     return costs[(loc1 * count_) + loc2];
   }
-
-  /**
-   * Get a random location. Makes sure it isn't the first or last location
-   * (which are fixed).
-   * @return  Returns the index of a random location.
-   */
-  uint32_t get_random_location() {
-    return static_cast<uint32_t>(r01() * (count_ - 2) + 1);
-  }
-
-  /**
-   * Convenience method to return a random floating point value: 0 <= r < 1
-   * @return  Returns a random value between 0 and 1.
-   */
-  float r01() {
-    return uniform_distribution_(random_generator_);
-  }
 };
 
 } // namespace thor
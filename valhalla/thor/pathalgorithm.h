@@ -10,6 +10,7 @@
 
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/label_queue.h>
 #include <valhalla/proto/tripcommon.pb.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/thor/pathinfo.h>
@@ -29,7 +30,9 @@ public:
   /**
    * Constructor
    */
-  PathAlgorithm() : interrupt(nullptr), has_ferry_(false) {
+  PathAlgorithm()
+      : interrupt(nullptr), has_ferry_(false),
+        label_queue_type_(baldr::LabelQueueType::kDoubleBucket) {
   }
 
   /**
@@ -69,6 +72,15 @@ public:
     interrupt = interrupt_callback;
   }
 
+  /**
+   * Set the kind of priority queue used to sort the edge labels. It takes
+   * effect the next time the adjacency list is created.
+   * @param type  The kind of label queue.
+   */
+  void set_label_queue_type(const baldr::LabelQueueType type) {
+    label_queue_type_ = type;
+  }
+
   /**
    * Does the path include a ferry?
    * @return  Returns true if the path includes a ferry.
@@ -82,6 +94,8 @@ protected:
 
   bool has_ferry_; // Indicates whether the path has a ferry
 
+  baldr::LabelQueueType label_queue_type_; // Kind of adjacency list
+
   /**
    * Check for path completion along the same edge. Edge ID in question
    * is along both an origin and destination and origin shows up at the
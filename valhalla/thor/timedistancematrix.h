@@ -8,9 +8,9 @@
 #include <utility>
 #include <vector>
 
-#include <valhalla/baldr/double_bucket_queue.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/label_queue.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/sif/dynamiccost.h>
 #include <valhalla/sif/edgelabel.h>
@@ -138,6 +138,25 @@ public:
    */
   void Clear();
 
+  /**
+   * Set the kind of priority queue used to sort the edge labels. It takes
+   * effect the next time the adjacency list is created.
+   * @param type  The kind of label queue.
+   */
+  void set_label_queue_type(const baldr::LabelQueueType type) {
+    label_queue_type_ = type;
+  }
+
+  /**
+   * Set the graph readers of additional threads which run some of the one to
+   * many (or many to one) searches of a many to many matrix. The results are
+   * the same for any number of threads.
+   * @param readers  Graph readers, one for each additional thread.
+   */
+  void set_thread_readers(const std::vector<std::shared_ptr<baldr::GraphReader>>& readers) {
+    thread_readers_ = readers;
+  }
+
 protected:
   // Number of destinations that have been found and settled (least cost path
   // computed).
@@ -146,6 +165,14 @@ protected:
   // The cost threshold being used for the currently executing query
   float current_cost_threshold_;
 
+  // Kind of adjacency list
+  baldr::LabelQueueType label_queue_type_;
+
+  // Graph readers of the additional threads and the matrices they search
+  // with, kept around so their memory is reused between requests
+  std::vector<std::shared_ptr<baldr::GraphReader>> thread_readers_;
+  std::vector<std::unique_ptr<TimeDistanceMatrix>> thread_matrices_;
+
   // List of destinations
   std::vector<Destination> destinations_;
 
@@ -159,8 +186,8 @@ protected:
   // Vector of edge labels (requires access by index).
   std::vector<sif::EdgeLabel> edgelabels_;
 
-  // Adjacency list - approximate double bucket sort
-  std::shared_ptr<baldr::DoubleBucketQueue> adjacencylist_;
+  // Adjacency list - priority queue of edge labels
+  std::shared_ptr<baldr::LabelQueue> adjacencylist_;
 
   // Edge status. Mark edges that are in adjacency list or settled.
   EdgeStatus edgestatus_;
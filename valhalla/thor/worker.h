@@ -2,6 +2,7 @@
 #define __VALHALLA_THOR_SERVICE_H__
 
 #include <cstdint>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -20,10 +21,12 @@
 #include <valhalla/thor/astar.h>
 #include <valhalla/thor/attributes_controller.h>
 #include <valhalla/thor/bidirectional_astar.h>
+#include <valhalla/thor/costmatrix.h>
 #include <valhalla/thor/isochrone.h>
 #include <valhalla/thor/match_result.h>
 #include <valhalla/thor/multimodal.h>
 #include <valhalla/thor/timedep.h>
+#include <valhalla/thor/timedistancematrix.h>
 #include <valhalla/thor/trippathbuilder.h>
 #include <valhalla/tyr/actor.h>
 #include <valhalla/worker.h>
@@ -57,14 +60,51 @@ public:
   std::string trace_attributes(valhalla_request_t& request);
 
 protected:
-  std::vector<thor::PathInfo> get_path(PathAlgorithm* path_algorithm,
+  typedef google::protobuf::RepeatedPtrField<odin::Location>::iterator location_iterator;
+
+  // The path algorithms, costing and graph reader legs are routed with, and
+  // what the legs did to the costing that carries over to the legs after them
+  struct leg_router_t {
+    AStarPathAlgorithm* astar;
+    BidirectionalAStar* bidir_astar;
+    MultiModalPathAlgorithm* multi_modal_astar;
+    TimeDepForward* timedep_forward;
+    TimeDepReverse* timedep_reverse;
+    valhalla::sif::cost_ptr_t* mode_costing;
+    valhalla::baldr::GraphReader* reader;
+    const std::function<void()>* interrupt;
+    // A leg needed a second pass, which relaxes the hierarchy limits
+    bool relaxed;
+    // A bidirectional A* leg disallowed destination only edges
+    bool disallowed_destination_only;
+    // A leg used destination only edges as allowed before the first leg
+    bool used_destination_only;
+  };
+
+  // Path algorithms, costing and graph reader of an additional thread routing
+  // the legs between other breaks of a route
+  struct leg_thread_t {
+    AStarPathAlgorithm astar;
+    BidirectionalAStar bidir_astar;
+    MultiModalPathAlgorithm multi_modal_astar;
+    TimeDepForward timedep_forward;
+    TimeDepReverse timedep_reverse;
+    valhalla::sif::cost_ptr_t mode_costing[static_cast<int>(sif::TravelMode::kMaxTravelMode)];
+    std::shared_ptr<valhalla::baldr::GraphReader> reader;
+  };
+
+  leg_router_t get_leg_router();
+  leg_router_t get_leg_router(leg_thread_t& leg_thread);
+  std::vector<thor::PathInfo> get_path(leg_router_t& router,
+                                       PathAlgorithm* path_algorithm,
                                        odin::Location& origin,
                                        odin::Location& destination,
                                        const std::string& costing);
   void log_admin(const odin::TripPath&);
   valhalla::sif::cost_ptr_t get_costing(const rapidjson::Document& request,
                                         const std::string& costing);
-  thor::PathAlgorithm* get_path_algorithm(const std::string& routetype,
+  thor::PathAlgorithm* get_path_algorithm(leg_router_t& router,
+                                          const std::string& routetype,
                                           const odin::Location& origin,
                                           const odin::Location& destination);
   odin::TripPath route_match(valhalla_request_t& request, const AttributesController& controller);
@@ -74,11 +114,15 @@ protected:
             uint32_t best_paths = 1);
 
   std::list<odin::TripPath>
-  path_arrive_by(google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
-                 const std::string& costing);
-  std::list<odin::TripPath>
-  path_depart_at(google::protobuf::RepeatedPtrField<valhalla::odin::Location>& correlated,
-                 const std::string& costing);
+  route_legs(valhalla_request_t& request, const std::string& costing, bool arrive_by);
+  std::list<odin::TripPath> path_arrive_by(leg_router_t& router,
+                                           location_iterator first,
+                                           location_iterator last,
+                                           const std::string& costing);
+  std::list<odin::TripPath> path_depart_at(leg_router_t& router,
+                                           location_iterator first,
+                                           location_iterator last,
+                                           const std::string& costing);
 
   void parse_locations(valhalla_request_t& request);
   void parse_measurements(const valhalla_request_t& request);
@@ -96,6 +140,13 @@ protected:
   TimeDepForward timedep_forward;
   TimeDepReverse timedep_reverse;
   Isochrone isochrone_gen;
+  // Matrix algorithms, kept around so their memory is reused between requests
+  CostMatrix cost_matrix;
+  TimeDistanceMatrix time_distance_matrix;
+  // Graph readers of the additional threads used by the matrix algorithms
+  std::vector<std::shared_ptr<valhalla::baldr::GraphReader>> matrix_readers;
+  // Additional threads routing the legs of a route
+  std::vector<std::shared_ptr<leg_thread_t>> leg_threads;
   std::shared_ptr<meili::MapMatcher> matcher;
   float long_request;
   std::unordered_map<std::string, float> max_matrix_distance;
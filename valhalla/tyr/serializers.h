@@ -12,6 +12,7 @@
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/midgard/gridded_data.h>
 #include <valhalla/proto/directions_options.pb.h>
+#include <valhalla/proto/response.pb.h>
 #include <valhalla/proto/route.pb.h>
 #include <valhalla/proto/tripdirections.pb.h>
 #include <valhalla/proto/trippath.pb.h>
@@ -25,14 +26,16 @@ namespace valhalla {
 namespace tyr {
 
 /**
- * Turn path and directions into a route that one can follow
+ * Turn path and directions into a route that one can follow. When the format
+ * is pbf the directions of the legs are serialized as an odin::Response
  */
 std::string serializeDirections(const valhalla_request_t& request,
                                 const std::list<odin::TripPath>& path_legs,
                                 const std::list<odin::TripDirections>& directions_legs);
 
 /**
- * Turn a time distance matrix into json that one can look up location pair results from
+ * Turn a time distance matrix into json that one can look up location pair results from.
+ * When the format is pbf the matrix is serialized as an odin::Response
  */
 std::string serializeMatrix(const valhalla_request_t& request,
                             const std::vector<thor::TimeDistance>& time_distances,
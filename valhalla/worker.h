@@ -32,6 +32,14 @@ struct valhalla_request_t {
 #ifdef HAVE_HTTP
   void parse(const http_request_t& request);
 #endif
+
+  /**
+   * Serializes only the members of the request document which the stages after
+   * loki still read. The rest of the request has been parsed into the options
+   * which are forwarded in binary, so later stages parse a much smaller document.
+   * @return the json of those members
+   */
+  std::string downstream_document() const;
 };
 
 #ifdef HAVE_HTTP
@@ -50,6 +58,17 @@ worker_t::result_t to_response_json(const std::string& json,
 worker_t::result_t to_response_xml(const std::string& xml,
                                    http_request_info_t& request_info,
                                    const valhalla_request_t& options);
+worker_t::result_t to_response_pbf(const std::string& pbf,
+                                   http_request_info_t& request_info,
+                                   const valhalla_request_t& options);
+// picks json, xml or pbf based on the format of the request
+worker_t::result_t to_response(const std::string& body,
+                               http_request_info_t& request_info,
+                               const valhalla_request_t& options);
+// picks json or pbf based on the format of the request, for actions without a gpx serializer
+worker_t::result_t to_response_json_or_pbf(const std::string& body,
+                                           http_request_info_t& request_info,
+                                           const valhalla_request_t& options);
 #endif
 
 class service_worker_t {